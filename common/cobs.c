@@ -0,0 +1,58 @@
+/**
+  @File Name
+    common/cobs.c
+
+  @Summary
+    Consistent Overhead Byte Stuffing. See cobs.h for details.
+*/
+
+#include "cobs.h"
+
+uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t code_pos = 0;  // length byte of current block
+    uint16_t n = 1;
+    uint8_t code = 1;
+
+    while (len--){
+        if (*in){
+            out[n++] = *in;
+            code++;
+        }
+        if (!*in++ || code == 0xFF){
+            out[code_pos] = code;
+            code = 1;
+            code_pos = n++;
+            // block of 254 bytes at the very end needs no empty one
+            if (!len && in[-1]){
+                return code_pos;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return n;
+}
+
+int16_t cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t i = 0, n = 0;
+    uint8_t code, j;
+
+    while (i < len){
+        code = in[i++];
+        if (!code || i + code - 1 > len){
+            return -1;
+        }
+        for (j = 1; j < code; j++){
+            if (!in[i]){
+                return -1;
+            }
+            out[n++] = in[i++];
+        }
+        // implicit zero between blocks, not after last or full block
+        if (code != 0xFF && i < len){
+            out[n++] = 0;
+        }
+    }
+    return (int16_t)n;
+}
@@ -0,0 +1,45 @@
+/**
+  @File Name
+    common/cobs.h
+
+  @Summary
+    Consistent Overhead Byte Stuffing - removes zero bytes from frame,
+    so that 0x00 can delimit frames on byte stream (UART).
+
+  @Description
+    Frame is split at each zero byte (and at every 254 non-zero bytes)
+    into blocks, each block is sent as its length + 1 followed by its
+    non-zero bytes:
+
+      11 22 00 33  ->  03 11 22 02 33
+
+    Overhead is 1 byte per started 254 bytes, worst case is known in
+    advance (COBS_MAX), receiver resynchronizes at next 0x00 after
+    any error. Shared by firmware (encoder) and host (sim/telem_rx.h).
+*/
+
+#ifndef COBS_H
+#define	COBS_H
+
+#include <stdint.h>
+
+// encoded size of 'len' bytes (without delimiter), worst case
+#define COBS_MAX(len) ((len) + (len) / 254 + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// encodes 'len' bytes to 'out' (COBS_MAX(len) bytes, not overlapping
+// 'in'), returns encoded length
+uint16_t cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out);
+// decodes frame without delimiter to 'out' (may be 'in'), returns
+// decoded length or -1 when frame is malformed (zero byte, block
+// longer than frame)
+int16_t cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* COBS_H */
@@ -0,0 +1,150 @@
+/**
+  @File Name
+    common/crash.c
+
+  @Summary
+    Persistent crash record filled by trap handlers - see crash.h
+*/
+
+#include <xc.h>
+#include <stddef.h>
+#include "crash.h"
+#include "out.h"
+
+// not initialized by C startup, survives any reset except power loss
+crash_record_t crash_record __attribute__((persistent));
+volatile uint16_t crash_trap_sp __attribute__((near)) = 0;
+
+// data RAM of PIC24FJ64GB002 and PIC24HJ128GP502 (8 KB)
+#define CRASH_RAM_START 0x0800U
+#define CRASH_RAM_END   0x2800U
+
+// trap codes as defined in traps.h (TRAPS_ERROR_CODE)
+static const char *const crash_names[] = {
+    "osc fail", "stack error", "address error", "math error", "dma error"
+};
+
+uint32_t __attribute__((weak)) crash_timestamp(void)
+{
+    return 0;
+}
+
+static uint16_t crash_sum(void)
+{
+    const uint16_t *w = (const uint16_t *)&crash_record;
+    uint16_t sum = 0;
+    uint8_t i;
+
+    for (i = 0; i < offsetof(crash_record_t, check) / 2; i++){
+        sum += w[i];
+    }
+    return (uint16_t)~sum;
+}
+
+static bool crash_valid(void)
+{
+    return crash_record.magic == CRASH_MAGIC && crash_record.check == crash_sum();
+}
+
+void crash_init(void)
+{
+    if (RCONbits.WDTO){
+        if (!crash_pending()){
+            crash_note(CRASH_WDT_STALL);
+        }
+        RCONbits.WDTO = 0;
+    }
+    if (RCONbits.POR || RCONbits.BOR || !crash_valid()){
+        // power-on (random RAM) or corrupted - start from scratch
+        crash_record.magic = 0;
+        crash_record.resets = 0;
+        crash_record.reported = 1;
+        crash_record.check = crash_sum();
+        // next trap/reset must not see POR again
+        RCONbits.POR = 0;
+        RCONbits.BOR = 0;
+    }
+}
+
+bool crash_pending(void)
+{
+    return crash_valid() && !crash_record.reported;
+}
+
+void crash_report(void (*out)(char c))
+{
+    crash_record_t r = crash_record;
+
+    if (!crash_pending()){
+        return;
+    }
+    out_str(out, "crash: ");
+    if (r.code < sizeof(crash_names) / sizeof(crash_names[0])){
+        out_str(out, crash_names[r.code]);
+    } else if (r.code == CRASH_WDT_STALL){
+        out_str(out, "watchdog stall");
+    } else if (r.code >= CRASH_WDT && r.code < CRASH_WDT_STALL){
+        out_str(out, "watchdog check-in ");
+        out_u32(out, r.code - CRASH_WDT);
+    } else {
+        out_str(out, "unknown");
+    }
+    out_str(out, " code ");
+    out_u32(out, r.code);
+    out_str(out, " pc 0x");
+    out_hex(out, r.pc, 6);
+    out_str(out, " sr 0x");
+    out_hex(out, r.sr, 2);
+    out_str(out, " rcon 0x");
+    out_hex(out, r.rcon, 4);
+    out_str(out, " time ");
+    out_u32(out, r.timestamp);
+    out_str(out, " resets ");
+    out_u32(out, r.resets);
+    out_str(out, "\r\n");
+
+    crash_record.reported = 1;
+    crash_record.check = crash_sum();
+}
+
+static void crash_store(uint16_t code, uint32_t pc, uint16_t sr)
+{
+    bool valid = crash_valid();
+
+    crash_record.code = code;
+    crash_record.pc = pc;
+    crash_record.sr = sr;
+    crash_record.rcon = RCON;
+    crash_record.timestamp = crash_timestamp();
+    crash_record.resets = valid ? crash_record.resets + 1 : 1;
+    crash_record.reported = 0;
+    crash_record.magic = CRASH_MAGIC;
+    crash_record.check = crash_sum();
+}
+
+void crash_note(uint16_t code)
+{
+    crash_store(code, 0, 0);
+}
+
+void crash_reset(uint16_t code)
+{
+    uint16_t sp = crash_trap_sp;
+    uint32_t pc = 0;
+    uint16_t sr = 0;
+
+    // trap pushed PC<15:0> and SRL:IPL3:PC<22:16>, read them only when
+    // stack pointer is sane (stack error may be caused by wild W15)
+    if (!(sp & 1) && sp >= CRASH_RAM_START + 4 && sp <= CRASH_RAM_END){
+        const uint16_t *frame = (const uint16_t *)(uintptr_t)(sp - 4);
+        pc = frame[0] | (uint32_t)(frame[1] & 0x7F) << 16;
+        sr = frame[1] >> 8;
+    }
+    crash_store(code, pc, sr);
+#if defined(__XC16__)
+    __asm__ volatile ("reset");
+#else
+    sim_builtin_reset(); // host simulator
+#endif
+    while (1);
+}
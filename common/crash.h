@@ -0,0 +1,85 @@
+/**
+  @File Name
+    common/crash.h
+
+  @Summary
+    Persistent crash record filled by trap handlers, fast reboot.
+
+  @Description
+    Instead of spinning forever in TRAPS_halt_on_error() (device dead
+    until power-cycled), trap handler calls crash_reset() that stores
+    crash record in persistent RAM (not cleared by C startup) and resets
+    CPU with RESET instruction - device is running again within
+    milliseconds. Next boot reports the record with crash_report().
+
+    Watchdog supervisor (wdt.h) stores its reason with crash_note()
+    before it lets hardware WDT reset CPU. WDT reset without record
+    (TMR1 ISR stalled) is recorded by crash_init() as CRASH_WDT_STALL.
+
+    Record contains:
+    - trap code (TRAPS_ERROR_CODE from traps.h) or CRASH_WDT* reason
+    - PC and SR low byte stacked by trap - PC points to instruction
+      after the faulting one (may be one more further for address error)
+    - RCON at time of trap
+    - timestamp from crash_timestamp() - weak, returns 0 by default,
+      projects with systime override it to return TMR1 ticks
+    - number of trap/watchdog resets since power-on (detects reboot loops)
+
+    Trap handler must store W15 to crash_trap_sp before its prologue,
+    use CRASH_TRAP_HANDLER attribute for that (XC16 preprologue).
+
+    Persistent RAM is random after power-on, so record is protected by
+    magic and checksum and cleared on POR/BOR by crash_init().
+
+    Usage:
+    - crash_init() early in main() (before RCON is modified)
+    - crash_pending() tells whether last reset was caused by trap,
+      crash_report(uart_putc) prints it (once)
+*/
+
+#ifndef CRASH_H
+#define	CRASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// trap handler attribute, saves stack pointer of trap frame
+#define CRASH_TRAP_HANDLER \
+    __attribute__((interrupt(preprologue("mov w15, _crash_trap_sp")), no_auto_psv))
+
+typedef struct {
+    uint16_t magic;     // CRASH_MAGIC when record is valid
+    uint16_t code;      // trap code
+    uint32_t pc;        // return address stacked by trap (23 bits)
+    uint16_t sr;        // SR<7:0> stacked by trap
+    uint16_t rcon;      // RCON at time of trap
+    uint32_t timestamp; // crash_timestamp() at time of trap
+    uint16_t resets;    // trap/watchdog resets since power-on
+    uint16_t reported;  // non-zero when already reported
+    uint16_t check;     // ~sum of all words above
+} crash_record_t;
+
+#define CRASH_MAGIC 0xC0DE
+
+// reset reasons recorded besides trap codes (TRAPS_ERROR_CODE 0..4)
+#define CRASH_WDT        0x10 // + id of missed check-in (see wdt.h)
+#define CRASH_WDT_STALL  0x1F // WDT reset without record (ISR stalled)
+
+extern crash_record_t crash_record;
+// W15 on trap entry (saved by CRASH_TRAP_HANDLER)
+extern volatile uint16_t crash_trap_sp;
+
+// validates record after reset, clears it on power-on
+void crash_init(void);
+// true when last reset was caused by trap and record was not reported yet
+bool crash_pending(void);
+// prints pending record as one line and marks it reported
+void crash_report(void (*out)(char c));
+// stores crash record and resets CPU, called from trap handler
+void crash_reset(uint16_t code) __attribute__((noreturn));
+// stores record without PC and without reset (reset follows by WDT)
+void crash_note(uint16_t code);
+// timestamp stored in record (weak, returns 0)
+uint32_t crash_timestamp(void);
+
+#endif	/* CRASH_H */
@@ -0,0 +1,32 @@
+/**
+  @File Name
+    common/crc16.c
+
+  @Summary
+    CRC-16/CCITT-FALSE. See crc16.h for details.
+*/
+
+#include "crc16.h"
+
+// CRC of 4-bit value in top nibble
+static const uint16_t CRC16_NIBBLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t crc16_update(uint16_t crc, uint8_t data)
+{
+    crc = (uint16_t)(crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data >> 4)];
+    crc = (uint16_t)(crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data & 0x0F)];
+    return crc;
+}
+
+uint16_t crc16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = CRC16_INIT;
+
+    while (len--){
+        crc = crc16_update(crc, *data++);
+    }
+    return crc;
+}
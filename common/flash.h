@@ -0,0 +1,68 @@
+/**
+  @File Name
+    common/flash.h
+
+  @Summary
+    Run-time self-programming (RTSP) of on-chip program flash.
+
+  @Description
+    Program memory of PIC24FJ64GB002 is 22K instructions (addresses
+    0x0000..0xABFF, 2 addresses per 24-bit instruction word). Erase
+    unit is page of 512 instructions (0x400 addresses), program unit is
+    row of 64 instructions (0x80 addresses, 192 bytes) or one word.
+    Only erased word (0xFFFFFF) may be programmed - data are written
+    once after erase, changes need a page erase (endurance is ~10000
+    cycles per page, so data structures on top of this - dee.h - spread
+    erases over pages). Last page holds configuration words and must
+    not be erased.
+
+    Every erase/write stalls CPU for its self-timed cycle (ms range),
+    interrupts are not serviced meanwhile - call from main context at
+    moments when missed ticks do not matter (TMR1 keeps counting,
+    systime stays correct, display multiplex pauses).
+
+    Data words are handled as 24 bits (low 16 bits + 8 bit high byte),
+    so one row stores 192 bytes (3 per word, see flash_write_row()).
+*/
+
+#ifndef FLASH_H
+#define	FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// program memory addresses
+typedef uint32_t flash_addr_t;
+
+#define FLASH_END        0xAC00UL   // end of program memory
+#define FLASH_PAGE_SIZE  0x400U     // erase page [addresses]
+#define FLASH_ROW_SIZE   0x80U      // program row [addresses]
+#define FLASH_ROW_WORDS  (FLASH_ROW_SIZE / 2)
+#define FLASH_ROW_BYTES  (FLASH_ROW_WORDS * 3)
+#define FLASH_ERASED     0xFFFFFFUL
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// 24-bit word at even address
+uint32_t flash_read(flash_addr_t addr);
+// reads 'len' bytes packed 3 per word from 'addr' (layout of
+// flash_write_row()), 'len' is multiple of 3
+void flash_read_bytes(flash_addr_t addr, uint8_t *data, uint16_t len);
+// erases page containing 'addr', returns false on error (WRERR)
+bool flash_erase_page(flash_addr_t addr);
+// programs one erased word
+bool flash_write_word(flash_addr_t addr, uint32_t value);
+// programs row at 'addr' (row aligned) with FLASH_ROW_BYTES bytes,
+// word i = data[3i] | data[3i+1] << 8 | data[3i+2] << 16
+bool flash_write_row(flash_addr_t addr, const uint8_t *data);
+// programs 'words' erased words from 'addr' (3 bytes each as above)
+// with one row write, rest of the row is left as it is
+bool flash_write_words(flash_addr_t addr, const uint8_t *data, uint8_t words);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FLASH_H */
@@ -0,0 +1,362 @@
+/**
+  @File Name
+    common/flog.c
+
+  @Summary
+    Temperature logger in program flash - see flog.h
+*/
+
+#include <xc.h>
+
+#include "flog.h"
+
+// pages reserved in program memory (linker keeps code and constants out)
+const uint16_t flog_flash[FLOG_PAGES * FLASH_PAGE_SIZE / 2]
+        __attribute__((space(prog), address(FLOG_BASE), noload));
+
+#define FLOG_ROW_ADDR(r) (FLOG_BASE + (flash_addr_t)(r) * FLASH_ROW_SIZE)
+#define FLOG_FREE        0xFFFFFFFFUL  // sequence of erased row
+
+// record codes (see flog.h)
+#define FLOG_ABSOLUTE    0xC0
+#define FLOG_FILLER      0xFF
+
+// head row (newest), collected here and written when full
+static uint8_t flog_row[FLASH_ROW_BYTES];
+static uint16_t flog_head = FLOG_ROWS - 1;
+static bool flog_open = false;   // flog_row holds head row
+static uint8_t flog_pos = 0;     // first free byte of flog_row
+static uint8_t flog_written = 0; // words of head row in flash
+static bool flog_dirty = false;  // flog_row has unwritten readings
+static uint32_t flog_pending;    // time of oldest unwritten reading
+static uint32_t flog_seq = 0;    // sequence of head row
+static uint16_t flog_used = 0;   // rows with data (including head)
+static uint32_t flog_epoch = 0;  // log time at boot
+static uint32_t flog_time;       // last reading
+static int16_t flog_value;
+static uint32_t flog_n = 0;
+// last flash word read by flog_byte()
+static flash_addr_t flog_cache_addr = FLASH_END;
+static uint32_t flog_cache;
+
+static uint32_t flog_u32(const uint8_t *b)
+{
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 |
+           (uint32_t)b[3] << 24;
+}
+
+// byte 'pos' of row (head row from RAM)
+static uint8_t flog_byte(uint16_t row, uint8_t pos)
+{
+    flash_addr_t addr;
+
+    if (pos >= FLASH_ROW_BYTES){
+        return FLOG_FILLER;
+    }
+    if (flog_open && row == flog_head){
+        return flog_row[pos];
+    }
+    addr = FLOG_ROW_ADDR(row) + (pos / 3) * 2;
+    if (addr != flog_cache_addr){
+        flog_cache_addr = addr;
+        flog_cache = flash_read(addr);
+    }
+    return (uint8_t)(flog_cache >> (8 * (pos % 3)));
+}
+
+// keyframe of row, returns its sequence (FLOG_FREE - erased row)
+static uint32_t flog_key(uint16_t row, uint32_t *time, int16_t *value)
+{
+    uint8_t buf[12];
+    const uint8_t *h = buf;
+
+    if (flog_open && row == flog_head){
+        h = flog_row;
+    } else {
+        flash_read_bytes(FLOG_ROW_ADDR(row), buf, sizeof(buf));
+    }
+    *time = flog_u32(h + 4);
+    *value = (int16_t)(h[8] | (uint16_t)h[9] << 8);
+    return flog_u32(h);
+}
+
+static uint16_t flog_row_add(uint16_t row, uint16_t n)
+{
+    return (uint16_t)((row + n) % FLOG_ROWS);
+}
+
+// oldest row with data
+static uint16_t flog_oldest(void)
+{
+    return flog_row_add(flog_head, FLOG_ROWS + 1 - flog_used);
+}
+
+bool flog_next(flog_iter_t *it, uint32_t *time, int16_t *value)
+{
+    uint8_t b, end;
+    uint16_t dt;
+
+    for (;;){
+        if (it->key){
+            flog_key(it->row, &it->time, &it->value);
+            it->key = false;
+            it->pos = FLOG_HEADER;
+            break;
+        }
+        end = flog_open && it->row == flog_head ? flog_pos : FLASH_ROW_BYTES;
+        if (it->pos >= end){
+            if (!it->left){
+                return false;
+            }
+            it->left--;
+            it->row = flog_row_add(it->row, 1);
+            it->key = true;
+            continue;
+        }
+        b = flog_byte(it->row, it->pos++);
+        if (b == FLOG_FILLER){
+            continue;
+        }
+        if (!(b & 0x80)){
+            // 0ttttvvv
+            dt = b >> 3;
+            it->value += (int8_t)(uint8_t)(b << 5) >> 5;
+        } else if ((b & 0xC0) == 0x80){
+            // 10vvvvvv tttttttt
+            dt = flog_byte(it->row, it->pos++);
+            it->value += (int8_t)(uint8_t)(b << 2) >> 2;
+        } else if (b == FLOG_ABSOLUTE){
+            dt = flog_byte(it->row, it->pos) |
+                 (uint16_t)flog_byte(it->row, it->pos + 1) << 8;
+            it->value = (int16_t)(flog_byte(it->row, it->pos + 2) |
+                 (uint16_t)flog_byte(it->row, it->pos + 3) << 8);
+            it->pos += 4;
+        } else {
+            // unknown record - rest of row is lost
+            it->pos = FLASH_ROW_BYTES;
+            continue;
+        }
+        it->time += dt;
+        break;
+    }
+    *time = it->time;
+    *value = it->value;
+    return true;
+}
+
+void flog_init(void)
+{
+    flog_iter_t it;
+    uint32_t seq, t;
+    int16_t v;
+    uint16_t row;
+    uint8_t end;
+
+    flog_open = false;
+    flog_dirty = false;
+    flog_used = 0;
+    flog_n = 0;
+    flog_cache_addr = FLASH_END;
+    for (row = 0; row < FLOG_ROWS; row++){
+        seq = flog_key(row, &t, &v);
+        if (seq == FLOG_FREE){
+            continue;
+        }
+        if (!flog_used++ || seq > flog_seq){
+            flog_seq = seq;
+            flog_head = row;
+        }
+    }
+    if (!flog_used){
+        flog_head = FLOG_ROWS - 1;
+        flog_seq = 0;
+        flog_epoch = 0;
+        return;
+    }
+    // continue in head row after its last record (not after last
+    // programmed word - record bytes may be 0xFF too)
+    flash_read_bytes(FLOG_ROW_ADDR(flog_head), flog_row, FLASH_ROW_BYTES);
+    flog_open = true;
+    flog_pos = FLASH_ROW_BYTES;
+    it.row = flog_head;
+    it.left = 0;
+    it.key = true;
+    end = FLOG_HEADER;
+    while (flog_next(&it, &flog_time, &flog_value)){
+        end = it.pos;
+    }
+    flog_written = (uint8_t)((end + 2) / 3);
+    flog_pos = (uint8_t)(3 * flog_written);
+    flog_epoch = flog_time;
+}
+
+// true when no row of page starting with 'row' was written (first
+// write of row always includes its header)
+static bool flog_page_blank(uint16_t row)
+{
+    uint8_t i;
+
+    for (i = 0; i < FLOG_ROWS_PER_PAGE; i++){
+        if (flash_read(FLOG_ROW_ADDR(row + i)) != FLASH_ERASED){
+            return false;
+        }
+    }
+    return true;
+}
+
+// starts new row with keyframe, erases page when row is its first one
+// (not when it is still erased - fresh chip, power lost after erase)
+static bool flog_new_row(uint32_t time, int16_t value)
+{
+    uint8_t i;
+
+    flog_open = false;
+    flog_head = flog_row_add(flog_head, 1);
+    if (flog_head % FLOG_ROWS_PER_PAGE == 0){
+        flog_cache_addr = FLASH_END;
+        if (flog_used > FLOG_ROWS - FLOG_ROWS_PER_PAGE){
+            flog_used = FLOG_ROWS - FLOG_ROWS_PER_PAGE;
+        }
+        if (!flog_page_blank(flog_head) &&
+                !flash_erase_page(FLOG_ROW_ADDR(flog_head))){
+            return false;
+        }
+    }
+    flog_used++;
+    flog_seq++;
+    for (i = 0; i < FLASH_ROW_BYTES; i++){
+        flog_row[i] = FLOG_FILLER;
+    }
+    for (i = 0; i < 4; i++){
+        flog_row[i] = (uint8_t)(flog_seq >> (8 * i));
+        flog_row[4 + i] = (uint8_t)(time >> (8 * i));
+    }
+    flog_row[8] = (uint8_t)value;
+    flog_row[9] = (uint8_t)((uint16_t)value >> 8);
+    flog_pos = FLOG_HEADER;
+    flog_written = 0;
+    flog_open = true;
+    return true;
+}
+
+bool flog_flush(void)
+{
+    uint8_t words;
+
+    if (!flog_dirty || !flog_open){
+        return true;
+    }
+    flog_dirty = false;
+    flog_cache_addr = FLASH_END;
+    // last word is completed by fillers, next reading goes to new word
+    words = (uint8_t)((flog_pos + 2) / 3);
+    flog_pos = (uint8_t)(3 * words);
+    if (!flash_write_words(FLOG_ROW_ADDR(flog_head) + 2 * flog_written,
+            flog_row + 3 * flog_written, words - flog_written)){
+        return false;
+    }
+    flog_written = words;
+    return true;
+}
+
+void flog_append(uint32_t now, int16_t value)
+{
+    uint32_t time = flog_epoch + now;
+    uint32_t dt = time - flog_time;
+    int16_t dv = (int16_t)(value - flog_value);
+    uint8_t rec[5];
+    uint8_t len = 0, i;
+
+    if (!flog_open || dt > 0xFFFF){
+        len = 0;
+    } else if (dt < 16 && dv >= -4 && dv < 4){
+        rec[0] = (uint8_t)(dt << 3 | (dv & 7));
+        len = 1;
+    } else if (dt < 256 && dv >= -32 && dv < 32){
+        rec[0] = (uint8_t)(0x80 | (dv & 0x3F));
+        rec[1] = (uint8_t)dt;
+        len = 2;
+    } else {
+        rec[0] = FLOG_ABSOLUTE;
+        rec[1] = (uint8_t)dt;
+        rec[2] = (uint8_t)(dt >> 8);
+        rec[3] = (uint8_t)value;
+        rec[4] = (uint8_t)((uint16_t)value >> 8);
+        len = 5;
+    }
+    if (!len || flog_pos + len > FLASH_ROW_BYTES){
+        // reading is keyframe of new row
+        flog_flush();
+        if (!flog_new_row(time, value)){
+            return;
+        }
+    } else {
+        for (i = 0; i < len; i++){
+            flog_row[flog_pos++] = rec[i];
+        }
+    }
+    if (!flog_dirty){
+        flog_dirty = true;
+        flog_pending = time;
+    }
+    flog_time = time;
+    flog_value = value;
+    flog_n++;
+    if (time - flog_pending >= FLOG_FLUSH_S){
+        flog_flush();
+    }
+}
+
+uint32_t flog_count(void)
+{
+    return flog_n;
+}
+
+bool flog_span(uint32_t *first, uint32_t *last)
+{
+    int16_t v;
+
+    if (!flog_used){
+        return false;
+    }
+    flog_key(flog_oldest(), first, &v);
+    *last = flog_time;
+    return true;
+}
+
+bool flog_seek(flog_iter_t *it, uint32_t from)
+{
+    flog_iter_t prev;
+    uint16_t lo = 0, hi, mid;
+    uint32_t t;
+    int16_t v;
+
+    if (!flog_used){
+        return false;
+    }
+    // last row with keyframe at or before 'from' (or oldest one)
+    hi = flog_used - 1;
+    while (lo < hi){
+        mid = (uint16_t)((lo + hi + 1) / 2);
+        flog_key(flog_row_add(flog_oldest(), mid), &t, &v);
+        if (t <= from){
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    it->row = flog_row_add(flog_oldest(), lo);
+    it->left = flog_used - 1 - lo;
+    it->key = true;
+    it->pos = 0;
+    for (;;){
+        prev = *it;
+        if (!flog_next(it, &t, &v)){
+            return false;
+        }
+        if (t >= from){
+            *it = prev;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+/**
+  @File Name
+    common/flog.h
+
+  @Summary
+    Temperature logger - circular journal of readings in program flash.
+
+  @Description
+    Readings (time in seconds, 16-bit value) are logged to FLOG_PAGES
+    flash pages from FLOG_BASE (see flash.h), used round robin as ring
+    of FLOG_ROWS rows. Every row starts with keyframe, rest is deltas:
+
+      bytes 0..3    sequence number of row (erased - free row)
+      bytes 4..7    time of first reading [s]
+      bytes 8..9    its value
+      bytes 10..191 records of following readings (dt - time since
+                    previous one, dv - change of value):
+        0ttttvvv                    dt 0..15, dv -4..3    (1 byte)
+        10vvvvvv tttttttt           dt 0..255, dv -32..31 (2 bytes)
+        11000000 dt:16 value:16     dt 0..65535, absolute (5 bytes)
+        11111111                    filler (erased)
+      (multi-byte fields little endian)
+
+    So each row decodes on its own and slowly changing temperature
+    takes 1 byte per reading (~180 readings per row). Row is collected
+    in RAM and written with one row write when full, or partially
+    (new words only) when its oldest unwritten reading is FLOG_FLUSH_S
+    old - at most that much is lost on power failure. Page is erased
+    when ring enters it (it holds the oldest rows), so all pages wear
+    the same, one erase per 8 rows.
+
+    Time is given by caller in seconds since boot, log continues from
+    last logged reading (flog_init()), so log time counts seconds the
+    device was running - without RTC power-off time is unknown.
+
+    Readers walk rows by sequence: flog_seek() finds the row of given
+    time by binary search over keyframes (few flash reads), then
+    flog_next() decodes readings, including those still in RAM.
+*/
+
+#ifndef FLOG_H
+#define	FLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash.h"
+
+// flash area (whole pages, below dee.h area)
+#ifndef FLOG_BASE
+#define FLOG_BASE   0x8000UL
+#endif
+#ifndef FLOG_PAGES
+#define FLOG_PAGES  8
+#endif
+// longest time [s] reading stays only in RAM
+#ifndef FLOG_FLUSH_S
+#define FLOG_FLUSH_S 600
+#endif
+
+#define FLOG_ROWS_PER_PAGE (FLASH_PAGE_SIZE / FLASH_ROW_SIZE)
+#define FLOG_ROWS   (FLOG_PAGES * FLOG_ROWS_PER_PAGE)
+#define FLOG_HEADER 10
+
+// position of reader
+typedef struct {
+    uint16_t left;   // rows left after current one
+    uint16_t row;    // current row
+    uint8_t pos;     // next byte in row
+    bool key;        // keyframe of row not yet returned
+    uint32_t time;   // last reading
+    int16_t value;
+} flog_iter_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// finds newest row and continues in it (time from its last reading)
+void flog_init(void);
+// logs reading, 'now' is time since boot [s], CPU stalls when row is
+// written or page erased (see flash.h)
+void flog_append(uint32_t now, int16_t value);
+// writes readings collected in RAM, returns false on flash error
+bool flog_flush(void);
+// number of readings logged since flog_init() (flash and RAM)
+uint32_t flog_count(void);
+// time span of log [s], returns false when log is empty
+bool flog_span(uint32_t *first, uint32_t *last);
+// positions reader before first reading at or after 'from' (log time),
+// returns false when there is none
+bool flog_seek(flog_iter_t *it, uint32_t from);
+// next reading, returns false at end of log
+bool flog_next(flog_iter_t *it, uint32_t *time, int16_t *value);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FLOG_H */
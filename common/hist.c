@@ -0,0 +1,288 @@
+/**
+  @File Name
+    common/hist.c
+
+  @Summary
+    Temperature history in RAM - see hist.h
+*/
+
+#include "hist.h"
+
+#if HIST_BYTES & (HIST_BYTES - 1)
+#error "HIST_BYTES must be power of 2"
+#endif
+#define HIST_MASK       (HIST_BYTES - 1)
+// dt of record followed by whole dt
+#define HIST_DT_LONG    15
+// longest record: 20 bits (3 bytes) + 32-bit dt (5 bytes)
+#define HIST_RECORD_MAX 8
+
+// bucket length of windows [s]
+static const uint16_t hist_bucket_s[HIST_WINDOWS] = { 5, 300, 7200 };
+
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int32_t sum;
+    uint16_t count;    // 0 - empty
+} hist_bucket_t;
+
+typedef struct {
+    uint32_t end;      // end of current bucket [s]
+    uint8_t current;   // index of current bucket
+    hist_bucket_t bucket[HIST_BUCKETS];
+    // all buckets combined
+    int16_t min;
+    int16_t max;
+    int32_t sum;
+    uint32_t count;
+} hist_win_t;
+
+static hist_win_t hist_win[HIST_WINDOWS];
+
+// ring of records, oldest reading is kept whole
+static uint8_t hist_ring[HIST_BYTES];
+static uint16_t hist_tail = 0;   // oldest record
+static uint16_t hist_bytes = 0;  // used by records
+static uint16_t hist_n = 0;      // readings (records + oldest)
+static uint32_t hist_first_time;
+static int16_t hist_first_value;
+static uint32_t hist_last_time;
+static int16_t hist_last_value;
+
+// recomputes combined values of window from its buckets
+static void hist_merge(hist_win_t *w)
+{
+    const hist_bucket_t *b;
+    uint8_t i;
+
+    w->count = 0;
+    w->sum = 0;
+    for (i = 0; i < HIST_BUCKETS; i++){
+        b = &w->bucket[i];
+        if (!b->count){
+            continue;
+        }
+        if (!w->count || b->min < w->min){
+            w->min = b->min;
+        }
+        if (!w->count || b->max > w->max){
+            w->max = b->max;
+        }
+        w->sum += b->sum;
+        w->count += b->count;
+    }
+}
+
+// moves window to bucket of 'now': buckets passed since then are
+// cleared (all of them after long gap) and the rest merged again
+static void hist_roll(hist_win_t *w, uint16_t len, uint32_t now)
+{
+    uint32_t steps;
+
+    if (now < w->end){
+        return;
+    }
+    steps = (now - w->end) / len + 1;
+    w->end += steps * len;
+    if (steps > HIST_BUCKETS){
+        steps = HIST_BUCKETS;
+    }
+    do {
+        w->current = w->current + 1 == HIST_BUCKETS ? 0 : w->current + 1;
+        w->bucket[w->current].count = 0;
+        w->bucket[w->current].sum = 0;
+    } while (--steps);
+    hist_merge(w);
+}
+
+// adds reading to current bucket and combined values
+static void hist_add(hist_win_t *w, int16_t value)
+{
+    hist_bucket_t *b = &w->bucket[w->current];
+
+    if (!b->count || value < b->min){
+        b->min = value;
+    }
+    if (!b->count || value > b->max){
+        b->max = value;
+    }
+    b->sum += value;
+    b->count++;
+    if (!w->count || value < w->min){
+        w->min = value;
+    }
+    if (!w->count || value > w->max){
+        w->max = value;
+    }
+    w->sum += value;
+    w->count++;
+}
+
+// variable-length number to b, returns its bytes
+static uint8_t hist_put(uint8_t *b, uint32_t v)
+{
+    uint8_t n = 0;
+
+    while (v >= 0x80){
+        b[n++] = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    b[n++] = (uint8_t)v;
+    return n;
+}
+
+// variable-length number from ring at *pos (moved past it)
+static uint32_t hist_get(uint16_t *pos)
+{
+    uint32_t v = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+
+    do {
+        b = hist_ring[*pos];
+        *pos = (*pos + 1) & HIST_MASK;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return v;
+}
+
+// decodes record at *pos (moved past it)
+static void hist_record(uint16_t *pos, uint32_t *dt, int16_t *dv)
+{
+    uint32_t v = hist_get(pos);
+    uint16_t zz = (uint16_t)(v >> 4);
+
+    *dt = v & 0x0F;
+    if (*dt == HIST_DT_LONG){
+        *dt = hist_get(pos);
+    }
+    *dv = (int16_t)((zz >> 1) ^ (uint16_t)-(zz & 1));
+}
+
+// drops oldest record, reading after it becomes the whole one
+static void hist_drop(void)
+{
+    uint16_t pos = hist_tail;
+    uint32_t dt;
+    int16_t dv;
+
+    hist_record(&pos, &dt, &dv);
+    hist_first_time += dt;
+    hist_first_value += dv;
+    hist_bytes -= (pos - hist_tail) & HIST_MASK;
+    hist_tail = pos;
+    hist_n--;
+}
+
+void hist_init(void)
+{
+    uint8_t w;
+
+    for (w = 0; w < HIST_WINDOWS; w++){
+        hist_win[w].end = 0;
+        hist_win[w].count = 0;
+    }
+    hist_tail = 0;
+    hist_bytes = 0;
+    hist_n = 0;
+}
+
+void hist_append(uint32_t now, int16_t value)
+{
+    uint8_t rec[HIST_RECORD_MAX];
+    uint8_t len, i;
+    uint32_t dt;
+    uint16_t dv, zz;
+
+    for (i = 0; i < HIST_WINDOWS; i++){
+        hist_roll(&hist_win[i], hist_bucket_s[i], now);
+        hist_add(&hist_win[i], value);
+    }
+    if (!hist_n){
+        hist_first_time = now;
+        hist_first_value = value;
+    } else {
+        // modulo 2^16 - any change of 16-bit value fits
+        dt = now - hist_last_time;
+        dv = (uint16_t)value - (uint16_t)hist_last_value;
+        zz = (uint16_t)(dv << 1) ^ (uint16_t)-(dv >> 15);
+        if (dt < HIST_DT_LONG){
+            len = hist_put(rec, (uint32_t)zz << 4 | dt);
+        } else {
+            len = hist_put(rec, (uint32_t)zz << 4 | HIST_DT_LONG);
+            len += hist_put(rec + len, dt);
+        }
+        while (HIST_BYTES - hist_bytes < len){
+            hist_drop();
+        }
+        for (i = 0; i < len; i++){
+            hist_ring[(hist_tail + hist_bytes++) & HIST_MASK] = rec[i];
+        }
+    }
+    hist_n++;
+    hist_last_time = now;
+    hist_last_value = value;
+}
+
+bool hist_stats(hist_window_t window, uint32_t now, hist_stats_t *s)
+{
+    hist_win_t *w = &hist_win[window];
+    int32_t half;
+
+    hist_roll(w, hist_bucket_s[window], now);
+    if (!w->count){
+        return false;
+    }
+    s->min = w->min;
+    s->max = w->max;
+    s->count = w->count;
+    half = (int32_t)(w->count / 2);
+    s->mean = (int16_t)((w->sum + (w->sum < 0 ? -half : half)) / (int32_t)w->count);
+    return true;
+}
+
+uint16_t hist_count(void)
+{
+    return hist_n;
+}
+
+uint16_t hist_used(void)
+{
+    return hist_bytes;
+}
+
+bool hist_first(hist_iter_t *it)
+{
+    if (!hist_n){
+        return false;
+    }
+    it->pos = hist_tail;
+    it->left = hist_n - 1;
+    it->first = true;
+    it->time = hist_first_time;
+    it->value = hist_first_value;
+    return true;
+}
+
+bool hist_next(hist_iter_t *it, uint32_t *time, int16_t *value)
+{
+    uint32_t dt;
+    int16_t dv;
+
+    if (it->first){
+        it->first = false;
+    } else {
+        if (!it->left){
+            return false;
+        }
+        hist_record(&it->pos, &dt, &dv);
+        it->left--;
+        it->time += dt;
+        it->value += dv;
+    }
+    *time = it->time;
+    *value = it->value;
+    return true;
+}
@@ -0,0 +1,109 @@
+/**
+  @File Name
+    common/hist.h
+
+  @Summary
+    Temperature history in RAM - delta compressed readings and sliding
+    window min/max/mean without rescanning them.
+
+  @Description
+    Readings (time in seconds, 16-bit value) are kept in ring of
+    HIST_BYTES bytes. Oldest reading is stored whole (outside of ring),
+    each following one as record of its change since previous reading
+    (dt - seconds, dv - value), both as variable-length unsigned numbers
+    (7 bits per byte, bit 7 - more bytes follow):
+
+      (zigzag(dv) << 4) | dt      dt 0..14
+      (zigzag(dv) << 4) | 15, dt  dt 15 and more
+
+    zigzag maps 0, -1, 1, -2 ... to 0, 1, 2, 3 ..., so slowly changing
+    temperature (dv -4..3, dt below 15 s) takes 1 byte per reading -
+    2 KB keep ~2000 readings, hours at adaptive sampling rates. When
+    ring is full, oldest record is decoded into the whole reading and
+    dropped (constant time per appended reading).
+
+    Statistics of sliding windows (HIST_WINDOWS, 1 min, 1 h, 24 h) are
+    not computed from the ring - 24 h do not fit there anyway. Each
+    window is divided into HIST_BUCKETS buckets of fixed length (bucket
+    number is time / length), every bucket keeps min, max, sum and count
+    of its readings and window keeps them combined over all buckets:
+
+    - hist_append() updates current bucket and combined values of each
+      window - O(1)
+    - when time moves to next bucket, the oldest one is cleared and
+      combined values are merged again from HIST_BUCKETS buckets - once
+      per bucket length (5 s, 5 min, 2 h), not per reading or query
+    - hist_stats() returns combined values - O(1)
+
+    So window covers current bucket and HIST_BUCKETS - 1 previous ones,
+    for example 1 h window is readings of last 55..60 minutes.
+
+    Time is given by caller in seconds since boot (as in flog.h), it
+    must not go back.
+*/
+
+#ifndef HIST_H
+#define	HIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ring size, power of 2
+#ifndef HIST_BYTES
+#define HIST_BYTES   2048
+#endif
+// buckets of each window
+#ifndef HIST_BUCKETS
+#define HIST_BUCKETS 12
+#endif
+
+// sliding windows
+typedef enum {
+    HIST_1MIN = 0,  // buckets of 5 s
+    HIST_1H,        // 5 min
+    HIST_24H,       // 2 h
+    HIST_WINDOWS
+} hist_window_t;
+
+// statistics of window
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t mean;    // rounded
+    uint32_t count;  // readings
+} hist_stats_t;
+
+// position of reader
+typedef struct {
+    uint16_t pos;    // next record in ring
+    uint16_t left;   // records left
+    bool first;      // oldest reading not yet returned
+    uint32_t time;   // last reading
+    int16_t value;
+} hist_iter_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// empty history and windows
+void hist_init(void);
+// adds reading, 'now' is time since boot [s]
+void hist_append(uint32_t now, int16_t value);
+// statistics of window at time 'now' (not before last reading),
+// returns false when window has no reading
+bool hist_stats(hist_window_t window, uint32_t now, hist_stats_t *s);
+// number of readings in ring
+uint16_t hist_count(void);
+// bytes of ring used by records
+uint16_t hist_used(void);
+// positions reader before oldest reading, returns false when empty
+bool hist_first(hist_iter_t *it);
+// next reading, returns false at end of history
+bool hist_next(hist_iter_t *it, uint32_t *time, int16_t *value);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HIST_H */
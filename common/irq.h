@@ -0,0 +1,74 @@
+/**
+  @File Name
+    common/irq.h
+
+  @Summary
+    Interrupt priority plan and critical sections.
+
+  @Description
+    Interrupt nesting is enabled (INTCON1.NSTDIS = 0, reset default), so
+    ISR with higher priority preempts ISR with lower one. All projects
+    use this priority plan (CPU IPL):
+
+      7     IRQ_IPL_ALL      - masks all user interrupts (traps only)
+      5..6                   - free
+      4     IRQ_IPL_ONEWIRE  - 1-wire time slots (main code raises IPL)
+      2..3  IRQ_IPL_COMM     - communication (UART), must preempt display
+      1     IRQ_IPL_TICK     - TMR1 tick: display multiplex, scheduler
+      0                      - main code
+
+    TMR1 ISR stays at the lowest level so any other interrupt preempts
+    display multiplex. Timing critical code in main context raises CPU
+    IPL only for the few microseconds that must not be stretched and
+    restores it right after - lower priority interrupts are delayed,
+    not lost (TMR1 tick latency is at most one 1-wire slot, ~65 us).
+
+    Unlike DISI (max 16383 cycles, does not nest, masks only IPL 1..6)
+    irq_raise()/irq_restore() nest and never lower current priority, so
+    they are safe also in ISRs.
+
+    Example:
+        irq_state_t s = irq_raise(IRQ_IPL_ONEWIRE);
+        ... up to ~100 us of timing critical code ...
+        irq_restore(s);
+*/
+
+#ifndef IRQ_H
+#define	IRQ_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#define IRQ_IPL_TICK     1
+#define IRQ_IPL_COMM     2
+#define IRQ_IPL_ONEWIRE  4
+#define IRQ_IPL_ALL      7
+
+// previous CPU IPL returned by irq_raise()
+typedef uint8_t irq_state_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// raises CPU IPL to at least 'ipl', returns previous IPL
+static inline irq_state_t irq_raise(uint8_t ipl)
+{
+    irq_state_t old = (irq_state_t)SRbits.IPL;
+    if (ipl > old){
+        SET_CPU_IPL(ipl);
+    }
+    return old;
+}
+
+// restores CPU IPL saved by irq_raise()
+static inline void irq_restore(irq_state_t old)
+{
+    SET_CPU_IPL(old);
+}
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* IRQ_H */
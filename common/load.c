@@ -0,0 +1,116 @@
+/**
+  @File Name
+    common/load.c
+
+  @Summary
+    CPU load meter based on idle-loop calibration.
+    See load.h for details.
+*/
+
+#include <xc.h>
+#include <stdbool.h>
+#include "load.h"
+#include "out.h"
+
+volatile uint16_t load_ticks = 0;
+uint16_t load_permille = 0;
+
+// modified only from main loop - no locking needed
+static uint32_t load_idle_count = 0;
+// reference: load_ref_count idle iterations in load_ref_period timer counts
+static uint32_t load_ref_count = 0;
+static uint32_t load_ref_period = 0;
+// state at previous load_update()
+static uint16_t load_last_ticks = 0;
+static uint32_t load_last_count = 0;
+
+void load_idle(void)
+{
+    // Nop() also lets host simulator advance time
+    Nop();
+    load_idle_count++;
+}
+
+// timer counts spent by 'count' iterations (must be shorter than period),
+// called with TMR1 interrupt masked
+static uint32_t load_measure(void (*iteration)(void), uint16_t count,
+                             uint32_t period)
+{
+    uint16_t t0, t1;
+    bool rollover;
+
+    do {
+        IFS0bits.T1IF = 0;
+        t0 = TMR1;
+    } while (IFS0bits.T1IF);
+    // nothing else in loop, so that it costs the same as real idle loop
+    while (count--){
+        iteration();
+    }
+    do {
+        rollover = IFS0bits.T1IF;
+        t1 = TMR1;
+    } while (rollover != IFS0bits.T1IF);
+    return (rollover ? period : 0) + t1 - t0;
+}
+
+void load_calibrate(void (*iteration)(void), uint16_t ticks)
+{
+    bool t1ie = IEC0bits.T1IE;
+    uint32_t period = (uint32_t)PR1 + 1;
+    uint32_t total = (uint32_t)ticks * period;
+    uint32_t elapsed = 0;
+    uint32_t count = 0;
+    uint16_t block = 1;
+
+    // no timer interrupts (and thus no tasks) during calibration
+    IEC0bits.T1IE = 0;
+    // find block of iterations that takes 1/4..1/2 of timer period
+    while (block < 0x4000 && load_measure(iteration, block, period) < period / 4){
+        block <<= 1;
+    }
+    while (elapsed < total){
+        elapsed += load_measure(iteration, block, period);
+        count += block;
+    }
+    // count of idle iterations is not affected by calibration itself
+    load_ref_count = count;
+    load_ref_period = elapsed;
+    // ticks skipped during calibration are lost (time stood still)
+    IFS0bits.T1IF = 0;
+    IEC0bits.T1IE = t1ie;
+
+    load_last_ticks = load_ticks;
+    load_last_count = load_idle_count;
+}
+
+uint16_t load_update(void)
+{
+    uint16_t ticks = load_ticks;
+    uint16_t dt = ticks - load_last_ticks;
+    uint32_t idle = load_idle_count - load_last_count;
+    uint32_t idle_permille;
+
+    if (dt == 0 || load_ref_count == 0){
+        return load_permille;
+    }
+    load_last_ticks = ticks;
+    load_last_count = load_idle_count;
+
+    idle_permille = (uint32_t)((uint64_t)idle * load_ref_period * LOAD_FULL /
+                   ((uint64_t)load_ref_count * dt * ((uint32_t)PR1 + 1)));
+    load_permille = idle_permille >= LOAD_FULL ?
+                    0 : (uint16_t)(LOAD_FULL - idle_permille);
+    return load_permille;
+}
+
+void load_print(void (*out)(char c))
+{
+    uint16_t v = load_permille;
+
+    out_str(out, "load ");
+    out_u32(out, v / 10);
+    out('.');
+    out((char)('0' + v % 10));
+    out_str(out, "%\r\n");
+}
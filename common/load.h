@@ -0,0 +1,61 @@
+/**
+  @File Name
+    common/load.h
+
+  @Summary
+    CPU load meter based on idle-loop calibration.
+
+  @Description
+    Main loop calls load_idle() whenever it has nothing to do, which
+    counts idle iterations. At boot load_calibrate() measures how many
+    iterations fit into TMR1 period with no load (timer interrupt masked,
+    no tasks ready). Load is then:
+
+        load = 1 - idle_iterations / (reference_per_tick * elapsed_ticks)
+
+    Timer period is read from PR1, so any TMR1 setup (and prescaler) works.
+
+    There is no extra hardware or interrupt cost - only one counter
+    increment per idle iteration. Resolution is limited by duration of
+    one idle iteration (tens of cycles), so values below ~1% are noise.
+
+    Usage:
+    - call load_tick() from periodic timer ISR (TMR1)
+    - call load_calibrate() once at boot with function that does exactly
+      one iteration of main loop (including load_idle()); no task may be
+      ready and TMR1 must be running
+    - call load_update() from main loop (typically every second),
+      result is also kept in load_permille
+*/
+
+#ifndef LOAD_H
+#define	LOAD_H
+
+#include <stdint.h>
+
+// load_permille value of fully loaded CPU
+#define LOAD_FULL 1000U
+
+// incremented from timer ISR by load_tick()
+extern volatile uint16_t load_ticks;
+// last computed load (0 = idle, LOAD_FULL = saturated)
+extern uint16_t load_permille;
+
+// must be called from periodic timer ISR
+static inline void load_tick(void)
+{
+    load_ticks++;
+}
+
+// one iteration of idle loop - call only from main loop
+void load_idle(void);
+// measures reference idle iterations during 'ticks' timer periods
+void load_calibrate(void (*iteration)(void), uint16_t ticks);
+// computes load since previous call, returns load_permille
+uint16_t load_update(void);
+// longest line of load_print()
+#define LOAD_LINE_MAX 13
+// writes "load 12.3%" line using putc-like function
+void load_print(void (*out)(char c));
+
+#endif	/* LOAD_H */
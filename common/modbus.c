@@ -0,0 +1,245 @@
+/**
+  @File Name
+    common/modbus.c
+
+  @Summary
+    Modbus RTU slave on UART1. See modbus.h for details.
+*/
+
+#include "modbus.h"
+
+#if MODBUS_ENABLE
+
+#include <stdbool.h>
+#include <xc.h>
+#include "irq.h"
+#include "uart.h"
+
+// TMR4 runs at Fcy/8, ticks of 'us'
+#define MODBUS_TMR_US(us) ((UART_FCY / 8000UL) * (us) / 1000UL)
+#if UART_BAUD > 19200UL
+#define MODBUS_T15_US 750UL
+#define MODBUS_T35_US 1750UL
+#else
+#define MODBUS_T15_US (16500000UL / UART_BAUD)
+#define MODBUS_T35_US (38500000UL / UART_BAUD)
+#endif
+// 8N1 character on line
+#define MODBUS_CHAR_US (10000000UL / UART_BAUD)
+
+#if MODBUS_TMR_US(MODBUS_T35_US) < 2 || MODBUS_TMR_US(MODBUS_T35_US) > 0x10000UL
+#error "t3.5 does not fit to TMR4 at Fcy/8"
+#endif
+
+// RX ISR runs char + silence after previous one
+#define MODBUS_GAP_MAX MODBUS_TMR_US(MODBUS_CHAR_US + MODBUS_T15_US)
+
+// address, function, CRC
+#define MODBUS_FRAME_MIN 4
+
+typedef enum {
+    MODBUS_INIT = 0,    // waits for t3.5 of silence
+    MODBUS_IDLE,        // waits for first byte
+    MODBUS_RECEIVING,   // frame in progress
+    MODBUS_BAD,         // frame in progress, dropped at its end
+    MODBUS_READY,       // frame waits for modbus_poll()
+} modbus_state_t;
+
+uint8_t modbus_address = 1;
+uint16_t modbus_requests = 0;
+uint16_t modbus_exceptions = 0;
+uint16_t modbus_crc_errors = 0;
+volatile uint16_t modbus_frame_errors = 0;
+volatile uint16_t modbus_ignored = 0;
+
+static volatile modbus_state_t modbus_state = MODBUS_INIT;
+// request, answer is built over it
+static uint8_t modbus_frame[MODBUS_FRAME_MAX];
+static volatile uint16_t modbus_len = 0;
+
+// CRC of 4-bit value in low nibble
+static const uint16_t MODBUS_CRC_NIBBLE[16] = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+};
+
+uint16_t modbus_crc(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--){
+        crc = (crc >> 4) ^ MODBUS_CRC_NIBBLE[(crc ^ *data) & 0x0F];
+        crc = (crc >> 4) ^ MODBUS_CRC_NIBBLE[(crc ^ (*data >> 4)) & 0x0F];
+        data++;
+    }
+    return crc;
+}
+
+void modbus_init(uint8_t address)
+{
+    modbus_address = address;
+    modbus_state = MODBUS_INIT;
+    T4CON = 0x0010;         // stopped, Fcy/8, 16-bit
+    TMR4 = 0;
+    PR4 = (uint16_t)(MODBUS_TMR_US(MODBUS_T35_US) - 1);
+    IPC6bits.T4IP = IRQ_IPL_COMM;
+    IFS1bits.T4IF = 0;
+    IEC1bits.T4IE = 1;
+    // silence of t3.5 before first frame
+    T4CONbits.TON = 1;
+}
+
+// t3.5 of silence - end of frame (ISR context)
+static void modbus_frame_end(void)
+{
+    IFS1bits.T4IF = 0;
+    T4CONbits.TON = 0;
+    switch (modbus_state){
+        case MODBUS_INIT:
+            modbus_state = MODBUS_IDLE;
+            break;
+        case MODBUS_RECEIVING:
+            if (modbus_len >= MODBUS_FRAME_MIN){
+                modbus_state = MODBUS_READY;
+                break;
+            }
+            // fall through - too short
+        case MODBUS_BAD:
+            modbus_frame_errors++;
+            modbus_state = MODBUS_IDLE;
+            break;
+        default:
+            break;
+    }
+}
+
+void __attribute__((interrupt, no_auto_psv)) _T4Interrupt(void)
+{
+    modbus_frame_end();
+}
+
+void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void)
+{
+    uint16_t gap = TMR4;    // since previous byte
+    uint16_t len = modbus_len;
+    modbus_state_t state;
+    uint8_t b;
+
+    IFS0bits.U1RXIF = 0;
+    if (IFS1bits.T4IF){
+        // t3.5 elapsed before this byte, T4 ISR did not run yet
+        modbus_frame_end();
+        gap = 0;
+    }
+    state = modbus_state;
+    if (U1STAbits.OERR){
+        // FIFO overrun, its content is lost by clearing OERR
+        U1STAbits.OERR = 0;
+        if (state == MODBUS_RECEIVING){
+            state = MODBUS_BAD;
+        }
+    }
+    while (U1STAbits.URXDA){
+        b = (uint8_t)U1RXREG;
+        switch (state){
+            case MODBUS_IDLE:
+                len = 0;
+                state = MODBUS_RECEIVING;
+                // fall through
+            case MODBUS_RECEIVING:
+                if (len == MODBUS_FRAME_MAX || (len && gap > MODBUS_GAP_MAX)){
+                    state = MODBUS_BAD;
+                    break;
+                }
+                modbus_frame[len++] = b;
+                break;
+            case MODBUS_READY:
+                modbus_ignored++;
+                break;
+            default:
+                break;
+        }
+        // more bytes in FIFO came right after this one
+        gap = 0;
+    }
+    modbus_len = len;
+    modbus_state = state;
+    // restart t3.5
+    TMR4 = 0;
+    T4CONbits.TON = 1;
+}
+
+// answers exception, returns answer length
+static uint8_t modbus_exception(uint8_t *f, uint8_t code)
+{
+    f[1] |= MODBUS_FC_ERROR;
+    f[2] = code;
+    modbus_exceptions++;
+    return 3;
+}
+
+// request of 'len' bytes without CRC, answer is built over it, returns
+// its length without CRC
+static uint16_t modbus_handle(uint8_t *f, uint16_t len)
+{
+    uint16_t addr, count;
+    uint8_t ex;
+
+    switch (f[1]){
+        case MODBUS_FC_READ_INPUT:
+            if (len != 6){
+                return modbus_exception(f, MODBUS_EX_VALUE);
+            }
+            addr = (uint16_t)f[2] << 8 | f[3];
+            count = (uint16_t)f[4] << 8 | f[5];
+            if (count < 1 || count > MODBUS_INPUT_MAX){
+                return modbus_exception(f, MODBUS_EX_VALUE);
+            }
+            if ((uint32_t)addr + count > 0x10000UL){
+                return modbus_exception(f, MODBUS_EX_ADDRESS);
+            }
+            // registers go over address and count
+            ex = modbus_read_inputs(addr, count, &f[3]);
+            if (ex != MODBUS_EX_NONE){
+                return modbus_exception(f, ex);
+            }
+            f[2] = (uint8_t)(2 * count);
+            return 3 + 2 * count;
+        case MODBUS_FC_DIAGNOSTICS:
+            if (len < 4 || f[2] || f[3]){
+                return modbus_exception(f, MODBUS_EX_FUNCTION);
+            }
+            // Return Query Data - echo
+            return len;
+        default:
+            return modbus_exception(f, MODBUS_EX_FUNCTION);
+    }
+}
+
+void modbus_poll(void)
+{
+    uint8_t *f = modbus_frame;
+    uint16_t len, crc;
+
+    if (modbus_state != MODBUS_READY){
+        return;
+    }
+    len = modbus_len - 2;
+    crc = modbus_crc(f, len);
+    if (crc != ((uint16_t)f[len] | (uint16_t)f[len + 1] << 8)){
+        modbus_crc_errors++;
+    } else if (f[0] == modbus_address){
+        modbus_requests++;
+        len = modbus_handle(f, len);
+        crc = modbus_crc(f, len);
+        f[len++] = (uint8_t)crc;
+        f[len++] = (uint8_t)(crc >> 8);
+        // TX ring is empty (master waits for previous answer), only
+        // echo of longest frame does not fit (counted in uart_tx_dropped)
+        uart_write(f, len);
+    }
+    // frame buffer is free, ISR may fill it again
+    modbus_state = MODBUS_IDLE;
+}
+
+#endif
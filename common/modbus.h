@@ -0,0 +1,106 @@
+/**
+  @File Name
+    common/modbus.h
+
+  @Summary
+    Modbus RTU slave on UART1 - input registers of application.
+
+  @Description
+    Built only with MODBUS_ENABLE=1 (project macro, all files): UART1
+    then carries Modbus frames only - uart.c leaves receiver to this
+    module and discards text written by uart_putc(), projects do not
+    start console tasks (trace, profiler, telemetry). Line is 8N1 at
+    UART_BAUD (uart.h), RS-485 transceiver with automatic direction
+    control is assumed.
+
+    Receive state machine runs in ISRs (both IRQ_IPL_COMM, see irq.h,
+    so they never preempt each other; display tick is preempted,
+    1-wire slots delay them by at most ~65 us):
+    - U1RX ISR stores bytes in linear frame buffer and restarts TMR4;
+      gap longer than t1.5 inside frame, FIFO overrun or frame longer
+      than MODBUS_FRAME_MAX marks frame bad
+    - TMR4 period (t3.5 of silence) ends frame: bad or short one is
+      counted and dropped, good one waits for modbus_poll()
+    t1.5/t3.5 follow 11-bit characters up to 19200 Bd, above it they
+    are fixed 750/1750 us (Modbus over serial line, 2.5.1.1). Bytes
+    arriving while frame waits are dropped (master must wait for the
+    answer anyway); after modbus_init() line must be silent for t3.5
+    before first frame is accepted.
+
+    modbus_poll() (main loop, scheduler idle) checks CRC and address,
+    parses request in the frame buffer and builds answer over it (no
+    copy of request data), then queues it by uart_write(). 1-wire
+    transfers (owbus.c) block main loop for tens of ms, so owbus.c
+    calls modbus_poll() after each byte too: answer starts ~t3.5 after
+    request plus at most one 1-wire byte (~0.6 ms), other tasks or
+    flash stall (settings save, flash log row). Registers may then be
+    read in the middle of measurement (each of them is consistent).
+    Broadcast (address 0) is ignored - there are no write functions.
+
+    Functions:
+    - 04 Read Input Registers, 1..125 registers, data from
+      modbus_read_inputs() of application
+    - 08 Diagnostics, sub-function 0000 (Return Query Data) only
+    - others answer exception 01 (illegal function)
+
+    Host master: sim/modbus_master.cpp, sim/build/modbus-master.
+*/
+
+#ifndef MODBUS_H
+#define	MODBUS_H
+
+#include <stdint.h>
+
+#ifndef MODBUS_ENABLE
+#define MODBUS_ENABLE 0
+#endif
+
+// longest RTU frame (address, PDU of up to 253 bytes, CRC)
+#define MODBUS_FRAME_MAX 256
+
+#define MODBUS_FC_READ_INPUT  0x04
+#define MODBUS_FC_DIAGNOSTICS 0x08
+// function code of exception answer has this bit set
+#define MODBUS_FC_ERROR       0x80
+#define MODBUS_INPUT_MAX      125   // registers per read
+
+// exception codes
+#define MODBUS_EX_NONE     0x00
+#define MODBUS_EX_FUNCTION 0x01 // illegal function
+#define MODBUS_EX_ADDRESS  0x02 // illegal data address
+#define MODBUS_EX_VALUE    0x03 // illegal data value
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// slave address (1..247)
+extern uint8_t modbus_address;
+// requests for this slave with good CRC, those answered with exception
+extern uint16_t modbus_requests;
+extern uint16_t modbus_exceptions;
+// frames dropped: CRC, timing (t1.5 gap, overrun, length) and bytes
+// that came while frame waited for modbus_poll()
+extern uint16_t modbus_crc_errors;
+extern volatile uint16_t modbus_frame_errors;
+extern volatile uint16_t modbus_ignored;
+
+// CRC-16/MODBUS (reflected 0xA001, init 0xFFFF), sent low byte first
+uint16_t modbus_crc(const uint8_t *data, uint16_t len);
+
+// configures TMR4 (prescaler 1:8) and its interrupt, call after
+// uart_init() before interrupts are enabled
+void modbus_init(uint8_t address);
+// answers received frame (if any), call from main loop
+void modbus_poll(void);
+
+// provided by application: stores 'count' input registers from 'addr'
+// to 'data' (big-endian, 2 bytes each), returns MODBUS_EX_NONE or
+// exception code (MODBUS_EX_ADDRESS for unknown register)
+uint8_t modbus_read_inputs(uint16_t addr, uint16_t count, uint8_t *data);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* MODBUS_H */
@@ -0,0 +1,55 @@
+/**
+  @File Name
+    common/out.c
+
+  @Summary
+    Text output through putc-like function. See out.h for details.
+*/
+
+#include "out.h"
+
+void out_str(out_fn_t out, const char *s)
+{
+    while (*s){
+        out(*s++);
+    }
+}
+
+void out_u32(out_fn_t out, uint32_t v)
+{
+    char buf[11];
+    uint8_t i = sizeof(buf);
+
+    buf[--i] = '\0';
+    do {
+        buf[--i] = (char)('0' + (uint8_t)(v % 10));
+        v /= 10;
+    } while (v);
+    out_str(out, &buf[i]);
+}
+
+void out_u64(out_fn_t out, uint64_t v)
+{
+    char buf[21];
+    uint8_t i = sizeof(buf);
+
+    if (v <= UINT32_MAX){
+        out_u32(out, (uint32_t)v);
+        return;
+    }
+    buf[--i] = '\0';
+    do {
+        buf[--i] = (char)('0' + (uint8_t)(v % 10));
+        v /= 10;
+    } while (v);
+    out_str(out, &buf[i]);
+}
+
+void out_hex(out_fn_t out, uint32_t v, uint8_t digits)
+{
+    static const char HEX[] = "0123456789ABCDEF";
+
+    while (digits--){
+        out(HEX[(v >> (digits * 4)) & 0xf]);
+    }
+}
@@ -0,0 +1,41 @@
+/**
+  @File Name
+    common/out.h
+
+  @Summary
+    Text output of numbers and strings through putc-like function.
+
+  @Description
+    Diagnostic dumps (crash_report(), prof_dump(), stack_print(),
+    load_print()) write through 'out' given by caller (uart_putc() in
+    projects) and share these writers, uart_puts() and the rest of
+    uart.h text output are built on them too. No leading space, sign or
+    prefix is written.
+*/
+
+#ifndef OUT_H
+#define	OUT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// putc-like output function
+typedef void (*out_fn_t)(char c);
+
+// writes string without terminating zero
+void out_str(out_fn_t out, const char *s);
+// unsigned decimal
+void out_u32(out_fn_t out, uint32_t v);
+// unsigned decimal of 64-bit value (slow - long division)
+void out_u64(out_fn_t out, uint64_t v);
+// 'digits' lowest hexadecimal digits of v (upper case)
+void out_hex(out_fn_t out, uint32_t v, uint8_t digits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* OUT_H */
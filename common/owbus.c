@@ -0,0 +1,413 @@
+/**
+  @File Name
+    common/owbus.c
+
+  @Summary
+    Bit-parallel 1-wire driver - see owbus.h
+*/
+
+#include <xc.h>
+#include <stddef.h>
+#include "owbus.h"
+#include "crc8.h"
+#include "irq.h"
+#include "modbus.h"
+
+#define FCY OWBUS_FCY
+#include <libpic30.h>  // __delay_us()
+
+owbus_timing_t owbus_timing __attribute__((persistent));
+uint16_t owbus_rise[16];
+
+// pins driven together with buses
+static uint16_t owbus_debug = 0;
+
+// pull down all buses (and debug pins) with one LATB write - read,
+// modify and write (separate instructions without optimization), so
+// only at IRQ_IPL_ONEWIRE: TMR1 ISR writes display pins of port B
+#define OWBUS_LOW(m)  (LATB &= (uint16_t)~((m) | owbus_debug))
+// release all buses (pulled up by resistors)
+#define OWBUS_HIZ(m)  (LATB |= (uint16_t)((m) | owbus_debug))
+
+// after each byte, outside of time slots: Modbus slave answers requests
+// while sensors are read (turnaround time, see modbus.h), time between
+// slots is not limited
+#if MODBUS_ENABLE
+#define OWBUS_YIELD() modbus_poll()
+#else
+#define OWBUS_YIELD()
+#endif
+
+// limits of calibrated timing [cycles]
+#define OWBUS_SLOT        OWBUS_US(60)  // read slot (+ code overhead)
+#define OWBUS_LOW0        OWBUS_US(62)  // write 0, 60 us + FRC tolerance
+#define OWBUS_SAMPLE_MAX  OWBUS_US(13)  // RDV 15 us - 2 us margin
+#define OWBUS_HOLD_MARGIN OWBUS_US(3)   // sample before sensor releases
+#define OWBUS_POLL_MAX    OWBUS_US(80)  // polling of bus level
+#define OWBUS_RISE_MAX    OWBUS_US(15)  // recovery while calibrating
+
+static uint16_t owbus_sum(void)
+{
+    const uint16_t *w = (const uint16_t *)&owbus_timing;
+    uint16_t sum = 0;
+    uint8_t i;
+
+    for (i = 0; i < offsetof(owbus_timing_t, check) / 2; i++){
+        sum += w[i];
+    }
+    return (uint16_t)~sum;
+}
+
+void owbus_timing_default(void)
+{
+    owbus_timing.buses = 0;
+    owbus_timing.rise = 0;
+    owbus_timing.hold = 0;
+    owbus_timing.rlow = OWBUS_US(6);
+    owbus_timing.sample = OWBUS_US(4);
+    owbus_timing.rest = OWBUS_US(50);
+    owbus_timing.wlow = OWBUS_US(3);
+    owbus_timing.low0 = OWBUS_US(60);
+    owbus_timing.recovery = OWBUS_US(2);
+    owbus_timing.check = owbus_sum();
+}
+
+bool owbus_timing_valid(owbus_mask_t buses)
+{
+    return owbus_timing.check == owbus_sum() && owbus_timing.buses == buses;
+}
+
+void owbus_init(owbus_mask_t buses, uint16_t debug)
+{
+    irq_state_t irq;
+
+    owbus_debug = debug;
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    OWBUS_HIZ(buses);
+    irq_restore(irq);
+    ODCB |= buses;
+    TRISB &= (uint16_t)~buses;
+    if (owbus_timing.check != owbus_sum()){
+        owbus_timing_default();
+    }
+}
+
+owbus_mask_t owbus_reset(owbus_mask_t buses, owbus_mask_t *busy)
+{
+    irq_state_t irq;
+    owbus_mask_t present;
+
+    // settle lines in Hi-Z (open-drain released)
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    OWBUS_HIZ(buses);
+    irq_restore(irq);
+    __delay_us(20);
+    // DQ lines should be free, busy ones are left out
+    *busy = (owbus_mask_t)(~PORTB & buses);
+    buses &= (owbus_mask_t)~*busy;
+    if (!buses){
+        return 0;
+    }
+    // trigger reset (at least 480 us, may be longer - ISRs may run)
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    OWBUS_LOW(buses);
+    irq_restore(irq);
+    __delay_us(500);
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    // give sensors 70us to respond with presence pulse
+    OWBUS_HIZ(buses);
+    __delay_us(70);
+    // devices must hold DQ lines - presence pulse
+    present = (owbus_mask_t)(~PORTB & buses);
+    irq_restore(irq);
+    // finish at least 480 us after release (+2% for FRC tolerance), also
+    // without presence - next reset may follow at once
+    __delay_us(430);
+    OWBUS_YIELD();
+    return present;
+}
+
+void owbus_write_bits(owbus_mask_t buses, owbus_mask_t ones)
+{
+    irq_state_t irq;
+
+    // low time is 1..15 us for 1 and 60..120 us for 0
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    OWBUS_LOW(buses);
+    __delay32(owbus_timing.wlow);
+    ones &= buses;
+    if (ones == buses){
+        // all send 1 - debug pins follow them
+        OWBUS_HIZ(buses);
+    } else if (ones){
+        // release lines sending 1
+        LATB |= ones;
+    } else {
+        Nop();
+    }
+    // keep timeslot must be between 60 us and 120 us
+    __delay32(owbus_timing.low0);
+    OWBUS_HIZ(buses);
+    irq_restore(irq);
+    __delay32(owbus_timing.recovery);
+}
+
+void owbus_write_byte(owbus_mask_t buses, uint8_t data)
+{
+    uint8_t i;
+
+    // LSB first
+    for (i = 0; i < 8; i++){
+        owbus_write_bits(buses, data & 1 ? buses : 0);
+        data >>= 1;
+    }
+    OWBUS_YIELD();
+}
+
+void owbus_write_each(owbus_mask_t buses, const uint8_t *const data[16], uint8_t len)
+{
+    owbus_mask_t ones;
+    uint8_t i, bit, pin;
+
+    for (i = 0; i < len; i++){
+        for (bit = 0; bit < 8; bit++){
+            ones = 0;
+            for (pin = 0; pin < 16; pin++){
+                if ((buses & (1U << pin)) && (data[pin][i] >> bit) & 1){
+                    ones |= 1U << pin;
+                }
+            }
+            owbus_write_bits(buses, ones);
+        }
+        OWBUS_YIELD();
+    }
+}
+
+uint16_t owbus_read_bit(owbus_mask_t buses)
+{
+    irq_state_t irq;
+    uint16_t sample;
+
+    // sample must be within 15 us from falling edge
+    irq = irq_raise(IRQ_IPL_ONEWIRE);
+    OWBUS_LOW(buses);
+    __delay32(owbus_timing.rlow);
+    OWBUS_HIZ(buses);
+    // wait for response, then sample all buses at once
+    __delay32(owbus_timing.sample);
+    sample = PORTB;
+    irq_restore(irq);
+    // keep timeslot - total time must be between 60us and 120us
+    __delay32(owbus_timing.rest);
+    return sample;
+}
+
+void owbus_read(owbus_mask_t buses, uint16_t *samples, uint8_t bytes)
+{
+    uint16_t n = (uint16_t)bytes * 8;
+
+    while (n--){
+        *samples++ = owbus_read_bit(buses);
+        if (!(n & 7)){
+            OWBUS_YIELD();
+        }
+    }
+}
+
+void owbus_search_start(owbus_search_t *s, owbus_mask_t buses, uint8_t cmd)
+{
+    uint8_t pin;
+
+    s->cmd = cmd;
+    s->more = buses;
+    for (pin = 0; pin < 16; pin++){
+        s->last[pin] = 0;
+    }
+}
+
+owbus_mask_t owbus_search_next(owbus_search_t *s)
+{
+    // direction written in each of 64 bits (ROM codes, interleaved)
+    static uint16_t dirs[64];
+    uint8_t zero[16];
+    owbus_mask_t active, busy, id, cmp, conflict, ones;
+    uint8_t i, pin;
+
+    if (!s->more){
+        return 0;
+    }
+    active = owbus_reset(s->more, &busy);
+    if (active){
+        owbus_write_byte(active, s->cmd);
+    }
+    for (pin = 0; pin < 16; pin++){
+        zero[pin] = 0;
+    }
+    for (i = 0; i < 64 && active; i++){
+        // bit of all devices still in search and its complement
+        id = owbus_read_bit(active);
+        cmp = owbus_read_bit(active);
+        // both 1 - no device answered (none alarming, or lost)
+        active &= (owbus_mask_t)~(id & cmp);
+        // both 0 - devices differ in this bit
+        conflict = (owbus_mask_t)(~id & ~cmp & active);
+        ones = (owbus_mask_t)(id & active);
+        for (pin = 0; conflict && pin < 16; pin++){
+            if (!(conflict & (1U << pin))){
+                continue;
+            }
+            conflict &= (owbus_mask_t)~(1U << pin);
+            // repeat path of last pass, take 1 at last discrepancy,
+            // 0 at new ones (remembered for next pass)
+            if (i + 1 < s->last[pin]){
+                if ((s->rom[pin][i / 8] >> (i % 8)) & 1){
+                    ones |= 1U << pin;
+                } else {
+                    zero[pin] = i + 1;
+                }
+            } else if (i + 1 == s->last[pin]){
+                ones |= 1U << pin;
+            } else {
+                zero[pin] = i + 1;
+            }
+        }
+        owbus_write_bits(active, ones);
+        dirs[i] = ones;
+        if ((i & 7) == 7){
+            OWBUS_YIELD();
+        }
+    }
+    // buses that went through all 64 bits found a device
+    s->more = 0;
+    for (pin = 0; pin < 16; pin++){
+        if (!(active & (1U << pin))){
+            continue;
+        }
+        for (i = 0; i < 8; i++){
+            s->rom[pin][i] = owbus_byte(dirs, i, pin);
+        }
+        if (crc8(s->rom[pin], 8) != 0){
+            // noise on bus - search on it is abandoned
+            active &= (owbus_mask_t)~(1U << pin);
+            continue;
+        }
+        s->last[pin] = zero[pin];
+        if (zero[pin]){
+            s->more |= 1U << pin;
+        }
+    }
+    return active;
+}
+
+// TMR1 cycles since 'from' (TMR1 ISR may be masked, so not systime)
+static uint16_t owbus_elapsed(uint16_t from)
+{
+    uint16_t now = TMR1;
+    return now >= from ? now - from : (uint16_t)(now + PR1 + 1 - from);
+}
+
+// polls PORTB after release until all 'buses' read high, stores time
+// each of them went high (since 'from') to 'when'
+static void owbus_poll(owbus_mask_t buses, uint16_t from, uint16_t *when)
+{
+    owbus_mask_t high;
+    uint16_t t;
+    uint8_t pin;
+
+    do {
+        high = PORTB & buses;
+        t = owbus_elapsed(from);
+        if (high){
+            buses &= (owbus_mask_t)~high;
+            for (pin = 0; pin < 16; pin++){
+                if (high & (1U << pin)){
+                    when[pin] = t;
+                }
+            }
+        }
+    } while (buses && t < OWBUS_POLL_MAX);
+    // stuck low
+    for (pin = 0; pin < 16; pin++){
+        if (buses & (1U << pin)){
+            when[pin] = OWBUS_POLL_MAX;
+        }
+    }
+}
+
+static uint16_t owbus_max(uint16_t a, uint16_t b)
+{
+    return a > b ? a : b;
+}
+
+bool owbus_calibrate(owbus_mask_t buses)
+{
+    uint16_t when[16];
+    owbus_mask_t present, busy, seen1 = 0;
+    irq_state_t irq;
+    uint16_t t0, t, sample;
+    uint8_t i, pin;
+    bool ok = true;
+
+    owbus_timing_default();
+    present = owbus_reset(buses, &busy);
+    if (!present){
+        return false;
+    }
+    for (pin = 0; pin < 16; pin++){
+        owbus_rise[pin] = 0;
+    }
+    owbus_timing.rise = 0;
+    owbus_timing.hold = OWBUS_POLL_MAX;
+    // bus may be slow, give it time to rise after write slots, release
+    // read slots early to see rise of 1 bits within 15 us
+    owbus_timing.recovery = OWBUS_RISE_MAX;
+    owbus_timing.rlow = OWBUS_DELAY_MIN;
+    // Read ROM - 64 bits of 1s (rise time) and 0s (response)
+    owbus_write_byte(present, 0x33);
+    for (i = 0; i < 64; i++){
+        irq = irq_raise(IRQ_IPL_ONEWIRE);
+        t0 = TMR1;
+        OWBUS_LOW(present);
+        __delay32(owbus_timing.rlow);
+        OWBUS_HIZ(present);
+        owbus_poll(present, t0, when);
+        irq_restore(irq);
+        for (pin = 0; pin < 16; pin++){
+            if (!(present & (1U << pin))){
+                continue;
+            }
+            if (when[pin] < OWBUS_US(15)){
+                t = when[pin] > owbus_timing.rlow ? when[pin] - owbus_timing.rlow : 0;
+                owbus_rise[pin] = owbus_max(owbus_rise[pin], t);
+                seen1 |= 1U << pin;
+                owbus_timing.rise = owbus_max(owbus_timing.rise, t);
+            } else if (when[pin] < owbus_timing.hold){
+                owbus_timing.hold = when[pin];
+            }
+        }
+        __delay32(OWBUS_SLOT);
+    }
+    if (seen1 != present || owbus_timing.hold == OWBUS_POLL_MAX){
+        // no 1 (bus too slow) or no 0 (stuck) seen - nothing to tune
+        owbus_timing_default();
+        return false;
+    }
+
+    owbus_timing.rlow = OWBUS_DELAY_MIN;
+    owbus_timing.wlow = OWBUS_DELAY_MIN;
+    sample = owbus_max(OWBUS_DELAY_MIN, owbus_timing.rise * 5 / 4 + OWBUS_US(1));
+    if (owbus_timing.rlow + sample > OWBUS_SAMPLE_MAX){
+        sample = OWBUS_SAMPLE_MAX - owbus_timing.rlow;
+        ok = false;
+    }
+    if (owbus_timing.rlow + sample + OWBUS_HOLD_MARGIN > owbus_timing.hold){
+        ok = false;
+    }
+    owbus_timing.sample = sample;
+    owbus_timing.rest = OWBUS_SLOT - owbus_timing.rlow - sample;
+    owbus_timing.low0 = OWBUS_LOW0 - owbus_timing.wlow;
+    owbus_timing.recovery = owbus_max(OWBUS_US(2), sample);
+    owbus_timing.buses = buses;
+    owbus_timing.check = owbus_sum();
+    return ok;
+}
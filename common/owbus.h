@@ -0,0 +1,158 @@
+/**
+  @File Name
+    common/owbus.h
+
+  @Summary
+    Bit-parallel 1-wire driver - up to 16 independent buses on port B.
+
+  @Description
+    Each bus is one open-drain DQ pin of port B, typically with single
+    sensor or few of them (short cables). All buses selected by
+    mask run in lockstep - every time slot is one LATB write driving all
+    of them low and one PORTB read sampling all of them, so reading
+    8 buses costs the same bus time as reading one:
+
+      owbus_reset(m)              -> mask of buses with presence pulse
+      owbus_write_byte(m, 0xCC)      same byte to all buses (Skip ROM)
+      owbus_read(m, samples, 9)      9 bytes = 72 PORTB samples
+      owbus_byte(samples, i, pin)    byte i of bus on pin (de-interleave)
+
+    Bits are de-interleaved and CRCs computed per bus after the timing
+    critical part, outside of time slots.
+
+    Buses may be multi-drop too: owbus_write_each() sends different
+    data to each bus in the same slots (Match ROM of one device per bus)
+    and owbus_search_next() runs Search ROM (0xF0) or Alarm Search
+    (0xEC) on all buses at once, each bus with own branch decisions.
+    Every pass finds next device on each bus, so number of passes is
+    the largest number of (alarming) devices on one bus. Pass on bus
+    without answering device ends after first 2 read slots - Alarm
+    Search with nothing alarming costs reset + 10 slots.
+
+    Reset is 500 us low, presence sampled 70 us after release. Default
+    slot timing (owbus_timing_default()) is the same as single-bus
+    driver of pic24fj-temp.X it replaces: write slot 3 us low (1) or
+    63 us (0) + 2 us recovery, read slot 6 us low, sampled 4 us after
+    release, 60 us total. Critical parts run at IRQ_IPL_ONEWIRE (irq.h).
+
+    owbus_calibrate() tunes slot timing to the buses (all buses share
+    it, so the slowest one decides):
+    - Read ROM (single-drop buses), in each of 64 read slots PORTB is
+      polled after release until every bus reads high
+    - bus high within 15 us - sensor sent 1, time since release is rise
+      time of that bus (slowest of all 1 bits)
+    - bus high later - sensor sent 0 and held bus (15..60 us), time
+      since falling edge is its response (shortest of all 0 bits)
+    Then read/write low time is minimal (OWBUS_DELAY_MIN), sample point
+    is 1.25 x rise time + 1 us after release and recovery after write
+    slot is the same. Sample point must stay 2 us before RDV (15 us)
+    and 3 us before sensor releases bus - longer bus fails calibration
+    (timing is clamped). Read slot stays 60 us, write 0 is 62 us low.
+
+    Slot length is set by sensor (60 us minimum), not by the bus, so
+    short bus gains little (write slot 1 us shorter, earlier sample).
+    Long bus (rise of several us, where fixed 4 us sample reads 0
+    instead of 1 and 2 us recovery cuts off rising edge) gets later
+    sample and longer recovery - up to ~8 us rise time. Timing is in persistent RAM with checksum, so warm
+    reset (watchdog, trap) keeps it, power-on re-calibrates. Measured
+    rise times need TMR1 clocked from Fcy (1:1 prescaler, see systime.h).
+
+    Debug pins given to owbus_init() follow bus drive (logic analyzer
+    trigger, pic24fj-temp.X uses RB9).
+*/
+
+#ifndef OWBUS_H
+#define	OWBUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// instruction clock for __delay_us() (same as firmware FCY)
+#ifndef OWBUS_FCY
+#define OWBUS_FCY 4000000UL
+#endif
+
+// cycles per microsecond
+#define OWBUS_US(us) ((uint16_t)((us) * (OWBUS_FCY / 1000000UL)))
+// shortest delay of __delay32()
+#define OWBUS_DELAY_MIN 12
+
+// bit mask of DQ pins on port B
+typedef uint16_t owbus_mask_t;
+
+// slot timing [cycles]
+typedef struct {
+    owbus_mask_t buses; // calibrated buses (0 - default timing)
+    uint16_t rise;      // slowest rise time after release
+    uint16_t hold;      // shortest 0 held by sensor (from falling edge)
+    uint16_t rlow;      // read slot low time
+    uint16_t sample;    // read slot release .. sample
+    uint16_t rest;      // read slot sample .. end of slot
+    uint16_t wlow;      // write slot low time (1)
+    uint16_t low0;      // write 0 low time after wlow
+    uint16_t recovery;  // write slot release .. next slot
+    uint16_t check;     // ~sum of words above
+} owbus_timing_t;
+
+// current slot timing (persistent)
+extern owbus_timing_t owbus_timing;
+// rise time of each bus (index is pin) from last calibration [cycles]
+extern uint16_t owbus_rise[16];
+
+// configures pins of buses as open-drain outputs, released (high),
+// 'debug' pins (outputs) are driven together with buses
+void owbus_init(owbus_mask_t buses, uint16_t debug);
+// reset pulse on all buses, returns mask of buses that answered with
+// presence pulse; buses held low before reset are stored to *busy
+owbus_mask_t owbus_reset(owbus_mask_t buses, owbus_mask_t *busy);
+// one write slot on all buses, buses in 'ones' write 1, others 0
+void owbus_write_bits(owbus_mask_t buses, owbus_mask_t ones);
+// writes same byte to all buses (LSB first)
+void owbus_write_byte(owbus_mask_t buses, uint8_t data);
+// writes 'len' bytes from data[pin] to bus on pin, all buses at once
+void owbus_write_each(owbus_mask_t buses, const uint8_t *const data[16], uint8_t len);
+// sets default timing (not tuned, same as original fixed one)
+void owbus_timing_default(void);
+// true when persistent timing is valid and was tuned for 'buses'
+bool owbus_timing_valid(owbus_mask_t buses);
+// measures buses and tunes slot timing, returns false when no bus
+// answered or rise time could not be measured (default timing kept),
+// or when slowest bus is out of limits (timing clamped to limits)
+bool owbus_calibrate(owbus_mask_t buses);
+// one read slot on all buses, returns PORTB sample
+uint16_t owbus_read_bit(owbus_mask_t buses);
+// reads 'bytes' bytes from all buses, stores one PORTB sample per bit
+// (samples must have room for 8 * bytes words)
+void owbus_read(owbus_mask_t buses, uint16_t *samples, uint8_t bytes);
+
+// ROM search on all buses in lockstep
+typedef struct {
+    uint8_t cmd;         // 0xF0 Search ROM, 0xEC Alarm Search
+    owbus_mask_t more;   // buses where next pass may find device
+    uint8_t last[16];    // last discrepancy per bus (bit 1..64, 0 - none)
+    uint8_t rom[16][8];  // ROM codes found by last pass (index is pin)
+} owbus_search_t;
+
+// starts new search with ROM command 'cmd' on 'buses'
+void owbus_search_start(owbus_search_t *s, owbus_mask_t buses, uint8_t cmd);
+// one search pass, returns mask of buses where device was found (its
+// ROM code with valid CRC in s->rom[pin]), 0 when search is finished
+owbus_mask_t owbus_search_next(owbus_search_t *s);
+
+// byte 'index' of bus on 'pin' from samples of owbus_read()
+static inline uint8_t owbus_byte(const uint16_t *samples, uint8_t index, uint8_t pin)
+{
+    const uint16_t *s = samples + 8 * index;
+    uint8_t data = 0;
+    uint8_t i;
+
+    for (i = 0; i < 8; i++){
+        data >>= 1;
+        if (s[i] & (1U << pin)){
+            data |= 0x80;
+        }
+    }
+    return data;
+}
+
+#endif	/* OWBUS_H */
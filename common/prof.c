@@ -0,0 +1,119 @@
+/**
+  @File Name
+    common/prof.c
+
+  @Summary
+    Cycle profiler of hot paths. See prof.h for details.
+*/
+
+#include <xc.h>
+#include "prof.h"
+#include "out.h"
+
+#define PROF_NAME(id, name) name,
+static const char * const prof_names[PROF_COUNT] = {
+    PROF_PROBES(PROF_NAME)
+};
+#undef PROF_NAME
+
+prof_entry_t prof_table[PROF_COUNT];
+
+void prof_init(void)
+{
+    T2CON = 0x0000;
+    T3CON = 0x0000;
+    // TON=0, T32=1 (TMR2 is LSW, TMR3 is MSW), TCKPS 1:1, TCS=Fcy
+    T2CONbits.T32 = 1;
+    TMR3HLD = 0; // transferred to TMR3 by write to TMR2
+    TMR2 = 0;
+    PR3 = 0xFFFF;
+    PR2 = 0xFFFF;
+    // period interrupt is not used
+    IEC0bits.T3IE = 0;
+    IFS0bits.T3IF = 0;
+    prof_reset();
+    T2CONbits.TON = 1;
+}
+
+uint32_t prof_now(void)
+{
+    uint16_t lo, hi;
+
+    // reading TMR2 latches TMR3 to TMR3HLD - pair must not be split
+    // by ISR that also reads timer
+    __builtin_disi(0x3FFF);
+    lo = TMR2;
+    hi = TMR3HLD;
+    DISICNT = 0;
+    return ((uint32_t)hi << 16) | lo;
+}
+
+void prof_record(prof_id_t id, uint32_t start)
+{
+    uint32_t d = prof_now() - start;
+    prof_entry_t *e = &prof_table[id];
+
+    __builtin_disi(0x3FFF);
+    if (e->count == 0 || d < e->min){
+        e->min = d;
+    }
+    if (d > e->max){
+        e->max = d;
+    }
+    e->count++;
+    e->total += d;
+    DISICNT = 0;
+}
+
+void prof_reset(void)
+{
+    uint8_t i;
+
+    __builtin_disi(0x3FFF);
+    for (i = 0; i < PROF_COUNT; i++){
+        prof_table[i].count = 0;
+        prof_table[i].min = 0;
+        prof_table[i].max = 0;
+        prof_table[i].total = 0;
+    }
+    DISICNT = 0;
+}
+
+void prof_dump_line(void (*out)(char c), uint8_t line)
+{
+    prof_entry_t e;
+
+    if (line == 0){
+        out_str(out, "# probe count min max avg total [cycles]\r\n");
+        return;
+    }
+    if (line > PROF_COUNT){
+        return;
+    }
+    // copy entry atomically, it may be updated by ISR
+    __builtin_disi(0x3FFF);
+    e = prof_table[line - 1];
+    DISICNT = 0;
+
+    out_str(out, prof_names[line - 1]);
+    out(' ');
+    out_u64(out, e.count);
+    out(' ');
+    out_u64(out, e.min);
+    out(' ');
+    out_u64(out, e.max);
+    out(' ');
+    out_u64(out, e.count ? e.total / e.count : 0);
+    out(' ');
+    out_u64(out, e.total);
+    out_str(out, "\r\n");
+}
+
+void prof_dump(void (*out)(char c))
+{
+    uint8_t i;
+
+    for (i = 0; i <= PROF_COUNT; i++){
+        prof_dump_line(out, i);
+    }
+}
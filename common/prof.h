@@ -0,0 +1,93 @@
+/**
+  @File Name
+    common/prof.h
+
+  @Summary
+    Cycle profiler of hot paths using TMR2/TMR3 as 32-bit free-running
+    counter clocked from Fcy (0.25 us resolution at 4 MHz, wraps after
+    ~18 minutes - intervals must be shorter).
+
+  @Description
+    Probe points are listed in PROF_PROBES() below - each one has fixed
+    slot in RAM table holding count, min, max and total of cycles spent
+    between PROF_ENTER() and PROF_EXIT(). Usage:
+
+        u8 foo(void)
+        {
+            PROF_ENTER(t);
+            ...
+            PROF_EXIT(PROF_FOO, t);
+            return x;
+        }
+
+    Probe overhead (~30 cycles incl. 2 reads of 32-bit timer) is included
+    in measured times. Probes may be used from ISR (update of table is
+    done with disabled interrupts).
+
+    Table is dumped as text by prof_dump() - one line per probe:
+        name count min max avg total   (all values in cycles)
+
+    Define PROF_ENABLE to 0 to compile all probes out.
+
+    Requirements:
+    - TMR2 and TMR3 must not be used by application
+*/
+
+#ifndef PROF_H
+#define	PROF_H
+
+#include <stdint.h>
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+// X(id, name) - all probe points
+#define PROF_PROBES(X) \
+    X(PROF_T1_ISR,           "_T1Interrupt") \
+    X(PROF_T1_CALLBACK,      "TMR1_CallBack") \
+    X(PROF_LCD_SEND,         "LCDSend") \
+    X(PROF_LCD_FRAME,        "lcd_frame") \
+    X(PROF_DALLAS_READ,      "dallas_read")
+
+#define PROF_ENUM(id, name) id,
+typedef enum {
+    PROF_PROBES(PROF_ENUM)
+    PROF_COUNT
+} prof_id_t;
+#undef PROF_ENUM
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} prof_entry_t;
+
+extern prof_entry_t prof_table[PROF_COUNT];
+
+// starts TMR2/3 as 32-bit free-running counter, clears table
+void prof_init(void);
+// current value of 32-bit cycle counter
+uint32_t prof_now(void);
+// records one interval that started at 'start' (from prof_now())
+void prof_record(prof_id_t id, uint32_t start);
+// clears all statistics
+void prof_reset(void);
+// longest line of dump (probe names up to 16 characters)
+#define PROF_LINE_MAX 96
+// writes table as text using putc-like function
+void prof_dump(void (*out)(char c));
+// writes line 'line' of the table (0 - header, 1..PROF_COUNT - probes),
+// for dumps that wait for room in UART TX ring between lines
+void prof_dump_line(void (*out)(char c), uint8_t line);
+
+#if PROF_ENABLE
+#define PROF_ENTER(v)    uint32_t v = prof_now()
+#define PROF_EXIT(id, v) prof_record((id), (v))
+#else
+#define PROF_ENTER(v)
+#define PROF_EXIT(id, v)
+#endif
+
+#endif	/* PROF_H */
@@ -0,0 +1,81 @@
+/**
+  @File Name
+    common/sampling.c
+
+  @Summary
+    Adaptive sampling policy - see sampling.h
+*/
+
+#include "sampling.h"
+
+void sampling_init(sampling_t *s, const sampling_config_t *config)
+{
+    s->config = config;
+    s->last = 0;
+    s->delta = 0;
+    s->level = config->normal;
+    s->stable = 0;
+    s->valid = false;
+}
+
+// true when 'th' lies between a (exclusive) and b (inclusive)
+static bool sampling_crossed(int16_t a, int16_t b, int16_t th)
+{
+    return (a < th && b >= th) || (a >= th && b < th);
+}
+
+sampling_reason_t sampling_update(sampling_t *s, int16_t value)
+{
+    const sampling_config_t *c = s->config;
+    int16_t d;
+    uint8_t i;
+
+    if (!s->valid){
+        s->valid = true;
+        s->last = value;
+        s->delta = 0;
+        s->level = c->normal;
+        s->stable = 0;
+        return SAMPLING_FIRST;
+    }
+    s->delta = (int16_t)(value - s->last);
+    d = s->delta < 0 ? (int16_t)-s->delta : s->delta;
+    for (i = 0; i < c->thresholds; i++){
+        if (sampling_crossed(s->last, value, c->threshold[i])){
+            break;
+        }
+    }
+    s->last = value;
+    if (i < c->thresholds){
+        s->level = 0;
+        s->stable = 0;
+        return SAMPLING_THRESHOLD;
+    }
+    if (d >= c->fast_delta){
+        s->level = 0;
+        s->stable = 0;
+        return SAMPLING_CHANGE;
+    }
+    if (d > c->stable_delta){
+        s->stable = 0;
+        if (s->level > c->normal){
+            s->level = c->normal;
+            return SAMPLING_MOVING;
+        }
+        return SAMPLING_HOLD;
+    }
+    if (++s->stable >= c->stable_count && s->level + 1 < c->levels){
+        s->stable = 0;
+        s->level++;
+        return SAMPLING_STABLE;
+    }
+    return SAMPLING_HOLD;
+}
+
+const char *sampling_reason_name(sampling_reason_t reason)
+{
+    static const char *const NAMES[] = {
+        "first", "hold", "stable", "moving", "change", "threshold"
+    };
+    return reason <= SAMPLING_THRESHOLD ? NAMES[reason] : "?";
+}
@@ -0,0 +1,81 @@
+/**
+  @File Name
+    common/sampling.h
+
+  @Summary
+    Adaptive sampling policy - slower when readings are stable, faster
+    when they change or cross thresholds.
+
+  @Description
+    Caller defines sampling levels, 0 is the fastest (for example
+    shorter pause and higher sensor resolution), levels-1 the slowest.
+    After each reading sampling_update() decides the level:
+
+      |change| >= fast_delta     -> level 0            SAMPLING_CHANGE
+      crossed any threshold      -> level 0            SAMPLING_THRESHOLD
+      |change| >  stable_delta   -> at most 'normal'   SAMPLING_MOVING
+      stable_count stable in row -> one level slower   SAMPLING_STABLE
+      otherwise                  -> unchanged          SAMPLING_HOLD
+
+    So the reading rate drops step by step while value stays put and
+    jumps back at once when it moves. Values are in any fixed unit (for
+    DS18B20 1/16 C), thresholds may be changed at run time.
+
+    Every decision is returned as reason (with change in s->delta), so
+    caller can expose it in telemetry.
+*/
+
+#ifndef SAMPLING_H
+#define	SAMPLING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef SAMPLING_MAX_THRESHOLDS
+#define SAMPLING_MAX_THRESHOLDS 4
+#endif
+
+typedef enum {
+    SAMPLING_FIRST = 0, // first reading, level 'normal'
+    SAMPLING_HOLD,      // level unchanged
+    SAMPLING_STABLE,    // one level slower
+    SAMPLING_MOVING,    // moderate change, back to 'normal'
+    SAMPLING_CHANGE,    // fast change, fastest level
+    SAMPLING_THRESHOLD  // threshold crossed, fastest level
+} sampling_reason_t;
+
+typedef struct {
+    int16_t fast_delta;   // |change| per reading for fastest level
+    int16_t stable_delta; // largest |change| still stable
+    uint8_t stable_count; // stable readings in row to slow down
+    uint8_t levels;       // number of levels
+    uint8_t normal;       // level for moderate change and first reading
+    uint8_t thresholds;   // number of used thresholds
+    int16_t threshold[SAMPLING_MAX_THRESHOLDS];
+} sampling_config_t;
+
+typedef struct {
+    const sampling_config_t *config;
+    int16_t last;      // previous reading
+    int16_t delta;     // change of last reading
+    uint8_t level;     // current level
+    uint8_t stable;    // stable readings in row
+    bool valid;        // 'last' is valid
+} sampling_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// starts at level config->normal without previous reading
+void sampling_init(sampling_t *s, const sampling_config_t *config);
+// feeds new reading, updates s->level, returns reason of decision
+sampling_reason_t sampling_update(sampling_t *s, int16_t value);
+// short name of reason ("stable", ...)
+const char *sampling_reason_name(sampling_reason_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	/* SAMPLING_H */
@@ -0,0 +1,117 @@
+/**
+  @File Name
+    common/sched.c
+
+  @Summary
+    Tiny cooperative (run-to-completion) scheduler driven by TMR1 tick.
+    See sched.h for details.
+*/
+
+#include <stddef.h>
+#include "sched.h"
+
+typedef struct {
+    sched_fn_t fn;
+    tw_timer_t timer; // wake-up timer
+    bool ready;
+} t_sched_entry;
+
+static t_sched_entry sched_tasks[SCHED_MAX_TASKS];
+static uint8_t sched_count = 0;
+static sched_task_t sched_running = SCHED_NO_TASK;
+
+// timer callback - marks task ready to run
+static void sched_wake_cb(void *arg)
+{
+    ((t_sched_entry *)arg)->ready = true;
+}
+
+void sched_init(void)
+{
+    tw_init();
+    sched_count = 0;
+    sched_running = SCHED_NO_TASK;
+}
+
+sched_task_t sched_add(sched_fn_t fn)
+{
+    t_sched_entry *e;
+
+    if (sched_count >= SCHED_MAX_TASKS){
+        return SCHED_NO_TASK;
+    }
+    e = &sched_tasks[sched_count];
+    e->fn = fn;
+    e->timer.next = NULL;
+    e->timer.pprev = NULL;
+    e->ready = false;
+    return sched_count++;
+}
+
+void sched_wake_in(sched_task_t task, uint16_t ticks)
+{
+    t_sched_entry *e = &sched_tasks[task];
+
+    if (ticks == 0){
+        tw_stop(&e->timer);
+        e->ready = true;
+    } else {
+        e->ready = false;
+        tw_start(&e->timer, ticks, 0, sched_wake_cb, e);
+    }
+}
+
+void sched_suspend(sched_task_t task)
+{
+    t_sched_entry *e = &sched_tasks[task];
+
+    tw_stop(&e->timer);
+    e->ready = false;
+}
+
+bool sched_is_armed(sched_task_t task)
+{
+    t_sched_entry *e = &sched_tasks[task];
+
+    return e->ready || tw_is_pending(&e->timer);
+}
+
+sched_task_t sched_current(void)
+{
+    return sched_running;
+}
+
+void __attribute__((weak)) sched_idle(void)
+{
+    // nothing to do - could put CPU to Idle() here
+}
+
+void sched_run_once(void)
+{
+    uint8_t i;
+    bool ran;
+    t_sched_entry *e;
+
+    // advance timer wheel - wakes tasks and runs software timers
+    ran = tw_run() != 0;
+    for(i=0;i<sched_count;i++){
+        e = &sched_tasks[i];
+        if (e->ready){
+            e->ready = false;
+            sched_running = i;
+            e->fn();
+            sched_running = SCHED_NO_TASK;
+            ran = true;
+        }
+    }
+    if (!ran){
+        sched_idle();
+    }
+}
+
+void sched_run(void)
+{
+    while(1){
+        sched_run_once();
+    }
+}
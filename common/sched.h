@@ -0,0 +1,76 @@
+/**
+  @File Name
+    common/sched.h
+
+  @Summary
+    Tiny cooperative (run-to-completion) scheduler driven by TMR1 tick.
+
+  @Description
+    Replaces __delay_ms() based control flow. Each task is plain function
+    that must return quickly (no long busy waits). Before returning task
+    may re-arm itself with sched_wake_in() - otherwise it is suspended
+    until someone else wakes it.
+
+    Usage:
+    - call sched_tick() from TMR1_CallBack() (ISR context)
+    - create tasks with sched_add() after SYSTEM_Initialize()
+    - arm them with sched_wake_in()
+    - call sched_run() at end of main() - it never returns
+
+    Task wake-ups are software timers of timer_wheel.h, so ISR only
+    increments tick counter; wheel is advanced in sched_run() main loop.
+    Other software timers (tw_start()) may be used freely from tasks.
+*/
+
+#ifndef SCHED_H
+#define	SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timer_wheel.h"
+
+// TMR1 period in microseconds - all PIC24FJ projects use 2.5 ms (400 Hz)
+#ifndef SCHED_TICK_US
+#define SCHED_TICK_US 2500UL
+#endif
+
+// maximum number of tasks (table is static)
+#ifndef SCHED_MAX_TASKS
+#define SCHED_MAX_TASKS 8
+#endif
+
+// converts milliseconds to ticks (rounded up), max. TW_MAX_TICKS (~81s)
+#define SCHED_MS(ms) \
+    ((uint16_t)((((uint32_t)(ms))*1000UL + SCHED_TICK_US - 1) / SCHED_TICK_US))
+
+// returned by sched_add() when task table is full
+#define SCHED_NO_TASK 0xFF
+
+typedef uint8_t sched_task_t;
+typedef void (*sched_fn_t)(void);
+
+// must be called from TMR1 ISR (TMR1_CallBack)
+static inline void sched_tick(void)
+{
+    tw_tick();
+}
+
+void sched_init(void);
+// registers new task in suspended state, returns SCHED_NO_TASK on error
+sched_task_t sched_add(sched_fn_t fn);
+// (re)arms task to run after 'ticks' TMR1 ticks, 0 = as soon as possible
+void sched_wake_in(sched_task_t task, uint16_t ticks);
+// task will not run until woken again
+void sched_suspend(sched_task_t task);
+bool sched_is_armed(sched_task_t task);
+// handle of currently running task (valid only inside task)
+sched_task_t sched_current(void);
+// main loop - never returns
+void sched_run(void);
+// single pass of main loop (runs ready tasks or calls sched_idle()),
+// used for idle-loop calibration (see load.h)
+void sched_run_once(void);
+// called by sched_run() when no task was ready, can be overridden
+void sched_idle(void);
+
+#endif	/* SCHED_H */
@@ -0,0 +1,72 @@
+/**
+  @File Name
+    common/stack.c
+
+  @Summary
+    Stack painting and high-water mark - see stack.h
+*/
+
+#include <xc.h>
+#include <stdint.h>
+#include "stack.h"
+#include "out.h"
+
+#if defined(__XC16__)
+// stack bounds defined by linker (__SP_init, __SPLIM_init)
+extern uint16_t _SP_init[];
+extern uint16_t _SPLIM_init[];
+
+void stack_paint(void)
+{
+    // W15 points to first free word, everything above is unused
+    uint16_t *p = (uint16_t *)WREG15;
+
+    while (p < _SPLIM_init){
+        *p++ = STACK_PAINT;
+    }
+}
+
+uint16_t stack_size(void)
+{
+    return (uint16_t)((uintptr_t)_SPLIM_init - (uintptr_t)_SP_init);
+}
+
+uint16_t stack_used(void)
+{
+    const uint16_t *p = _SPLIM_init;
+
+    while (p > _SP_init && p[-1] == STACK_PAINT){
+        p--;
+    }
+    return (uint16_t)((uintptr_t)p - (uintptr_t)_SP_init);
+}
+#else
+// host simulator - no PIC stack (see stack.h)
+void stack_paint(void)
+{
+}
+
+uint16_t stack_size(void)
+{
+    return 0;
+}
+
+uint16_t stack_used(void)
+{
+    return 0;
+}
+#endif
+
+void stack_print(void (*out)(char c))
+{
+    uint16_t size = stack_size();
+
+    if (size == 0){
+        return;
+    }
+    out_str(out, "stack ");
+    out_u32(out, stack_used());
+    out('/');
+    out_u32(out, size);
+    out_str(out, " bytes\r\n");
+}
@@ -0,0 +1,53 @@
+/**
+  @File Name
+    common/stack.h
+
+  @Summary
+    Stack painting and high-water mark of software stack.
+
+  @Description
+    PIC24 stack grows up from _SP_init to _SPLIM_init (linker symbols,
+    by default all RAM left after data and heap). stack_paint() fills
+    unused part above current W15 with STACK_PAINT pattern, words that
+    are still painted later were never touched - stack_used() scans
+    down from the limit and returns peak usage since painting:
+
+      _SP_init                W15 (paint)          peak          _SPLIM_init
+         | main frames ...    | painted ...........|..............|
+         |<------------ stack_used() ------------->|
+
+    Peak includes nested ISRs, 1-wire and LCD rendering - whatever ran
+    since stack_paint(). Word with value equal to pattern at the very
+    top is not counted (may under-report by 2 bytes). Use the report to
+    size linker option --stack (minimum stack) when RAM gets tight.
+
+    Usage:
+    - stack_paint() as first statement of main() (interrupts disabled)
+    - stack_print(uart_putc) from diagnostic task, prints
+      "stack 312/6144 bytes"
+
+    In host simulator there is no PIC stack, stack_size() returns 0 and
+    stack_print() prints nothing - simulator reports call depth of each
+    task instead (see sim/README, make stack-depth).
+*/
+
+#ifndef STACK_H
+#define	STACK_H
+
+#include <stdint.h>
+
+// fill pattern of unused stack
+#define STACK_PAINT 0x5AA5U
+
+// fills stack above current W15 with STACK_PAINT
+void stack_paint(void);
+// total stack size in bytes (0 when unknown)
+uint16_t stack_size(void);
+// peak stack usage in bytes since stack_paint()
+uint16_t stack_used(void);
+// longest line of stack_print()
+#define STACK_LINE_MAX 25
+// writes "stack used/size bytes" line using putc-like function
+void stack_print(void (*out)(char c));
+
+#endif	/* STACK_H */
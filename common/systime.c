@@ -0,0 +1,66 @@
+/**
+  @File Name
+    common/systime.c
+
+  @Summary
+    Monotonic system time with sub-tick resolution.
+    See systime.h for details.
+*/
+
+#include <xc.h>
+#include <stdbool.h>
+#include "systime.h"
+
+volatile uint32_t systime_ticks = 0;
+
+void systime_now(systime_t *t)
+{
+    uint32_t ticks;
+    uint16_t tmr;
+    bool pending1, pending2;
+
+    do {
+        ticks = systime_ticks;
+        pending1 = IFS0bits.T1IF;
+        tmr = TMR1;
+        pending2 = IFS0bits.T1IF;
+        // retry when ISR or TMR1 rollover came in between
+    } while (pending1 != pending2 || ticks != systime_ticks);
+
+    if (pending2){
+        // rollover already happened, but ISR did not run yet
+        // (interrupts masked or we run at higher priority)
+        ticks++;
+    }
+    t->ticks = ticks;
+    t->cycles = tmr;
+}
+
+uint64_t systime_to_cycles(const systime_t *t)
+{
+    return (uint64_t)t->ticks * SYSTIME_TICK_CYCLES + t->cycles;
+}
+
+uint64_t systime_to_us(const systime_t *t)
+{
+    return systime_to_cycles(t) / SYSTIME_CYCLES_PER_US;
+}
+
+uint32_t systime_diff_cycles(const systime_t *from, const systime_t *to)
+{
+    uint32_t dticks = to->ticks - from->ticks;
+
+    // avoid 64-bit math in common (short interval) case
+    if (dticks >= 0xFFFFFFFFUL / SYSTIME_TICK_CYCLES){
+        return 0xFFFFFFFFUL;
+    }
+    return dticks * SYSTIME_TICK_CYCLES + to->cycles - from->cycles;
+}
+
+uint64_t systime_us(void)
+{
+    systime_t t;
+
+    systime_now(&t);
+    return systime_to_us(&t);
+}
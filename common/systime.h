@@ -0,0 +1,72 @@
+/**
+  @File Name
+    common/systime.h
+
+  @Summary
+    Monotonic system time with sub-tick resolution.
+
+  @Description
+    Combines 32-bit software tick counter (incremented from TMR1 ISR)
+    with live TMR1 register value, so timestamps have resolution of
+    single instruction cycle (0.25 us at Fcy = 4 MHz). Range of 32-bit
+    tick counter at 2.5 ms is ~124 days, converted values are 64-bit.
+
+    Reads are lock-free (interrupts are never disabled): reader retries
+    when TMR1 ISR updated counter in the middle of read. Pending (not
+    yet serviced) TMR1 rollover is detected from T1IF, so time is
+    monotonic even when called with interrupts masked.
+
+    Cheapest call is systime_now() that only captures raw stamp,
+    conversion to microseconds may be done later (for example when
+    dumping profiling data).
+
+    Requirements:
+    - TMR1 with 1:1 prescaler clocked from Fcy, period SYSTIME_TICK_CYCLES
+    - systime_tick() called from TMR1 ISR
+    - T1IF must be cleared at beginning of TMR1 ISR (before callback)
+*/
+
+#ifndef SYSTIME_H
+#define	SYSTIME_H
+
+#include <stdint.h>
+
+// instruction clock
+#ifndef SYSTIME_FCY
+#define SYSTIME_FCY 4000000UL
+#endif
+
+// TMR1 cycles per tick (PR1+1), 2.5 ms at 4 MHz
+#ifndef SYSTIME_TICK_CYCLES
+#define SYSTIME_TICK_CYCLES 10000U
+#endif
+
+#define SYSTIME_CYCLES_PER_US (SYSTIME_FCY / 1000000UL)
+
+// raw timestamp
+typedef struct {
+    uint32_t ticks;  // TMR1 ticks since boot
+    uint16_t cycles; // cycles since last tick (0..SYSTIME_TICK_CYCLES-1)
+} systime_t;
+
+// incremented by systime_tick() from TMR1 ISR
+extern volatile uint32_t systime_ticks;
+
+// must be called from TMR1 ISR
+static inline void systime_tick(void)
+{
+    systime_ticks++;
+}
+
+// captures current time (lock-free, callable from any context)
+void systime_now(systime_t *t);
+// converts timestamp to microseconds since boot
+uint64_t systime_to_us(const systime_t *t);
+// converts timestamp to instruction cycles since boot
+uint64_t systime_to_cycles(const systime_t *t);
+// cycles elapsed between two timestamps (saturated to 32-bit)
+uint32_t systime_diff_cycles(const systime_t *from, const systime_t *to);
+// microseconds since boot
+uint64_t systime_us(void);
+
+#endif	/* SYSTIME_H */
@@ -0,0 +1,157 @@
+/**
+  @File Name
+    common/telem.c
+
+  @Summary
+    Binary telemetry over UART. See telem.h for details.
+*/
+
+#include "telem.h"
+#include "crc16.h"
+#include "uart.h"
+
+#if TELEM_HDR_SIZE + 1 + 4 * TELEM_COUNTER_COUNT + TELEM_CRC_SIZE > TELEM_FRAME_MAX || \
+    TELEM_HDR_SIZE + 1 + 2 * TELEM_DIAG_COUNT + TELEM_CRC_SIZE > TELEM_FRAME_MAX
+#error "counters or diagnostics do not fit to TELEM_FRAME_MAX"
+#endif
+
+uint32_t telem_frames = 0;
+uint32_t telem_dropped = 0;
+
+static uint8_t telem_seq = 0;
+// frame and its encoding enclosed in delimiters
+static uint8_t telem_frame[TELEM_FRAME_MAX];
+static uint8_t telem_wire[TELEM_WIRE_MAX];
+
+static uint8_t *telem_put16(uint8_t *p, uint16_t v)
+{
+    *p++ = (uint8_t)v;
+    *p++ = (uint8_t)(v >> 8);
+    return p;
+}
+
+static uint8_t *telem_put32(uint8_t *p, uint32_t v)
+{
+    p = telem_put16(p, (uint16_t)v);
+    return telem_put16(p, (uint16_t)(v >> 16));
+}
+
+// encodes frame of 'len' bytes (body already in telem_frame) and queues it
+static bool telem_queue(uint8_t type, uint8_t len)
+{
+    uint16_t n;
+
+    telem_frame[0] = type;
+    telem_frame[1] = telem_seq++;
+    len += TELEM_HDR_SIZE;
+    telem_put16(&telem_frame[len], crc16(telem_frame, len));
+    len += TELEM_CRC_SIZE;
+    telem_wire[0] = 0;
+    n = cobs_encode(telem_frame, len, &telem_wire[1]);
+    telem_wire[n + 1] = 0;
+    if (!uart_write(telem_wire, n + 2)){
+        telem_dropped++;
+        return false;
+    }
+    telem_frames++;
+    return true;
+}
+
+bool telem_send(uint8_t type, const uint8_t *body, uint8_t len)
+{
+    uint8_t i;
+
+    if (len > TELEM_FRAME_MAX - TELEM_HDR_SIZE - TELEM_CRC_SIZE){
+        return false;
+    }
+    for (i = 0; i < len; i++){
+        telem_frame[TELEM_HDR_SIZE + i] = body[i];
+    }
+    return telem_queue(type, len);
+}
+
+bool telem_samples(uint8_t sensor, uint32_t t0, uint16_t dt,
+                   const int16_t *value, uint8_t n)
+{
+    uint8_t *p = &telem_frame[TELEM_HDR_SIZE];
+    uint8_t i;
+
+    if (!n || n > TELEM_BATCH_MAX){
+        return false;
+    }
+    *p++ = sensor;
+    *p++ = n;
+    p = telem_put32(p, t0);
+    p = telem_put16(p, dt);
+    for (i = 0; i < n; i++){
+        p = telem_put16(p, (uint16_t)value[i]);
+    }
+    return telem_queue(TELEM_SAMPLES, (uint8_t)(TELEM_SAMPLES_HDR + 2 * n));
+}
+
+bool telem_counters(const uint32_t *value, uint8_t n)
+{
+    uint8_t *p = &telem_frame[TELEM_HDR_SIZE];
+    uint8_t i;
+
+    if (n > TELEM_COUNTER_COUNT){
+        return false;
+    }
+    *p++ = n;
+    for (i = 0; i < n; i++){
+        p = telem_put32(p, value[i]);
+    }
+    return telem_queue(TELEM_COUNTERS, (uint8_t)(1 + 4 * n));
+}
+
+bool telem_diag(const uint16_t *value, uint8_t n)
+{
+    uint8_t *p = &telem_frame[TELEM_HDR_SIZE];
+    uint8_t i;
+
+    if (n > TELEM_DIAG_COUNT){
+        return false;
+    }
+    *p++ = n;
+    for (i = 0; i < n; i++){
+        p = telem_put16(p, value[i]);
+    }
+    return telem_queue(TELEM_DIAG, (uint8_t)(1 + 2 * n));
+}
+
+void telem_batch_init(telem_batch_t *b, uint8_t sensor, uint16_t dt)
+{
+    b->sensor = sensor;
+    b->n = 0;
+    b->dt = dt;
+}
+
+bool telem_batch_flush(telem_batch_t *b)
+{
+    uint8_t n = b->n;
+
+    if (!n){
+        return true;
+    }
+    b->n = 0;
+    return telem_samples(b->sensor, b->t0, n > 1 ? b->dt : 0, b->value, n);
+}
+
+bool telem_batch_add(telem_batch_t *b, uint32_t t, int16_t value)
+{
+    bool ok = true;
+    // distance from expected time, modulo 2^32 as t0 wraps
+    int32_t off = (int32_t)(t - b->t0 - (uint32_t)b->n * b->dt);
+
+    if (b->n && (off > b->dt / 2 || off < -(int32_t)(b->dt / 2))){
+        ok = telem_batch_flush(b);
+    }
+    if (!b->n){
+        b->t0 = t;
+    }
+    b->value[b->n++] = value;
+    if (b->n == TELEM_BATCH_MAX){
+        ok = telem_batch_flush(b) && ok;
+    }
+    return ok;
+}
@@ -0,0 +1,79 @@
+/**
+  @File Name
+    common/telem.h
+
+  @Summary
+    Binary telemetry over UART - COBS framed, CRC protected samples,
+    counters and diagnostics (format in telem_fmt.h).
+
+  @Description
+    Frame is built and encoded in static buffer and queued by
+    uart_write() as whole or not at all - sender never waits for UART,
+    so telemetry cannot stall measurement or display. Refused frames
+    are counted in telem_dropped and still take their sequence number,
+    receiver sees them as gap.
+
+    Fast sampling (up to 1 kHz) goes through telem_batch_t: values of
+    one sensor taken every dt are collected and sent TELEM_BATCH_MAX at
+    a time (2.5 bytes per value on wire). Value that does not follow
+    the period (more than dt/2 off) starts new batch, so receiver
+    computes exact times as t0 + i * dt.
+
+    Encoding a frame costs ~30 cycles per byte (CRC-16 and COBS), ~2500
+    cycles for full sample frame. Call from main loop only (uart.h).
+
+    Host receiver: sim/telem_rx.h (library), sim/build/telem-dump
+    (prints frames), sim/build/telem-check (make check-telemetry).
+*/
+
+#ifndef TELEM_H
+#define	TELEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cobs.h"
+#include "telem_fmt.h"
+
+// longest frame on wire (COBS and delimiters) - room in UART TX ring
+// other output leaves to telemetry
+#define TELEM_WIRE_MAX (COBS_MAX(TELEM_FRAME_MAX) + 2)
+
+typedef struct {
+    uint8_t sensor;
+    uint8_t n;        // values collected
+    uint16_t dt;      // period [us]
+    uint32_t t0;      // time of first value [us]
+    int16_t value[TELEM_BATCH_MAX];
+} telem_batch_t;
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// frames queued and refused (UART TX ring full)
+extern uint32_t telem_frames;
+extern uint32_t telem_dropped;
+
+// queues frame of given type and body (see telem_fmt.h), false when
+// it did not fit to TX ring
+bool telem_send(uint8_t type, const uint8_t *body, uint8_t len);
+// sample frame of 'n' values (1..TELEM_BATCH_MAX)
+bool telem_samples(uint8_t sensor, uint32_t t0, uint16_t dt,
+                   const int16_t *value, uint8_t n);
+// counters and diagnostic frames, 'n' values in order of their lists
+bool telem_counters(const uint32_t *value, uint8_t n);
+bool telem_diag(const uint16_t *value, uint8_t n);
+
+// empty batch of sensor with period 'dt' [us]
+void telem_batch_init(telem_batch_t *b, uint8_t sensor, uint16_t dt);
+// adds value taken at 't' [us], sends batch when it is full (or
+// before value off period), false when a frame was dropped
+bool telem_batch_add(telem_batch_t *b, uint32_t t, int16_t value);
+// sends collected values (if any)
+bool telem_batch_flush(telem_batch_t *b);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TELEM_H */
@@ -0,0 +1,92 @@
+/**
+  @File Name
+    common/telem_fmt.h
+
+  @Summary
+    Binary format of telemetry frames (see telem.h). Shared by firmware
+    and host receiver (sim/telem_rx.h).
+
+  @Description
+    Each frame is COBS encoded (cobs.h) and enclosed in 0x00 bytes, so
+    text and event trace on the same UART only cost frames that overlap
+    them. All values are little-endian.
+
+        offset  size  field
+        0       1     type - TELEM_xxx
+        1       1     seq  - incremented per frame, also for frames
+                             dropped by sender (gap = lost frames)
+        2       len   body
+        2+len   2     CRC-16 (crc16.h) of bytes 0 .. 1+len
+
+    TELEM_SAMPLES - readings of one sensor taken every dt:
+        0       1     sensor
+        1       1     n - number of values (1..TELEM_BATCH_MAX)
+        2       4     t0 - time of first value [us since boot], wraps
+                           every ~71 min (receiver extends it)
+        6       2     dt - period [us], 0 for single value
+        8       2*n   values, i16 (DS18B20: 1/16 C)
+
+    TELEM_COUNTERS - free running u32 counters:
+        0       1     n
+        1       4*n   values in order of TELEM_COUNTER_LIST
+
+    TELEM_DIAG - u16 gauges:
+        0       1     n
+        1       2*n   values in order of TELEM_DIAG_LIST
+
+    Receiver ignores values beyond lists it knows, so fields are only
+    appended.
+
+    Sample frame of 32 values is 76 bytes, 79 with COBS and delimiters -
+    2.5 bytes per value: 1 kHz stream takes 2470 of 3840 bytes/s at
+    38400 Bd.
+*/
+
+#ifndef TELEM_FMT_H
+#define	TELEM_FMT_H
+
+// frame types
+#define TELEM_SAMPLES  1
+#define TELEM_COUNTERS 2
+#define TELEM_DIAG     3
+
+// X(id, name)
+#define TELEM_COUNTER_LIST(X) \
+    X(TELEM_CNT_UPTIME,      "uptime_s") \
+    X(TELEM_CNT_READS,       "ow_reads") \
+    X(TELEM_CNT_CRC_ERRORS,  "ow_crc_errors") \
+    X(TELEM_CNT_LOGGED,      "flog_readings") \
+    X(TELEM_CNT_FRAMES,      "telem_frames") \
+    X(TELEM_CNT_DROPPED,     "telem_dropped") \
+    X(TELEM_CNT_RX_OVERRUNS, "uart_rx_overruns")
+
+#define TELEM_DIAG_LIST(X) \
+    X(TELEM_DIAG_LOAD,     "load_permille") \
+    X(TELEM_DIAG_STACK,    "stack_used") \
+    X(TELEM_DIAG_TX_FREE,  "uart_tx_free") \
+    X(TELEM_DIAG_SAMPLING, "sampling_level") \
+    X(TELEM_DIAG_SENSORS,  "sensors") \
+    X(TELEM_DIAG_HIST,     "hist_readings")
+
+#define TELEM_ENUM(id, name) id,
+typedef enum {
+    TELEM_COUNTER_LIST(TELEM_ENUM)
+    TELEM_COUNTER_COUNT
+} telem_counter_t;
+
+typedef enum {
+    TELEM_DIAG_LIST(TELEM_ENUM)
+    TELEM_DIAG_COUNT
+} telem_diag_t;
+#undef TELEM_ENUM
+
+// values per sample frame
+#define TELEM_BATCH_MAX    32
+#define TELEM_HDR_SIZE     2
+#define TELEM_CRC_SIZE     2
+#define TELEM_SAMPLES_HDR  8
+// longest frame (sample frame), without COBS
+#define TELEM_FRAME_MAX    (TELEM_HDR_SIZE + TELEM_SAMPLES_HDR + \
+                            2 * TELEM_BATCH_MAX + TELEM_CRC_SIZE)
+
+#endif	/* TELEM_FMT_H */
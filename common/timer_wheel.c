@@ -0,0 +1,144 @@
+/**
+  @File Name
+    common/timer_wheel.c
+
+  @Summary
+    Software timers on top of TMR1 tick - hierarchical timing wheel.
+    See timer_wheel.h for details.
+*/
+
+#include <stddef.h>
+#include "timer_wheel.h"
+
+#define TW_L0_BITS 5
+#define TW_L1_BITS 5
+#define TW_L2_BITS 6
+#define TW_L0_SIZE (1U << TW_L0_BITS)
+#define TW_L1_SIZE (1U << TW_L1_BITS)
+#define TW_L2_SIZE (1U << TW_L2_BITS)
+#define TW_L0_MASK (TW_L0_SIZE - 1)
+#define TW_L1_MASK (TW_L1_SIZE - 1)
+#define TW_L2_MASK (TW_L2_SIZE - 1)
+#define TW_L1_SHIFT TW_L0_BITS
+#define TW_L2_SHIFT (TW_L0_BITS + TW_L1_BITS)
+
+volatile uint16_t tw_ticks = 0;
+
+static tw_timer_t *tw_l0[TW_L0_SIZE];
+static tw_timer_t *tw_l1[TW_L1_SIZE];
+static tw_timer_t *tw_l2[TW_L2_SIZE];
+// last tick processed by wheel (may lag behind tw_ticks)
+static uint16_t tw_now = 0;
+
+static void tw_link(tw_timer_t **head, tw_timer_t *t)
+{
+    t->next = *head;
+    if (t->next){
+        t->next->pprev = &t->next;
+    }
+    *head = t;
+    t->pprev = head;
+}
+
+static void tw_unlink(tw_timer_t *t)
+{
+    *t->pprev = t->next;
+    if (t->next){
+        t->next->pprev = t->pprev;
+    }
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+// puts timer to proper slot according to its distance from tw_now
+static void tw_insert(tw_timer_t *t)
+{
+    uint16_t delta = t->expires - tw_now;
+
+    if (delta < TW_L0_SIZE){
+        tw_link(&tw_l0[t->expires & TW_L0_MASK], t);
+    } else if (delta < (1U << TW_L2_SHIFT)){
+        tw_link(&tw_l1[(t->expires >> TW_L1_SHIFT) & TW_L1_MASK], t);
+    } else {
+        tw_link(&tw_l2[(t->expires >> TW_L2_SHIFT) & TW_L2_MASK], t);
+    }
+}
+
+// moves all timers from upper level slot to lower levels
+static void tw_cascade(tw_timer_t **head)
+{
+    tw_timer_t *t;
+
+    while ((t = *head) != NULL){
+        tw_unlink(t);
+        tw_insert(t);
+    }
+}
+
+void tw_init(void)
+{
+    uint8_t i;
+
+    for(i=0;i<TW_L0_SIZE;i++) tw_l0[i] = NULL;
+    for(i=0;i<TW_L1_SIZE;i++) tw_l1[i] = NULL;
+    for(i=0;i<TW_L2_SIZE;i++) tw_l2[i] = NULL;
+    tw_now = tw_ticks;
+}
+
+void tw_start(tw_timer_t *t, uint16_t ticks, uint16_t period,
+              tw_callback_t cb, void *arg)
+{
+    if (tw_is_pending(t)){
+        tw_unlink(t);
+    }
+    if (ticks == 0){
+        ticks = 1;
+    }
+    t->cb = cb;
+    t->arg = arg;
+    t->period = period;
+    // relative to real tick (not tw_now) so lagging wheel does not
+    // shorten timeout
+    t->expires = tw_ticks + ticks;
+    tw_insert(t);
+}
+
+void tw_stop(tw_timer_t *t)
+{
+    if (tw_is_pending(t)){
+        tw_unlink(t);
+    }
+}
+
+uint16_t tw_run(void)
+{
+    uint16_t target = tw_ticks;
+    uint16_t fired = 0;
+    uint8_t idx;
+    tw_timer_t *t;
+
+    while (tw_now != target){
+        tw_now++;
+        idx = tw_now & TW_L0_MASK;
+        if (idx == 0){
+            uint8_t idx1 = (tw_now >> TW_L1_SHIFT) & TW_L1_MASK;
+            if (idx1 == 0){
+                tw_cascade(&tw_l2[(tw_now >> TW_L2_SHIFT) & TW_L2_MASK]);
+            }
+            tw_cascade(&tw_l1[idx1]);
+        }
+        // callbacks may start/stop any timer - always take list head
+        while ((t = tw_l0[idx]) != NULL){
+            tw_unlink(t);
+            if (t->period){
+                // re-arm before callback, so callback may stop it
+                // (expires is advanced from previous value - no drift)
+                t->expires += t->period;
+                tw_insert(t);
+            }
+            t->cb(t->arg);
+            fired++;
+        }
+    }
+    return fired;
+}
@@ -0,0 +1,69 @@
+/**
+  @File Name
+    common/timer_wheel.h
+
+  @Summary
+    Software timers on top of TMR1 tick - hierarchical timing wheel.
+
+  @Description
+    Provides O(1) start/stop/expire for any number of one-shot and periodic
+    timers. Timers are intrusive - caller owns tw_timer_t storage (12 bytes
+    on PIC24), so there is no fixed limit on timer count.
+
+    ISR cost does not depend on number of timers: TMR1 ISR only increments
+    tw_ticks (via tw_tick()). Wheel is advanced and callbacks are dispatched
+    from main context by tw_run() (called from sched_run() main loop), which
+    catches up with all ticks elapsed since last call.
+
+    Wheel layout (16-bit tick space, 128 list heads = 256 bytes of RAM):
+    - level 0: 32 slots x 1 tick      (expires in < 32 ticks = 80 ms)
+    - level 1: 32 slots x 32 ticks    (expires in < 1024 ticks = 2.56 s)
+    - level 2: 64 slots x 1024 ticks  (rest of 16-bit range)
+    Timers in upper levels are cascaded down when lower level wraps.
+
+    Maximum timeout/period is TW_MAX_TICKS (~81 s at 2.5 ms tick).
+*/
+
+#ifndef TIMER_WHEEL_H
+#define	TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TW_MAX_TICKS 0x7FFFU
+
+typedef void (*tw_callback_t)(void *arg);
+
+typedef struct tw_timer {
+    struct tw_timer  *next;
+    struct tw_timer **pprev;   // NULL when timer is not pending
+    uint16_t          expires; // absolute tick
+    uint16_t          period;  // 0 = one-shot
+    tw_callback_t     cb;
+    void             *arg;
+} tw_timer_t;
+
+// system tick counter, incremented by tw_tick() from TMR1 ISR
+extern volatile uint16_t tw_ticks;
+
+// must be called from TMR1 ISR - only tick increment, O(1)
+static inline void tw_tick(void)
+{
+    tw_ticks++;
+}
+
+void tw_init(void);
+// (re)starts timer to fire after 'ticks' (min. 1) ticks, then every
+// 'period' ticks (0 = one-shot). Callback runs in main context (tw_run).
+void tw_start(tw_timer_t *t, uint16_t ticks, uint16_t period,
+              tw_callback_t cb, void *arg);
+void tw_stop(tw_timer_t *t);
+static inline bool tw_is_pending(const tw_timer_t *t)
+{
+    return t->pprev != 0;
+}
+// advances wheel up to tw_ticks and runs expired callbacks,
+// returns number of callbacks invoked
+uint16_t tw_run(void);
+
+#endif	/* TIMER_WHEEL_H */
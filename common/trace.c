@@ -0,0 +1,100 @@
+/**
+  @File Name
+    common/trace.c
+
+  @Summary
+    Lock-free in-RAM event trace. See trace.h for details.
+*/
+
+#include "trace.h"
+#include "crc8.h"
+
+trace_ring_t trace_rings[TRACE_RINGS];
+
+void trace_init(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < TRACE_RINGS; i++){
+        trace_rings[i].head = 0;
+        trace_rings[i].tail = 0;
+        trace_rings[i].dropped = 0;
+    }
+}
+
+// sends byte and adds it to CRC
+static uint8_t trace_out(void (*out)(char c), uint8_t crc, uint8_t b)
+{
+    out((char)b);
+    return crc8_update(crc, b);
+}
+
+static uint8_t trace_out16(void (*out)(char c), uint8_t crc, uint16_t v)
+{
+    crc = trace_out(out, crc, (uint8_t)v);
+    return trace_out(out, crc, (uint8_t)(v >> 8));
+}
+
+uint8_t trace_pending(void)
+{
+    uint8_t i, n = 0;
+
+    for (i = 0; i < TRACE_RINGS; i++){
+        n += (uint8_t)((trace_rings[i].head - trace_rings[i].tail) & TRACE_MASK);
+    }
+    return n;
+}
+
+uint16_t trace_dump(void (*out)(char c), uint16_t room)
+{
+    uint16_t sent = 0, fit;
+    uint8_t i, tail, head, n, crc;
+    systime_t now;
+    trace_ring_t *r;
+    const trace_rec_t *e;
+
+    for (i = 0; i < TRACE_RINGS; i++){
+        r = &trace_rings[i];
+        tail = r->tail;
+        head = r->head; // snapshot - records after it go to next frame
+        n = (uint8_t)((head - tail) & TRACE_MASK);
+        if (n == 0){
+            continue;
+        }
+        if (room < TRACE_HDR_SIZE + 1 + TRACE_REC_SIZE){
+            break;
+        }
+        // oldest records that fit, the rest waits for next dump
+        fit = (room - TRACE_HDR_SIZE - 1) / TRACE_REC_SIZE;
+        if (n > fit){
+            n = (uint8_t)fit;
+            head = (uint8_t)((tail + n) & TRACE_MASK);
+        }
+        room -= TRACE_HDR_SIZE + 1 + n * TRACE_REC_SIZE;
+        systime_now(&now);
+
+        out((char)TRACE_SYNC0);
+        out((char)TRACE_SYNC1);
+        crc = CRC8_INIT;
+        crc = trace_out(out, crc, i);
+        crc = trace_out(out, crc, n);
+        crc = trace_out16(out, crc, r->dropped);
+        crc = trace_out16(out, crc, (uint16_t)now.ticks);
+        crc = trace_out16(out, crc, (uint16_t)(now.ticks >> 16));
+        while (tail != head){
+            e = &r->buf[tail];
+            crc = trace_out16(out, crc, e->tick);
+            crc = trace_out16(out, crc, e->cycles);
+            crc = trace_out(out, crc, e->event);
+            crc = trace_out(out, crc, e->aux);
+            crc = trace_out16(out, crc, e->arg);
+            tail = (uint8_t)((tail + 1) & TRACE_MASK);
+            // free slot immediately, producer may reuse it
+            TRACE_BARRIER();
+            r->tail = tail;
+            sent++;
+        }
+        out((char)crc);
+    }
+    return sent;
+}
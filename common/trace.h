@@ -0,0 +1,105 @@
+/**
+  @File Name
+    common/trace.h
+
+  @Summary
+    Lock-free in-RAM event trace with binary UART dump.
+
+  @Description
+    Events (see trace_fmt.h) are stored as 8-byte timestamped records
+    in single-producer/single-consumer rings - one ring per producer
+    context (main loop, TMR1 ISR). Producer only writes 'head', consumer
+    (trace_dump() from main loop) only writes 'tail', so no interrupts
+    are disabled on either side. When ring is full, new records are
+    dropped and counted (oldest records survive - they explain failure).
+
+    Cost of TRACE() is ~20 instruction cycles (no call, no loop).
+
+    Timestamp is low 16 bits of systime tick plus TMR1 value. When main
+    loop record is interrupted between the two reads by TMR1 ISR, its
+    stamp is one tick early - decoder fixes that by keeping stamps of
+    ring monotonic.
+
+    Host decoder: sim/trace_decode.cpp (text and VCD output).
+
+    Define TRACE_ENABLE to 0 to compile all events out.
+*/
+
+#ifndef TRACE_H
+#define	TRACE_H
+
+#include <xc.h>
+#include <stdint.h>
+#include "systime.h"
+#include "trace_fmt.h"
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+// records per ring, must be power of 2 (max 128)
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 32
+#endif
+
+#define TRACE_MASK (TRACE_SIZE - 1)
+
+typedef struct {
+    uint16_t tick;
+    uint16_t cycles;
+    uint8_t event;
+    uint8_t aux;
+    uint16_t arg;
+} trace_rec_t;
+
+typedef struct {
+    trace_rec_t buf[TRACE_SIZE];
+    volatile uint8_t head;      // written only by producer
+    volatile uint8_t tail;      // written only by consumer
+    volatile uint16_t dropped;  // written only by producer
+} trace_ring_t;
+
+extern trace_ring_t trace_rings[TRACE_RINGS];
+
+// keeps compiler from moving record stores after head update
+#define TRACE_BARRIER() __asm__ volatile ("" ::: "memory")
+
+static inline void trace_put(uint8_t ring, uint8_t event, uint8_t aux,
+                             uint16_t arg)
+{
+    trace_ring_t *r = &trace_rings[ring];
+    uint8_t head = r->head;
+    uint8_t next = (uint8_t)((head + 1) & TRACE_MASK);
+    trace_rec_t *e;
+
+    if (next == r->tail){
+        r->dropped++;
+        return;
+    }
+    e = &r->buf[head];
+    e->tick = (uint16_t)systime_ticks;
+    e->cycles = TMR1;
+    e->event = event;
+    e->aux = aux;
+    e->arg = arg;
+    TRACE_BARRIER();
+    r->head = next; // publish record
+}
+
+#if TRACE_ENABLE
+#define TRACE(ring, event, aux, arg) \
+    trace_put((ring), (event), (uint8_t)(aux), (uint16_t)(arg))
+#else
+#define TRACE(ring, event, aux, arg)
+#endif
+
+void trace_init(void);
+// sends pending records as frames (one per non-empty ring) using
+// putc-like function, at most 'room' bytes in total (frame takes
+// TRACE_HDR_SIZE + 1 + TRACE_REC_SIZE per record, records that do not
+// fit stay for next call), returns number of records sent
+uint16_t trace_dump(void (*out)(char c), uint16_t room);
+// records waiting in all rings
+uint8_t trace_pending(void);
+
+#endif	/* TRACE_H */
@@ -0,0 +1,73 @@
+/**
+  @File Name
+    common/trace_fmt.h
+
+  @Summary
+    Event list and binary format of event trace (see trace.h).
+    Shared by firmware and host decoder (sim/trace_decode.cpp).
+
+  @Description
+    Dump is stream of frames, one frame per ring with pending records
+    (oldest of them, as many as fit to UART TX ring). Frames may be
+    mixed with text output on the same UART - decoder searches for sync
+    and verifies CRC. All values are little-endian.
+
+        offset  size  field
+        0       2     sync 0xA5 0x5A
+        2       1     ring (TRACE_RING_xxx)
+        3       1     n - number of records
+        4       2     dropped - free running count of lost records
+        6       4     now - systime ticks when frame was sent
+        10      8*n   records
+        10+8*n  1     CRC-8 (crc8.h) of bytes 2 .. 9+8*n
+
+    Record:
+        0       2     tick   - low 16 bits of systime ticks
+        2       2     cycles - TMR1 value (cycles since tick)
+        4       1     event  - TRACE_xxx
+        5       1     aux    - event specific
+        6       2     arg    - event specific
+
+    Tick counter in record wraps every 65536 ticks (~164 s), decoder
+    extends it using 'now' of frame, so records must be drained sooner.
+*/
+
+#ifndef TRACE_FMT_H
+#define	TRACE_FMT_H
+
+// X(id, name, kind)
+// kind: TRACE_KIND_PULSE - point event (arg is value)
+//       TRACE_KIND_LEVEL - aux is new level of signal (1=begin, 0=end)
+#define TRACE_EVENTS(X) \
+    X(TRACE_BOOT,        "boot",        TRACE_KIND_PULSE) \
+    X(TRACE_OW_RESET,    "ow_reset",    TRACE_KIND_PULSE) \
+    X(TRACE_OW_CRC_FAIL, "ow_crc_fail", TRACE_KIND_PULSE) \
+    X(TRACE_TEMP,        "temp",        TRACE_KIND_PULSE) \
+    X(TRACE_SPI_BURST,   "spi_burst",   TRACE_KIND_LEVEL) \
+    X(TRACE_ISR_OVERRUN, "isr_overrun", TRACE_KIND_PULSE) \
+    X(TRACE_OW_TUNE,     "ow_tune",     TRACE_KIND_PULSE) \
+    X(TRACE_SAMPLING,    "sampling",    TRACE_KIND_PULSE) \
+    X(TRACE_OW_SEARCH,   "ow_search",   TRACE_KIND_PULSE) \
+    X(TRACE_OW_ALARM,    "ow_alarm",    TRACE_KIND_PULSE)
+
+#define TRACE_KIND_PULSE 0
+#define TRACE_KIND_LEVEL 1
+
+#define TRACE_EVENT_ENUM(id, name, kind) id,
+typedef enum {
+    TRACE_EVENTS(TRACE_EVENT_ENUM)
+    TRACE_EVENT_COUNT
+} trace_event_t;
+#undef TRACE_EVENT_ENUM
+
+// rings - each must have single producer context
+#define TRACE_RING_MAIN 0 // main loop (scheduler tasks)
+#define TRACE_RING_ISR  1 // TMR1 ISR
+#define TRACE_RINGS     2
+
+#define TRACE_SYNC0 0xA5
+#define TRACE_SYNC1 0x5A
+#define TRACE_HDR_SIZE 10
+#define TRACE_REC_SIZE 8
+
+#endif	/* TRACE_FMT_H */
@@ -0,0 +1,205 @@
+/**
+  @File Name
+    common/uart.c
+
+  @Summary
+    Interrupt driven UART1 with ring buffers. See uart.h for details.
+*/
+
+#include <xc.h>
+#include "irq.h"
+#include "modbus.h"
+#include "out.h"
+#include "uart.h"
+
+#if (UART_TX_SIZE & (UART_TX_SIZE - 1)) || (UART_RX_SIZE & (UART_RX_SIZE - 1))
+#error "UART_TX_SIZE and UART_RX_SIZE must be powers of 2"
+#endif
+
+static uint8_t uart_tx_buf[UART_TX_SIZE];
+static volatile uint16_t uart_tx_head = 0; // written by main
+static volatile uint16_t uart_tx_tail = 0; // written by U1TX ISR
+#if !MODBUS_ENABLE
+static uint8_t uart_rx_buf[UART_RX_SIZE];
+static volatile uint16_t uart_rx_head = 0; // written by U1RX ISR
+static volatile uint16_t uart_rx_tail = 0; // written by main
+#endif
+
+uint16_t uart_tx_dropped = 0;
+volatile uint16_t uart_rx_overruns = 0;
+
+void uart_init(void)
+{
+    // RB2/AN4, RB3/AN5 to digital
+#if defined(__PIC24HJ128GP502__)
+    AD1PCFGL |= (1U << 4) | (1U << 5);
+#else
+    AD1PCFG |= (1U << 4) | (1U << 5);
+#endif
+    _LATB2 = 1; // idle level of TX
+    _TRISB2 = 0;
+    _TRISB3 = 1;
+
+    U1MODE = 0x0008; // BRGH=1, 8N1, UART disabled
+    // UTXISEL1:0 = 10 - interrupt when TX FIFO becomes empty (refilled
+    // by 4 bytes), URXISEL = 00 - interrupt on every received byte
+    U1STA = 0x8000;
+    U1BRG = (uint16_t)UART_BRG;
+    IPC3bits.U1TXIP = IRQ_IPL_COMM;
+    IPC2bits.U1RXIP = IRQ_IPL_COMM;
+    IFS0bits.U1RXIF = 0;
+    IEC0bits.U1RXIE = 1;
+    U1MODEbits.UARTEN = 1;
+    U1STAbits.UTXEN = 1;
+    // UTXEN sets U1TXIF, ISR runs once ring has data
+    IEC0bits.U1TXIE = 0;
+}
+
+// moves bytes from TX ring to FIFO while it has room, returns true
+// when ring is empty
+static inline bool uart_tx_fill(void)
+{
+    uint16_t tail = uart_tx_tail;
+
+    while (tail != uart_tx_head && !U1STAbits.UTXBF){
+        U1TXREG = uart_tx_buf[tail];
+        tail = (tail + 1) & (UART_TX_SIZE - 1);
+    }
+    uart_tx_tail = tail;
+    return tail == uart_tx_head;
+}
+
+void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void)
+{
+    IFS0bits.U1TXIF = 0;
+    if (uart_tx_fill()){
+        // nothing more to send, writer enables interrupt again
+        IEC0bits.U1TXIE = 0;
+    }
+}
+
+#if !MODBUS_ENABLE
+// receiver belongs to modbus.c otherwise
+void __attribute__((interrupt, no_auto_psv)) _U1RXInterrupt(void)
+{
+    uint16_t head = uart_rx_head;
+    uint16_t next;
+    uint8_t b;
+
+    IFS0bits.U1RXIF = 0;
+    if (U1STAbits.OERR){
+        // FIFO overrun, its content is lost by clearing OERR
+        uart_rx_overruns++;
+        U1STAbits.OERR = 0;
+    }
+    while (U1STAbits.URXDA){
+        b = (uint8_t)U1RXREG;
+        next = (head + 1) & (UART_RX_SIZE - 1);
+        if (next == uart_rx_tail){
+            uart_rx_overruns++;
+            continue;
+        }
+        uart_rx_buf[head] = b;
+        head = next;
+    }
+    uart_rx_head = head;
+}
+#endif
+
+uint16_t uart_tx_free(void)
+{
+    return (UART_TX_SIZE - 1) - ((uart_tx_head - uart_tx_tail) & (UART_TX_SIZE - 1));
+}
+
+// new data in ring - let ISR send it (it runs at once when FIFO is
+// empty, because U1TXIF stays set since FIFO emptied)
+static inline void uart_tx_kick(void)
+{
+    IEC0bits.U1TXIE = 1;
+}
+
+#if MODBUS_ENABLE
+// line carries Modbus frames only
+void uart_putc(char c)
+{
+    (void)c;
+}
+#else
+// ring full: feeds FIFO from main with TX interrupt masked, works also
+// when ISR cannot run (interrupts disabled or CPU IPL too high)
+static void uart_tx_wait(void)
+{
+    while (!uart_tx_free()){
+        IEC0bits.U1TXIE = 0;
+        uart_tx_fill();
+        IEC0bits.U1TXIE = 1;
+    }
+}
+
+void uart_putc(char c)
+{
+    uint16_t head = uart_tx_head;
+
+    uart_tx_wait();
+    uart_tx_buf[head] = (uint8_t)c;
+    uart_tx_head = (head + 1) & (UART_TX_SIZE - 1);
+    uart_tx_kick();
+}
+#endif
+
+bool uart_write(const uint8_t *data, uint16_t len)
+{
+    uint16_t head = uart_tx_head;
+
+    if (uart_tx_free() < len){
+        uart_tx_dropped++;
+        return false;
+    }
+    while (len--){
+        uart_tx_buf[head] = *data++;
+        head = (head + 1) & (UART_TX_SIZE - 1);
+    }
+    uart_tx_head = head;
+    uart_tx_kick();
+    return true;
+}
+
+#if !MODBUS_ENABLE
+int16_t uart_getc(void)
+{
+    uint16_t tail = uart_rx_tail;
+    uint8_t b;
+
+    if (tail == uart_rx_head){
+        return -1;
+    }
+    b = uart_rx_buf[tail];
+    uart_rx_tail = (tail + 1) & (UART_RX_SIZE - 1);
+    return b;
+}
+#endif
+
+void uart_puts(const char *s)
+{
+    out_str(uart_putc, s);
+}
+
+void uart_put_u32(uint32_t v)
+{
+    out_u32(uart_putc, v);
+}
+
+void uart_put_hex16(uint16_t v)
+{
+    out_hex(uart_putc, v, 4);
+}
+
+void uart_flush(void)
+{
+    while (uart_tx_tail != uart_tx_head){
+        IEC0bits.U1TXIE = 0;
+        uart_tx_fill();
+        IEC0bits.U1TXIE = 1;
+    }
+    while (!U1STAbits.TRMT);
+}
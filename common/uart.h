@@ -0,0 +1,91 @@
+/**
+  @File Name
+    common/uart.h
+
+  @Summary
+    Interrupt driven UART1 (8N1, 38400 Bd) with TX and RX ring buffers.
+
+  @Description
+    Pins (Peripheral Pin Select):
+    - RB2/RP2/PIN6 - U1TX (connect to RX of 3.3V USB-serial adapter)
+    - RB3/RP3/PIN7 - U1RX
+    Both pins are AN4/AN5 after reset, uart_init() switches them
+    to digital mode. Projects map them in their pin manager together
+    with other PPS functions: with IOL1WAY = ON PPS locks once, later
+    unlock in uart_init() would be ignored.
+
+    Output goes to TX ring (UART_TX_SIZE bytes), U1TX ISR (IRQ_IPL_COMM,
+    see irq.h) refills 4-level TX FIFO each time it becomes empty, so
+    writer only copies bytes to RAM:
+    - uart_write() never waits - queues whole block or nothing (returns
+      false, counted in uart_tx_dropped), for binary frames from any
+      task (telemetry, see telem.h)
+    - uart_putc() and the rest wait while ring is full (diagnostic text,
+      dumps) and feed FIFO directly meanwhile, so they work also with
+      interrupts disabled (before INTERRUPT_GlobalEnable(), crash report);
+      periodic dumps from tasks check uart_tx_free() before each line
+      or frame so that they never wait
+
+    U1RX ISR moves received bytes to RX ring (UART_RX_SIZE), read them
+    with uart_getc(). Bytes lost on full ring or FIFO overrun are
+    counted in uart_rx_overruns. Built with MODBUS_ENABLE (modbus.h)
+    the receiver belongs to Modbus slave, there is no uart_getc() and
+    uart_putc() with the rest of text output discards everything.
+
+    Rings have single producer and single consumer (main loop and ISR),
+    index of each is written by one side only - no locking. Call
+    uart_* functions from main loop (scheduler tasks), never from ISR.
+*/
+
+#ifndef UART_H
+#define	UART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// instruction clock (pic24hj-blink.X defines UART_FCY=16000000UL in project)
+#ifndef UART_FCY
+#define UART_FCY 4000000UL
+#endif
+
+#ifndef UART_BAUD
+#define UART_BAUD 38400UL
+#endif
+
+// ring sizes, powers of 2
+#ifndef UART_TX_SIZE
+#define UART_TX_SIZE 256
+#endif
+#ifndef UART_RX_SIZE
+#define UART_RX_SIZE 64
+#endif
+
+// BRGH=1: baud = Fcy / (4 * (U1BRG + 1)), rounded
+#define UART_BRG ((UART_FCY + 2UL * UART_BAUD) / (4UL * UART_BAUD) - 1UL)
+
+// uart_write() calls refused for lack of space
+extern uint16_t uart_tx_dropped;
+// received bytes lost (RX ring full, FIFO overrun)
+extern volatile uint16_t uart_rx_overruns;
+
+// configures pins, enables UART1 and its interrupts
+void uart_init(void);
+// sends single character
+void uart_putc(char c);
+// sends NUL terminated string
+void uart_puts(const char *s);
+// sends unsigned number in decimal
+void uart_put_u32(uint32_t v);
+// sends 4 digit hexadecimal number
+void uart_put_hex16(uint16_t v);
+// queues 'len' bytes without waiting, false (nothing queued) when
+// TX ring has less free space
+bool uart_write(const uint8_t *data, uint16_t len);
+// free space in TX ring
+uint16_t uart_tx_free(void);
+// next received byte, -1 when none
+int16_t uart_getc(void);
+// waits until all characters were shifted out
+void uart_flush(void);
+
+#endif	/* UART_H */
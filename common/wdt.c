@@ -0,0 +1,45 @@
+/**
+  @File Name
+    common/wdt.c
+
+  @Summary
+    Watchdog supervisor with per-activity check-ins - see wdt.h
+*/
+
+#include <xc.h>
+#include "wdt.h"
+#include "crash.h"
+
+volatile uint16_t wdt_age[WDT_MAX_CHECKS];
+uint16_t wdt_deadline[WDT_MAX_CHECKS];
+uint8_t wdt_count = 0;
+volatile bool wdt_running = false;
+
+wdt_id_t wdt_add(uint16_t deadline)
+{
+    if (wdt_count >= WDT_MAX_CHECKS){
+        return WDT_NO_ID;
+    }
+    wdt_deadline[wdt_count] = deadline;
+    wdt_age[wdt_count] = 0;
+    return wdt_count++;
+}
+
+void wdt_start(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < wdt_count; i++){
+        wdt_age[i] = 0;
+    }
+    ClrWdt();
+    wdt_running = true;
+    RCONbits.SWDTEN = 1;
+}
+
+void wdt_expire(wdt_id_t id)
+{
+    // ISR keeps running, hardware WDT resets CPU within its period
+    wdt_running = false;
+    crash_note(CRASH_WDT + id);
+}
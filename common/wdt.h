@@ -0,0 +1,87 @@
+/**
+  @File Name
+    common/wdt.h
+
+  @Summary
+    Watchdog supervisor with per-activity check-ins.
+
+  @Description
+    Each supervised activity (measurement cycle, LCD frame, ...) gets
+    deadline in TMR1 ticks and must call wdt_checkin() at least that
+    often. Hardware WDT is cleared only from TMR1 ISR by wdt_tick() and
+    only while all activities are within their deadlines:
+
+      activity:  wdt_checkin(id)  -> age[id] = 0
+      TMR1 ISR:  age[id]++ for all; all ages <= deadline -> ClrWdt()
+
+    So hardware WDT resets CPU when
+    - an activity misses its deadline (task stuck in busy loop, or not
+      scheduled any more) - supervisor records CRASH_WDT + id with
+      crash_note() and stops clearing WDT
+    - TMR1 ISR does not run (display refresh and scheduler dead) - next
+      boot records CRASH_WDT_STALL
+    Reason is printed on next boot by crash_report() (see crash.h).
+
+    Hardware WDT is enabled by software (config FWDTEN = OFF, then
+    RCON.SWDTEN) after boot calibration. Config FWPSA = PR32 and
+    WDTPS = PS128 give ~128 ms (LPRC 31 kHz +-15 %) - far above TMR1
+    period, so it expires only when ISR stalls or supervisor stops
+    clearing it. Deadlines should have margin of 50 % or more over
+    longest regular check-in interval.
+*/
+
+#ifndef WDT_H
+#define	WDT_H
+
+#include <xc.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// maximum number of supervised activities
+#ifndef WDT_MAX_CHECKS
+#define WDT_MAX_CHECKS 4
+#endif
+
+// returned by wdt_add() when table is full
+#define WDT_NO_ID 0xFF
+
+typedef uint8_t wdt_id_t;
+
+// ticks since last check-in, incremented by wdt_tick()
+extern volatile uint16_t wdt_age[WDT_MAX_CHECKS];
+extern uint16_t wdt_deadline[WDT_MAX_CHECKS];
+extern uint8_t wdt_count;
+// true between wdt_start() and missed deadline
+extern volatile bool wdt_running;
+
+// registers activity, deadline in TMR1 ticks (SCHED_MS())
+wdt_id_t wdt_add(uint16_t deadline);
+// resets all ages and enables hardware WDT
+void wdt_start(void);
+// records missed deadline and stops supervision (called by wdt_tick())
+void wdt_expire(wdt_id_t id);
+
+// activity is alive
+static inline void wdt_checkin(wdt_id_t id)
+{
+    wdt_age[id] = 0;
+}
+
+// must be called from TMR1 ISR
+static inline void wdt_tick(void)
+{
+    uint8_t i;
+
+    if (!wdt_running){
+        return;
+    }
+    for (i = 0; i < wdt_count; i++){
+        if (++wdt_age[i] > wdt_deadline[i]){
+            wdt_expire(i);
+            return;
+        }
+    }
+    ClrWdt();
+}
+
+#endif	/* WDT_H */
@@ -9,6 +9,11 @@
     Uses Timer1 with Interrupt handler to Toggle LED every 0.5 s (2 Hz)
     which gives 1 Hz (1s) blinking rate.
 
+    Main loop is idle loop of CPU load meter (../common/load.h):
+    - brightness of lit LED (software PWM from idle loop) shows CPU load
+    - load is reported every second on UART1 TX - RB2/PIN6, 38400 Bd
+    Note: at 100% load idle loop never runs, so LED stops blinking.
+
   @Description
     Generation Information :
         Board             : Microstick II DM330013-2
@@ -46,26 +51,72 @@
 #include "mcc_generated_files/tmr1.h"
 #include "mcc_generated_files/pin_manager.h"
 #include "mcc_generated_files/interrupt_manager.h"
+#include "load.h"
+#include "uart.h"
+#include "crash.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// LED is lit in every other TMR1 period (blinking at 1 Hz)
+volatile bool led_lit = false;
+// brightness of lit LED - PWM duty 0..255 (set from CPU load)
+uint8_t led_duty = 0;
+// minimal brightness, so blinking is visible on idle CPU
+#define LED_DUTY_MIN 13
 
-// automatically overrides weak function in tmr1.c:
-void TMR1_CallBack(void)
+// called from TMR1 ISR, bound at compile time (see tmr1.h):
+TMR1_CALLBACK void TMR1_CallBack(void)
 {
     // toggle LED at 2 Hz rate => blinking at 1 Hz
-    LED_Toggle();
+    led_lit = !led_lit;
+    load_tick();
+}
+// _T1Interrupt with inlined TMR1_CallBack (see TMR1_STATIC_CALLBACK)
+TMR1_ISR(TMR1_CallBack)
+
+// one iteration of main (idle) loop
+void main_loop(void)
+{
+    static uint16_t last_report = 0;
+    uint8_t pwm_phase;
+
+    load_idle();
+    // software PWM: TMR1 counts at Fcy/256, so its low 8 bits wrap at ~61 Hz
+    // (read always - iteration must cost the same whether LED is lit or not)
+    pwm_phase = (uint8_t)TMR1;
+    if (led_lit && pwm_phase < led_duty){
+        LED_SetHigh();
+    } else {
+        LED_SetLow();
+    }
+    // report every second (2 TMR1 periods)
+    if ((uint16_t)(load_ticks - last_report) >= 2){
+        last_report = load_ticks;
+        load_update();
+        led_duty = (uint8_t)(LED_DUTY_MIN +
+            (uint32_t)load_permille * (255 - LED_DUTY_MIN) / LOAD_FULL);
+        load_print(uart_putc);
+    }
 }
 
 int main(void)
 {
     SYSTEM_Initialize();
+    uart_init();
+    // report trap that caused last reset (see traps.c)
+    crash_init();
+    crash_report(uart_putc);
     INTERRUPT_GlobalEnable();
     TMR1_Start();
-    
+    // no-load reference (takes 1 TMR1 period = 0.5 s)
+    load_calibrate(main_loop, 1);
+
     while (1)
     {
-        // so far NOP
+        main_loop();
     }
     
     // never returns
     return 1;
 }
-
@@ -86,5 +86,15 @@ void PIN_MANAGER_Initialize (void)
      * Setting the Analog/Digital Configuration SFR(s)
      ***************************************************************************/
     AD1PCFG = 0x000D;
+
+    /****************************************************************************
+     * Set the PPS
+     ***************************************************************************/
+    __builtin_write_OSCCONL(OSCCON & 0xbf); // unlock PPS
+
+    RPOR1bits.RP2R = 0x0003;    //RB2->UART1:U1TX
+    RPINR18bits.U1RXR = 0x0003;    //RB3->UART1:U1RX
+
+    __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
 }
 
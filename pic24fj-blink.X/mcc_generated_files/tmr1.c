@@ -53,8 +53,10 @@
 /**
  Section: File specific functions
 */
+#if !TMR1_STATIC_CALLBACK
 void (*TMR1_InterruptHandler)(void) = NULL;
 void TMR1_CallBack(void);
+#endif
 
 /**
   Section: Data Type Definitions
@@ -73,6 +75,7 @@ void TMR1_CallBack(void);
     None.
 */
 
+#if !TMR1_STATIC_CALLBACK
 typedef struct _TMR_OBJ_STRUCT
 {
     /* Timer Elapsed */
@@ -83,6 +86,7 @@ typedef struct _TMR_OBJ_STRUCT
 } TMR_OBJ;
 
 static TMR_OBJ tmr1_obj;
+#endif
 
 /**
   Section: Driver Interface
@@ -97,19 +101,24 @@ void TMR1_Initialize (void)
     //TCKPS 1:256; TON enabled; TSIDL disabled; TCS FOSC/2; TSYNC disabled; TGATE disabled; 
     T1CON = 0x8030;
 
+#if !TMR1_STATIC_CALLBACK
     if(TMR1_InterruptHandler == NULL)
     {
         TMR1_SetInterruptHandler(&TMR1_CallBack);
     }
+#endif
 
     IFS0bits.T1IF = false;
     IEC0bits.T1IE = true;
 	
+#if !TMR1_STATIC_CALLBACK
     tmr1_obj.timerElapsed = false;
+#endif
 
 }
 
 
+#if !TMR1_STATIC_CALLBACK
 void __attribute__ ( ( interrupt, no_auto_psv ) ) _T1Interrupt (  )
 {
     /* Check if the Timer Interrupt/Status is set */
@@ -130,12 +139,16 @@ void __attribute__ ( ( interrupt, no_auto_psv ) ) _T1Interrupt (  )
     IFS0bits.T1IF = false;
 }
 
+#endif
+
 void TMR1_Period16BitSet( uint16_t value )
 {
     /* Update the counter values */
     PR1 = value;
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 }
 
 uint16_t TMR1_Period16BitGet( void )
@@ -147,8 +160,10 @@ void TMR1_Counter16BitSet ( uint16_t value )
 {
     /* Update the counter values */
     TMR1 = value;
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 }
 
 uint16_t TMR1_Counter16BitGet( void )
@@ -156,6 +171,7 @@ uint16_t TMR1_Counter16BitGet( void )
     return( TMR1 );
 }
 
+#if !TMR1_STATIC_CALLBACK
 
 void __attribute__ ((weak)) TMR1_CallBack(void)
 {
@@ -168,11 +184,14 @@ void  TMR1_SetInterruptHandler(void (* InterruptHandler)(void))
     TMR1_InterruptHandler = InterruptHandler; 
     IEC0bits.T1IE = true;
 }
+#endif
 
 void TMR1_Start( void )
 {
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 
     /*Enable the interrupt*/
     IEC0bits.T1IE = true;
@@ -190,6 +209,7 @@ void TMR1_Stop( void )
     IEC0bits.T1IE = false;
 }
 
+#if !TMR1_STATIC_CALLBACK
 bool TMR1_GetElapsedThenClear(void)
 {
     bool status;
@@ -212,6 +232,7 @@ void TMR1_SoftwareCounterClear(void)
 {
     tmr1_obj.count = 0; 
 }
+#endif
 
 /**
  End of File
@@ -61,6 +61,47 @@
 
 #define TMR1_INTERRUPT_TICKER_FACTOR    1
 
+/**
+  @Summary
+    Compile-time bound callback (added by hand - keep on MCC regeneration)
+
+  @Description
+    TMR1_STATIC_CALLBACK 1 - _T1Interrupt is not defined in tmr1.c.
+    Application defines it with TMR1_ISR(callback) in the same file as
+    callback declared with TMR1_CALLBACK, so callback is inlined into ISR.
+    Call through TMR1_InterruptHandler pointer (and saving of all working
+    registers it forces) and software counter/elapsed flag bookkeeping
+    are compiled out - TMR1_SetInterruptHandler(), TMR1_GetElapsedThenClear()
+    and TMR1_SoftwareCounterGet/Clear() are not available.
+
+    TMR1_STATIC_CALLBACK 0 - original MCC behaviour.
+
+  @Example
+    <code>
+        TMR1_CALLBACK void TMR1_CallBack(void)
+        {
+            // runs in ISR, T1IF is already cleared
+        }
+        TMR1_ISR(TMR1_CallBack)
+    </code>
+*/
+#ifndef TMR1_STATIC_CALLBACK
+#define TMR1_STATIC_CALLBACK 1
+#endif
+
+#if TMR1_STATIC_CALLBACK
+#define TMR1_CALLBACK static inline __attribute__((always_inline))
+#define TMR1_ISR(callback) \
+    void __attribute__ ( ( interrupt, no_auto_psv ) ) _T1Interrupt ( void ) \
+    { \
+        IFS0bits.T1IF = false; \
+        callback(); \
+    }
+#else
+#define TMR1_CALLBACK
+#define TMR1_ISR(callback)
+#endif
+
 /**
   Section: Interface Routines
 */
@@ -219,7 +260,9 @@ uint16_t TMR1_Counter16BitGet( void );
     </code>
 */
 
+#if !TMR1_STATIC_CALLBACK
 void TMR1_SetInterruptHandler(void (* InterruptHandler)(void));
+#endif
 
 /**
   @Summary
@@ -278,7 +321,9 @@ void TMR1_Stop( void );
     Refer to the example of TMR1_Initialize();
 */
 
+#if !TMR1_STATIC_CALLBACK
 bool TMR1_GetElapsedThenClear(void);
+#endif
 
 /**
   @Summary
@@ -297,7 +342,9 @@ bool TMR1_GetElapsedThenClear(void);
     Refer to the example of TMR1_Initialize();
 */
 
+#if !TMR1_STATIC_CALLBACK
 int TMR1_SoftwareCounterGet(void);
+#endif
 
 /**
   @Summary
@@ -316,7 +363,9 @@ int TMR1_SoftwareCounterGet(void);
     Refer to the example of TMR1_Initialize();
 */
 
+#if !TMR1_STATIC_CALLBACK
 void TMR1_SoftwareCounterClear(void);
+#endif
 
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -65,7 +65,7 @@ typedef enum
 
   @Description
     This routine will be called whenever a trap happens. It stores the trap
-    error code and waits forever.
+    error code and crash record (../common/crash.h) and resets the CPU.
     This routine has a weak attribute and can be over written.
 
   @Preconditions
@@ -23,9 +23,18 @@
     - f_RC = 8 MHz (fixed)
     - f_CPU   = f_RC / 2 = 4 MHz
   
+    Timing:
+    - TMR1 period is 2.5 ms (400 Hz), it drives cooperative scheduler
+      (see ../common/sched.h) - no __delay_ms() in main loop.
+
+    Build with LCD_CHART=1 for temperature chart instead of demo text
+    (see chart_task()).
+
     Used PINs:
     - RA0/PIN2 - on-board red LED blinking at 5 Hz
     - RA3/CLKO/PIN10 - instruction clock output - f_cy =  4 MHz
+    - RB2/PIN6 - UART1 TX (38400 Bd, 8N1) - profiler output
+    - RB3/PIN7 - UART1 RX
     LCD display connections:
     - PIC socket               LCD pin
     - RB7/SPI1:SCK1OUT/PIN16   SCK/PIN9  - SPI1 SCK (clock output)
@@ -83,18 +92,44 @@ const char *BUILD_VER = "v0.10";
 #define FCY 4000000UL 
 #include "mcc_generated_files/mcc.h"
 #include <libpic30.h>  // __delay_us())
+#include "sched.h"
+#include "systime.h"
+#include "uart.h"
+#include "prof.h"
+#include "load.h"
+#include "trace.h"
+#include "crash.h"
+#include "wdt.h"
+#include "stack.h"
 
 #include <stdint.h>
 // type aliases like Linux kernel
 typedef uint8_t u8;
 typedef uint16_t u16;
+typedef int16_t i16;
+
+// 1 - temperature chart, 0 - text and marquee demo
+#ifndef LCD_CHART
+#define LCD_CHART 0
+#endif
 
-// automatically overrides weak function in tmr1.c:
-void TMR1_CallBack(void)
+// called from TMR1 ISR, bound at compile time (see tmr1.h):
+// TMR1 Period is 2.5 ms ( 400 Hz)
+TMR1_CALLBACK void TMR1_CallBack(void)
 {
-    // toggle LED at 10 Hz rate => blinking at 5 Hz
-    LED_RA0_Toggle();
+    PROF_ENTER(prof_start);
+    systime_tick();
+    sched_tick();
+    load_tick();
+    wdt_tick();
+    if (IFS0bits.T1IF){
+        // next period already elapsed - tick was lost
+        TRACE(TRACE_RING_ISR, TRACE_ISR_OVERRUN, 0, TMR1);
+    }
+    PROF_EXIT(PROF_T1_CALLBACK, prof_start);
 }
+// _T1Interrupt with inlined TMR1_CallBack (see TMR1_STATIC_CALLBACK)
+TMR1_ISR(TMR1_CallBack)
 
 // LCD stuff mostly copied and ported from:
 // https://github.com/OLIMEX/UEXT-MODULES/blob/master/MOD-LCD3310/Software/Arduino(AVR)/lcd3310_GPIO.c
@@ -117,8 +152,13 @@ typedef enum {
     SEND_DATA,
 } t_cmd_data;
 
+// bytes sent to LCD (cost of redraw)
+u16 lcd_bytes = 0;
+
 void LCDSend(u8 val,t_cmd_data dc)
 {
+    PROF_ENTER(prof_start);
+    lcd_bytes++;
     LCD_CS_SetLow(); // activate /CS
     if (dc == SEND_DATA){
         LCD_DC_SetHigh(); // sending DATA -> D/C=1
@@ -127,6 +167,7 @@ void LCDSend(u8 val,t_cmd_data dc)
     }
     SPI1_Exchange8bit( val );
     LCD_CS_SetHigh(); // deactivate /CS
+    PROF_EXIT(PROF_LCD_SEND, prof_start);
 }
 
 void LCDcls(void)
@@ -351,16 +392,316 @@ const char *ROLL_TEXT = "Hello!";
 // 6 -number of character in text, 5 is width of single char
 u8 ROLL_BUFFER[6*5];
 
+// scheduler tasks
+sched_task_t led_task_id = SCHED_NO_TASK;
+sched_task_t roll_task_id = SCHED_NO_TASK;
+sched_task_t prof_task_id = SCHED_NO_TASK;
+sched_task_t load_task_id = SCHED_NO_TASK;
+sched_task_t trace_task_id = SCHED_NO_TASK;
+sched_task_t chart_task_id = SCHED_NO_TASK;
+// LCD frame every 100 ms, first one 1 s after start screen (chart
+// every CHART_PERIOD_MS)
+wdt_id_t roll_wdt_id = WDT_NO_ID;
+#define ROLL_WDT_DEADLINE SCHED_MS(1500)
+
+void led_task(void)
+{
+    // toggle LED at 10 Hz rate => blinking at 5 Hz
+    LED_RA0_Toggle();
+    sched_wake_in(led_task_id, SCHED_MS(100));
+}
+
+// rolls text on last line by one pixel every 100ms
+void roll_task(void)
+{
+    static u8 ofs = 0;
+    u8 x;
+    PROF_ENTER(prof_start);
+
+    TRACE(TRACE_RING_MAIN, TRACE_SPI_BURST, 1, 0);
+    LCDSend(0x80, SEND_CMD); // set X address to 0
+    LCDSend(0x40+(LCD_TEXTLINES-1), SEND_CMD); // set Y address to last line
+    // copy whole line to LCD
+    for(x=0;x<LCD_COLUMNS;x++){
+        LCDSend( ROLL_BUFFER[ (x+ofs) % ((u8)sizeof(ROLL_BUFFER)) ],
+                SEND_DATA);
+    }
+    ofs++;
+    if (ofs == sizeof(ROLL_BUFFER)){
+        ofs = 0;
+    }
+    // 2 commands + 1 line of data
+    TRACE(TRACE_RING_MAIN, TRACE_SPI_BURST, 0, 2+LCD_COLUMNS);
+    PROF_EXIT(PROF_LCD_FRAME, prof_start);
+    wdt_checkin(roll_wdt_id);
+    sched_wake_in(roll_task_id, SCHED_MS(100));
+}
+
+// Temperature chart: text line 0 shows top of scale and last reading,
+// lines 1..4 are chart (32 pixel rows, 84 columns = CHART_COLUMNS
+// readings), line 5 bottom of scale and time span. Controller cannot
+// scroll horizontally (start line moves rows only) and shifted plot
+// would change every column, so the chart sweeps instead: reading is
+// drawn to column after previous one (wraps at the right edge) and
+// column after it is cleared as gap that marks the newest reading.
+// Each reading costs the same 4 x (Set X, Set Y, 2 columns) + value
+// label = 8 cmd + 8 data + 2 cmd + 25 data bytes, whole screen (504
+// data bytes) is redrawn only when reading leaves the scale.
+#define CHART_COLUMNS LCD_COLUMNS
+#define CHART_BANK    1              // first text line of chart
+#define CHART_BANKS   4
+#define CHART_ROWS    (CHART_BANKS * 8)
+#define CHART_STEP    4              // 1/16 C per pixel row (0.25 C)
+#define CHART_SPAN    (CHART_ROWS * CHART_STEP)
+#define CHART_PERIOD_MS 1000
+
+i16 chart_value[CHART_COLUMNS];      // readings of columns [1/16 C]
+u8 chart_n = 0;                      // columns with reading
+u8 chart_x = 0;                      // column of next reading
+i16 chart_low;                       // bottom of scale [1/16 C]
+// SPI bytes of last reading, maximum of incremental ones and count of
+// full redraws
+u16 chart_bytes = 0;
+u16 chart_bytes_max = 0;
+u16 chart_redraws = 0;
+
+// pixel row of reading (0 - top), readings off the scale (older ones
+// after rescale) are clipped to top or bottom row
+static u8 chart_row(i16 v)
+{
+    i16 r = (i16)(CHART_ROWS - 1 - (v - chart_low) / CHART_STEP);
+
+    if (r < 0){
+        return 0;
+    }
+    return r >= CHART_ROWS ? CHART_ROWS - 1 : (u8)r;
+}
+
+// byte of chart column x in bank b (0..CHART_BANKS-1): vertical line
+// from previous reading to this one, so steps stay connected
+static u8 chart_byte(u8 x, u8 b)
+{
+    u8 prev = x ? x - 1 : CHART_COLUMNS - 1;
+    u8 top, bottom, r;
+    u8 bits = 0;
+
+    if (x >= chart_n || x == chart_x){
+        return 0; // no reading yet or gap
+    }
+    top = bottom = chart_row(chart_value[x]);
+    if (prev < chart_n && prev != chart_x){
+        r = chart_row(chart_value[prev]);
+        if (r < top) top = r;
+        if (r > bottom) bottom = r;
+    }
+    for (r = 0; r < 8; r++){
+        if (b * 8 + r >= top && b * 8 + r <= bottom){
+            bits |= 1 << r;
+        }
+    }
+    return bits;
+}
+
+// "-5.2", "21.5" (5 characters with padding on the left) to buf[6]
+static void chart_format(char *buf, i16 v)
+{
+    u16 t = (u16)(v < 0 ? -v : v);
+    u8 i;
+
+    t = (u16)(t * 10UL / 16);   // 0.1 C
+    if (t > 999){
+        t = 999;
+    }
+    for (i = 0; i < 5; i++){
+        buf[i] = ' ';
+    }
+    buf[5] = '\0';
+    buf[4] = '0' + t % 10;
+    buf[3] = '.';
+    i = 2;
+    t /= 10;
+    do {
+        buf[i--] = '0' + t % 10;
+        t /= 10;
+    } while (t);
+    if (v < 0){
+        buf[i] = '-';
+    }
+}
+
+// text at column x of text line y
+static void chart_text(u8 x, u8 y, const char *text)
+{
+    LCDSend(0x80 | x, SEND_CMD);
+    LCDSend(0x40 | y, SEND_CMD);
+    LCDputs(text);
+}
+
+// scale labels, reading and all chart columns
+static void chart_draw(void)
+{
+    char buf[6];
+    u8 x, b;
+
+    chart_format(buf, chart_low + CHART_SPAN);
+    chart_text(0, 0, buf);
+    chart_format(buf, chart_low);
+    chart_text(0, LCD_TEXTLINES - 1, buf);
+    chart_text(LCD_COLUMNS - 4 * 5, LCD_TEXTLINES - 1, "84 s");
+    for (b = 0; b < CHART_BANKS; b++){
+        LCDSend(0x80, SEND_CMD);
+        LCDSend(0x40 | (CHART_BANK + b), SEND_CMD);
+        for (x = 0; x < CHART_COLUMNS; x++){
+            LCDSend(chart_byte(x, b), SEND_DATA);
+        }
+    }
+}
+
+// demo readings - this board has no sensor: random walk from 21 C
+static i16 chart_reading(void)
+{
+    static u16 lfsr = 0xACE1;
+    static i16 v = 21 * 16;
+
+    lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+    v += (i16)(lfsr % 7) - 3;
+    return v;
+}
+
+// adds reading to chart every CHART_PERIOD_MS, redraws its column, gap
+// and reading label (whole chart when reading is out of scale)
+void chart_task(void)
+{
+    i16 v = chart_reading();
+    u8 x = chart_x;
+    u8 b;
+    char buf[6];
+    PROF_ENTER(prof_start);
+
+    TRACE(TRACE_RING_MAIN, TRACE_SPI_BURST, 1, 0);
+    lcd_bytes = 0;
+    chart_value[x] = v;
+    if (chart_n <= x){
+        chart_n = x + 1;
+    }
+    chart_x = x + 1 == CHART_COLUMNS ? 0 : x + 1;
+    if (chart_n == 1 || v < chart_low || v >= chart_low + CHART_SPAN){
+        // reading in the middle of new scale (whole degrees)
+        chart_low = (i16)((v - CHART_SPAN / 2) & ~15);
+        chart_draw();
+        chart_redraws++;
+    } else {
+        for (b = 0; b < CHART_BANKS; b++){
+            LCDSend(0x80 | x, SEND_CMD);
+            LCDSend(0x40 | (CHART_BANK + b), SEND_CMD);
+            LCDSend(chart_byte(x, b), SEND_DATA);
+            if (x + 1 < CHART_COLUMNS){
+                LCDSend(chart_byte(x + 1, b), SEND_DATA);
+            }
+        }
+        // gap wrapped to the left edge
+        if (chart_x == 0){
+            for (b = 0; b < CHART_BANKS; b++){
+                LCDSend(0x80, SEND_CMD);
+                LCDSend(0x40 | (CHART_BANK + b), SEND_CMD);
+                LCDSend(0, SEND_DATA);
+            }
+        }
+    }
+    chart_format(buf, v);
+    chart_text(LCD_COLUMNS - 5 * 5, 0, buf);
+    chart_bytes = lcd_bytes;
+    if (chart_bytes > chart_bytes_max && chart_n > 1){
+        chart_bytes_max = chart_bytes;
+    }
+    TRACE(TRACE_RING_MAIN, TRACE_SPI_BURST, 0, chart_bytes);
+    PROF_EXIT(PROF_LCD_FRAME, prof_start);
+    wdt_checkin(roll_wdt_id);
+    sched_wake_in(chart_task_id, SCHED_MS(CHART_PERIOD_MS));
+}
+
+// report CPU load to UART every second, line is skipped when TX ring
+// has no room for it (text output never waits for UART)
+void load_task(void)
+{
+    load_update();
+    if (uart_tx_free() >= LOAD_LINE_MAX){
+        load_print(uart_putc);
+    }
+    sched_wake_in(load_task_id, SCHED_MS(1000));
+}
+
+// drain event trace to UART (binary frames, see ../common/trace.h) as
+// far as TX ring has room, records that did not fit follow in 50 ms
+void trace_task(void)
+{
+    u8 pending = trace_pending();
+
+    sched_wake_in(trace_task_id, trace_dump(uart_putc, uart_tx_free()) < pending ?
+                  SCHED_MS(50) : SCHED_MS(500));
+}
+
+// overrides weak function in sched.c - nothing is ready to run
+void sched_idle(void)
+{
+    load_idle();
+}
+
+// dump profiler table and stack usage to UART every 10 s, a line at a
+// time when TX ring has room for it
+void prof_task(void)
+{
+    static u8 line = 0;
+
+    while (line <= PROF_COUNT && uart_tx_free() >= PROF_LINE_MAX){
+        prof_dump_line(uart_putc, line++);
+    }
+    if (line <= PROF_COUNT || uart_tx_free() < STACK_LINE_MAX){
+        sched_wake_in(prof_task_id, SCHED_MS(10));
+        return;
+    }
+    stack_print(uart_putc);
+    line = 0;
+    sched_wake_in(prof_task_id, SCHED_MS(10000));
+}
+
+// overrides weak function in crash.c - trap time in TMR1 ticks
+uint32_t crash_timestamp(void)
+{
+    return systime_ticks;
+}
+
 int main(void)
 {
+#if !LCD_CHART
     u8 y;
     u8 x;
+#endif
+
+    // for stack high-water mark reported by prof_task()
+    stack_paint();
     // initialize the device
     SYSTEM_Initialize();
+    uart_init();
+    prof_init();
+    trace_init();
+    TRACE(TRACE_RING_MAIN, TRACE_BOOT, 0, RCON);
+    // report trap that caused last reset (see traps.c)
+    crash_init();
+    crash_report(uart_putc);
+    sched_init();
+    led_task_id = sched_add(led_task);
+    roll_task_id = sched_add(roll_task);
+    prof_task_id = sched_add(prof_task);
+    load_task_id = sched_add(load_task);
+    trace_task_id = sched_add(trace_task);
+    chart_task_id = sched_add(chart_task);
+    roll_wdt_id = wdt_add(ROLL_WDT_DEADLINE);
     LCD_init();
     TMR1_Start();
     INTERRUPT_GlobalEnable();
     
+#if !LCD_CHART
     for(y=0;y!=LCD_TEXTLINES;y++){
         LCDSend(0x80, SEND_CMD); // set X address to 0
         LCDSend(0x40+y, SEND_CMD); // set Y address to 1
@@ -379,23 +720,24 @@ int main(void)
             
         }
     }
+#endif
     // render text for scrolling to PIC RAM
     BUFFERputs(ROLL_TEXT,ROLL_BUFFER,sizeof(ROLL_BUFFER));
-    __delay_ms(1000); // wait a bit and then start rolling text in bottom line
-    while (1)
-    {
-        u8 ofs;
-        for(ofs=0;ofs!=sizeof(ROLL_BUFFER);ofs++){
-            LCDSend(0x80, SEND_CMD); // set X address to 0
-            LCDSend(0x40+(LCD_TEXTLINES-1), SEND_CMD); // set Y address to last line
-            // copy whole line to LCD
-            for(x=0;x<LCD_COLUMNS;x++){
-                LCDSend( ROLL_BUFFER[ (x+ofs) % ((u8)sizeof(ROLL_BUFFER)) ],
-                        SEND_DATA);
-            }
-            __delay_ms(100);
-        }
-    }
+    // no-load reference for CPU load meter (takes 100 ms)
+    load_calibrate(sched_run_once, SCHED_MS(100));
+    sched_wake_in(led_task_id, 0);
+#if LCD_CHART
+    sched_wake_in(chart_task_id, 0);
+#else
+    // wait a bit and then start rolling text in bottom line
+    sched_wake_in(roll_task_id, SCHED_MS(1000));
+#endif
+    sched_wake_in(prof_task_id, SCHED_MS(10000));
+    sched_wake_in(load_task_id, SCHED_MS(1000));
+    sched_wake_in(trace_task_id, SCHED_MS(500));
+    // supervise LCD frames (see ../common/wdt.h)
+    wdt_start();
+    sched_run(); // never returns
 
     return 1;
 }
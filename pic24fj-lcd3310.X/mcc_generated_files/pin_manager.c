@@ -92,8 +92,10 @@ void PIN_MANAGER_Initialize (void)
      ***************************************************************************/
     __builtin_write_OSCCONL(OSCCON & 0xbf); // unlock PPS
 
+    RPOR1bits.RP2R = 0x0003;    //RB2->UART1:U1TX
     RPOR3bits.RP7R = 0x0008;    //RB7->SPI1:SCK1OUT
     RPOR4bits.RP9R = 0x0007;    //RB9->SPI1:SDO1
+    RPINR18bits.U1RXR = 0x0003;    //RB3->UART1:U1RX
     RPINR20bits.SDI1R = 0x0008;    //RB8->SPI1:SDI1
 
     __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
@@ -71,10 +71,10 @@
 #pragma config IESO = OFF    //Internal External Switchover->IESO mode (Two-Speed Start-up) disabled
 
 // CONFIG1
-#pragma config WDTPS = PS32768    //Watchdog Timer Postscaler->1:32768
-#pragma config FWPSA = PR128    //WDT Prescaler->Prescaler ratio of 1:128
+#pragma config WDTPS = PS128    //Watchdog Timer Postscaler->1:128
+#pragma config FWPSA = PR32    //WDT Prescaler->Prescaler ratio of 1:32
 #pragma config WINDIS = OFF    //Windowed WDT->Standard Watchdog Timer enabled,(Windowed-mode is disabled)
-#pragma config FWDTEN = OFF    //Watchdog Timer->Watchdog Timer is disabled
+#pragma config FWDTEN = OFF    //Watchdog Timer->Watchdog Timer is disabled (enabled by SWDTEN, see ../common/wdt.h)
 #pragma config ICS = PGx1    //Emulator Pin Placement Select bits->Emulator functions are shared with PGEC1/PGED1
 #pragma config GWRP = OFF    //General Segment Write Protect->Writes to program memory are allowed
 #pragma config GCP = OFF    //General Segment Code Protect->Code protection is disabled
@@ -49,12 +49,15 @@
 
 #include <stdio.h>
 #include "tmr1.h"
+#include "prof.h"
 
 /**
  Section: File specific functions
 */
+#if !TMR1_STATIC_CALLBACK
 void (*TMR1_InterruptHandler)(void) = NULL;
 void TMR1_CallBack(void);
+#endif
 
 /**
   Section: Data Type Definitions
@@ -73,6 +76,7 @@ void TMR1_CallBack(void);
     None.
 */
 
+#if !TMR1_STATIC_CALLBACK
 typedef struct _TMR_OBJ_STRUCT
 {
     /* Timer Elapsed */
@@ -83,6 +87,7 @@ typedef struct _TMR_OBJ_STRUCT
 } TMR_OBJ;
 
 static TMR_OBJ tmr1_obj;
+#endif
 
 /**
   Section: Driver Interface
@@ -92,27 +97,37 @@ void TMR1_Initialize (void)
 {
     //TMR1 0; 
     TMR1 = 0x00;
-    //Period = 0.100032 s; Frequency = 4000000 Hz; PR1 1562; 
-    PR1 = 0x61A;
-    //TCKPS 1:256; TON enabled; TSIDL disabled; TCS FOSC/2; TSYNC disabled; TGATE disabled; 
-    T1CON = 0x8030;
+    //Period = 0.0025 s; Frequency = 4000000 Hz; PR1 9999; 
+    PR1 = 0x270F;
+    //TCKPS 1:1; TON enabled; TSIDL disabled; TCS FOSC/2; TSYNC disabled; TGATE disabled; 
+    T1CON = 0x8000;
 
+#if !TMR1_STATIC_CALLBACK
     if(TMR1_InterruptHandler == NULL)
     {
         TMR1_SetInterruptHandler(&TMR1_CallBack);
     }
+#endif
 
     IFS0bits.T1IF = false;
     IEC0bits.T1IE = true;
 	
+#if !TMR1_STATIC_CALLBACK
     tmr1_obj.timerElapsed = false;
+#endif
 
 }
 
 
+#if !TMR1_STATIC_CALLBACK
 void __attribute__ ( ( interrupt, no_auto_psv ) ) _T1Interrupt (  )
 {
+    PROF_ENTER(prof_start);
+
     /* Check if the Timer Interrupt/Status is set */
+    /* Flag is cleared before callback, so that callback (and systime.c)
+     * can detect next pending rollover */
+    IFS0bits.T1IF = false;
 
     //***User Area Begin
 
@@ -127,15 +142,19 @@ void __attribute__ ( ( interrupt, no_auto_psv ) ) _T1Interrupt (  )
 
     tmr1_obj.count++;
     tmr1_obj.timerElapsed = true;
-    IFS0bits.T1IF = false;
+    PROF_EXIT(PROF_T1_ISR, prof_start);
 }
 
+#endif
+
 void TMR1_Period16BitSet( uint16_t value )
 {
     /* Update the counter values */
     PR1 = value;
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 }
 
 uint16_t TMR1_Period16BitGet( void )
@@ -147,8 +166,10 @@ void TMR1_Counter16BitSet ( uint16_t value )
 {
     /* Update the counter values */
     TMR1 = value;
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 }
 
 uint16_t TMR1_Counter16BitGet( void )
@@ -156,6 +177,7 @@ uint16_t TMR1_Counter16BitGet( void )
     return( TMR1 );
 }
 
+#if !TMR1_STATIC_CALLBACK
 
 void __attribute__ ((weak)) TMR1_CallBack(void)
 {
@@ -168,11 +190,14 @@ void  TMR1_SetInterruptHandler(void (* InterruptHandler)(void))
     TMR1_InterruptHandler = InterruptHandler; 
     IEC0bits.T1IE = true;
 }
+#endif
 
 void TMR1_Start( void )
 {
+#if !TMR1_STATIC_CALLBACK
     /* Reset the status information */
     tmr1_obj.timerElapsed = false;
+#endif
 
     /*Enable the interrupt*/
     IEC0bits.T1IE = true;
@@ -190,6 +215,7 @@ void TMR1_Stop( void )
     IEC0bits.T1IE = false;
 }
 
+#if !TMR1_STATIC_CALLBACK
 bool TMR1_GetElapsedThenClear(void)
 {
     bool status;
@@ -212,6 +238,7 @@ void TMR1_SoftwareCounterClear(void)
 {
     tmr1_obj.count = 0; 
 }
+#endif
 
 /**
  End of File
@@ -13,10 +13,16 @@
     - RA2/PIN9 - Display mux 2nd Digit
     - RA3/PIN10 - Display mux 3rd Digit 
     - RA4/PIN12 - Display mux 4th Digit
+    - RB2/PIN6 - UART1 TX (38400 Bd, 8N1) - profiler output, event
+      trace and telemetry frames (../common/telem.h); built with
+      MODBUS_ENABLE=1 Modbus RTU slave instead (../common/modbus.h,
+      input registers below at MODBUS_REG_*)
+    - RB3/PIN7 - UART1 RX
     - RB4/PIN11 - seg A, PIN11
     - RB5/PIN14 - seg F, PIN10
     - RB7/PIN16 - seg B, PIN7
-    - RB8 - Dallas DS18B20, DQ, open-drain (really?)
+    - RB8 - Dallas DS18B20, DQ, open-drain (really?), more sensors
+      may be added on own buses (other RBx pins, see DALLAS_BUSES)
     - RB9 - Dallas Debug (Output for Analyzer)
     - RB10/PIN21 - seg E, PIN1
     - RB11/PIN22 - seg D, PIN2
@@ -65,6 +71,25 @@
 #include <libpic30.h>  // __delay_xs())
 
 #include "mcc_generated_files/mcc.h"
+#include "sched.h"
+#include "systime.h"
+#include "uart.h"
+#include "out.h"
+#include "prof.h"
+#include "load.h"
+#include "trace.h"
+#include "crc8.h"
+#include "crash.h"
+#include "wdt.h"
+#include "stack.h"
+#include "irq.h"
+#include "owbus.h"
+#include "sampling.h"
+#include "dee.h"
+#include "flog.h"
+#include "hist.h"
+#include "telem.h"
+#include "modbus.h"
 
 #include<stdbool.h>
 #include<stdint.h>
@@ -72,6 +97,7 @@
 typedef uint8_t u8;
 typedef uint16_t u16;
 typedef int16_t i16;
+typedef uint32_t u32;
 
 // 4-bit code to 7-seg display
 //     A
@@ -117,16 +143,21 @@ volatile u8 disp_digits[4] = { 0,0,0,0 };
 volatile u16 counter = 0;
 // force display blank
 volatile bool blank = false;
-// automatically overrides weak function in tmr1.c:
+// called from TMR1 ISR, bound at compile time (see tmr1.h):
 // TMR1 Period is 2.5 ms ( 400 Hz)
 // we have to multiplex 4 digits on LED display, so 
 // LED display frequency is 400 Hz / 4 = 100 Hz
-void TMR1_CallBack(void)
+TMR1_CALLBACK void TMR1_CallBack(void)
 {
     u8 mux;
     u8 digit_data;
+    PROF_ENTER(prof_start);
     
     counter++;
+    systime_tick();
+    sched_tick();
+    load_tick();
+    wdt_tick();
     // REMOVED: Blink LED at 1Hz - toggle must be at 2 Hz (1:200) to get freq 1 Hz
     if (counter % 200 == 0){
         // RED_LED_RA0_Toggle();
@@ -139,6 +170,7 @@ void TMR1_CallBack(void)
         // turn of all segments (not required but better for analyzer)
         SEG_A_SetHigh();SEG_B_SetHigh();SEG_C_SetHigh();SEG_D_SetHigh();
         SEG_E_SetHigh();SEG_F_SetHigh();SEG_G_SetHigh();SEG_DP_SetHigh();
+        PROF_EXIT(PROF_T1_CALLBACK, prof_start);
         return;
     }
     
@@ -174,13 +206,14 @@ void TMR1_CallBack(void)
     if (digit_data & 0x04) SEG_F_SetLow(); else SEG_F_SetHigh();
     if (digit_data & 0x02) SEG_G_SetLow(); else SEG_G_SetHigh();
     if (digit_data & 0x01) SEG_DP_SetLow(); else SEG_DP_SetHigh();   
+    if (IFS0bits.T1IF){
+        // next period already elapsed - display multiplex lost a tick
+        TRACE(TRACE_RING_ISR, TRACE_ISR_OVERRUN, 0, TMR1);
+    }
+    PROF_EXIT(PROF_T1_CALLBACK, prof_start);
 }
-
-void wait4interrupt(void)
-{
-    u16 old_counter = counter;
-    while (old_counter == counter); // NOP
-}
+// _T1Interrupt with inlined TMR1_CallBack (see TMR1_STATIC_CALLBACK)
+TMR1_ISR(TMR1_CallBack)
 
 
 // Error codes
@@ -189,118 +222,979 @@ void wait4interrupt(void)
 #define EC_RESET_BUSY 0x01
 // device did not respond with present pulse on reset
 #define EC_NOT_PRESENT 0x02
+// CRC of scratchpad does not match
+#define EC_CRC_ERROR 0x03
 
 typedef u8 t_ec; // my type for error codes
 
 // names and portions of code based on:
 // https://www.analog.com/en/technical-articles/1wire-communication-with-a-microchip-picmicro-microcontroller.html
-// here is how Open-Drain output is driven on PIC25FJ
-// Pull down Open-Drain output to DS18B20
-#define DALLAS_OW_LOW() { DALLAS_DQ_SetLow();DEBUG_RB9_SetLow(); }
-// Release (Pull-Up) Open-Drain to DS18B20
-#define DALLAS_OW_HIZ() { DALLAS_DQ_SetHigh();  DEBUG_RB9_SetHigh(); }
-
-// Reset Dallas DS18B20 sensor
-// return false if failed
+// Sensors are read by bit-parallel driver (see ../common/owbus.h): buses
+// are port B pins run in lockstep, each with one or more DS18B20 found
+// by Search ROM. All sensors convert at once (Skip ROM). Sensor shown on
+// display is read every cycle, others only when Alarm Search finds them
+// out of TH/TL band programmed around their last reading, so bus time
+// follows number of changing sensors, not all of them. All sensors are
+// read every DALLAS_FULL_READ cycles. Display shows first sensor on
+// DALLAS_DISPLAY_PIN, others are reported by TRACE_TEMP events.
+#ifndef DALLAS_BUSES
+#define DALLAS_BUSES       (1U << 8)  // RB8 (DALLAS_DQ)
+#endif
+#define DALLAS_DISPLAY_PIN 8
+#define DALLAS_DISPLAY_BUS (1U << DALLAS_DISPLAY_PIN)
+// RB9 follows bus drive (output for analyzer)
+#define DALLAS_DEBUG_PINS  (1U << 9)
+
+// Timing critical parts of 1-wire slots run at IRQ_IPL_ONEWIRE (see irq.h),
+// so display multiplex (TMR1 ISR) may run only between them, where
+// stretching does not matter (reset low, slot recovery).
+
+// buses that answered last reset with presence pulse
+owbus_mask_t dallas_present = 0;
+
+// Reset all Dallas DS18B20 buses
+// returns error of display bus
 t_ec dallas_reset(void)
 {
-    // settle line in Hi-Z (Open-Drain released)
-    DALLAS_OW_HIZ();
-    __delay_us(20);
-    // DQ line should be free
-    if (DALLAS_DQ_GetValue()==0){
+    owbus_mask_t busy;
+
+    dallas_present = owbus_reset(DALLAS_BUSES, &busy);
+    if (busy & DALLAS_DISPLAY_BUS){
         return EC_RESET_BUSY;
     }
-    // trigger reset    
-    DALLAS_OW_LOW();
-    __delay_us(500);
-    // give sensor 70us to respond with presence pulse
-    DALLAS_OW_HIZ();
-    __delay_us(70);
-    // device must hold DQ line - presence pulse
-    if (DALLAS_DQ_GetValue()==1){
+    if (!(dallas_present & DALLAS_DISPLAY_BUS)){
         return EC_NOT_PRESENT;
     }
-    // finish 500uS timeslot
-    __delay_us(400);
     return EC_NO_ERROR;
 }
 
-void dallas_write_byte(u8 data)
+t_ec dallas_start_reset(void)
 {
-    u8 i=0;
-    for(i=0;i<8;i++){
-        // Master write - drive DQ Low
-        DALLAS_OW_LOW();
-        // wait at least 3uS, at most 15uS
-        __delay_us(3);
-        if (data & 1){
-            // release line when sending 1 (LSB first)
-            DALLAS_OW_HIZ();
-        } else {
-            Nop();
+    t_ec err;
+    err = dallas_reset();
+    TRACE(TRACE_RING_MAIN, TRACE_OW_RESET, err, dallas_present);
+    return err;
+}
+
+// sensors on all buses (bit masks of sensor indexes are u32)
+#define DALLAS_MAX_SENSORS 32
+#define DALLAS_NO_SENSOR   0xFF
+#define DALLAS_BIT(i)      ((t_sensor_set)1 << (i))
+typedef u32 t_sensor_set;
+
+// all sensors are read every DALLAS_FULL_READ cycles, in between only
+// displayed and alarming ones
+#define DALLAS_FULL_READ 10
+// TH/TL are DALLAS_ALARM_BAND whole degrees around last reading, sensor
+// alarms when integer part of its temperature moves that far
+#define DALLAS_ALARM_BAND 1
+// TH/TL of sensor without reading - never alarms
+#define DALLAS_TH_OFF 0x7F
+#define DALLAS_TL_OFF 0x80
+
+typedef struct {
+    u8 rom[8];
+    u8 pin;
+    // programmed in sensor scratchpad (resolution 0 - not yet)
+    u8 th, tl, resolution;
+    u16 temp;     // last reading [1/16 C]
+    bool valid;   // temp is valid
+    u16 errors;   // failed reads and losses since boot (wraps)
+} t_dallas_sensor;
+
+t_dallas_sensor dallas_sensors[DALLAS_MAX_SENSORS];
+u8 dallas_count = 0;
+// index of sensor shown on display
+u8 dallas_display = DALLAS_NO_SENSOR;
+// buses with sensors and those with more than one (need Match ROM)
+owbus_mask_t dallas_known = 0;
+owbus_mask_t dallas_multi = 0;
+// sensors changed (unknown alarming one, missing one) - search again
+bool dallas_rescan = true;
+// table was loaded from flash (dallas_load()) - search once to verify it
+// after first reading (measure_task())
+bool dallas_verify = false;
+// counts cycles to full read
+u8 dallas_cycle = 0;
+// state of Search ROM / Alarm Search (static - keeps stack small)
+owbus_search_t dallas_search;
+
+// current Temp of display bus returned in this variable by dallas_read_temperature(void)
+u16  dallas_temp = 0;
+
+// slot timing is re-tuned when CRC errors climb (see ../common/owbus.h):
+// DALLAS_TUNE_ERRORS within DALLAS_TUNE_WINDOW scratchpad reads
+#define DALLAS_TUNE_WINDOW 16
+#define DALLAS_TUNE_ERRORS 2
+u8 dallas_reads = 0;
+u8 dallas_crc_errors = 0;
+// totals since boot (telemetry counters)
+u32 dallas_read_count = 0;
+u32 dallas_error_count = 0;
+
+// sensor table or slot timing changed, save them (settings_save())
+bool settings_changed = false;
+
+// measures buses and tunes slot timing, reports it to UART
+void dallas_tune(void)
+{
+    bool ok = owbus_calibrate(DALLAS_BUSES);
+
+    TRACE(TRACE_RING_MAIN, TRACE_OW_TUNE, ok, owbus_timing.sample);
+    uart_puts("ow tune: rise ");
+    uart_put_u32(owbus_timing.rise);
+    uart_puts(" hold ");
+    uart_put_u32(owbus_timing.hold);
+    uart_puts(" sample ");
+    uart_put_u32(owbus_timing.rlow + owbus_timing.sample);
+    uart_puts(" recovery ");
+    uart_put_u32(owbus_timing.recovery);
+    uart_puts(ok ? " cycles\r\n" : " cycles, out of limits\r\n");
+    settings_changed = true;
+    dallas_reads = 0;
+    dallas_crc_errors = 0;
+}
+
+// prints ROM code as family-serial, for example 28-0000056A1B2C
+static void dallas_put_rom(const u8 *rom)
+{
+    u8 i = 0;
+
+    do {
+        out_hex(uart_putc, rom[i], 2);
+        if (i == 0){
+            uart_putc('-');
+            i = 7;
         }
-        // keep timeslot must be between 60 us and 120 us
-        __delay_us(60);
-        DALLAS_OW_HIZ();
-        __delay_us(2);
-        data >>= 1;
-    }
-}
-
-u8 dallas_read_byte(void)
-{
-    u8 i=0, data=0;
-    for(i=0;i<8;i++){
-        data >>= 1;
-        // Master read - drive DQ Low
-        DALLAS_OW_LOW();
-        // wait 6 us
-        __delay_us(6);
-        // release DQ line
-        DALLAS_OW_HIZ();
-        // wait 4 us for response
-        __delay_us(4);
-        if (DALLAS_DQ_GetValue()){
-            data |= 0x80;
-        } else {
-            Nop();
+    } while (--i);
+}
+
+// index of sensor with ROM code on bus 'pin', DALLAS_NO_SENSOR if none
+static u8 dallas_find(u8 pin, const u8 *rom)
+{
+    u8 i, j;
+
+    for (i = 0; i < dallas_count; i++){
+        if (dallas_sensors[i].pin != pin){
+            continue;
+        }
+        for (j = 0; j < 8 && dallas_sensors[i].rom[j] == rom[j]; j++){
+        }
+        if (j == 8){
+            return i;
         }
-        // keep timeslot - total time must be between 60us and 120us
-        __delay_us(50);
     }
-    return data;
+    return DALLAS_NO_SENSOR;
 }
 
-t_ec dallas_start_reset(void)
+// buses with sensors, multi-drop buses and display sensor from table
+static void dallas_index(void)
+{
+    owbus_mask_t bus;
+    u8 i;
+
+    dallas_display = DALLAS_NO_SENSOR;
+    dallas_known = 0;
+    dallas_multi = 0;
+    for (i = 0; i < dallas_count; i++){
+        bus = 1U << dallas_sensors[i].pin;
+        if (dallas_known & bus){
+            dallas_multi |= bus;
+        }
+        dallas_known |= bus;
+        if (dallas_sensors[i].pin == DALLAS_DISPLAY_PIN && dallas_display == DALLAS_NO_SENSOR){
+            dallas_display = i;
+        }
+    }
+}
+
+// finds all sensors (Search ROM) and merges them to table: known ones
+// keep their state (reading, programmed band), new ones are appended,
+// missing ones dropped; changed table is printed to UART and saved
+void dallas_enumerate(void)
 {
-    wait4interrupt(); // ensure that 1-wire communication is not disturbed by TMR1
-    return dallas_reset();   
+    t_sensor_set seen = 0;
+    owbus_mask_t found;
+    t_dallas_sensor *s;
+    bool changed = false;
+    u8 i, n, pin;
+
+    owbus_search_start(&dallas_search, DALLAS_BUSES, 0xF0);
+    while ((found = owbus_search_next(&dallas_search))){
+        for (pin = 0; pin < 16; pin++){
+            if (!(found & (1U << pin))){
+                continue;
+            }
+            i = dallas_find(pin, dallas_search.rom[pin]);
+            if (i == DALLAS_NO_SENSOR){
+                if (dallas_count == DALLAS_MAX_SENSORS){
+                    continue;
+                }
+                i = dallas_count++;
+                s = &dallas_sensors[i];
+                for (n = 0; n < 8; n++){
+                    s->rom[n] = dallas_search.rom[pin][n];
+                }
+                s->pin = pin;
+                s->resolution = 0;
+                s->valid = false;
+                s->errors = 0;
+                changed = true;
+            }
+            seen |= DALLAS_BIT(i);
+        }
+    }
+    for (i = n = 0; i < dallas_count; i++){
+        if (seen & DALLAS_BIT(i)){
+            dallas_sensors[n++] = dallas_sensors[i];
+        }
+    }
+    changed = changed || n != dallas_count;
+    dallas_count = n;
+    dallas_index();
+    TRACE(TRACE_RING_MAIN, TRACE_OW_SEARCH, dallas_count, dallas_known);
+    dallas_rescan = false;
+    dallas_verify = false;
+    if (!changed){
+        return;
+    }
+    for (i = 0; i < dallas_count; i++){
+        uart_puts("ow sensor ");
+        uart_put_u32(i);
+        uart_puts(": RB");
+        uart_put_u32(dallas_sensors[i].pin);
+        uart_putc(' ');
+        dallas_put_rom(dallas_sensors[i].rom);
+        uart_puts("\r\n");
+    }
+    settings_changed = true;
+    // new sensors have no reading yet
+    dallas_cycle = DALLAS_FULL_READ - 1;
 }
 
-// current Temp returned in this variable by dallas_get_temperature(void)
-u16  dallas_temp = 0;
-t_ec dallas_get_temperature(void)
+// Sensors of one bus are accessed one after another, buses in lockstep:
+// each round takes one sensor of every bus from 'todo' (removed from it),
+// sel[pin] is its index; returns buses of round
+static owbus_mask_t dallas_round(t_sensor_set *todo, u8 *sel)
+{
+    owbus_mask_t buses = 0, bus;
+    u8 i;
+
+    for (i = 0; i < dallas_count; i++){
+        bus = 1U << dallas_sensors[i].pin;
+        if ((*todo & DALLAS_BIT(i)) && !(buses & bus)){
+            buses |= bus;
+            sel[dallas_sensors[i].pin] = i;
+            *todo &= ~DALLAS_BIT(i);
+        }
+    }
+    return buses;
+}
+
+// resets buses of round and selects its sensors: Skip ROM when all of
+// them are alone on bus, Match ROM otherwise; returns buses that
+// answered (busy ones in *busy)
+static owbus_mask_t dallas_select(owbus_mask_t buses, const u8 *sel, owbus_mask_t *busy)
+{
+    const u8 *roms[16];
+    owbus_mask_t present;
+    u8 pin;
+
+    present = owbus_reset(buses, busy);
+    if (!present){
+        return 0;
+    }
+    if (!(present & dallas_multi)){
+        owbus_write_byte(present, 0xCC); // Skip ROM
+        return present;
+    }
+    for (pin = 0; pin < 16; pin++){
+        if (present & (1U << pin)){
+            roms[pin] = dallas_sensors[sel[pin]].rom;
+        }
+    }
+    owbus_write_byte(present, 0x55); // Match ROM
+    owbus_write_each(present, roms, 8);
+    return present;
+}
+
+// TH/TL alarm band of sensor around its last reading
+static void dallas_band(const t_dallas_sensor *s, u8 *th, u8 *tl)
+{
+    i16 t = (i16)s->temp >> 4;
+
+    if (!s->valid){
+        *th = DALLAS_TH_OFF;
+        *tl = DALLAS_TL_OFF;
+        return;
+    }
+    *th = (u8)(t + DALLAS_ALARM_BAND > 127 ? 127 : t + DALLAS_ALARM_BAND);
+    *tl = (u8)(t - DALLAS_ALARM_BAND < -128 ? -128 : t - DALLAS_ALARM_BAND);
+}
+
+// writes alarm band and resolution (9..12 bits) to sensors where they
+// differ from programmed ones (Write Scratchpad, not copied to E2)
+static void dallas_program(u8 resolution)
+{
+    u8 data[16][3];
+    const u8 *p[16];
+    u8 sel[16];
+    owbus_mask_t buses, present, busy;
+    t_dallas_sensor *s;
+    t_sensor_set todo = 0;
+    u8 i, pin, th, tl;
+
+    for (i = 0; i < dallas_count; i++){
+        s = &dallas_sensors[i];
+        dallas_band(s, &th, &tl);
+        if (th != s->th || tl != s->tl || resolution != s->resolution){
+            todo |= DALLAS_BIT(i);
+        }
+    }
+    while (todo){
+        buses = dallas_round(&todo, sel);
+        present = dallas_select(buses, sel, &busy);
+        if (!present){
+            continue;
+        }
+        for (pin = 0; pin < 16; pin++){
+            if (present & (1U << pin)){
+                dallas_band(&dallas_sensors[sel[pin]], &data[pin][0], &data[pin][1]);
+                // config: R1 R0 in bits 6..5, others read as 1
+                data[pin][2] = (u8)((resolution - 9) << 5) | 0x1F;
+                p[pin] = data[pin];
+            }
+        }
+        owbus_write_byte(present, 0x4E); // Write Scratchpad: TH, TL, config
+        owbus_write_each(present, p, 3);
+        for (pin = 0; pin < 16; pin++){
+            if (present & (1U << pin)){
+                s = &dallas_sensors[sel[pin]];
+                s->th = data[pin][0];
+                s->tl = data[pin][1];
+                s->resolution = resolution;
+            }
+        }
+    }
+}
+
+// 1st half of measurement: trigger conversion on all present sensors
+// with given resolution (9..12 bits), temperature must be read after
+// conversion time (93.75 ms at 9 bits, doubled per bit, 750 ms at 12)
+t_ec dallas_start_conversion(u8 resolution)
 {
     t_ec err;
-    dallas_temp = 0;
+    if (dallas_rescan){
+        dallas_enumerate();
+    }
+    dallas_program(resolution);
     err = dallas_start_reset();
-    if (err) return err;
-    dallas_write_byte(0xCC); // Send Skip ROM Command (0xCC)
-    dallas_write_byte(0x44); // Convert T
-    __delay_ms(800); // wait at least 740 ms
+    if (!dallas_present) return err;
+    if (dallas_present & ~dallas_known){
+        // sensor connected to empty bus
+        dallas_rescan = true;
+    }
+    owbus_write_byte(dallas_present, 0xCC); // Send Skip ROM Command (0xCC)
+    owbus_write_byte(dallas_present, 0x44); // Convert T
+    return err;
+}
 
-    // to read data we have to: RESET and read temperature
-    err = dallas_start_reset();
+// Alarm Search - sensors out of their band since last conversion,
+// unknown alarming sensor leads to new Search ROM
+static t_sensor_set dallas_alarms(void)
+{
+    t_sensor_set alarms = 0;
+    owbus_mask_t found, buses = 0;
+    u8 i, pin, n = 0;
+
+    owbus_search_start(&dallas_search, dallas_known, 0xEC);
+    while ((found = owbus_search_next(&dallas_search))){
+        buses |= found;
+        for (pin = 0; pin < 16; pin++){
+            if (!(found & (1U << pin))){
+                continue;
+            }
+            i = dallas_find(pin, dallas_search.rom[pin]);
+            if (i == DALLAS_NO_SENSOR){
+                dallas_rescan = true;
+            } else {
+                alarms |= DALLAS_BIT(i);
+                n++;
+            }
+        }
+    }
+    TRACE(TRACE_RING_MAIN, TRACE_OW_ALARM, n, buses);
+    return alarms;
+}
+
+// DS18B20 scratchpad: TEMP LSB, TEMP MSB, TH, TL, CONFIG, 3x reserved, CRC
+#define DALLAS_SCRATCHPAD_LEN 9
+#define DALLAS_CONFIG 4
+#define DALLAS_CONFIG_ONES 0x1F
+
+// reads scratchpads of sensors in 'todo' (one sensor of each bus at once)
+// and checks CRCs; returns error of display sensor
+static t_ec dallas_read_sensors(t_sensor_set todo)
+{
+    // one PORTB sample per bit (static - keeps stack small)
+    static u16 samples[8*DALLAS_SCRATCHPAD_LEN];
+    t_ec err = EC_NO_ERROR;
+    t_dallas_sensor *s;
+    owbus_mask_t buses, present, busy;
+    u8 sp[DALLAS_SCRATCHPAD_LEN];
+    u8 sel[16];
+    u8 i, pin, crc;
+
+    while (todo){
+        buses = dallas_round(&todo, sel);
+        present = dallas_select(buses, sel, &busy);
+        for (pin = 0; pin < 16; pin++){
+            if ((buses & ~present) & (1U << pin)){
+                // sensor lost - search again
+                dallas_sensors[sel[pin]].valid = false;
+                dallas_sensors[sel[pin]].errors++;
+                dallas_rescan = true;
+                if (sel[pin] == dallas_display){
+                    err = busy & (1U << pin) ? EC_RESET_BUSY : EC_NOT_PRESENT;
+                }
+            }
+        }
+        if (!present){
+            continue;
+        }
+        owbus_write_byte(present, 0xBE); // Read ScratchPad
+        // whole scratchpad is read to verify CRC
+        PROF_ENTER(prof_start);
+        owbus_read(present, samples, DALLAS_SCRATCHPAD_LEN);
+        PROF_EXIT(PROF_DALLAS_READ, prof_start);
+        for(pin=0;pin<16;pin++){
+            if (!(present & (1U << pin))){
+                continue;
+            }
+            s = &dallas_sensors[sel[pin]];
+            for(i=0;i<DALLAS_SCRATCHPAD_LEN;i++){
+                sp[i] = owbus_byte(samples, i, pin);
+            }
+            crc = crc8(sp, DALLAS_SCRATCHPAD_LEN-1);
+            dallas_reads++;
+            dallas_read_count++;
+            // all zeros (bus stuck low, sampled too early) pass CRC, low
+            // 5 bits of config register always read as 1
+            if (crc != sp[DALLAS_SCRATCHPAD_LEN-1] ||
+                    (sp[DALLAS_CONFIG] & DALLAS_CONFIG_ONES) != DALLAS_CONFIG_ONES){
+                dallas_crc_errors++;
+                dallas_error_count++;
+                s->errors++;
+                TRACE(TRACE_RING_MAIN, TRACE_OW_CRC_FAIL, sel[pin], (u16)crc << 8 | sp[DALLAS_SCRATCHPAD_LEN-1]);
+                if (sel[pin] == dallas_display){
+                    err = EC_CRC_ERROR;
+                }
+                continue;
+            }
+            // bits below resolution are undefined
+            s->temp = ((u16)sp[0] | (u16)sp[1] << 8) &
+                    (u16)(0xFFFF << (12 - (s->resolution ? s->resolution : 12)));
+            s->valid = true;
+            TRACE(TRACE_RING_MAIN, TRACE_TEMP, sel[pin], s->temp);
+#if !MODBUS_ENABLE
+            telem_samples(sel[pin], (u32)systime_us(), 0, (const i16 *)&s->temp, 1);
+#endif
+        }
+    }
+    return err;
+}
+
+// 2nd half of measurement: read display sensor and alarming ones (all
+// of them every DALLAS_FULL_READ cycles)
+t_ec dallas_read_temperature(void)
+{
+    t_sensor_set todo;
+    t_ec err;
+    dallas_temp = 0;
+    if (++dallas_cycle >= DALLAS_FULL_READ){
+        dallas_cycle = 0;
+        todo = dallas_count < DALLAS_MAX_SENSORS ? DALLAS_BIT(dallas_count) - 1 : ~(t_sensor_set)0;
+    } else {
+        todo = dallas_alarms();
+    }
+    if (dallas_display != DALLAS_NO_SENSOR){
+        todo |= DALLAS_BIT(dallas_display);
+    }
+    err = dallas_read_sensors(todo);
+    if (dallas_display == DALLAS_NO_SENSOR) return EC_NOT_PRESENT;
     if (err) return err;
-    dallas_write_byte(0xCC); // Send Skip ROM Command (0xCC)
-    dallas_write_byte(0xBE); // Read ScratchPad   
-    dallas_temp = (u16)dallas_read_byte();
-    dallas_temp |=  (u16)dallas_read_byte() << 8;
+    dallas_temp = dallas_sensors[dallas_display].temp;
     return EC_NO_ERROR;
 }
 
-void fatal_error(t_ec err)
+// readings of display sensor are logged to flash (../common/flog.h),
+// reports logged span after boot
+void log_init(void)
+{
+    u32 first, last;
+
+    flog_init();
+    if (!flog_span(&first, &last)){
+        return;
+    }
+    uart_puts("log: ");
+    uart_put_u32(first);
+    uart_puts("..");
+    uart_put_u32(last);
+    uart_puts(" s in flash\r\n");
+}
+
+// seconds since boot - time of log and history
+u32 uptime_s(void)
+{
+    return (u32)(systime_us() / 1000000UL);
+}
+
+#if MODBUS_ENABLE
+// Modbus input registers (function 04, ../common/modbus.h), 32-bit
+// values take two registers, high word first
+#define MODBUS_REG_UPTIME    0x0000  // [s], 2 registers
+#define MODBUS_REG_SENSORS   0x0002  // sensors in table
+#define MODBUS_REG_READS     0x0003  // scratchpad reads, 2 registers
+#define MODBUS_REG_ERRORS    0x0005  // failed reads (CRC), 2 registers
+#define MODBUS_REG_REQUESTS  0x0007  // Modbus requests answered
+#define MODBUS_REG_BAD       0x0008  // Modbus frames dropped (CRC, timing)
+#define MODBUS_REG_TEMP      0x0100  // + sensor: last reading [1/16 C]
+#define MODBUS_REG_SENSOR_ERRORS 0x0200 // + sensor: errors of t_dallas_sensor
+#define MODBUS_NO_READING    0x8000  // no sensor or no valid reading
+#define MODBUS_ADDRESS 1
+
+// one input register, false when there is none at 'addr'
+static bool modbus_input(u16 addr, u32 uptime, u16 *v)
+{
+    const t_dallas_sensor *s;
+    u16 i;
+
+    switch (addr){
+        case MODBUS_REG_UPTIME:     *v = (u16)(uptime >> 16); return true;
+        case MODBUS_REG_UPTIME + 1: *v = (u16)uptime; return true;
+        case MODBUS_REG_SENSORS:    *v = dallas_count; return true;
+        case MODBUS_REG_READS:      *v = (u16)(dallas_read_count >> 16); return true;
+        case MODBUS_REG_READS + 1:  *v = (u16)dallas_read_count; return true;
+        case MODBUS_REG_ERRORS:     *v = (u16)(dallas_error_count >> 16); return true;
+        case MODBUS_REG_ERRORS + 1: *v = (u16)dallas_error_count; return true;
+        case MODBUS_REG_REQUESTS:   *v = modbus_requests; return true;
+        case MODBUS_REG_BAD:        *v = modbus_crc_errors + modbus_frame_errors; return true;
+    }
+    i = addr & 0xFF;
+    if (i >= DALLAS_MAX_SENSORS){
+        return false;
+    }
+    s = &dallas_sensors[i];
+    switch (addr & 0xFF00){
+        case MODBUS_REG_TEMP:
+            *v = i < dallas_count && s->valid ? s->temp : MODBUS_NO_READING;
+            return true;
+        case MODBUS_REG_SENSOR_ERRORS:
+            *v = i < dallas_count ? s->errors : 0;
+            return true;
+    }
+    return false;
+}
+
+// register map of ../common/modbus.c, called by modbus_poll() in main
+// loop - readings and counters do not change meanwhile
+uint8_t modbus_read_inputs(uint16_t addr, uint16_t count, uint8_t *data)
+{
+    u32 uptime = uptime_s();
+    u16 v;
+
+    while (count--){
+        if (!modbus_input(addr++, uptime, &v)){
+            return MODBUS_EX_ADDRESS;
+        }
+        *data++ = (u8)(v >> 8);
+        *data++ = (u8)v;
+    }
+    return MODBUS_EX_NONE;
+}
+#endif
+
+// scheduler tasks
+sched_task_t measure_task_id = SCHED_NO_TASK;
+sched_task_t error_task_id = SCHED_NO_TASK;
+sched_task_t prof_task_id = SCHED_NO_TASK;
+sched_task_t load_task_id = SCHED_NO_TASK;
+sched_task_t trace_task_id = SCHED_NO_TASK;
+sched_task_t display_task_id = SCHED_NO_TASK;
+sched_task_t telem_task_id = SCHED_NO_TASK;
+sched_task_t log_task_id = SCHED_NO_TASK;
+
+// Adaptive sampling (see ../common/sampling.h): stable temperature is
+// read less often and with lower resolution (fewer conversions - less
+// self-heating, bus traffic and power), fast change or crossing of
+// threshold switches back to fastest level at once
+typedef struct {
+    u8 resolution;  // bits
+    u16 convert;    // conversion wait [ticks]
+    u16 pause;      // pause after read [ticks]
+} t_sample_level;
+
+const t_sample_level SAMPLE_LEVELS[] = {
+    { 12, SCHED_MS(800), SCHED_MS(200) },   // changing, ~1 s cycle
+    { 12, SCHED_MS(800), SCHED_MS(1000) },  // normal, 1.8 s
+    { 11, SCHED_MS(400), SCHED_MS(3000) },  // stable, 3.4 s
+    { 10, SCHED_MS(200), SCHED_MS(8000) },  // stable long, 8.2 s
+};
+#define SAMPLE_LEVEL_COUNT (sizeof(SAMPLE_LEVELS)/sizeof(SAMPLE_LEVELS[0]))
+
+// temperatures in 1/16 C
+sampling_config_t sample_config = {
+    .fast_delta = 8,     // 0.5 C per reading
+    .stable_delta = 4,   // 0.25 C (one 10-bit step)
+    .stable_count = 5,
+    .levels = SAMPLE_LEVEL_COUNT,
+    .normal = 1,
+    .thresholds = 2,
+    .threshold = { 0 * 16, 30 * 16 }, // freezing, too warm
+};
+sampling_t sample_state;
+
+// Settings in emulated EEPROM (see ../common/dee.h), one 16-bit word
+// per key. Boot loads sensor table and slot timing from it instead of
+// Search ROM and tuning, so first conversion starts right after reset.
+#define SET_LAYOUT    0   // SET_LAYOUT_VERSION, other keys valid
+#define SET_TIMING    1   // owbus_timing_t, one key per word (10)
+#define SET_SAMPLING  11  // sample_config: deltas, count, thresholds
+#define SET_COUNT     16  // sensors in table
+#define SET_SENSORS   17  // 4 keys per sensor
+#define SET_KEYS      (SET_SENSORS + 4 * DALLAS_MAX_SENSORS)
+#define SET_LAYOUT_VERSION 1
+
+#if SET_KEYS > DEE_KEYS
+#error DEE_KEYS too small for settings
+#endif
+
+// writes sensor table, slot timing and sampling policy to flash (only
+// changed words), CPU stalls few ms when anything changed
+void settings_save(void)
+{
+    const u16 *timing = (const u16 *)&owbus_timing;
+    const t_dallas_sensor *s;
+    u8 i, key;
+
+    settings_changed = false;
+    dee_set(SET_LAYOUT, SET_LAYOUT_VERSION);
+    for (i = 0; i < sizeof(owbus_timing_t) / 2; i++){
+        dee_set(SET_TIMING + i, timing[i]);
+    }
+    dee_set(SET_SAMPLING + 0, (u16)sample_config.fast_delta);
+    dee_set(SET_SAMPLING + 1, (u16)sample_config.stable_delta);
+    dee_set(SET_SAMPLING + 2, sample_config.stable_count);
+    dee_set(SET_SAMPLING + 3, (u16)sample_config.threshold[0]);
+    dee_set(SET_SAMPLING + 4, (u16)sample_config.threshold[1]);
+    dee_set(SET_COUNT, dallas_count);
+    // ROM code without CRC (computed on load) and bus pin
+    for (i = 0, key = SET_SENSORS; i < dallas_count; i++){
+        s = &dallas_sensors[i];
+        dee_set(key++, (u16)s->rom[0] | (u16)s->rom[1] << 8);
+        dee_set(key++, (u16)s->rom[2] | (u16)s->rom[3] << 8);
+        dee_set(key++, (u16)s->rom[4] | (u16)s->rom[5] << 8);
+        dee_set(key++, (u16)s->rom[6] | (u16)s->pin << 8);
+    }
+    if (!dee_commit()){
+        uart_puts("settings: flash write failed\r\n");
+    }
+}
+
+// loads settings saved by settings_save(); slot timing only when
+// persistent one is not valid (power-on); returns true when timing is
+// valid and sensor table was loaded - first conversion may start
+// without search, which verifies the table after first reading
+// (dallas_verify)
+bool dallas_load(void)
+{
+    u16 *timing = (u16 *)&owbus_timing;
+    u16 v, w[4];
+    t_dallas_sensor *s;
+    u8 i, j, count, key;
+
+    dee_init();
+    if (!dee_read(SET_LAYOUT, &v) || v != SET_LAYOUT_VERSION){
+        return false;
+    }
+    if (!owbus_timing_valid(DALLAS_BUSES)){
+        for (i = 0; i < sizeof(owbus_timing_t) / 2; i++){
+            if (dee_read(SET_TIMING + i, &v)){
+                timing[i] = v;
+            }
+        }
+        if (!owbus_timing_valid(DALLAS_BUSES)){
+            // other buses or damaged - tune again
+            owbus_timing_default();
+        }
+    }
+    if (dee_read(SET_SAMPLING + 0, &v)) sample_config.fast_delta = (i16)v;
+    if (dee_read(SET_SAMPLING + 1, &v)) sample_config.stable_delta = (i16)v;
+    if (dee_read(SET_SAMPLING + 2, &v)) sample_config.stable_count = (u8)v;
+    if (dee_read(SET_SAMPLING + 3, &v)) sample_config.threshold[0] = (i16)v;
+    if (dee_read(SET_SAMPLING + 4, &v)) sample_config.threshold[1] = (i16)v;
+    if (!dee_read(SET_COUNT, &v) || v > DALLAS_MAX_SENSORS){
+        return false;
+    }
+    count = (u8)v;
+    dallas_count = 0;
+    for (i = 0, key = SET_SENSORS; i < count; i++){
+        for (j = 0; j < 4; j++){
+            if (!dee_read(key++, &w[j])){
+                return false;
+            }
+        }
+        s = &dallas_sensors[dallas_count];
+        for (j = 0; j < 7; j++){
+            s->rom[j] = (u8)(w[j / 2] >> (8 * (j & 1)));
+        }
+        s->rom[7] = crc8(s->rom, 7);
+        s->pin = (u8)(w[3] >> 8);
+        s->resolution = 0;
+        s->valid = false;
+        s->errors = 0;
+        // bus no longer used by this build
+        if (s->pin < 16 && (DALLAS_BUSES & (1U << s->pin))){
+            dallas_count++;
+        }
+    }
+    dallas_index();
+    dallas_rescan = false;
+    dallas_verify = true;
+    // first read takes all sensors (no readings yet)
+    dallas_cycle = DALLAS_FULL_READ - 1;
+    uart_puts("ow sensors: ");
+    uart_put_u32(dallas_count);
+    uart_puts(" from flash\r\n");
+    return dallas_count && owbus_timing_valid(DALLAS_BUSES);
+}
+
+// longest measurement cycle (slowest level), deadline has 50% margin
+wdt_id_t measure_wdt_id = WDT_NO_ID;
+#define MEASURE_WDT_DEADLINE ((SCHED_MS(200) + SCHED_MS(8000)) * 3 / 2)
+
+// applies reading of display bus to sampling policy, every decision
+// goes to trace, level change also to UART
+void sample_update(i16 temp)
+{
+    u8 old = sample_state.level;
+    sampling_reason_t reason = sampling_update(&sample_state, temp);
+    const t_sample_level *l = &SAMPLE_LEVELS[sample_state.level];
+
+    TRACE(TRACE_RING_MAIN, TRACE_SAMPLING, sample_state.level | reason << 4,
+          (u16)sample_state.delta);
+    if (sample_state.level == old && reason != SAMPLING_FIRST){
+        return;
+    }
+    uart_puts("sampling: level ");
+    uart_put_u32(sample_state.level);
+    uart_puts(" (");
+    uart_puts(sampling_reason_name(reason));
+    uart_puts("), ");
+    uart_put_u32(l->resolution);
+    uart_puts(" bit, cycle ");
+    uart_put_u32(((u32)l->convert + l->pause) * SCHED_TICK_US / 1000UL);
+    uart_puts(" ms\r\n");
+}
+
+// blink display every 200ms (400ms period) while error is shown
+void error_blink_task(void)
+{
+    blank = !blank;
+    sched_wake_in(error_task_id, SCHED_MS(200));
+}
+
+// room for text and trace dumps in UART TX ring: they never wait for
+// UART (uart_putc() would on full ring and stall measurement) and leave
+// space of one frame to telemetry
+static u16 dump_room(void)
+{
+    u16 n = uart_tx_free();
+
+    return n > TELEM_WIRE_MAX ? n - TELEM_WIRE_MAX : 0;
+}
+
+// report CPU load to UART every second, line is skipped when there is
+// no room for it
+void load_task(void)
+{
+    load_update();
+    if (dump_room() >= LOAD_LINE_MAX){
+        load_print(uart_putc);
+    }
+    sched_wake_in(load_task_id, SCHED_MS(1000));
+}
+
+// drain event trace to UART (binary frames, see ../common/trace.h),
+// records that did not fit follow in 50 ms
+void trace_task(void)
+{
+    u8 pending = trace_pending();
+
+    sched_wake_in(trace_task_id, trace_dump(uart_putc, dump_room()) < pending ?
+                  SCHED_MS(50) : SCHED_MS(500));
+}
+
+// counters and diagnostics as telemetry frames every second (readings
+// are sent as they come, see dallas_read_sensors())
+void telem_task(void)
+{
+    u32 cnt[TELEM_COUNTER_COUNT];
+    u16 diag[TELEM_DIAG_COUNT];
+
+    cnt[TELEM_CNT_UPTIME] = uptime_s();
+    cnt[TELEM_CNT_READS] = dallas_read_count;
+    cnt[TELEM_CNT_CRC_ERRORS] = dallas_error_count;
+    cnt[TELEM_CNT_LOGGED] = flog_count();
+    cnt[TELEM_CNT_FRAMES] = telem_frames;
+    cnt[TELEM_CNT_DROPPED] = telem_dropped;
+    cnt[TELEM_CNT_RX_OVERRUNS] = uart_rx_overruns;
+    telem_counters(cnt, TELEM_COUNTER_COUNT);
+    diag[TELEM_DIAG_LOAD] = load_permille;
+    diag[TELEM_DIAG_STACK] = stack_used();
+    diag[TELEM_DIAG_TX_FREE] = uart_tx_free();
+    diag[TELEM_DIAG_SAMPLING] = sample_state.level;
+    diag[TELEM_DIAG_SENSORS] = dallas_count;
+    diag[TELEM_DIAG_HIST] = hist_count();
+    telem_diag(diag, TELEM_DIAG_COUNT);
+    sched_wake_in(telem_task_id, SCHED_MS(1000));
+}
+
+#if !MODBUS_ENABLE
+// log read-out on UART console: line "log [from [to]]" (log time in
+// seconds, whole log without arguments) streams readings of that window
+// as "log <time> <value in 1/16 C>" lines and ends with "log end
+// <count>", other lines are ignored. A line is written only when TX
+// ring has room for it (dump_room()), so dump of the whole log (~1 min at 38400 Bd)
+// never blocks main loop and telemetry keeps its share of the line.
+#define LOG_CMD_MAX  24     // longest command line
+#define LOG_LINE_MAX 24     // "log 4294967295 -32768\r\n"
+
+static char log_cmd[LOG_CMD_MAX];
+static u8 log_cmd_len = 0;  // LOG_CMD_MAX - line too long, ignored
+static bool log_active = false;
+static flog_iter_t log_it;
+static u32 log_to, log_sent;
+
+// decimal number after spaces, false when there is none
+static bool log_arg(const char **p, u32 *v)
+{
+    const char *s = *p;
+
+    while (*s == ' '){
+        s++;
+    }
+    if (*s < '0' || *s > '9'){
+        return false;
+    }
+    for (*v = 0; *s >= '0' && *s <= '9'; s++){
+        *v = *v * 10 + (u32)(*s - '0');
+    }
+    *p = s;
+    return true;
+}
+
+// starts dump of window given by command line
+static void log_command(const char *p)
+{
+    u32 from = 0, to = UINT32_MAX, first, last;
+
+    if (p[0] != 'l' || p[1] != 'o' || p[2] != 'g' || (p[3] && p[3] != ' ')){
+        return;
+    }
+    p += 3;
+    if (log_arg(&p, &from)){
+        log_arg(&p, &to);
+    }
+    while (*p == ' '){
+        p++;
+    }
+    if (*p){
+        uart_puts("log ?\r\n");
+        return;
+    }
+    log_sent = 0;
+    // readings logged after the command are not part of the dump
+    log_active = flog_span(&first, &last) && flog_seek(&log_it, from);
+    log_to = to < last ? to : last;
+    if (!log_active){
+        uart_puts("log end 0\r\n");
+    }
+}
+
+// reads commands, streams readings of active dump
+void log_task(void)
+{
+    int16_t c;
+    u32 time;
+    i16 value;
+
+    while (!log_active && (c = uart_getc()) >= 0){
+        if (c == '\r' || c == '\n'){
+            if (log_cmd_len < LOG_CMD_MAX){
+                log_cmd[log_cmd_len] = 0;
+                log_command(log_cmd);
+            }
+            log_cmd_len = 0;
+        } else if (log_cmd_len < LOG_CMD_MAX - 1){
+            log_cmd[log_cmd_len++] = (char)c;
+        } else {
+            log_cmd_len = LOG_CMD_MAX;
+        }
+    }
+    while (log_active && dump_room() >= LOG_LINE_MAX){
+        if (!flog_next(&log_it, &time, &value) || time > log_to){
+            log_active = false;
+            uart_puts("log end ");
+            uart_put_u32(log_sent);
+            uart_puts("\r\n");
+            break;
+        }
+        uart_puts("log ");
+        uart_put_u32(time);
+        uart_putc(' ');
+        if (value < 0){
+            uart_putc('-');
+        }
+        uart_put_u32(value < 0 ? (u32)-(int32_t)value : (u32)value);
+        uart_puts("\r\n");
+        log_sent++;
+    }
+    sched_wake_in(log_task_id, SCHED_MS(log_active ? 10 : 100));
+}
+#endif
+
+// overrides weak function in sched.c - nothing is ready to run
+void sched_idle(void)
+{
+#if MODBUS_ENABLE
+    // answer as soon as no task runs
+    modbus_poll();
+#endif
+    load_idle();
+}
+
+// dump profiler table and stack usage to UART every 10 s, a line at a
+// time when there is room for it
+void prof_task(void)
+{
+    static u8 line = 0;
+
+    while (line <= PROF_COUNT && dump_room() >= PROF_LINE_MAX){
+        prof_dump_line(uart_putc, line++);
+    }
+    if (line <= PROF_COUNT || dump_room() < STACK_LINE_MAX){
+        sched_wake_in(prof_task_id, SCHED_MS(10));
+        return;
+    }
+    stack_print(uart_putc);
+    line = 0;
+    sched_wake_in(prof_task_id, SCHED_MS(10000));
+}
+
+// show error code on display and blink it until next good measurement
+void show_error(t_ec err)
 {
     disp_digits[0] = DISP_DEC[ 0xe ]; // capital E like "error"
     disp_digits[1] = 0; // blank
@@ -308,77 +1202,273 @@ void fatal_error(t_ec err)
     disp_digits[2] = DISP_DEC[ (u8)((err >> 4) & 0xf) ];
     // low 4-bit nibbles to hex
     disp_digits[3] = DISP_DEC[ (u8)(err & 0xf) ];
-    while(1)
-    {
-        // blink every 200ms (400ms period) forever
-        blank = !blank;
-        __delay_ms(200);
+    if (!sched_is_armed(error_task_id)){
+        sched_wake_in(error_task_id, 0);
     }
-    
 }
 
-int main(void)
+void clear_error(void)
+{
+    sched_suspend(error_task_id);
+    blank = false;
+}
+
+void display_temperature(i16 temp)
 {
+    u16 t = (u16)temp;
     u16 temp_frac=0;
-    t_ec err=0;
-#if 0    
-    u8 hex;
+
+    // quick and dirty temperature display
+    if (temp < 0){
+        // set minus sign ond 1st digit
+        disp_digits[0] = SEG_G;
+        // make complement
+        t = 1U+(u16)(~ t);
+    } else {
+        disp_digits[0] = 0; // blank (like +)
+    }
+    // fraction part of temperature
+    temp_frac = t & 0xf;
+    temp_frac = temp_frac * 10 / 16;
+    t >>= 4;
+    if (t>99){
+        t = 99;
+    }
+    disp_digits[1] = DISP_DEC[ t/10 ];
+    disp_digits[2] = DISP_DEC[ t%10 ] | SEG_DP;
+    disp_digits[3] = DISP_DEC[ temp_frac & 0x0f ];
+        
+#if 0        
+    // debug: put 16-bit hexadecimal temperature to display
+    disp_digits[0] = DISP_DEC[ (u8)((t >> 12) & 0xf) ];
+    disp_digits[1] = DISP_DEC[ (u8)((t >> 8) & 0xf) ];
+    disp_digits[2] = DISP_DEC[ (u8)((t >> 4) & 0xf) ];
+    disp_digits[3] = DISP_DEC[ (u8)(t & 0xf) ];
 #endif
-    // initialize the device
-    SYSTEM_Initialize();
-    INTERRUPT_GlobalEnable();
-    TMR1_Start();
+}
+
+// Display cycles temperature (DISP_TEMP_MS) with maximum and minimum
+// of last 24 h (DISP_STATS_MS each) from history (../common/hist.h),
+// shown as "H23.5", "L-5.2" (below -9.9 C without fraction, "L-12")
+#define SEG_H (SEG_B | SEG_C | SEG_E | SEG_F | SEG_G)
+#define SEG_L (SEG_D | SEG_E | SEG_F)
+#define DISP_TEMP_MS  8000
+#define DISP_STATS_MS 2000
+
+// screen rotation checks in every DISP_TEMP_MS at most, 50% margin
+wdt_id_t display_wdt_id = WDT_NO_ID;
+#define DISPLAY_WDT_DEADLINE (SCHED_MS(DISP_TEMP_MS) * 3 / 2)
+
+typedef enum {
+    DISP_TEMP = 0,
+    DISP_MAX,
+    DISP_MIN,
+} t_disp_screen;
 
-    while (1)
-    {
-        RED_LED_RA0_SetHigh();
-        // measure temperature
-        err = dallas_get_temperature();
-        if (err){
-            fatal_error(err);
+t_disp_screen disp_screen = DISP_TEMP;
+// last reading of display sensor
+i16 disp_temp = 0;
+bool disp_valid = false;
+
+// 'letter' and temperature in 1/16 C on display
+void display_stat(u8 letter, i16 temp)
+{
+    u16 t = (u16)(temp < 0 ? -temp : temp);
+
+    t = (u16)(t * 10UL / 16);   // 0.1 C, cut as display_temperature()
+    disp_digits[0] = letter;
+    if (temp >= 0){
+        if (t > 999){
+            t = 999;
         }
-        RED_LED_RA0_SetLow();
-        
-        // quick and dirty temperature display
-        if ((i16)dallas_temp < 0){
-            // set minus sign ond 1st digit
-            disp_digits[0] = SEG_G;
-            // make complement
-            dallas_temp = 1U+(u16)(~ dallas_temp);
+        disp_digits[1] = DISP_DEC[ t / 100 ];
+        disp_digits[2] = DISP_DEC[ t / 10 % 10 ] | SEG_DP;
+        disp_digits[3] = DISP_DEC[ t % 10 ];
+    } else if (t < 100){
+        disp_digits[1] = SEG_G;
+        disp_digits[2] = DISP_DEC[ t / 10 ] | SEG_DP;
+        disp_digits[3] = DISP_DEC[ t % 10 ];
+    } else {
+        t /= 10;
+        disp_digits[1] = SEG_G;
+        disp_digits[2] = DISP_DEC[ t / 10 % 10 ];
+        disp_digits[3] = DISP_DEC[ t % 10 ];
+    }
+}
+
+// shows current screen (not while error blinks)
+void display_screen(void)
+{
+    hist_stats_t s;
+
+    if (sched_is_armed(error_task_id) || !disp_valid){
+        return;
+    }
+    if (disp_screen != DISP_TEMP && hist_stats(HIST_24H, uptime_s(), &s)){
+        if (disp_screen == DISP_MAX){
+            display_stat(SEG_H, s.max);
         } else {
-            disp_digits[0] = 0; // blank (like +)
+            display_stat(SEG_L, s.min);
         }
-        // fraction part of temperature
-        temp_frac = dallas_temp & 0xf;
-        temp_frac = temp_frac * 10 / 16;
-        dallas_temp >>= 4;
-        if (dallas_temp>99){
-            dallas_temp = 99;
-        }
-        disp_digits[1] = DISP_DEC[ dallas_temp/10 ];
-        disp_digits[2] = DISP_DEC[ dallas_temp%10 ] | SEG_DP;
-        disp_digits[3] = DISP_DEC[ temp_frac & 0x0f ];
-        
-#if 0        
-        // debug: put 16-bit hexadecimal temperature to display
-        disp_digits[0] = DISP_DEC[ (u8)((dallas_temp >> 12) & 0xf) ];
-        disp_digits[1] = DISP_DEC[ (u8)((dallas_temp >> 8) & 0xf) ];
-        disp_digits[2] = DISP_DEC[ (u8)((dallas_temp >> 4) & 0xf) ];
-        disp_digits[3] = DISP_DEC[ (u8)(dallas_temp & 0xf) ];
+        return;
+    }
+    disp_screen = DISP_TEMP;
+    display_temperature(disp_temp);
+}
+
+// switches to next screen
+void display_task(void)
+{
+    disp_screen = disp_screen == DISP_MIN ? DISP_TEMP : disp_screen + 1;
+    display_screen();
+    wdt_checkin(display_wdt_id);
+    sched_wake_in(display_task_id, disp_screen == DISP_TEMP ?
+                  SCHED_MS(DISP_TEMP_MS) : SCHED_MS(DISP_STATS_MS));
+}
+
+typedef enum {
+    MEAS_CONVERT = 0,
+    MEAS_READ,
+} t_meas_state;
+
+// measurement: start conversion, sleep until it is done, read
+// temperature, pause (avoid self-heating sensor) and repeat. Resolution
+// and times are given by sampling level. On error the measurement is
+// retried in next cycle
+void measure_task(void)
+{
+    static t_meas_state state = MEAS_CONVERT;
+    t_ec err = EC_NO_ERROR;
+    const t_sample_level *l = &SAMPLE_LEVELS[sample_state.level];
+    u32 now;
+
+    switch(state){
+        case MEAS_CONVERT:
+            RED_LED_RA0_SetHigh();
+            err = dallas_start_conversion(l->resolution);
+            if (!dallas_present){
+                break;
+            }
+            // error of display bus (if any) is reported after read,
+            // conversion runs on other buses
+            state = MEAS_READ;
+            sched_wake_in(measure_task_id, l->convert);
+            return;
+        case MEAS_READ:
+            err = dallas_read_temperature();
+            if (dallas_crc_errors >= DALLAS_TUNE_ERRORS){
+                dallas_tune();
+            } else if (dallas_reads >= DALLAS_TUNE_WINDOW){
+                dallas_reads = 0;
+                dallas_crc_errors = 0;
+            }
+            if (err){
+                break;
+            }
+            RED_LED_RA0_SetLow();
+            clear_error();
+            sample_update((i16)dallas_temp);
+            l = &SAMPLE_LEVELS[sample_state.level];
+            // to flash log (row written every ~180 readings) and history
+            // of display statistics
+            now = uptime_s();
+            flog_append(now, (i16)dallas_temp);
+            hist_append(now, (i16)dallas_temp);
+            disp_temp = (i16)dallas_temp;
+            disp_valid = true;
+            display_screen();
+            // table from flash is verified once first reading is shown
+            if (dallas_verify){
+                dallas_enumerate();
+            }
+            // after reading - flash stall does not delay it
+            if (settings_changed){
+                settings_save();
+            }
+            break;
+    }
+    if (err){
+        RED_LED_RA0_SetLow();
+        show_error(err);
+    }
+    state = MEAS_CONVERT;
+    // measurement cycle finished (with or without error)
+    wdt_checkin(measure_wdt_id);
+    // avoid self-heating sensor with some delay
+    sched_wake_in(measure_task_id, l->pause);
+}
+
+// overrides weak function in crash.c - trap time in TMR1 ticks
+uint32_t crash_timestamp(void)
+{
+    return systime_ticks;
+}
+
+int main(void)
+{
+    // for stack high-water mark reported by prof_task()
+    stack_paint();
+    // initialize the device
+    SYSTEM_Initialize();
+    owbus_init(DALLAS_BUSES, DALLAS_DEBUG_PINS);
+    uart_init();
+    prof_init();
+    trace_init();
+    TRACE(TRACE_RING_MAIN, TRACE_BOOT, 0, RCON);
+    // report trap that caused last reset (see traps.c)
+    crash_init();
+    crash_report(uart_putc);
+    sched_init();
+    measure_task_id = sched_add(measure_task);
+    error_task_id = sched_add(error_blink_task);
+#if !MODBUS_ENABLE
+    prof_task_id = sched_add(prof_task);
+    load_task_id = sched_add(load_task);
+    trace_task_id = sched_add(trace_task);
 #endif
-        
-#if 0 
-        // test digits on display
-        disp_digits[0] = DISP_DEC[ (u8)((hex) & 0xf) ];
-        disp_digits[1] = DISP_DEC[ (u8)((hex+1) & 0xf) ];
-        disp_digits[2] = DISP_DEC[ (u8)((hex+2) & 0xf) ];
-        disp_digits[3] = DISP_DEC[ (u8)((hex+3) & 0xf) ];
-        hex = (u8)((hex+1) & 0x0f);
-#endif        
-        // avoid self-heating sensor with some delay
-        __delay_ms(1000);
+    display_task_id = sched_add(display_task);
+#if MODBUS_ENABLE
+    // UART1 carries Modbus only - no console tasks
+    modbus_init(MODBUS_ADDRESS);
+#else
+    telem_task_id = sched_add(telem_task);
+    log_task_id = sched_add(log_task);
+#endif
+    measure_wdt_id = wdt_add(MEASURE_WDT_DEADLINE);
+    display_wdt_id = wdt_add(DISPLAY_WDT_DEADLINE);
+    bool cached = dallas_load();
+    log_init();
+    hist_init();
+    sampling_init(&sample_state, &sample_config);
+    INTERRUPT_GlobalEnable();
+    TMR1_Start();
+    // known sensors and timing - first conversion runs while load meter
+    // calibrates, table is verified by search after its reading
+    if (cached){
+        measure_task();
+    }
+    // no-load reference for CPU load meter (takes 100 ms)
+    load_calibrate(sched_run_once, SCHED_MS(100));
+    // slot timing survives warm reset (persistent) and is kept in flash,
+    // tune it when neither is valid
+    if (!owbus_timing_valid(DALLAS_BUSES)){
+        dallas_tune();
+    }
 
+    if (!sched_is_armed(measure_task_id)){
+        sched_wake_in(measure_task_id, 0);
     }
+#if !MODBUS_ENABLE
+    sched_wake_in(prof_task_id, SCHED_MS(10000));
+    sched_wake_in(load_task_id, SCHED_MS(1000));
+    sched_wake_in(trace_task_id, SCHED_MS(500));
+    sched_wake_in(telem_task_id, SCHED_MS(1000));
+    sched_wake_in(log_task_id, SCHED_MS(100));
+#endif
+    sched_wake_in(display_task_id, SCHED_MS(DISP_TEMP_MS));
+    // supervise measurement and display refresh (see ../common/wdt.h)
+    wdt_start();
+    sched_run(); // never returns
 
     return 1;
 }
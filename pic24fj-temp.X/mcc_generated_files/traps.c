@@ -47,8 +47,10 @@
 */
 #include <xc.h>
 #include "traps.h"
+#include "crash.h"
 
-#define ERROR_HANDLER __attribute__((interrupt,no_auto_psv))
+// saves W15 before prologue, so crash_reset() finds stacked PC
+#define ERROR_HANDLER CRASH_TRAP_HANDLER
 #define FAILSAFE_STACK_GUARDSIZE 8
 
 /**
@@ -57,7 +59,8 @@
 static uint16_t TRAPS_error_code = -1;
 
 /**
- * Halts 
+ * Stores crash record and resets CPU (see ../common/crash.h),
+ * record is reported on UART by next boot
  * 
  * @param code error code
  */
@@ -68,8 +71,7 @@ void __attribute__((weak)) TRAPS_halt_on_error(uint16_t code)
     __builtin_software_breakpoint();
     /* If we are in debug mode, cause a software breakpoint in the debugger */
 #endif
-    while(1);
-    
+    crash_reset(code);
 }
 
 /**
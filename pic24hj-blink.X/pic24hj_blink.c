@@ -55,6 +55,20 @@
 #define LED  	 _LATA0
 #define LED_TRIS _TRISA0
 
+// CPU load meter - main loop is its idle loop
+#include "load.h"
+// crash record of last trap is reported on UART1 TX (RB2/PIN6, 38400 Bd)
+#include "crash.h"
+#include "uart.h"
+#include <stdbool.h>
+
+// LED is lit in every other TMR1 period (blinking at 1 Hz)
+volatile bool led_lit = false;
+// brightness of lit LED - PWM duty 0..255 (set from CPU load)
+uint8_t led_duty = 0;
+// minimal brightness, so blinking is visible on idle CPU
+#define LED_DUTY_MIN 13
+
 // Timer1 Overflow Interrupt handler.
 // Handler name must match id defined in:
 // XC16_ROOT/docs/vector_docs/PIC24HJ128GP502.html
@@ -62,11 +76,37 @@
 // DATA from PROGRAM memory (Program Space Visibility window - PSV)
 void __attribute__ ((interrupt, no_auto_psv)) _T1Interrupt(void)
 {
-    LED ^= 1; // Toggle the LED
+    led_lit = !led_lit; // Toggle the LED (see main_loop())
+    load_tick();
     // Clear Timer1 Overflow Interrupt Flag
     IFS0bits.T1IF = 0;
 }
 
+// one iteration of main (idle) loop. CPU load is updated every second
+// in load_permille (watch it in debugger) and shown as LED brightness
+void main_loop(void)
+{
+    static uint16_t last_update = 0;
+    uint8_t pwm_phase;
+
+    load_idle();
+    // software PWM: TMR1 counts at Fcy/256, low 8 bits wrap at ~244 Hz
+    // (read always - iteration must cost the same whether LED is lit or not)
+    pwm_phase = (uint8_t)TMR1;
+    if (led_lit && pwm_phase < led_duty){
+        LED = 1;
+    } else {
+        LED = 0;
+    }
+    // update every second (2 TMR1 periods)
+    if ((uint16_t)(load_ticks - last_update) >= 2){
+        last_update = load_ticks;
+        load_update();
+        led_duty = (uint8_t)(LED_DUTY_MIN +
+            (uint32_t)load_permille * (255 - LED_DUTY_MIN) / LOAD_FULL);
+    }
+}
+
 int main(void) {
 
     // based on microstick_demo_v2013_06_26/firmware/src/main.c
@@ -74,6 +114,17 @@ int main(void) {
     // Initialize the LED. This symbol is defined in system_config.h
     LED_TRIS = 0;
 
+    // UART1 pins (see uart.h)
+    __builtin_write_OSCCONL(OSCCON & 0xbf); // unlock PPS
+    RPOR1bits.RP2R = 3;     // RB2->UART1:U1TX
+    RPINR18bits.U1RXR = 3;  // RB3->UART1:U1RX
+    __builtin_write_OSCCONL(OSCCON | 0x40); // lock PPS
+
+    // report trap that caused last reset (see traps.c)
+    uart_init();
+    crash_init();
+    crash_report(uart_putc);
+
     /* Initialize Timer 1
      * Each configuration sets the MCU's oscillator to 32MHz 
      * For the LED to blink at a rate of 1Hz,
@@ -90,9 +141,11 @@ int main(void) {
     _T1IF = 0; // ensure that Interrupt Flag is cleared on boot
     _T1IE = 1; // enable Timer1 Overflow Interrupt
     T1CONbits.TON = 1; 
+    // no-load reference (takes 1 TMR1 period = 0.5 s)
+    load_calibrate(main_loop, 1);
     
     while(1){
-        // NOP
+        main_loop();
     }
     
     // never reached
@@ -29,6 +29,7 @@
 */
 
 #include <xc.h>
+#include "crash.h"
 
 typedef enum 
 {
@@ -40,7 +41,8 @@ typedef enum
     TRAPS_DMA_ERR = 4,  /** DMA Error Trap vector */
 } TRAPS_ERROR_CODE;
 
-#define ERROR_HANDLER __attribute__((interrupt,no_auto_psv))
+// saves W15 before prologue, so crash_reset() finds stacked PC
+#define ERROR_HANDLER CRASH_TRAP_HANDLER
 #define FAILSAFE_STACK_GUARDSIZE 8
 
 /**
@@ -49,7 +51,8 @@ typedef enum
 static uint16_t TRAPS_error_code = -1;
 
 /**
- * Halts 
+ * Stores crash record and resets CPU (see ../common/crash.h),
+ * record is reported on UART by next boot
  * 
  * @param code error code
  */
@@ -60,8 +63,7 @@ void __attribute__((weak)) TRAPS_halt_on_error(uint16_t code)
     __builtin_software_breakpoint();
     /* If we are in debug mode, cause a software breakpoint in the debugger */
 #endif
-    while(1);
-    
+    crash_reset(code);
 }
 
 /**
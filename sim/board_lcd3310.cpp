@@ -0,0 +1,50 @@
+/**
+  @File Name
+    sim/board_lcd3310.cpp
+
+  @Summary
+    Hardware of pic24fj-lcd3310.X attached to simulator.
+
+  @Description
+    - SPI1 + RB10 /CS, RB13 D/C, RB11 /RES - OLIMEX MOD-LCD3310 (TLS8204)
+
+    Options (-o name=value):
+    - lcd_frames=PREFIX  writes every changed frame to PREFIXnnnn.pbm
+    - lcd_format=png     frame images as PNG instead of PBM
+    - lcd_log=1          bytes and SPI time of every frame to stderr
+    - lcd_last=FILE      final content of display (.png or PBM)
+*/
+
+#include <cstdlib>
+
+#include "tls8204.h"
+
+static TLS8204 lcd(1, 10, 13, 11);
+
+void sim_board_setup(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    const char *v;
+
+    if ((v = sim_option("lcd_frames"))){
+        lcd.frame_prefix = v;
+    }
+    if ((v = sim_option("lcd_format"))){
+        lcd.frame_ext = v;
+    }
+    if ((v = sim_option("lcd_log"))){
+        lcd.log_frames = atoi(v) != 0;
+    }
+    sim_attach(&lcd);
+}
+
+int sim_board_report(void)
+{
+    const char *last = sim_option("lcd_last");
+    unsigned errors = lcd.report();
+
+    if (last && !lcd.write_glass(last)){
+        errors++;
+    }
+    return errors ? 1 : 0;
+}
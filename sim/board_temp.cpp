@@ -0,0 +1,127 @@
+/**
+  @File Name
+    sim/board_temp.cpp
+
+  @Summary
+    Hardware of pic24fj-temp.X attached to simulator.
+
+  @Description
+    - RB8 - 1-wire bus (DS18B20 DQ) with timing monitor and one DS18B20
+    - more buses with one DS18B20 each for firmware built with
+      DALLAS_BUSES (sim-temp-multi), sensor on RBn reads temp + n
+    - more DS18B20 on each bus (multi-drop), k-th one reads 0.3 * k more
+      and has k in top byte of serial
+    - RA1..RA4 mux, RB4.. segments - 4 digit LED display BQ-M512RD
+
+    Options (-o name=value):
+    - temp=C     sensor temperature at start (default 21.5)
+    - ramp=C/s   temperature change per second (default 0)
+    - sensor=0   no sensor on bus (no presence pulse - error display)
+    - buses=0,1  pins of port B with additional buses
+    - sensors=n  sensors on each bus (default 1)
+    - rise=us    rise time of buses after release (long cable, default 0),
+      rise<pin>=us sets it for one bus (rise8=6), rise_at=s time when it
+      applies (cable swapped in running device, default 0)
+    - eye_tau=ms eye integration time constant of display (default 20)
+    - display_log=1  prints perceived display text whenever it changes
+    - display_art=1  prints perceived display as ASCII art at exit
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "onewire.h"
+#include "ds18b20.h"
+#include "led7seg.h"
+
+static OneWireBus onewire(1, 8);
+static DS18B20 sensor(0x0000056A1B2CULL);
+static bool sensor_on = true;
+// additional buses, each with own sensor
+static std::vector<std::unique_ptr<OneWireBus>> buses;
+static std::vector<std::unique_ptr<DS18B20>> sensors;
+// segments A B C D E F G DP
+static LedMux7Seg display({ 1, 2, 3, 4 }, { 4, 7, 14, 11, 10, 5, 15, 13 });
+
+static double option(const char *name, double def)
+{
+    const char *v = sim_option(name);
+    return v ? atof(v) : def;
+}
+
+static void set_rise(OneWireBus &bus, int pin)
+{
+    std::string name = "rise" + std::to_string(pin);
+
+    bus.rise_us = option(name.c_str(), option("rise", 0));
+    bus.rise_from = (uint64_t)(option("rise_at", 0) * sim_fcy);
+}
+
+// attaches sensors 1..n-1 of multi-drop bus, serial and temperature
+// offset of first sensor on bus are given
+static void add_sensors(OneWireBus &bus, int n, uint64_t serial, double temp, double ramp)
+{
+    for (int k = 1; k < n; k++){
+        sensors.emplace_back(new DS18B20(serial + ((uint64_t)k << 40)));
+        sensors.back()->temperature = [temp, ramp, k](double t) {
+            return temp + 0.3 * k + ramp * t;
+        };
+        bus.attach(sensors.back().get());
+    }
+}
+
+void sim_board_setup(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    double temp = option("temp", 21.5);
+    double ramp = option("ramp", 0);
+    int n = (int)option("sensors", 1);
+
+    sensor.temperature = [temp, ramp](double t) { return temp + ramp * t; };
+    sensor_on = option("sensor", 1) != 0;
+    if (sensor_on){
+        onewire.attach(&sensor);
+        add_sensors(onewire, n, 0x0000056A1B2CULL, temp, ramp);
+    }
+    set_rise(onewire, 8);
+    sim_attach(&onewire);
+    for (const char *p = sim_option("buses"); p && *p; p += strcspn(p, ",")){
+        p += *p == ',';
+        int pin = atoi(p);
+        buses.emplace_back(new OneWireBus(1, pin));
+        sensors.emplace_back(new DS18B20(0x0000056A1B00ULL + (unsigned)pin));
+        buses.back()->label = "onewire RB" + std::to_string(pin);
+        sensors.back()->temperature = [temp, ramp, pin](double t) {
+            return temp + pin + ramp * t;
+        };
+        buses.back()->attach(sensors.back().get());
+        add_sensors(*buses.back(), n, 0x0000056A1B00ULL + (unsigned)pin, temp + pin, ramp);
+        set_rise(*buses.back(), pin);
+        sim_attach(buses.back().get());
+    }
+    display.tau_ms = option("eye_tau", 20);
+    display.log_text = option("display_log", 0) != 0;
+    sim_attach(&display);
+}
+
+int sim_board_report(void)
+{
+    unsigned errors = onewire.report();
+
+    display.report();
+    if (option("display_art", 0) != 0){
+        display.print_art(stderr);
+    }
+    if (sensor_on){
+        errors += sensor.report();
+    }
+    for (auto &b : buses){
+        errors += b->report();
+    }
+    for (auto &s : sensors){
+        errors += s->report();
+    }
+    return errors ? 1 : 0;
+}
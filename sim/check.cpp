@@ -0,0 +1,43 @@
+/**
+  @File Name
+    sim/check.cpp
+
+  @Summary
+    Common part of host checks. See check.h for details.
+*/
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "check.h"
+
+std::mt19937 rng;
+unsigned failures = 0;
+
+static const char *check_name = "check";
+
+void check_init(const char *name, unsigned seed)
+{
+    check_name = name;
+    rng.seed(seed);
+}
+
+void fail(const char *fmt, ...)
+{
+    va_list ap;
+
+    failures++;
+    if (failures > 10) {
+        return;
+    }
+    va_start(ap, fmt);
+    fprintf(stderr, "%s: FAIL ", check_name);
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    va_end(ap);
+}
+
+unsigned rnd(unsigned n)
+{
+    return (unsigned)(rng() % n);
+}
@@ -0,0 +1,33 @@
+/**
+  @File Name
+    sim/check.h
+
+  @Summary
+    Common part of host checks (flog-check, hist-check, telem-check,
+    modbus-check, ...).
+
+  @Description
+    check_init() names the check and seeds 'rng', so that every run
+    with the same -s seed repeats. fail() counts failure and prints
+    "<name>: FAIL <message>" to stderr - the first 10 of them, the
+    rest is only counted; exit status of check is 'failures' != 0.
+*/
+
+#ifndef SIM_CHECK_H
+#define SIM_CHECK_H
+
+#include <random>
+
+// pseudo-random generator of check, seeded by check_init()
+extern std::mt19937 rng;
+// number of fail() calls
+extern unsigned failures;
+
+// sets prefix of messages ("flog") and seed of 'rng'
+void check_init(const char *name, unsigned seed);
+// records failure, printf-like message
+void fail(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+// pseudo-random number 0..n-1
+unsigned rnd(unsigned n);
+
+#endif /* SIM_CHECK_H */
@@ -0,0 +1,280 @@
+/**
+  @File Name
+    sim/dee_check.cpp
+
+  @Summary
+    Host check of data EEPROM emulation (common/dee.h) under power loss
+    against flash model of simulator.
+
+  @Description
+    Usage: dee-check [-n commits] [-s seed]
+
+    Runs ../common/dee.c and flash.c compiled for simulator (Makefile
+    builds them with 127 keys, so that pack of all keys is 128 slots -
+    header and records end exactly on row boundary). Flash starts with
+    active page of generation 0xFFFD written directly, so that packs
+    wrap 16-bit generation early.
+
+    Every commit changes random keys - few of them (appended) or many
+    (packed), all keys once in a while - and is cut by power loss after
+    0, 1, 2, ... erase/write operations: after each cut firmware powers
+    on (dee_init()), sets the same values again and commits, power lasts
+    one operation longer every time until commit succeeds. After every
+    power-on dee_read() of all keys must give either old values or new
+    ones, never a mix, and new ones once commit returned true.
+
+    Also checked: commits alternate between appends and packs, some
+    packs write all keys, generation wraps, no flash violation.
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "check.h"
+#include "sim.h"
+#include "dee.h"
+
+// values of all keys, -1 = never written
+typedef std::vector<int32_t> Values;
+
+static unsigned long commits = 2000;
+static unsigned long appends = 0, packs = 0, full_packs = 0;
+static unsigned long append_then_pack = 0, pack_then_append = 0;
+static unsigned long cuts = 0, cuts_old = 0, cuts_new = 0;
+static uint16_t gen_first = 0xFFFD, gen_last = 0;
+static bool wrapped = false;
+
+#define DEE_PAGE_ADDR(p) (DEE_BASE + (flash_addr_t)(p) * FLASH_PAGE_SIZE)
+
+static Values read_all(void)
+{
+    Values v(DEE_KEYS, -1);
+    uint16_t value;
+
+    for (unsigned key = 0; key < DEE_KEYS; key++){
+        if (dee_read((uint8_t)key, &value)){
+            v[key] = value;
+        }
+    }
+    return v;
+}
+
+static unsigned count(const Values &v)
+{
+    unsigned n = 0;
+    for (int32_t x : v){
+        n += x >= 0;
+    }
+    return n;
+}
+
+static uint32_t erases(void)
+{
+    uint32_t n = 0;
+    for (unsigned p = 0; p < DEE_PAGES; p++){
+        n += sim_flash_erases(DEE_PAGE_ADDR(p));
+    }
+    return n;
+}
+
+// generation of active page (newest header, as dee_init() picks it)
+static uint16_t active_gen(void)
+{
+    bool found = false;
+    uint16_t gen = 0;
+
+    for (unsigned p = 0; p < DEE_PAGES; p++){
+        uint32_t w = sim_flash_read(DEE_PAGE_ADDR(p));
+        if ((w >> 16) == DEE_MAGIC && (!found || (int16_t)((uint16_t)w - gen) > 0)){
+            found = true;
+            gen = (uint16_t)w;
+        }
+    }
+    return gen;
+}
+
+// last page active with generation gen_first and some records, written
+// with flash functions as older firmware would have left it
+static Values seed(void)
+{
+    Values v(DEE_KEYS, -1);
+    flash_addr_t base = DEE_PAGE_ADDR(DEE_PAGES - 1);
+    uint16_t slot = 1;
+
+    for (unsigned p = 0; p < DEE_PAGES; p++){
+        flash_erase_page(DEE_PAGE_ADDR(p));
+    }
+    for (unsigned key = 0; key < DEE_KEYS; key += 1 + rnd(8)){
+        v[key] = rnd(0x10000);
+        flash_write_word(base + 2 * slot++, (uint32_t)key << 16 | (uint16_t)v[key]);
+    }
+    flash_write_word(base, (uint32_t)DEE_MAGIC << 16 | gen_first);
+    return v;
+}
+
+// random changes of next commit
+static Values changes(const Values &old)
+{
+    Values c(DEE_KEYS, -1);
+    unsigned r = rnd(100), n, i;
+
+    if (r < 5){
+        n = DEE_KEYS;                       // all keys
+    } else if (r < 25){
+        n = DEE_APPEND_MAX + 1 + rnd(40);   // pack
+    } else {
+        n = 1 + rnd(DEE_APPEND_MAX);        // append (when it fits)
+    }
+    for (i = 0; i < n; i++){
+        unsigned key = n == DEE_KEYS ? i : rnd(DEE_KEYS);
+        // some are rewrites of current value (not dirty)
+        c[key] = old[key] >= 0 && rnd(8) == 0 ? old[key] : (int32_t)rnd(0x10000);
+    }
+    return c;
+}
+
+static void set_all(const Values &c)
+{
+    for (unsigned key = 0; key < DEE_KEYS; key++){
+        if (c[key] >= 0){
+            dee_set((uint8_t)key, (uint16_t)c[key]);
+        }
+    }
+}
+
+// one commit cut by power loss at every operation until it succeeds,
+// returns new values
+static Values commit(unsigned long n, const Values &old, const Values &c)
+{
+    Values want = old;
+    for (unsigned key = 0; key < DEE_KEYS; key++){
+        if (c[key] >= 0){
+            want[key] = c[key];
+        }
+    }
+    uint32_t erased = erases();
+
+    for (int64_t cut = 0;; cut++){
+        set_all(c);
+        sim_flash_cut(cut);
+        bool ok = dee_commit();
+        sim_flash_cut(-1);
+        if (ok){
+            if (read_all() != want){
+                fail("commit %lu: values in RAM differ after commit", n);
+            }
+        } else {
+            cuts++;
+        }
+        // power-on
+        dee_init();
+        Values got = read_all();
+        if (got == want && (ok || want != old)){
+            if (!ok){
+                cuts_new++;
+            }
+            break;
+        }
+        if (got == old){
+            if (ok && want != old){
+                fail("commit %lu: old values after successful commit", n);
+                break;
+            }
+            cuts_old++;
+            if (ok){
+                break;                       // nothing to write
+            }
+            continue;
+        }
+        fail("commit %lu cut after %lld operations: mix of old and new values "
+             "(%u keys, %u old, %u new)", n, (long long)cut, count(got), count(old),
+             count(want));
+        return got;
+    }
+    bool packed = erases() != erased;
+    if (want != old){
+        if (packed){
+            packs++;
+            full_packs += count(want) == DEE_KEYS;
+        } else {
+            appends++;
+        }
+    }
+    uint16_t gen = active_gen();
+    if (gen < gen_last && gen_last - gen > 0x8000){
+        wrapped = true;
+    }
+    gen_last = gen;
+    return want;
+}
+
+static int check_main(void)
+{
+    bool last_packed = false;
+    unsigned long last_packs = 0;
+
+    Values values = seed();
+    dee_init();
+    if (read_all() != values){
+        fail("seeded values not found by dee_init()");
+    }
+    gen_last = active_gen();
+    for (unsigned long n = 0; n < commits; n++){
+        Values c = changes(values);
+        unsigned long before = appends + packs;
+        values = commit(n, values, c);
+        if (appends + packs == before){
+            continue;
+        }
+        bool packed = packs != last_packs;
+        last_packs = packs;
+        if (before){
+            append_then_pack += packed && !last_packed;
+            pack_then_append += !packed && last_packed;
+        }
+        last_packed = packed;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1){
+        switch (opt){
+            case 'n': commits = strtoul(optarg, NULL, 0); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n commits] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    check_init("dee", seed);
+    sim_reset();
+    sim_run(check_main, UINT64_MAX / 2);
+
+    fprintf(stderr, "dee: %lu commits, %lu appends, %lu packs (%lu of all %u keys "
+            "ending on row boundary), %lu append-pack and %lu pack-append changes\n",
+            commits, appends, packs, full_packs, DEE_KEYS, append_then_pack,
+            pack_then_append);
+    fprintf(stderr, "dee: %lu power cuts, %lu kept old values, %lu new ones; "
+            "generation 0x%04X..0x%04X%s\n", cuts, cuts_old, cuts_new, gen_first,
+            gen_last, wrapped ? " (wrapped)" : "");
+    if (!full_packs || !append_then_pack || !pack_then_append){
+        fail("appends/packs do not alternate or no pack of all keys");
+    }
+    if (!wrapped){
+        fail("generation did not wrap");
+    }
+    if (sim_flash_report()){
+        failures++;
+    }
+    fprintf(stderr, "dee: %u failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,289 @@
+/**
+  @File Name
+    sim/ds18b20.cpp
+
+  @Summary
+    DS18B20 temperature sensor model - see ds18b20.h
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "ds18b20.h"
+
+// errors printed in detail, further ones are only counted
+static const size_t LOG_MAX = 10;
+
+// power-on scratchpad: 85 C, TH 75 C, TL 70 C, 12-bit resolution
+static const uint8_t SCRATCH_POR[8] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10 };
+// conversion time at 9-bit resolution, doubles with each extra bit [us]
+static const double CONV_US_9BIT = 93750;
+// Copy Scratchpad to E2 [us]
+static const double COPY_US = 10000;
+
+uint8_t DS18B20::crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--){
+        uint8_t b = *data++;
+        for (int i = 0; i < 8; i++){
+            bool mix = (crc ^ b) & 1;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            b >>= 1;
+        }
+    }
+    return crc;
+}
+
+DS18B20::DS18B20(uint64_t serial)
+{
+    rom_[0] = 0x28; // family code
+    for (int i = 0; i < 6; i++){
+        rom_[1 + i] = (uint8_t)(serial >> (8 * i));
+    }
+    rom_[7] = crc8(rom_, 7);
+    memcpy(scratch_, SCRATCH_POR, sizeof(SCRATCH_POR));
+    memcpy(e2_, &SCRATCH_POR[2], sizeof(e2_));
+    update_crc();
+}
+
+void DS18B20::error(uint64_t cycle, const char *what)
+{
+    errors_++;
+    if (log_.size() < LOG_MAX){
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%12.3f ms: %s",
+                 sim_cycles_to_us(cycle) / 1000.0, what);
+        log_.push_back(buf);
+    }
+}
+
+void DS18B20::update_crc()
+{
+    scratch_[8] = crc8(scratch_, 8);
+}
+
+void DS18B20::finish_conversion(uint64_t cycle)
+{
+    if (!conv_pending_ || cycle < conv_end_){
+        return;
+    }
+    double c = temperature(sim_cycles_to_us(conv_end_) / 1e6);
+    if (c < -55) c = -55;
+    if (c > 125) c = 125;
+    int16_t raw = (int16_t)lround(c * 16);
+    // undefined low bits at lower resolution are zero
+    unsigned res = (scratch_[4] >> 5) & 3;
+    raw = (int16_t)(raw & ~((1 << (3 - res)) - 1));
+    scratch_[0] = (uint8_t)raw;
+    scratch_[1] = (uint8_t)((uint16_t)raw >> 8);
+    update_crc();
+    conv_pending_ = false;
+    converted_ = true;
+}
+
+bool DS18B20::alarm() const
+{
+    // integer part of temperature compared with signed TH/TL
+    int t = (int16_t)(scratch_[1] << 8 | scratch_[0]) >> 4;
+    return converted_ && (t >= (int8_t)scratch_[2] || t <= (int8_t)scratch_[3]);
+}
+
+void DS18B20::transmit(const uint8_t *data, size_t len, State next)
+{
+    tx_.assign(data, data + len);
+    tx_bit_ = 0;
+    tx_next_ = next;
+    st_ = ST_TX;
+}
+
+void DS18B20::receive(State st)
+{
+    st_ = st;
+    rx_byte_ = 0;
+    rx_bits_ = 0;
+    rx_count_ = 0;
+}
+
+bool DS18B20::ow_reset(uint64_t cycle)
+{
+    finish_conversion(cycle);
+    reading_scratch_ = false;
+    receive(ST_ROM_CMD);
+    return true;
+}
+
+int DS18B20::ow_slot(uint64_t cycle)
+{
+    int b;
+
+    finish_conversion(cycle);
+    switch (st_){
+        case ST_TX:
+            if (tx_bit_ >= tx_.size() * 8){
+                return 1; // nothing more to send
+            }
+            b = (tx_[tx_bit_ / 8] >> (tx_bit_ % 8)) & 1;
+            if (++tx_bit_ == tx_.size() * 8){
+                if (reading_scratch_){
+                    reads_++;
+                    reading_scratch_ = false;
+                }
+                if (tx_next_ != ST_TX){
+                    receive(tx_next_);
+                }
+            }
+            return b;
+        case ST_BUSY:
+            return cycle >= busy_end_ ? 1 : 0;
+        case ST_SEARCH:
+            if (search_phase_ == 0){
+                search_phase_ = 1;
+                return rom_bit(search_bit_);
+            }
+            if (search_phase_ == 1){
+                search_phase_ = 2;
+                return !rom_bit(search_bit_);
+            }
+            return -1;
+        default:
+            return -1;
+    }
+}
+
+void DS18B20::ow_write(uint64_t cycle, int bit)
+{
+    finish_conversion(cycle);
+    if (st_ == ST_SEARCH){
+        if (bit != rom_bit(search_bit_)){
+            st_ = ST_IDLE; // master took other branch
+        } else if (++search_bit_ == 64){
+            receive(ST_FUNC_CMD);
+        } else {
+            search_phase_ = 0;
+        }
+        return;
+    }
+    if (st_ != ST_ROM_CMD && st_ != ST_MATCH && st_ != ST_FUNC_CMD && st_ != ST_RX){
+        return;
+    }
+    rx_byte_ |= (uint8_t)(bit << rx_bits_);
+    if (++rx_bits_ < 8){
+        return;
+    }
+    uint8_t b = rx_byte_;
+    rx_byte_ = 0;
+    rx_bits_ = 0;
+    switch (st_){
+        case ST_ROM_CMD:
+            rom_command(cycle, b);
+            break;
+        case ST_MATCH:
+            if (b != rom_[rx_count_]){
+                st_ = ST_IDLE;
+            } else if (++rx_count_ == 8){
+                receive(ST_FUNC_CMD);
+            }
+            break;
+        case ST_FUNC_CMD:
+            function_command(cycle, b);
+            break;
+        case ST_RX:
+            // TH, TL, config (only R1:R0 bits are writable)
+            scratch_[2 + rx_count_] = rx_count_ == 2 ? (uint8_t)((b & 0x60) | 0x1F) : b;
+            update_crc();
+            if (++rx_count_ == 3){
+                st_ = ST_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void DS18B20::rom_command(uint64_t cycle, uint8_t cmd)
+{
+    char buf[48];
+
+    switch (cmd){
+        case 0x33: // Read ROM
+            transmit(rom_, sizeof(rom_), ST_FUNC_CMD);
+            break;
+        case 0x55: // Match ROM
+            receive(ST_MATCH);
+            break;
+        case 0xCC: // Skip ROM
+            receive(ST_FUNC_CMD);
+            break;
+        case 0xF0: // Search ROM
+        case 0xEC: // Alarm Search
+            st_ = cmd == 0xF0 || alarm() ? ST_SEARCH : ST_IDLE;
+            search_bit_ = 0;
+            search_phase_ = 0;
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "unknown ROM command 0x%02X", cmd);
+            error(cycle, buf);
+            st_ = ST_IDLE;
+            break;
+    }
+}
+
+void DS18B20::function_command(uint64_t cycle, uint8_t cmd)
+{
+    char buf[48];
+
+    switch (cmd){
+        case 0x44: // Convert T
+            conv_end_ = cycle + (uint64_t)(CONV_US_9BIT * (1 << ((scratch_[4] >> 5) & 3))
+                                           * sim_fcy / 1e6);
+            conv_pending_ = true;
+            conversions_++;
+            busy_end_ = conv_end_;
+            st_ = ST_BUSY;
+            break;
+        case 0xBE: // Read Scratchpad
+            if (conv_pending_){
+                error(cycle, "Read Scratchpad during conversion");
+            }
+            reading_scratch_ = true;
+            transmit(scratch_, sizeof(scratch_), ST_TX);
+            break;
+        case 0x4E: // Write Scratchpad
+            receive(ST_RX);
+            break;
+        case 0x48: // Copy Scratchpad
+            memcpy(e2_, &scratch_[2], sizeof(e2_));
+            busy_end_ = cycle + (uint64_t)(COPY_US * sim_fcy / 1e6);
+            st_ = ST_BUSY;
+            break;
+        case 0xB8: // Recall E2
+            memcpy(&scratch_[2], e2_, sizeof(e2_));
+            update_crc();
+            busy_end_ = cycle;
+            st_ = ST_BUSY;
+            break;
+        case 0xB4: // Read Power Supply - external
+            transmit(NULL, 0, ST_TX);
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "unknown function command 0x%02X", cmd);
+            error(cycle, buf);
+            st_ = ST_IDLE;
+            break;
+    }
+}
+
+unsigned DS18B20::report() const
+{
+    fprintf(stderr, "ds18b20 28-%02x%02x%02x%02x%02x%02x: %u conversions, "
+            "%u scratchpad reads, %u errors\n", rom_[6], rom_[5], rom_[4],
+            rom_[3], rom_[2], rom_[1], conversions_, reads_, errors_);
+    for (const std::string &l : log_){
+        fprintf(stderr, "ds18b20: ERROR %s\n", l.c_str());
+    }
+    return errors_;
+}
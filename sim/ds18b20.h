@@ -0,0 +1,104 @@
+/**
+  @File Name
+    sim/ds18b20.h
+
+  @Summary
+    DS18B20 temperature sensor model for 1-wire bus of host simulator.
+
+  @Description
+    Bit level model of DS18B20 (see onewire.h how slots are sampled):
+    - ROM commands: Read ROM 0x33, Match ROM 0x55, Skip ROM 0xCC,
+      Search ROM 0xF0, Alarm Search 0xEC
+    - function commands: Convert T 0x44, Read Scratchpad 0xBE,
+      Write Scratchpad 0x4E, Copy Scratchpad 0x48, Recall E2 0xB8,
+      Read Power Supply 0xB4 (external supply)
+    - 64-bit ROM code (family 0x28, 48-bit serial, CRC-8)
+    - scratchpad with CRC-8, power-on value 85 C, TH/TL/config in E2
+    - conversion time by resolution (93.75..750 ms), read slots return 0
+      while converting; temperature is taken from 'temperature'
+      function of simulated time when conversion finishes
+
+    Protocol errors of master are counted and printed by report():
+    unknown command, Read Scratchpad during conversion (returns old
+    value).
+*/
+
+#ifndef SIM_DS18B20_H
+#define SIM_DS18B20_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "onewire.h"
+
+class DS18B20 : public OneWireSlave {
+public:
+    // ROM code from 48-bit serial number
+    explicit DS18B20(uint64_t serial);
+
+    // temperature [C] at given simulated time [s]
+    std::function<double(double)> temperature = [](double) { return 21.5; };
+
+    const uint8_t *rom() const { return rom_; }
+    unsigned conversions() const { return conversions_; }
+    unsigned scratchpad_reads() const { return reads_; }
+    unsigned errors() const { return errors_; }
+    // prints statistics and protocol errors to stderr, returns errors
+    unsigned report() const;
+
+    // Dallas/Maxim CRC-8 (x^8 + x^5 + x^4 + 1)
+    static uint8_t crc8(const uint8_t *data, size_t len);
+
+    bool ow_reset(uint64_t cycle) override;
+    int ow_slot(uint64_t cycle) override;
+    void ow_write(uint64_t cycle, int bit) override;
+
+private:
+    enum State {
+        ST_IDLE,      // not selected, waits for reset
+        ST_ROM_CMD,   // receives ROM command
+        ST_MATCH,     // receives 64-bit ROM code of Match ROM
+        ST_SEARCH,    // Search ROM / Alarm Search
+        ST_FUNC_CMD,  // receives function command
+        ST_RX,        // receives Write Scratchpad data
+        ST_TX,        // transmits tx_ buffer, then 1s
+        ST_BUSY       // conversion in progress: read slots return 0
+    };
+
+    uint8_t rom_[8];
+    uint8_t scratch_[9];
+    uint8_t e2_[3];           // TH, TL, config
+    State st_ = ST_IDLE;
+    State tx_next_ = ST_IDLE; // state after tx_ is transmitted
+    uint8_t rx_byte_ = 0;
+    unsigned rx_bits_ = 0;
+    unsigned rx_count_ = 0;   // bytes received in current state
+    std::vector<uint8_t> tx_;
+    unsigned tx_bit_ = 0;
+    unsigned search_bit_ = 0;  // 0..63
+    unsigned search_phase_ = 0; // 0 bit, 1 complement, 2 master direction
+    bool reading_scratch_ = false;
+    uint64_t busy_end_ = 0;   // end of conversion or E2 copy
+    uint64_t conv_end_ = 0;
+    bool conv_pending_ = false;
+    bool converted_ = false;  // alarm flag valid
+
+    unsigned conversions_ = 0;
+    unsigned reads_ = 0;
+    unsigned errors_ = 0;
+    std::vector<std::string> log_;
+
+    void error(uint64_t cycle, const char *what);
+    void finish_conversion(uint64_t cycle);
+    void update_crc();
+    bool alarm() const;
+    void transmit(const uint8_t *data, size_t len, State next);
+    void receive(State st);
+    void rom_command(uint64_t cycle, uint8_t cmd);
+    void function_command(uint64_t cycle, uint8_t cmd);
+    int rom_bit(unsigned i) const { return (rom_[i / 8] >> (i % 8)) & 1; }
+};
+
+#endif /* SIM_DS18B20_H */
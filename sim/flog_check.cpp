@@ -0,0 +1,239 @@
+/**
+  @File Name
+    sim/flog_check.cpp
+
+  @Summary
+    Host check of flash temperature logger (common/flog.h) against
+    flash model of simulator.
+
+  @Description
+    Usage: flog-check [-n readings] [-s seed] [-r resets]
+
+    Runs ../common/flog.c and flash.c compiled for simulator (TBLRD/TBLWT
+    and NVMCON of sim.cpp, which flags programming of not erased word
+    and counts erases per page) and feeds it pseudo-random readings:
+    slow drift (1 byte records), faster steps (2 bytes), jumps and long
+    gaps (absolute records, new keyframe rows). Log region is small
+    (Makefile builds it with few pages), so the ring wraps many times.
+
+    Every reading is kept in reference list and checked:
+    - whole log is tail of the reference (oldest rows dropped by ring)
+    - random time windows streamed by flog_seek()/flog_next() match
+      reference readings of that window
+    - resets: clean one (flog_flush() before) keeps everything, power
+      loss keeps at least readings older than FLOG_FLUSH_S
+    - erases are spread over pages (max - min <= 1), no flash violation
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "check.h"
+#include "sim.h"
+#include "flog.h"
+
+struct Reading {
+    uint32_t time;
+    int16_t value;
+};
+
+static std::vector<Reading> ref;
+static unsigned long readings = 50000;
+static unsigned resets = 20;
+// seek + window statistics
+static uint64_t seek_cycles = 0, seek_max = 0, windows = 0, window_readings = 0;
+
+// whole log, oldest first
+static std::vector<Reading> read_all(void)
+{
+    std::vector<Reading> log;
+    flog_iter_t it;
+    Reading r;
+
+    if (flog_seek(&it, 0)){
+        while (flog_next(&it, &r.time, &r.value)){
+            log.push_back(r);
+        }
+    }
+    return log;
+}
+
+// log must be tail of reference, returns false when not
+static bool check_tail(const std::vector<Reading> &log, const char *when)
+{
+    if (log.size() > ref.size()){
+        fail("%s: %zu readings in log, only %zu logged", when, log.size(), ref.size());
+        return false;
+    }
+    size_t base = ref.size() - log.size();
+    for (size_t i = 0; i < log.size(); i++){
+        const Reading &a = log[i], &b = ref[base + i];
+        if (a.time != b.time || a.value != b.value){
+            fail("%s: reading %zu of log is %u s %d, expected %u s %d", when,
+                 i, a.time, a.value, b.time, b.value);
+            return false;
+        }
+    }
+    return true;
+}
+
+// streams random window and compares it with reference
+static void check_window(const std::vector<Reading> &log)
+{
+    if (log.empty()){
+        return;
+    }
+    uint32_t first = log.front().time, last = log.back().time;
+    uint32_t from = first + rnd(last - first + 1);
+    uint32_t to = from + rnd(4000);
+    flog_iter_t it;
+    Reading r;
+    std::vector<Reading> got;
+
+    uint64_t start = sim_cycles;
+    bool found = flog_seek(&it, from);
+    uint64_t cycles = sim_cycles - start;
+    seek_cycles += cycles;
+    seek_max = std::max(seek_max, cycles);
+    windows++;
+    while (found && flog_next(&it, &r.time, &r.value) && r.time <= to){
+        got.push_back(r);
+    }
+    window_readings += got.size();
+    size_t j = 0;
+    for (const Reading &e : log){
+        if (e.time < from || e.time > to){
+            continue;
+        }
+        if (j >= got.size() || got[j].time != e.time || got[j].value != e.value){
+            fail("window %u..%u s: reading %zu differs", from, to, j);
+            return;
+        }
+        j++;
+    }
+    if (j != got.size()){
+        fail("window %u..%u s: %zu readings, expected %zu", from, to, got.size(), j);
+    }
+}
+
+// reset of firmware: RAM is lost, flog_init() finds log again
+static void reset(bool clean)
+{
+    uint32_t last = ref.empty() ? 0 : ref.back().time;
+
+    if (clean){
+        flog_flush();
+    }
+    flog_init();
+    std::vector<Reading> log = read_all();
+    if (log.empty()){
+        if (!ref.empty()){
+            fail("log lost on reset");
+        }
+        return;
+    }
+    // readings after last one found are lost, at most FLOG_FLUSH_S
+    size_t n = ref.size();
+    while (n && ref[n - 1].time > log.back().time){
+        n--;
+    }
+    if (n < ref.size() && (clean || ref[n].time + FLOG_FLUSH_S <= last)){
+        fail("%s reset lost readings %u..%u s", clean ? "clean" : "power-loss",
+             ref[n].time, last);
+    }
+    ref.resize(n);
+    check_tail(log, clean ? "after clean reset" : "after power-loss reset");
+}
+
+static int check_main(void)
+{
+    unsigned long i;
+    uint32_t now = 0, dt = 3;
+    int16_t value = 21 * 16;
+    unsigned long next_reset = readings / (resets + 1);
+
+    flog_init();
+    for (i = 0; i < readings; i++){
+        unsigned r = rnd(1000);
+        // sampling period changes now and then, rare long gaps
+        if (r < 20){
+            dt = 1 + rnd(9);
+        } else if (r < 26){
+            dt = 10 + rnd(300);
+        }
+        uint32_t step = r == 999 ? 70000 + rnd(10000) : dt;
+        r = rnd(1000);
+        if (r < 900){
+            value += (int16_t)rnd(5) - 2;
+        } else if (r < 995){
+            value += (int16_t)rnd(41) - 20;
+        } else {
+            value = (int16_t)(rnd(2000) - 800);
+        }
+        now += step;
+        flog_append(now, value);
+        ref.push_back({ (ref.empty() ? 0 : ref.back().time) + step, value });
+        if (i % 97 == 0){
+            std::vector<Reading> log = read_all();
+            check_tail(log, "while logging");
+            check_window(log);
+        }
+        if (i == next_reset){
+            reset(rnd(2) == 0);
+            now = 0;
+            next_reset += readings / (resets + 1);
+        }
+    }
+    reset(true);
+    return 0;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n readings] [-s seed] [-r resets]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:r:h")) != -1){
+        switch (opt){
+            case 'n': readings = strtoul(optarg, NULL, 0); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'r': resets = (unsigned)strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    check_init("flog", seed);
+    sim_reset();
+    sim_run(check_main, UINT64_MAX / 2);
+
+    uint32_t min = UINT32_MAX, max = 0;
+    for (unsigned p = 0; p < FLOG_PAGES; p++){
+        uint32_t e = sim_flash_erases(FLOG_BASE + p * FLASH_PAGE_SIZE);
+        min = std::min(min, e);
+        max = std::max(max, e);
+    }
+    fprintf(stderr, "flog: %lu readings, %u rows of %u pages, %zu readings "
+            "kept after last reset\n", readings, FLOG_ROWS, FLOG_PAGES, ref.size());
+    fprintf(stderr, "flog: erases per page %u..%u, %llu windows streamed "
+            "(%llu readings), seek avg %llu max %llu cycles\n", min, max,
+            (unsigned long long)windows, (unsigned long long)window_readings,
+            (unsigned long long)(windows ? seek_cycles / windows : 0),
+            (unsigned long long)seek_max);
+    if (max - min > 1){
+        fail("uneven wear, erases per page %u..%u", min, max);
+    }
+    if (sim_flash_report()){
+        failures++;
+    }
+    fprintf(stderr, "flog: %u failures\n", failures);
+    return failures ? 1 : 0;
+}
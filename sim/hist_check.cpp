@@ -0,0 +1,205 @@
+/**
+  @File Name
+    sim/hist_check.cpp
+
+  @Summary
+    Host check of in-RAM temperature history (common/hist.h).
+
+  @Description
+    Usage: hist-check [-n readings] [-s seed]
+
+    Runs ../common/hist.c (small ring, see Makefile) with pseudo-random
+    readings: slow drift (1 byte records), steps, jumps over whole
+    16-bit range, sampling period 1..9 s with some long ones and rare
+    gaps of hours. Every reading is kept in reference list and checked:
+    - history decodes to tail of the reference and the ring is full
+      (it drops only as many oldest readings as needed)
+    - statistics of each window (every few readings, sometimes at later
+      time than last reading) equal min/max/mean computed by rescanning
+      reference readings of window buckets, at once after long gaps
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "check.h"
+#include "hist.h"
+
+struct Reading {
+    uint32_t time;
+    int16_t value;
+};
+
+// bucket length of windows (hist.c)
+static const uint32_t BUCKET_S[HIST_WINDOWS] = { 5, 300, 7200 };
+
+static std::vector<Reading> ref;
+static uint64_t queries = 0, scanned = 0, kept = 0, checks = 0;
+
+// bytes of variable-length number
+static unsigned varint_len(uint32_t v)
+{
+    unsigned n = 1;
+
+    while (v >= 0x80){
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+// bytes of record of reading b after a (encoding of hist.h)
+static unsigned record_len(const Reading &a, const Reading &b)
+{
+    uint16_t dv = (uint16_t)((uint16_t)b.value - (uint16_t)a.value);
+    uint32_t zz = (uint16_t)(dv << 1) ^ (dv & 0x8000 ? 0xFFFF : 0);
+    uint32_t dt = b.time - a.time;
+
+    if (dt < 15){
+        return varint_len(zz << 4 | dt);
+    }
+    return varint_len(zz << 4 | 15) + varint_len(dt);
+}
+
+// history must be tail of reference and fill the ring
+static void check_tail(void)
+{
+    hist_iter_t it;
+    Reading r;
+    size_t n = 0, base = ref.size() - hist_count();
+
+    if (hist_count() > ref.size()){
+        fail("%u readings in history, only %zu added", hist_count(), ref.size());
+        return;
+    }
+    if (hist_first(&it)){
+        while (hist_next(&it, &r.time, &r.value)){
+            const Reading &e = ref[base + n];
+            if (r.time != e.time || r.value != e.value){
+                fail("reading %zu of history is %u s %d, expected %u s %d",
+                     n, r.time, r.value, e.time, e.value);
+                return;
+            }
+            n++;
+        }
+    }
+    if (n != hist_count()){
+        fail("%zu readings decoded, %u in history", n, hist_count());
+    }
+    // record of last dropped reading must not fit in free space
+    if (base && (unsigned)(HIST_BYTES - hist_used()) >= record_len(ref[base - 1], ref[base])){
+        fail("ring not full: %u bytes used, %zu readings dropped", hist_used(), base);
+    }
+    kept += n;
+    checks++;
+}
+
+// statistics of window at 'now' against rescan of reference
+static void check_stats(hist_window_t w, uint32_t now)
+{
+    uint32_t from = now / BUCKET_S[w];
+    from = from >= HIST_BUCKETS - 1 ? from - (HIST_BUCKETS - 1) : 0;
+    int16_t min = INT16_MAX, max = INT16_MIN;
+    int64_t sum = 0;
+    uint32_t count = 0;
+    for (size_t i = ref.size(); i-- > 0 && ref[i].time / BUCKET_S[w] >= from; ){
+        min = std::min(min, ref[i].value);
+        max = std::max(max, ref[i].value);
+        sum += ref[i].value;
+        count++;
+    }
+    scanned += count;
+    queries++;
+
+    hist_stats_t s;
+    bool found = hist_stats(w, now, &s);
+    if (found != (count != 0)){
+        fail("window %d at %u s: %s, %u readings expected", w, now,
+             found ? "found" : "empty", count);
+        return;
+    }
+    if (!count){
+        return;
+    }
+    int16_t mean = (int16_t)((sum + (sum < 0 ? -(int64_t)(count / 2) : count / 2)) / count);
+    if (s.min != min || s.max != max || s.mean != mean || s.count != count){
+        fail("window %d at %u s: min %d max %d mean %d count %u, expected "
+             "%d %d %d %u", w, now, s.min, s.max, s.mean, s.count,
+             min, max, mean, count);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long readings = 200000, i;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1){
+        switch (opt){
+            case 'n': readings = strtoul(optarg, NULL, 0); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n readings] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    check_init("hist", seed);
+
+    uint32_t now = 0, dt = 3;
+    int16_t value = 21 * 16;
+    hist_init();
+    for (i = 0; i < readings; i++){
+        unsigned r = rnd(1000);
+        if (r < 20){
+            dt = 1 + rnd(9);
+        } else if (r < 23){
+            dt = 10 + rnd(300);
+        }
+        bool gap = r == 999;
+        now += gap ? 3600 + rnd(40000) : dt;
+        r = rnd(1000);
+        if (r < 900){
+            value += (int16_t)rnd(5) - 2;
+        } else if (r < 995){
+            value += (int16_t)rnd(41) - 20;
+        } else if (r < 998){
+            value = (int16_t)(rnd(2000) - 800);
+        } else {
+            value = (int16_t)rng();
+        }
+        hist_append(now, value);
+        ref.push_back({ now, value });
+        if (i % 53 == 0){
+            check_tail();
+        }
+        if (gap){
+            // buckets of all windows moved, old ones must be cleared
+            for (unsigned w = 0; w < HIST_WINDOWS; w++){
+                check_stats((hist_window_t)w, now);
+            }
+        } else if (i % 7 == 0){
+            // query later than last reading now and then (no reading since)
+            if (rnd(20) == 0){
+                now += rnd(rnd(2) ? 100 : 20000);
+            }
+            check_stats((hist_window_t)rnd(HIST_WINDOWS), now);
+        }
+    }
+    check_tail();
+    for (unsigned w = 0; w < HIST_WINDOWS; w++){
+        check_stats((hist_window_t)w, now);
+    }
+
+    fprintf(stderr, "hist: %lu readings, ring of %u bytes keeps %.0f readings "
+            "on average (%.2f bytes per reading)\n", readings, HIST_BYTES,
+            (double)kept / checks, HIST_BYTES * checks / (double)kept);
+    fprintf(stderr, "hist: %llu window queries, rescan would read %.0f readings "
+            "per query\n", (unsigned long long)queries, (double)scanned / queries);
+    fprintf(stderr, "hist: %u failures\n", failures);
+    return failures ? 1 : 0;
+}
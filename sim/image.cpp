@@ -0,0 +1,127 @@
+/**
+  @File Name
+    sim/image.cpp
+
+  @Summary
+    Minimal PBM/PNG writer - see image.h
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "image.h"
+
+static bool write_pbm(FILE *f, int width, int height,
+                      const std::vector<uint8_t> &pixels)
+{
+    fprintf(f, "P4\n%d %d\n", width, height);
+    for (int y = 0; y < height; y++){
+        for (int x = 0; x < width; x += 8){
+            uint8_t b = 0;
+            for (int i = 0; i < 8 && x + i < width; i++){
+                if (pixels[(size_t)y * width + x + i]){
+                    b |= (uint8_t)(0x80 >> i);
+                }
+            }
+            fputc(b, f);
+        }
+    }
+    return true;
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--){
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++){
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void put_be32(std::vector<uint8_t> &v, uint32_t x)
+{
+    v.push_back((uint8_t)(x >> 24));
+    v.push_back((uint8_t)(x >> 16));
+    v.push_back((uint8_t)(x >> 8));
+    v.push_back((uint8_t)x);
+}
+
+static void png_chunk(FILE *f, const char *type, const std::vector<uint8_t> &data)
+{
+    std::vector<uint8_t> c;
+    put_be32(c, (uint32_t)data.size());
+    c.insert(c.end(), type, type + 4);
+    c.insert(c.end(), data.begin(), data.end());
+    put_be32(c, crc32(0, &c[4], c.size() - 4));
+    fwrite(c.data(), 1, c.size(), f);
+}
+
+static bool write_png(FILE *f, int width, int height,
+                      const std::vector<uint8_t> &pixels)
+{
+    static const uint8_t SIG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> ihdr, raw, z;
+
+    fwrite(SIG, 1, sizeof(SIG), f);
+    put_be32(ihdr, (uint32_t)width);
+    put_be32(ihdr, (uint32_t)height);
+    ihdr.push_back(8); // bit depth
+    ihdr.push_back(0); // grayscale
+    ihdr.push_back(0); // deflate
+    ihdr.push_back(0); // adaptive filtering
+    ihdr.push_back(0); // no interlace
+    png_chunk(f, "IHDR", ihdr);
+
+    for (int y = 0; y < height; y++){
+        raw.push_back(0); // filter: none
+        for (int x = 0; x < width; x++){
+            raw.push_back(pixels[(size_t)y * width + x] ? 0x00 : 0xFF);
+        }
+    }
+    // zlib stream of stored (not compressed) deflate blocks
+    z.push_back(0x78);
+    z.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t n = raw.size() - pos;
+        if (n > 65535) n = 65535;
+        z.push_back(pos + n == raw.size() ? 1 : 0); // BFINAL, BTYPE=00
+        z.push_back((uint8_t)n);
+        z.push_back((uint8_t)(n >> 8));
+        z.push_back((uint8_t)~n);
+        z.push_back((uint8_t)(~n >> 8));
+        z.insert(z.end(), raw.begin() + pos, raw.begin() + pos + n);
+        pos += n;
+    } while (pos < raw.size());
+    uint32_t a = 1, b = 0;
+    for (uint8_t c : raw){
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    put_be32(z, b << 16 | a);
+    png_chunk(f, "IDAT", z);
+    png_chunk(f, "IEND", std::vector<uint8_t>());
+    return true;
+}
+
+bool image_write(const char *path, int width, int height,
+                 const std::vector<uint8_t> &pixels)
+{
+    size_t len = strlen(path);
+    bool png = len >= 4 && strcmp(path + len - 4, ".png") == 0;
+    FILE *f = fopen(path, "wb");
+
+    if (!f){
+        perror(path);
+        return false;
+    }
+    if (png){
+        write_png(f, width, height, pixels);
+    } else {
+        write_pbm(f, width, height, pixels);
+    }
+    return fclose(f) == 0;
+}
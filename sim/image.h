@@ -0,0 +1,25 @@
+/**
+  @File Name
+    sim/image.h
+
+  @Summary
+    Minimal image writer for display models of host simulator.
+
+  @Description
+    Writes monochrome image as binary PBM (P4) or as 8-bit grayscale
+    PNG (uncompressed deflate, no zlib needed) - format is chosen by
+    file extension (".png", anything else is PBM). Pixel value is 1 for
+    "on" (black) and 0 for "off" (white), row by row.
+*/
+
+#ifndef SIM_IMAGE_H
+#define SIM_IMAGE_H
+
+#include <stdint.h>
+#include <vector>
+
+// returns false on I/O error
+bool image_write(const char *path, int width, int height,
+                 const std::vector<uint8_t> &pixels);
+
+#endif /* SIM_IMAGE_H */
@@ -0,0 +1,42 @@
+/**
+  @File Name
+    sim/include/libpic30.h
+
+  @Summary
+    Host replacement of XC16 <libpic30.h> - delays advance virtual time.
+
+  @Description
+    Same as in XC16 the delay is converted to instruction cycles using
+    FCY defined by firmware. Simulator then converts cycles to time using
+    its own (real) Fcy, so firmware built with wrong FCY shows wrong timing
+    in simulation just like on hardware.
+
+    Interrupts that fire during delay stretch it (ISR cycles are added),
+    which is what happens with __delay32() on real CPU.
+*/
+
+#ifndef SIM_LIBPIC30_H
+#define SIM_LIBPIC30_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void __delay32(unsigned long cycles);
+
+#if !defined(FCY)
+#error "FCY must be defined before including libpic30.h"
+#endif
+
+#define __delay_ms(d) \
+  { __delay32( (unsigned long) (((unsigned long long) d)*(FCY)/1000ULL)); }
+#define __delay_us(d) \
+  { __delay32( (unsigned long) (((unsigned long long) d)*(FCY)/1000000ULL)); }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_LIBPIC30_H */
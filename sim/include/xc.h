@@ -0,0 +1,440 @@
+/**
+  @File Name
+    sim/include/xc.h
+
+  @Summary
+    Host replacement of XC16 <xc.h> for PIC24FJ64GB002 simulation.
+
+  @Description
+    Every SFR access goes through sim_sfr() (see sim.h), which:
+    - charges one instruction cycle (so spin loops advance virtual time)
+    - refreshes "live" registers (TMRx, PORTx, SPI/UART status)
+    - commits side effects of previous write (pin change, SPI/UART TX)
+
+    Only registers and bits used by projects in this repository are
+    provided - add more when needed. Bit layouts follow PIC24FJ64GB004
+    family datasheet (DS39940).
+*/
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SFR_PORTA, SFR_LATA, SFR_TRISA, SFR_ODCA,
+    SFR_PORTB, SFR_LATB, SFR_TRISB, SFR_ODCB,
+    SFR_CNPU1, SFR_CNPU2, SFR_AD1PCFG,
+    SFR_TMR1, SFR_PR1, SFR_T1CON,
+    SFR_TMR2, SFR_TMR3, SFR_TMR3HLD, SFR_PR2, SFR_PR3, SFR_T2CON, SFR_T3CON,
+    SFR_TMR4, SFR_PR4, SFR_T4CON,
+    SFR_IFS0, SFR_IFS1, SFR_IFS4, SFR_IEC0, SFR_IEC1, SFR_IEC4,
+    SFR_IPC0, SFR_IPC1, SFR_IPC2, SFR_IPC3, SFR_IPC6, SFR_IPC7, SFR_IPC16,
+    SFR_INTCON1, SFR_INTCON2, SFR_INTTREG,
+    SFR_SPI1BUF, SFR_SPI1STAT, SFR_SPI1CON1, SFR_SPI1CON2,
+    SFR_U1MODE, SFR_U1STA, SFR_U1BRG, SFR_U1TXREG, SFR_U1RXREG,
+    SFR_RPOR0, SFR_RPOR1, SFR_RPOR2, SFR_RPOR3, SFR_RPOR4,
+    SFR_RPOR5, SFR_RPOR6, SFR_RPOR7,
+    SFR_RPINR18, SFR_RPINR19, SFR_RPINR20,
+    SFR_OSCCON, SFR_CLKDIV, SFR_OSCTUN, SFR_REFOCON,
+    SFR_PMD1, SFR_PMD2, SFR_PMD3, SFR_PMD4,
+    SFR_SR, SFR_CORCON, SFR_SPLIM, SFR_DISICNT, SFR_RCON,
+    SFR_NVMCON, SFR_TBLPAG,
+    SFR_COUNT
+} sim_sfr_id_t;
+
+volatile uint16_t *sim_sfr(sim_sfr_id_t id);
+
+#define SIM_REG(id)          (*sim_sfr(id))
+#define SIM_BITS(type, id)   (*(volatile type *)sim_sfr(id))
+
+// 16 single bit fields named <prefix>0 .. <prefix>15
+#define SIM_BITS16(p) \
+    uint16_t p##0:1;  uint16_t p##1:1;  uint16_t p##2:1;  uint16_t p##3:1;  \
+    uint16_t p##4:1;  uint16_t p##5:1;  uint16_t p##6:1;  uint16_t p##7:1;  \
+    uint16_t p##8:1;  uint16_t p##9:1;  uint16_t p##10:1; uint16_t p##11:1; \
+    uint16_t p##12:1; uint16_t p##13:1; uint16_t p##14:1; uint16_t p##15:1;
+
+typedef struct { SIM_BITS16(RA) }    PORTABITS;
+typedef struct { SIM_BITS16(LATA) }  LATABITS;
+typedef struct { SIM_BITS16(TRISA) } TRISABITS;
+typedef struct { SIM_BITS16(ODA) }   ODCABITS;
+typedef struct { SIM_BITS16(RB) }    PORTBBITS;
+typedef struct { SIM_BITS16(LATB) }  LATBBITS;
+typedef struct { SIM_BITS16(TRISB) } TRISBBITS;
+typedef struct { SIM_BITS16(ODB) }   ODCBBITS;
+typedef struct { SIM_BITS16(PCFG) }  AD1PCFGBITS;
+
+#define PORTA       SIM_REG(SFR_PORTA)
+#define PORTAbits   SIM_BITS(PORTABITS, SFR_PORTA)
+#define LATA        SIM_REG(SFR_LATA)
+#define LATAbits    SIM_BITS(LATABITS, SFR_LATA)
+#define TRISA       SIM_REG(SFR_TRISA)
+#define TRISAbits   SIM_BITS(TRISABITS, SFR_TRISA)
+#define ODCA        SIM_REG(SFR_ODCA)
+#define ODCAbits    SIM_BITS(ODCABITS, SFR_ODCA)
+#define PORTB       SIM_REG(SFR_PORTB)
+#define PORTBbits   SIM_BITS(PORTBBITS, SFR_PORTB)
+#define LATB        SIM_REG(SFR_LATB)
+#define LATBbits    SIM_BITS(LATBBITS, SFR_LATB)
+#define TRISB       SIM_REG(SFR_TRISB)
+#define TRISBbits   SIM_BITS(TRISBBITS, SFR_TRISB)
+#define ODCB        SIM_REG(SFR_ODCB)
+#define ODCBbits    SIM_BITS(ODCBBITS, SFR_ODCB)
+#define CNPU1       SIM_REG(SFR_CNPU1)
+#define CNPU2       SIM_REG(SFR_CNPU2)
+#define AD1PCFG     SIM_REG(SFR_AD1PCFG)
+#define AD1PCFGbits SIM_BITS(AD1PCFGBITS, SFR_AD1PCFG)
+
+// single pin shortcuts (_LATB8, _RB8, _TRISB8, ...)
+#define _RA0  PORTAbits.RA0
+#define _RA1  PORTAbits.RA1
+#define _RA2  PORTAbits.RA2
+#define _RA3  PORTAbits.RA3
+#define _RA4  PORTAbits.RA4
+#define _LATA0  LATAbits.LATA0
+#define _LATA1  LATAbits.LATA1
+#define _LATA2  LATAbits.LATA2
+#define _LATA3  LATAbits.LATA3
+#define _LATA4  LATAbits.LATA4
+#define _TRISA0 TRISAbits.TRISA0
+#define _TRISA1 TRISAbits.TRISA1
+#define _TRISA2 TRISAbits.TRISA2
+#define _TRISA3 TRISAbits.TRISA3
+#define _TRISA4 TRISAbits.TRISA4
+#define _RB0  PORTBbits.RB0
+#define _RB1  PORTBbits.RB1
+#define _RB2  PORTBbits.RB2
+#define _RB3  PORTBbits.RB3
+#define _RB4  PORTBbits.RB4
+#define _RB5  PORTBbits.RB5
+#define _RB6  PORTBbits.RB6
+#define _RB7  PORTBbits.RB7
+#define _RB8  PORTBbits.RB8
+#define _RB9  PORTBbits.RB9
+#define _RB10 PORTBbits.RB10
+#define _RB11 PORTBbits.RB11
+#define _RB12 PORTBbits.RB12
+#define _RB13 PORTBbits.RB13
+#define _RB14 PORTBbits.RB14
+#define _RB15 PORTBbits.RB15
+#define _LATB0  LATBbits.LATB0
+#define _LATB1  LATBbits.LATB1
+#define _LATB2  LATBbits.LATB2
+#define _LATB3  LATBbits.LATB3
+#define _LATB4  LATBbits.LATB4
+#define _LATB5  LATBbits.LATB5
+#define _LATB6  LATBbits.LATB6
+#define _LATB7  LATBbits.LATB7
+#define _LATB8  LATBbits.LATB8
+#define _LATB9  LATBbits.LATB9
+#define _LATB10 LATBbits.LATB10
+#define _LATB11 LATBbits.LATB11
+#define _LATB12 LATBbits.LATB12
+#define _LATB13 LATBbits.LATB13
+#define _LATB14 LATBbits.LATB14
+#define _LATB15 LATBbits.LATB15
+#define _TRISB0  TRISBbits.TRISB0
+#define _TRISB1  TRISBbits.TRISB1
+#define _TRISB2  TRISBbits.TRISB2
+#define _TRISB3  TRISBbits.TRISB3
+#define _TRISB4  TRISBbits.TRISB4
+#define _TRISB5  TRISBbits.TRISB5
+#define _TRISB6  TRISBbits.TRISB6
+#define _TRISB7  TRISBbits.TRISB7
+#define _TRISB8  TRISBbits.TRISB8
+#define _TRISB9  TRISBbits.TRISB9
+#define _TRISB10 TRISBbits.TRISB10
+#define _TRISB11 TRISBbits.TRISB11
+#define _TRISB12 TRISBbits.TRISB12
+#define _TRISB13 TRISBbits.TRISB13
+#define _TRISB14 TRISBbits.TRISB14
+#define _TRISB15 TRISBbits.TRISB15
+
+// Timers
+typedef struct {
+    uint16_t :1; uint16_t TCS:1; uint16_t TSYNC:1; uint16_t :1;
+    uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6;
+    uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1;
+} T1CONBITS;
+typedef struct {
+    uint16_t :1; uint16_t TCS:1; uint16_t :1; uint16_t T32:1;
+    uint16_t TCKPS:2; uint16_t TGATE:1; uint16_t :6;
+    uint16_t TSIDL:1; uint16_t :1; uint16_t TON:1;
+} T2CONBITS;
+
+#define TMR1      SIM_REG(SFR_TMR1)
+#define PR1       SIM_REG(SFR_PR1)
+#define T1CON     SIM_REG(SFR_T1CON)
+#define T1CONbits SIM_BITS(T1CONBITS, SFR_T1CON)
+#define TMR2      SIM_REG(SFR_TMR2)
+#define TMR3      SIM_REG(SFR_TMR3)
+#define TMR3HLD   SIM_REG(SFR_TMR3HLD)
+#define PR2       SIM_REG(SFR_PR2)
+#define PR3       SIM_REG(SFR_PR3)
+#define T2CON     SIM_REG(SFR_T2CON)
+#define T2CONbits SIM_BITS(T2CONBITS, SFR_T2CON)
+#define T3CON     SIM_REG(SFR_T3CON)
+#define T3CONbits SIM_BITS(T1CONBITS, SFR_T3CON)
+#define TMR4      SIM_REG(SFR_TMR4)
+#define PR4       SIM_REG(SFR_PR4)
+#define T4CON     SIM_REG(SFR_T4CON)
+#define T4CONbits SIM_BITS(T2CONBITS, SFR_T4CON)
+
+// Interrupt controller
+typedef struct {
+    uint16_t INT0IF:1; uint16_t IC1IF:1; uint16_t OC1IF:1; uint16_t T1IF:1;
+    uint16_t :1; uint16_t IC2IF:1; uint16_t OC2IF:1; uint16_t T2IF:1;
+    uint16_t T3IF:1; uint16_t SPF1IF:1; uint16_t SPI1IF:1; uint16_t U1RXIF:1;
+    uint16_t U1TXIF:1; uint16_t AD1IF:1; uint16_t :2;
+} IFS0BITS;
+typedef struct {
+    uint16_t INT0IE:1; uint16_t IC1IE:1; uint16_t OC1IE:1; uint16_t T1IE:1;
+    uint16_t :1; uint16_t IC2IE:1; uint16_t OC2IE:1; uint16_t T2IE:1;
+    uint16_t T3IE:1; uint16_t SPF1IE:1; uint16_t SPI1IE:1; uint16_t U1RXIE:1;
+    uint16_t U1TXIE:1; uint16_t AD1IE:1; uint16_t :2;
+} IEC0BITS;
+typedef struct {
+    uint16_t SI2C1IF:1; uint16_t MI2C1IF:1; uint16_t CMIF:1; uint16_t CNIF:1;
+    uint16_t INT1IF:1; uint16_t :4; uint16_t OC3IF:1; uint16_t OC4IF:1;
+    uint16_t T4IF:1; uint16_t T5IF:1; uint16_t INT2IF:1; uint16_t U2RXIF:1;
+    uint16_t U2TXIF:1;
+} IFS1BITS;
+typedef struct {
+    uint16_t SI2C1IE:1; uint16_t MI2C1IE:1; uint16_t CMIE:1; uint16_t CNIE:1;
+    uint16_t INT1IE:1; uint16_t :4; uint16_t OC3IE:1; uint16_t OC4IE:1;
+    uint16_t T4IE:1; uint16_t T5IE:1; uint16_t INT2IE:1; uint16_t U2RXIE:1;
+    uint16_t U2TXIE:1;
+} IEC1BITS;
+typedef struct {
+    uint16_t INT0IP:3; uint16_t :1; uint16_t IC1IP:3; uint16_t :1;
+    uint16_t OC1IP:3; uint16_t :1; uint16_t T1IP:3; uint16_t :1;
+} IPC0BITS;
+typedef struct {
+    uint16_t :4; uint16_t IC2IP:3; uint16_t :1;
+    uint16_t OC2IP:3; uint16_t :1; uint16_t T2IP:3; uint16_t :1;
+} IPC1BITS;
+typedef struct {
+    uint16_t T3IP:3; uint16_t :1; uint16_t SPF1IP:3; uint16_t :1;
+    uint16_t SPI1IP:3; uint16_t :1; uint16_t U1RXIP:3; uint16_t :1;
+} IPC2BITS;
+typedef struct {
+    uint16_t U1TXIP:3; uint16_t :1; uint16_t AD1IP:3; uint16_t :9;
+} IPC3BITS;
+typedef struct {
+    uint16_t :4; uint16_t OC3IP:3; uint16_t :1;
+    uint16_t OC4IP:3; uint16_t :1; uint16_t T4IP:3; uint16_t :1;
+} IPC6BITS;
+typedef struct {
+    uint16_t T5IP:3; uint16_t :1; uint16_t INT2IP:3; uint16_t :1;
+    uint16_t U2RXIP:3; uint16_t :1; uint16_t U2TXIP:3; uint16_t :1;
+} IPC7BITS;
+typedef struct {
+    uint16_t :1; uint16_t OSCFAIL:1; uint16_t STKERR:1; uint16_t ADDRERR:1;
+    uint16_t MATHERR:1; uint16_t :10; uint16_t NSTDIS:1;
+} INTCON1BITS;
+typedef struct {
+    uint16_t INT0EP:1; uint16_t INT1EP:1; uint16_t INT2EP:1; uint16_t :11;
+    uint16_t DISI:1; uint16_t ALTIVT:1;
+} INTCON2BITS;
+
+#define IFS0        SIM_REG(SFR_IFS0)
+#define IFS0bits    SIM_BITS(IFS0BITS, SFR_IFS0)
+#define IFS1        SIM_REG(SFR_IFS1)
+#define IFS1bits    SIM_BITS(IFS1BITS, SFR_IFS1)
+#define IEC0        SIM_REG(SFR_IEC0)
+#define IEC0bits    SIM_BITS(IEC0BITS, SFR_IEC0)
+#define IEC1        SIM_REG(SFR_IEC1)
+#define IEC1bits    SIM_BITS(IEC1BITS, SFR_IEC1)
+#define IPC0        SIM_REG(SFR_IPC0)
+#define IPC0bits    SIM_BITS(IPC0BITS, SFR_IPC0)
+#define IPC1        SIM_REG(SFR_IPC1)
+#define IPC1bits    SIM_BITS(IPC1BITS, SFR_IPC1)
+#define IPC2        SIM_REG(SFR_IPC2)
+#define IPC2bits    SIM_BITS(IPC2BITS, SFR_IPC2)
+#define IPC3        SIM_REG(SFR_IPC3)
+#define IPC3bits    SIM_BITS(IPC3BITS, SFR_IPC3)
+#define IPC6        SIM_REG(SFR_IPC6)
+#define IPC6bits    SIM_BITS(IPC6BITS, SFR_IPC6)
+#define IPC7        SIM_REG(SFR_IPC7)
+#define IPC7bits    SIM_BITS(IPC7BITS, SFR_IPC7)
+#define INTCON1     SIM_REG(SFR_INTCON1)
+#define INTCON1bits SIM_BITS(INTCON1BITS, SFR_INTCON1)
+#define INTCON2     SIM_REG(SFR_INTCON2)
+#define INTCON2bits SIM_BITS(INTCON2BITS, SFR_INTCON2)
+#define INTTREG     SIM_REG(SFR_INTTREG)
+#define _VECNUM     (INTTREG & 0x7F)
+#define _T1IF IFS0bits.T1IF
+#define _T1IE IEC0bits.T1IE
+#define _T1IP IPC0bits.T1IP
+
+// SPI1
+typedef struct {
+    uint16_t SPIRBF:1; uint16_t SPITBF:1; uint16_t SISEL:3; uint16_t SRXMPT:1;
+    uint16_t SPIROV:1; uint16_t SRMPT:1; uint16_t SPIBEC:3; uint16_t :2;
+    uint16_t SPISIDL:1; uint16_t :1; uint16_t SPIEN:1;
+} SPI1STATBITS;
+typedef struct {
+    uint16_t PPRE:2; uint16_t SPRE:3; uint16_t MSTEN:1; uint16_t CKP:1;
+    uint16_t SSEN:1; uint16_t CKE:1; uint16_t SMP:1; uint16_t MODE16:1;
+    uint16_t DISSDO:1; uint16_t DISSCK:1; uint16_t :3;
+} SPI1CON1BITS;
+
+#define SPI1BUF      SIM_REG(SFR_SPI1BUF)
+#define SPI1STAT     SIM_REG(SFR_SPI1STAT)
+#define SPI1STATbits SIM_BITS(SPI1STATBITS, SFR_SPI1STAT)
+#define SPI1CON1     SIM_REG(SFR_SPI1CON1)
+#define SPI1CON1bits SIM_BITS(SPI1CON1BITS, SFR_SPI1CON1)
+#define SPI1CON2     SIM_REG(SFR_SPI1CON2)
+
+// UART1
+typedef struct {
+    uint16_t STSEL:1; uint16_t PDSEL:2; uint16_t BRGH:1; uint16_t RXINV:1;
+    uint16_t ABAUD:1; uint16_t LPBACK:1; uint16_t WAKE:1; uint16_t UEN:2;
+    uint16_t :1; uint16_t RTSMD:1; uint16_t IREN:1; uint16_t USIDL:1;
+    uint16_t :1; uint16_t UARTEN:1;
+} U1MODEBITS;
+typedef struct {
+    uint16_t URXDA:1; uint16_t OERR:1; uint16_t FERR:1; uint16_t PERR:1;
+    uint16_t RIDLE:1; uint16_t ADDEN:1; uint16_t URXISEL:2; uint16_t TRMT:1;
+    uint16_t UTXBF:1; uint16_t UTXEN:1; uint16_t UTXBRK:1; uint16_t :1;
+    uint16_t UTXISEL0:1; uint16_t UTXINV:1; uint16_t UTXISEL1:1;
+} U1STABITS;
+
+#define U1MODE     SIM_REG(SFR_U1MODE)
+#define U1MODEbits SIM_BITS(U1MODEBITS, SFR_U1MODE)
+#define U1STA      SIM_REG(SFR_U1STA)
+#define U1STAbits  SIM_BITS(U1STABITS, SFR_U1STA)
+#define U1BRG      SIM_REG(SFR_U1BRG)
+#define U1TXREG    SIM_REG(SFR_U1TXREG)
+#define U1RXREG    SIM_REG(SFR_U1RXREG)
+
+// Peripheral Pin Select
+#define SIM_RPOR(lo, hi) struct { \
+    uint16_t lo:5; uint16_t :3; uint16_t hi:5; uint16_t :3; }
+typedef SIM_RPOR(RP0R, RP1R)   RPOR0BITS;
+typedef SIM_RPOR(RP2R, RP3R)   RPOR1BITS;
+typedef SIM_RPOR(RP4R, RP5R)   RPOR2BITS;
+typedef SIM_RPOR(RP6R, RP7R)   RPOR3BITS;
+typedef SIM_RPOR(RP8R, RP9R)   RPOR4BITS;
+typedef SIM_RPOR(RP10R, RP11R) RPOR5BITS;
+typedef SIM_RPOR(RP12R, RP13R) RPOR6BITS;
+typedef SIM_RPOR(RP14R, RP15R) RPOR7BITS;
+typedef SIM_RPOR(U1RXR, U1CTSR) RPINR18BITS;
+typedef SIM_RPOR(U2RXR, U2CTSR) RPINR19BITS;
+typedef SIM_RPOR(SDI1R, SCK1R)  RPINR20BITS;
+
+#define RPOR0bits   SIM_BITS(RPOR0BITS, SFR_RPOR0)
+#define RPOR1bits   SIM_BITS(RPOR1BITS, SFR_RPOR1)
+#define RPOR2bits   SIM_BITS(RPOR2BITS, SFR_RPOR2)
+#define RPOR3bits   SIM_BITS(RPOR3BITS, SFR_RPOR3)
+#define RPOR4bits   SIM_BITS(RPOR4BITS, SFR_RPOR4)
+#define RPOR5bits   SIM_BITS(RPOR5BITS, SFR_RPOR5)
+#define RPOR6bits   SIM_BITS(RPOR6BITS, SFR_RPOR6)
+#define RPOR7bits   SIM_BITS(RPOR7BITS, SFR_RPOR7)
+#define RPINR18bits SIM_BITS(RPINR18BITS, SFR_RPINR18)
+#define RPINR19bits SIM_BITS(RPINR19BITS, SFR_RPINR19)
+#define RPINR20bits SIM_BITS(RPINR20BITS, SFR_RPINR20)
+
+// Oscillator, power management
+#define OSCCON  SIM_REG(SFR_OSCCON)
+#define CLKDIV  SIM_REG(SFR_CLKDIV)
+#define OSCTUN  SIM_REG(SFR_OSCTUN)
+#define REFOCON SIM_REG(SFR_REFOCON)
+#define PMD1    SIM_REG(SFR_PMD1)
+#define PMD2    SIM_REG(SFR_PMD2)
+#define PMD3    SIM_REG(SFR_PMD3)
+#define PMD4    SIM_REG(SFR_PMD4)
+
+// CPU core
+typedef struct {
+    uint16_t C:1; uint16_t Z:1; uint16_t OV:1; uint16_t N:1;
+    uint16_t RA:1; uint16_t IPL:3; uint16_t :8;
+} SRBITS;
+typedef struct {
+    uint16_t :2; uint16_t PSV:1; uint16_t IPL3:1; uint16_t :12;
+} CORCONBITS;
+typedef struct {
+    uint16_t POR:1; uint16_t BOR:1; uint16_t IDLE:1; uint16_t SLEEP:1;
+    uint16_t WDTO:1; uint16_t SWDTEN:1; uint16_t SWR:1; uint16_t EXTR:1;
+    uint16_t PMSLP:1; uint16_t CM:1; uint16_t :4; uint16_t IOPUWR:1;
+    uint16_t TRAPR:1;
+} RCONBITS;
+typedef struct {
+    uint16_t NVMOP:4; uint16_t :2; uint16_t ERASE:1; uint16_t :6;
+    uint16_t WRERR:1; uint16_t WREN:1; uint16_t WR:1;
+} NVMCONBITS;
+
+#define SR         SIM_REG(SFR_SR)
+#define SRbits     SIM_BITS(SRBITS, SFR_SR)
+#define CORCON     SIM_REG(SFR_CORCON)
+#define CORCONbits SIM_BITS(CORCONBITS, SFR_CORCON)
+#define SPLIM      SIM_REG(SFR_SPLIM)
+#define DISICNT    SIM_REG(SFR_DISICNT)
+#define RCON       SIM_REG(SFR_RCON)
+#define RCONbits   SIM_BITS(RCONBITS, SFR_RCON)
+#define NVMCON     SIM_REG(SFR_NVMCON)
+#define NVMCONbits SIM_BITS(NVMCONBITS, SFR_NVMCON)
+#define TBLPAG     SIM_REG(SFR_TBLPAG)
+
+// compiler builtins
+void sim_builtin_nop(void);
+void sim_builtin_disi(uint16_t cycles);
+void sim_builtin_interrupts(int enable);
+void sim_builtin_idle(void);
+void sim_builtin_clrwdt(void);
+void sim_builtin_reset(void);
+uint16_t sim_builtin_tblrdl(uint16_t offset);
+uint16_t sim_builtin_tblrdh(uint16_t offset);
+void sim_builtin_tblwtl(uint16_t offset, uint16_t data);
+void sim_builtin_tblwth(uint16_t offset, uint16_t data);
+void sim_builtin_write_nvm(void);
+void sim_builtin_write_oscconl(uint8_t v);
+
+#define Nop()        sim_builtin_nop()
+#define Idle()       sim_builtin_idle()
+#define ClrWdt()     sim_builtin_clrwdt()
+#define __builtin_nop()                sim_builtin_nop()
+#define __builtin_disi(n)              sim_builtin_disi(n)
+#define __builtin_enable_interrupts()  sim_builtin_interrupts(1)
+#define __builtin_disable_interrupts() sim_builtin_interrupts(0)
+#define __builtin_write_OSCCONH(v)     ((void)(v))
+#define __builtin_write_OSCCONL(v)     sim_builtin_write_oscconl(v)
+#define __builtin_software_breakpoint() ((void)0)
+#define __builtin_tblrdl(offset)       sim_builtin_tblrdl(offset)
+#define __builtin_tblrdh(offset)       sim_builtin_tblrdh(offset)
+#define __builtin_tblwtl(offset, data) sim_builtin_tblwtl(offset, data)
+#define __builtin_tblwth(offset, data) sim_builtin_tblwth(offset, data)
+#define __builtin_write_NVM()          sim_builtin_write_nvm()
+
+// CPU priority helpers from device header (p24FJ64GB002.h)
+#define SET_CPU_IPL(ipl) { \
+    int DISI_save; \
+    DISI_save = DISICNT; \
+    __builtin_disi(0x3FFF); \
+    SRbits.IPL = (ipl); \
+    DISICNT = DISI_save; } (void) 0
+#define SET_AND_SAVE_CPU_IPL(save_to, ipl) { \
+    save_to = SRbits.IPL; \
+    SET_CPU_IPL(ipl); } (void) 0
+#define RESTORE_CPU_IPL(saved_to) SET_CPU_IPL(saved_to)
+
+// XC16 attributes that have no meaning (or other meaning) on host
+#define interrupt   unused
+#define no_auto_psv unused
+#define persistent  section("sim_persistent") // kept on reset
+#define noload      unused  // space(prog) reservations (flash is modelled)
+#define space(s)    unused
+#define address(a)  unused
+#define near        unused
+#define auto_psv    unused
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_XC_H */
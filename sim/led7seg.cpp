@@ -0,0 +1,202 @@
+/**
+  @File Name
+    sim/led7seg.cpp
+
+  @Summary
+    Multiplexed 7-segment LED display model - see led7seg.h
+*/
+
+#include <cmath>
+#include <cstdio>
+
+#include "led7seg.h"
+
+// segment patterns (bit 0 = A ... bit 6 = G) and characters they show
+static const struct { uint8_t segs; char c; } GLYPHS[] = {
+    { 0x3F, '0' }, { 0x06, '1' }, { 0x5B, '2' }, { 0x4F, '3' },
+    { 0x66, '4' }, { 0x6D, '5' }, { 0x7D, '6' }, { 0x07, '7' },
+    { 0x7F, '8' }, { 0x6F, '9' }, { 0x77, 'A' }, { 0x7C, 'b' },
+    { 0x39, 'C' }, { 0x5E, 'd' }, { 0x79, 'E' }, { 0x71, 'F' },
+    { 0x40, '-' }, { 0x50, 'r' }, { 0x76, 'H' }, { 0x38, 'L' },
+    { 0x00, ' ' },
+};
+
+// perceived segment is lit above this fraction of brightest one
+static const double LIT = 0.5;
+// dimmer segments above this fraction are visible ghosts
+static const double GHOST = 0.01;
+
+LedMux7Seg::LedMux7Seg(const int (&mux_pins)[DIGITS], const int (&seg_pins)[SEGS])
+{
+    for (int d = 0; d < DIGITS; d++){
+        mux_mask_[d] = (uint16_t)(1U << mux_pins[d]);
+    }
+    for (int s = 0; s < SEGS; s++){
+        seg_mask_[s] = (uint16_t)(1U << seg_pins[s]);
+    }
+}
+
+// light emitted since last pin change
+void LedMux7Seg::integrate(uint64_t cycle)
+{
+    uint64_t dt = cycle - last_;
+    double k = 1.0 - exp(-sim_cycles_to_us(dt) / (tau_ms * 1000.0));
+
+    last_ = cycle;
+    for (int d = 0; d < DIGITS; d++){
+        bool on = !(porta_ & mux_mask_[d]);
+        for (int s = 0; s < SEGS; s++){
+            bool lit = on && !(portb_ & seg_mask_[s]);
+            if (lit){
+                lit_[d][s] += dt;
+                slot_lit_[d][s] += dt;
+            }
+            pov_[d][s] += ((lit ? 1.0 : 0.0) - pov_[d][s]) * k;
+        }
+    }
+}
+
+void LedMux7Seg::slot_end(int d, uint64_t cycle)
+{
+    uint64_t len = cycle - slot_start_[d];
+
+    slot_on_[d] = false;
+    slot_total_[d] += len;
+    for (int s = 0; s < SEGS; s++){
+        lit_sum_ += (double)slot_lit_[d][s];
+        if (slot_lit_[d][s] * 2 < len){
+            ghost_frame_ += (double)slot_lit_[d][s];
+        }
+        slot_lit_[d][s] = 0;
+    }
+}
+
+void LedMux7Seg::frame_end(uint64_t cycle)
+{
+    if (frame_start_ != UINT64_MAX){
+        uint64_t period = cycle - frame_start_;
+        if (frames_ == 0 || period < period_min_) period_min_ = period;
+        if (period > period_max_) period_max_ = period;
+        period_sum_ += period;
+        for (int d = 0; d < DIGITS; d++){
+            duty_sum_[d] += slot_total_[d];
+        }
+        ghost_sum_ += ghost_frame_;
+        if (ghost_frame_ > ghost_max_) ghost_max_ = ghost_frame_;
+        frames_++;
+        if (log_text){
+            std::string t = text();
+            if (t != last_text_){
+                fprintf(stderr, "display: %10.3f ms \"%s\"\n",
+                        sim_cycles_to_us(cycle) / 1000.0, t.c_str());
+                last_text_ = t;
+            }
+        }
+    }
+    frame_start_ = cycle;
+    ghost_frame_ = 0;
+    for (int d = 0; d < DIGITS; d++){
+        slot_total_[d] = 0;
+    }
+}
+
+void LedMux7Seg::on_pins(uint64_t cycle, uint16_t porta, uint16_t portb)
+{
+    integrate(cycle);
+    for (int d = 0; d < DIGITS; d++){
+        bool on = !(porta & mux_mask_[d]);
+        if (on && !slot_on_[d]){
+            if (d == 0){
+                frame_end(cycle);
+            }
+            slot_on_[d] = true;
+            slot_start_[d] = cycle;
+        } else if (!on && slot_on_[d]){
+            slot_end(d, cycle);
+        }
+    }
+    porta_ = porta;
+    portb_ = portb;
+}
+
+double LedMux7Seg::brightest()
+{
+    double max = 0;
+
+    integrate(sim_cycles);
+    for (int d = 0; d < DIGITS; d++){
+        for (int s = 0; s < SEGS; s++){
+            if (pov_[d][s] > max) max = pov_[d][s];
+        }
+    }
+    return max;
+}
+
+std::string LedMux7Seg::text()
+{
+    double max = brightest();
+    std::string t;
+
+    for (int d = 0; d < DIGITS; d++){
+        uint8_t segs = 0;
+        for (int s = 0; s < SEGS; s++){
+            if (max > 0 && pov_[d][s] >= LIT * max){
+                segs |= (uint8_t)(1U << s);
+            }
+        }
+        char c = '?';
+        for (const auto &g : GLYPHS){
+            if (g.segs == (segs & 0x7F)){
+                c = g.c;
+            }
+        }
+        t += c;
+        if (segs & 0x80){
+            t += '.';
+        }
+    }
+    return t;
+}
+
+void LedMux7Seg::print_art(FILE *f)
+{
+    double max = brightest();
+    auto ch = [&](int d, int s, char lit) {
+        double b = max > 0 ? pov_[d][s] / max : 0;
+        return b >= LIT ? lit : b >= GHOST ? '.' : ' ';
+    };
+
+    // rows: A, F B, G, E C, D DP
+    for (int d = 0; d < DIGITS; d++) fprintf(f, " %c%c%c   ", ch(d, 0, '_'), ch(d, 0, '_'), ch(d, 0, '_'));
+    fputc('\n', f);
+    for (int d = 0; d < DIGITS; d++) fprintf(f, "%c   %c  ", ch(d, 5, '|'), ch(d, 1, '|'));
+    fputc('\n', f);
+    for (int d = 0; d < DIGITS; d++) fprintf(f, " %c%c%c   ", ch(d, 6, '_'), ch(d, 6, '_'), ch(d, 6, '_'));
+    fputc('\n', f);
+    for (int d = 0; d < DIGITS; d++) fprintf(f, "%c   %c  ", ch(d, 4, '|'), ch(d, 2, '|'));
+    fputc('\n', f);
+    for (int d = 0; d < DIGITS; d++) fprintf(f, " %c%c%c %c ", ch(d, 3, '_'), ch(d, 3, '_'), ch(d, 3, '_'), ch(d, 7, 'o'));
+    fputc('\n', f);
+}
+
+void LedMux7Seg::report()
+{
+    if (frames_ == 0){
+        fprintf(stderr, "display: no complete frame\n");
+        return;
+    }
+    double avg = (double)period_sum_ / frames_;
+    fprintf(stderr, "display: %llu frames, refresh %.2f Hz (min %.2f max %.2f)\n",
+            (unsigned long long)frames_, 1e6 / sim_cycles_to_us((uint64_t)avg),
+            1e6 / sim_cycles_to_us(period_max_), 1e6 / sim_cycles_to_us(period_min_));
+    fprintf(stderr, "display: duty");
+    for (int d = 0; d < DIGITS; d++){
+        fprintf(stderr, " %.2f%%", 100.0 * duty_sum_[d] / period_sum_);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "display: ghost %.2f seg*us/frame (max %.2f), %.4f%% of light\n",
+            sim_cycles_to_us((uint64_t)(ghost_sum_ / frames_)),
+            sim_cycles_to_us((uint64_t)ghost_max_),
+            lit_sum_ > 0 ? 100.0 * ghost_sum_ / lit_sum_ : 0.0);
+    fprintf(stderr, "display: shows \"%s\"\n", text().c_str());
+}
@@ -0,0 +1,92 @@
+/**
+  @File Name
+    sim/led7seg.h
+
+  @Summary
+    Multiplexed 7-segment LED display model with persistence of vision.
+
+  @Description
+    Common anode digits switched by mux pins, segment cathodes on
+    segment pins, both active low (BQ-M512RD on pic24fj-temp.X). Segment
+    of digit emits light while both its mux and segment pin are low.
+    Every pin change integrates light of previous interval:
+
+    - on-time of each segment and digit slot (mux low interval)
+    - ghosting - light of segment that is not part of steady pattern of
+      the slot (lit for less than half of slot), typically when mux is
+      switched before segment pins or two digits overlap; measured as
+      energy in segment*us
+    - frame - from one slot of digit 0 to the next one: refresh rate,
+      duty cycle of each digit and ghost energy per frame
+    - what human sees - light of each segment through first order
+      low-pass filter (eye integration, tau 20 ms by default), segments
+      brighter than half of the brightest one are decoded as characters,
+      dimmer ones above 1 % are visible ghosts
+
+    Report tells how changes of multiplex ISR affect flicker (refresh
+    rate, missed ticks), brightness (duty) and ghosting.
+*/
+
+#ifndef SIM_LED7SEG_H
+#define SIM_LED7SEG_H
+
+#include <stdint.h>
+#include <string>
+
+#include "sim.h"
+
+class LedMux7Seg : public SimDevice {
+public:
+    static const int DIGITS = 4;
+    static const int SEGS = 8; // A B C D E F G DP
+
+    // mux pins on port A (digit 0 = leftmost), segment pins on port B
+    // in order A B C D E F G DP
+    LedMux7Seg(const int (&mux_pins)[DIGITS], const int (&seg_pins)[SEGS]);
+
+    // eye integration time constant [ms]
+    double tau_ms = 20;
+    // prints perceived text whenever it changes (checked every frame)
+    bool log_text = false;
+
+    // perceived characters, for example "21.5" or "Err2" ('?' unknown)
+    std::string text();
+    // perceived display as ASCII art ('#' lit, '.' visible ghost)
+    void print_art(FILE *f);
+    void report();
+
+    void on_pins(uint64_t cycle, uint16_t porta, uint16_t portb) override;
+
+private:
+    uint16_t mux_mask_[DIGITS];
+    uint16_t seg_mask_[SEGS];
+    uint16_t porta_ = 0xFFFF, portb_ = 0xFFFF;
+    uint64_t last_ = 0;
+
+    double pov_[DIGITS][SEGS] = {};   // perceived brightness 0..1
+    uint64_t lit_[DIGITS][SEGS] = {}; // total on-time [cycles]
+
+    // current slot of each digit
+    bool slot_on_[DIGITS] = {};
+    uint64_t slot_start_[DIGITS] = {};
+    uint64_t slot_lit_[DIGITS][SEGS] = {};
+    uint64_t slot_total_[DIGITS] = {}; // summed slot time in frame
+
+    // frames
+    uint64_t frame_start_ = UINT64_MAX;
+    uint64_t frames_ = 0;
+    uint64_t period_min_ = 0, period_max_ = 0, period_sum_ = 0;
+    uint64_t duty_sum_[DIGITS] = {};   // slot time of counted frames
+    double ghost_frame_ = 0;           // segment*cycles in current frame
+    double ghost_sum_ = 0, ghost_max_ = 0;
+    double lit_sum_ = 0;               // segment*cycles of all slots
+    std::string last_text_;
+
+    void integrate(uint64_t cycle);
+    void slot_end(int d, uint64_t cycle);
+    void frame_end(uint64_t cycle);
+    uint8_t pattern(double threshold, double ref);
+    double brightest();
+};
+
+#endif /* SIM_LED7SEG_H */
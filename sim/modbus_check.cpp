@@ -0,0 +1,391 @@
+/**
+  @File Name
+    sim/modbus_check.cpp
+
+  @Summary
+    Host Modbus master check of thermometer firmware built as Modbus
+    RTU slave (common/modbus.h) over pseudo-terminal.
+
+  @Description
+    Usage: modbus-check [-n seconds] [-s seed] [-e temps] [-l log]
+                        simulator [options]
+
+    Creates pty and runs simulator (sim-temp-modbus) with its UART1 on
+    the other side (-o uart=path, -t seconds + 1 are appended, output
+    goes to -l log). Then it is Modbus master for -n seconds (default
+    10):
+    - waits for slave (Diagnostics echo, up to 3 s after boot)
+    - CRC-16/MODBUS of known vector
+    - exceptions: unknown function, diagnostics sub-function, register
+      out of map, count 0 and over 125, read request of wrong length
+    - frames that must stay unanswered: bad CRC, other slave, broadcast,
+      frame split by pause over t3.5 (two bad frames), too short frame
+    - echo of 252-byte request (answer built over the request)
+    - random reads of status, temperature and error registers until the
+      end, 0..30 ms apart so that requests fall to every phase of
+      1-wire reads, display multiplex and scheduler tick
+
+    Every answer must come before timeout with good CRC and length,
+    uptime must not go back, "requests" register must equal requests
+    sent with good CRC to the slave and "dropped" one the broken frames
+    sent. Once read, temperatures must match -e (comma separated
+    degrees C in any order, 0.5 C tolerance - 9-bit readings of stable
+    temperature) and error registers must be 0. Simulator exit status
+    must be 0 (1-wire timing, reply latency given by its -o reply_min /
+    reply_max).
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "modbus_rtu.h"
+#include "serial.h"
+
+// input registers of pic24fj-temp.X/main.c (MODBUS_REG_*)
+#define REG_UPTIME   0x0000
+#define REG_SENSORS  0x0002
+#define REG_REQUESTS 0x0007
+#define REG_BAD      0x0008
+#define REG_STATUS_COUNT 9
+#define REG_TEMP     0x0100
+#define REG_ERRORS   0x0200
+#define MAX_SENSORS  32
+#define NO_READING   0x8000
+
+static const uint8_t SLAVE = 1;
+
+static uint64_t good_sent = 0;      // requests to slave with good CRC
+static uint64_t bad_sent = 0;       // frames slave must drop
+static uint64_t exceptions = 0;
+static uint32_t last_uptime = 0;
+static std::vector<double> expect_temps;
+static bool temps_checked = false;
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_ms(unsigned ms)
+{
+    usleep(ms * 1000);
+}
+
+static const char *result_name(int r)
+{
+    static char buf[32];
+
+    switch (r) {
+        case MODBUS_TIMEOUT: return "timeout";
+        case MODBUS_BAD: return "bad answer";
+        case MODBUS_IO: return "I/O error";
+        default:
+            snprintf(buf, sizeof(buf), "exception %02X", r);
+            return buf;
+    }
+}
+
+static std::vector<uint8_t> read_req(uint8_t slave, uint16_t addr, uint16_t count)
+{
+    return { slave, 0x04, (uint8_t)(addr >> 8), (uint8_t)addr,
+             (uint8_t)(count >> 8), (uint8_t)count };
+}
+
+// request that must be answered by exception 'code'
+static void expect_exception(ModbusMaster &mb, const char *what,
+                             const std::vector<uint8_t> &req, uint8_t code)
+{
+    std::vector<uint8_t> ans;
+    int r = mb.request(req, ans);
+
+    good_sent++;
+    exceptions++;
+    if (r < 0) {
+        fail("%s: %s", what, result_name(r));
+    } else if (r != 3 || !(ans[1] & 0x80) || ans[2] != code) {
+        fail("%s: answer %02X %02X instead of exception %02X", what, ans[1],
+             r > 2 ? ans[2] : 0, code);
+    }
+}
+
+// raw frame that must stay unanswered, 'bad' frames are dropped by slave
+static void expect_silence(ModbusMaster &mb, const char *what,
+                           const std::vector<std::vector<uint8_t>> &parts, unsigned bad)
+{
+    uint64_t stray = mb.stray();
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (i) {
+            // far over t3.5 - also when simulator lags behind wall clock
+            sleep_ms(50);
+        }
+        mb.send_raw(parts[i]);
+    }
+    sleep_ms(mb.timeout_ms);
+    // answer, if any, is drained before next request
+    mb.send_raw({});
+    if (mb.stray() != stray) {
+        fail("%s: answered (%llu bytes)", what, (unsigned long long)(mb.stray() - stray));
+    }
+    bad_sent += bad;
+}
+
+static std::vector<uint8_t> with_crc(std::vector<uint8_t> f)
+{
+    uint16_t c = ModbusMaster::crc(f.data(), f.size());
+
+    f.push_back((uint8_t)c);
+    f.push_back((uint8_t)(c >> 8));
+    return f;
+}
+
+static void check_status(const std::vector<uint16_t> &v, double elapsed)
+{
+    uint32_t uptime = (uint32_t)v[REG_UPTIME] << 16 | v[REG_UPTIME + 1];
+
+    if (uptime < last_uptime || uptime > elapsed + 1) {
+        fail("uptime %lu s after %lu s (%.1f s since start)", (unsigned long)uptime,
+             (unsigned long)last_uptime, elapsed);
+    }
+    last_uptime = uptime;
+    if (v[REG_REQUESTS] != (uint16_t)good_sent) {
+        fail("requests register %u, sent %llu", v[REG_REQUESTS],
+             (unsigned long long)good_sent);
+    }
+    if (v[REG_BAD] != (uint16_t)bad_sent) {
+        fail("dropped frames register %u, sent %llu broken", v[REG_BAD],
+             (unsigned long long)bad_sent);
+    }
+}
+
+// 'sensors' - count from last status read, -1 before it
+static void check_temps(const std::vector<uint16_t> &v, int sensors)
+{
+    std::vector<double> t;
+
+    if (sensors < 0) {
+        return;
+    }
+    for (unsigned i = 0; i < MAX_SENSORS; i++) {
+        if (i >= (unsigned)sensors) {
+            if (v[i] != NO_READING) {
+                fail("sensor %u of %d has reading %04X", i, sensors, v[i]);
+            }
+        } else if (v[i] != NO_READING) {
+            t.push_back((int16_t)v[i] / 16.0);
+        }
+    }
+    if (expect_temps.empty() || t.size() < (size_t)sensors) {
+        return;
+    }
+    if (t.size() != expect_temps.size()) {
+        fail("%zu sensors read, %zu expected", t.size(), expect_temps.size());
+        return;
+    }
+    std::sort(t.begin(), t.end());
+    for (size_t i = 0; i < t.size(); i++) {
+        if (fabs(t[i] - expect_temps[i]) > 0.5) {
+            fail("temperature %.4f C, expected %.4f C", t[i], expect_temps[i]);
+        }
+    }
+    temps_checked = true;
+}
+
+// one random read of status, temperatures or errors
+static void poll_once(ModbusMaster &mb, double start, int &sensors)
+{
+    std::vector<uint16_t> v;
+    uint16_t addr, count;
+    unsigned what = rnd(4);
+
+    switch (what) {
+        case 0: addr = REG_UPTIME; count = REG_STATUS_COUNT; break;
+        case 1: addr = REG_TEMP; count = MAX_SENSORS; break;
+        case 2: addr = REG_ERRORS; count = MAX_SENSORS; break;
+        default:
+            count = (uint16_t)(1 + rnd(MAX_SENSORS));
+            addr = (uint16_t)((rnd(2) ? REG_TEMP : REG_ERRORS) + rnd(MAX_SENSORS - count + 1));
+            break;
+    }
+    int r = mb.read_inputs(SLAVE, addr, count, v);
+    good_sent++;
+    if (r) {
+        fail("read %04X+%u at %.3f s: %s", addr, count, now_s() - start, result_name(r));
+        return;
+    }
+    switch (what) {
+        case 0:
+            sensors = v[REG_SENSORS];
+            check_status(v, now_s() - start);
+            break;
+        case 1:
+            check_temps(v, sensors);
+            break;
+        case 2:
+            for (unsigned i = 0; i < MAX_SENSORS; i++) {
+                if (v[i]) {
+                    fail("sensor %u has %u errors", i, v[i]);
+                }
+            }
+            break;
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n seconds] [-s seed] [-e temps] [-l log] "
+            "simulator [options]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 10;
+    unsigned seed = 1;
+    const char *log = "/dev/null";
+    int opt;
+
+    // options of simulator follow its path
+    while ((opt = getopt(argc, argv, "+n:s:e:l:h")) != -1) {
+        switch (opt) {
+            case 'n': seconds = atof(optarg); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'e':
+                for (const char *p = optarg; *p; p += strcspn(p, ",")) {
+                    p += *p == ',';
+                    expect_temps.push_back(atof(p));
+                }
+                std::sort(expect_temps.begin(), expect_temps.end());
+                break;
+            case 'l': log = optarg; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+    }
+    check_init("modbus", seed);
+    if (ModbusMaster::crc((const uint8_t *)"123456789", 9) != 0x4B37) {
+        fail("CRC-16/MODBUS of \"123456789\" is not 4B37");
+    }
+
+    std::string path;
+    int fd = serial_open_pty(path);
+    if (fd < 0) {
+        perror("pty");
+        return 1;
+    }
+    char t[32];
+    snprintf(t, sizeof(t), "%g", seconds + 1);
+    std::string uart = "uart=" + path;
+    std::vector<char *> args(argv + optind, argv + argc);
+    args.push_back((char *)"-t");
+    args.push_back(t);
+    args.push_back((char *)"-o");
+    args.push_back((char *)uart.c_str());
+    args.push_back(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int out = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out >= 0) {
+            dup2(out, 1);
+            dup2(out, 2);
+        }
+        execv(args[0], args.data());
+        perror(args[0]);
+        _exit(2);
+    }
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    double start = now_s();
+    ModbusMaster mb(fd);
+    std::vector<uint8_t> ans;
+    std::vector<uint8_t> echo = { SLAVE, 0x08, 0x00, 0x00, 0xA5, 0x37 };
+    int r = MODBUS_TIMEOUT;
+    while (r == MODBUS_TIMEOUT && now_s() - start < 3) {
+        r = mb.request(echo, ans);
+    }
+    if (r < 0 || ans != echo) {
+        fail("no echo from slave: %s", r < 0 ? result_name(r) : "different data");
+    }
+    // requests before boot were not received at all
+    good_sent = 1;
+
+    expect_exception(mb, "function 03", { SLAVE, 0x03, 0x00, 0x00, 0x00, 0x01 }, 0x01);
+    expect_exception(mb, "diagnostics 0001", { SLAVE, 0x08, 0x00, 0x01, 0x00, 0x00 }, 0x01);
+    expect_exception(mb, "register 0010", read_req(SLAVE, 0x0010, 1), 0x02);
+    expect_exception(mb, "sensor 32", read_req(SLAVE, REG_TEMP, MAX_SENSORS + 1), 0x02);
+    expect_exception(mb, "register FFFF+2", read_req(SLAVE, 0xFFFF, 2), 0x02);
+    expect_exception(mb, "count 0", read_req(SLAVE, REG_UPTIME, 0), 0x03);
+    expect_exception(mb, "count 126", read_req(SLAVE, REG_UPTIME, 126), 0x03);
+    expect_exception(mb, "request of 7 bytes",
+                     { SLAVE, 0x04, 0x00, 0x00, 0x00, 0x01, 0x00 }, 0x03);
+
+    std::vector<uint8_t> f = with_crc(read_req(SLAVE, REG_UPTIME, 2));
+    std::vector<uint8_t> broken(f);
+    broken[3] ^= 0x10;
+    expect_silence(mb, "bad CRC", { broken }, 1);
+    expect_silence(mb, "other slave", { with_crc(read_req(SLAVE + 1, REG_UPTIME, 2)) }, 0);
+    expect_silence(mb, "broadcast", { with_crc(read_req(0, REG_UPTIME, 2)) }, 0);
+    expect_silence(mb, "split frame", { std::vector<uint8_t>(f.begin(), f.begin() + 3),
+                                        std::vector<uint8_t>(f.begin() + 3, f.end()) }, 2);
+    expect_silence(mb, "short frame", { { SLAVE, 0x04, 0x00 } }, 1);
+
+    std::vector<uint8_t> big = { SLAVE, 0x08, 0x00, 0x00 };
+    while (big.size() < 252) {
+        big.push_back((uint8_t)rnd(256));
+    }
+    r = mb.request(big, ans);
+    good_sent++;
+    if (r < 0 || ans != big) {
+        fail("echo of %zu bytes: %s", big.size() + 2, r < 0 ? result_name(r) : "different data");
+    }
+
+    int sensors = -1;
+    uint64_t polls = 0;
+    while (now_s() - start < seconds) {
+        poll_once(mb, start, sensors);
+        polls++;
+        sleep_ms(rnd(31));
+    }
+    std::vector<uint16_t> v;
+    r = mb.read_inputs(SLAVE, REG_UPTIME, REG_STATUS_COUNT, v);
+    good_sent++;
+    if (r) {
+        fail("final status: %s", result_name(r));
+    } else {
+        check_status(v, now_s() - start);
+    }
+    if (!expect_temps.empty() && !temps_checked) {
+        fail("no complete set of temperatures read");
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fail("simulator failed (see %s)", log);
+    }
+    close(fd);
+    printf("modbus: %llu requests (%llu exceptions, %llu polls), %llu broken frames, "
+           "%u failures\n", (unsigned long long)good_sent, (unsigned long long)exceptions,
+           (unsigned long long)polls, (unsigned long long)bad_sent, failures);
+    return failures ? 1 : 0;
+}
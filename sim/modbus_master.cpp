@@ -0,0 +1,91 @@
+/**
+  @File Name
+    sim/modbus_master.cpp
+
+  @Summary
+    Reads input registers of Modbus RTU slave (function 04).
+
+  @Description
+    Usage: modbus-master [-b baud] [-a slave] [-n polls] [-i interval_ms]
+                         [-T timeout_ms] device [addr [count]]
+
+    Device is serial port (RS-485 adapter, opened raw at -b baud,
+    default 38400) or pseudo-terminal of simulator:
+
+      build/sim-temp-modbus -t 60 -o uart=pty &   # prints its path
+      build/modbus-master -n 5 /dev/pts/3 0x100 3
+
+    Registers from addr (default 0) are printed in hex and decimal, one
+    line per poll; exception answers and timeouts are printed too, exit
+    status is 1 when any poll failed.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "modbus_rtu.h"
+#include "serial.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-b baud] [-a slave] [-n polls] [-i interval_ms] "
+            "[-T timeout_ms] device [addr [count]]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned baud = 38400;
+    unsigned slave = 1, polls = 1, interval_ms = 1000;
+    int timeout_ms = 200;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:a:n:i:T:h")) != -1) {
+        switch (opt) {
+            case 'b': baud = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'a': slave = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'n': polls = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'i': interval_ms = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'T': timeout_ms = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind >= argc || slave < 1 || slave > 247) {
+        usage(argv[0]);
+    }
+    const char *path = argv[optind++];
+    unsigned addr = optind < argc ? (unsigned)strtoul(argv[optind++], NULL, 0) : 0;
+    unsigned count = optind < argc ? (unsigned)strtoul(argv[optind++], NULL, 0) : 1;
+    int fd = serial_open(path, baud);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    ModbusMaster mb(fd);
+    mb.timeout_ms = timeout_ms;
+    int status = 0;
+    for (unsigned n = 0; n < polls; n++) {
+        if (n) {
+            usleep(interval_ms * 1000);
+        }
+        std::vector<uint16_t> v;
+        int r = mb.read_inputs((uint8_t)slave, (uint16_t)addr, (uint16_t)count, v);
+        if (r == MODBUS_TIMEOUT) {
+            printf("timeout\n");
+        } else if (r == MODBUS_BAD || r == MODBUS_IO) {
+            printf("%s\n", r == MODBUS_BAD ? "bad answer" : "I/O error");
+        } else if (r) {
+            printf("exception %02X\n", r);
+        } else {
+            for (unsigned i = 0; i < count; i++) {
+                printf("%s%04X:%04X(%d)", i ? " " : "", addr + i, v[i], (int16_t)v[i]);
+            }
+            printf("\n");
+        }
+        fflush(stdout);
+        status = status || r;
+    }
+    return status;
+}
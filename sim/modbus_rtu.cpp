@@ -0,0 +1,138 @@
+/**
+  @File Name
+    sim/modbus_rtu.cpp
+
+  @Summary
+    Host Modbus RTU master. See modbus_rtu.h for details.
+*/
+
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+#include "modbus_rtu.h"
+
+uint16_t ModbusMaster::crc(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+// waits up to 'ms' for byte, -1 on silence or error
+static int read_byte(int fd, int ms)
+{
+    struct pollfd p = { fd, POLLIN, 0 };
+    uint8_t b;
+
+    for (;;) {
+        int r = poll(&p, 1, ms);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0 || !(p.revents & POLLIN) || read(fd, &b, 1) != 1) {
+            return -1;
+        }
+        return b;
+    }
+}
+
+// discards anything on the line until it is silent for gap_ms
+void ModbusMaster::drain(void)
+{
+    while (read_byte(fd_, gap_ms) >= 0) {
+        stray_++;
+    }
+}
+
+bool ModbusMaster::send_raw(const std::vector<uint8_t> &bytes)
+{
+    drain();
+    return write(fd_, bytes.data(), bytes.size()) == (ssize_t)bytes.size();
+}
+
+// length of answer with CRC once known from its head, 0 meanwhile
+size_t ModbusMaster::expected(const std::vector<uint8_t> &req,
+                              const std::vector<uint8_t> &ans) const
+{
+    if (ans.size() < 3) {
+        return 0;
+    }
+    if (ans[1] & 0x80) {
+        return 5;
+    }
+    switch (ans[1]) {
+        case 0x03: case 0x04: return 5 + ans[2];
+        case 0x08: return req.size() + 2;
+        default: return 0;
+    }
+}
+
+int ModbusMaster::request(const std::vector<uint8_t> &req, std::vector<uint8_t> &ans)
+{
+    std::vector<uint8_t> f(req);
+    uint16_t c = crc(req.data(), req.size());
+
+    f.push_back((uint8_t)c);
+    f.push_back((uint8_t)(c >> 8));
+    if (!send_raw(f)) {
+        return MODBUS_IO;
+    }
+    ans.clear();
+    int b = read_byte(fd_, timeout_ms);
+    if (b < 0) {
+        return MODBUS_TIMEOUT;
+    }
+    ans.push_back((uint8_t)b);
+    for (;;) {
+        size_t n = expected(req, ans);
+        if (n && ans.size() >= n) {
+            break;
+        }
+        // gap ends answer of unknown length only, rest of known one may
+        // come late (host scheduling of simulator)
+        if ((b = read_byte(fd_, n || ans.size() < 3 ? timeout_ms : gap_ms)) < 0) {
+            break;
+        }
+        ans.push_back((uint8_t)b);
+    }
+    size_t n = ans.size();
+    if (n < 5 || crc(ans.data(), n - 2) != (ans[n - 2] | ans[n - 1] << 8) ||
+            ans[0] != req[0] || (ans[1] & 0x7F) != req[1]) {
+        return MODBUS_BAD;
+    }
+    ans.resize(n - 2);
+    return (int)ans.size();
+}
+
+int ModbusMaster::read_inputs(uint8_t slave, uint16_t addr, uint16_t count,
+                              std::vector<uint16_t> &value)
+{
+    std::vector<uint8_t> ans;
+    std::vector<uint8_t> req = {
+        slave, 0x04, (uint8_t)(addr >> 8), (uint8_t)addr,
+        (uint8_t)(count >> 8), (uint8_t)count
+    };
+    int r = request(req, ans);
+
+    if (r < 0) {
+        return r;
+    }
+    if (ans[1] & 0x80) {
+        return ans[2];
+    }
+    if (ans[2] != 2 * count || ans.size() != 3 + 2 * (size_t)count) {
+        return MODBUS_BAD;
+    }
+    value.clear();
+    for (uint16_t i = 0; i < count; i++) {
+        value.push_back((uint16_t)(ans[3 + 2 * i] << 8 | ans[4 + 2 * i]));
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**
+  @File Name
+    sim/modbus_rtu.h
+
+  @Summary
+    Host Modbus RTU master over serial port (see common/modbus.h).
+
+  @Description
+    ModbusMaster sends request (address and PDU, CRC is appended) and
+    collects answer until its length known from function code (read
+    answers carry byte count, exceptions have 5 bytes, echo has length
+    of request) is reached or 'timeout_ms' passes; answer of other
+    function ends when line is silent for 'gap_ms'. Before
+    each request line is kept silent for at least 'gap_ms' (t3.5 on
+    real line, more for pseudo-terminal of simulator).
+
+    CRC is computed bit by bit here, independent of table driven one of
+    firmware.
+*/
+
+#ifndef SIM_MODBUS_RTU_H
+#define SIM_MODBUS_RTU_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// results of ModbusMaster::request() (>= 0 - answer length)
+#define MODBUS_TIMEOUT -1   // no answer
+#define MODBUS_BAD     -2   // answer with bad CRC, address or length
+#define MODBUS_IO      -3   // read or write failed
+
+class ModbusMaster {
+public:
+    int timeout_ms = 200;   // response timeout
+    int gap_ms = 5;         // silence before request, end of answer
+
+    explicit ModbusMaster(int fd) : fd_(fd) {}
+
+    static uint16_t crc(const uint8_t *data, size_t len);
+    // sends raw bytes as they are (no CRC) - broken frames
+    bool send_raw(const std::vector<uint8_t> &bytes);
+    // sends 'req' (address, function, data) with CRC, answer without
+    // CRC goes to 'ans', returns its length or MODBUS_TIMEOUT/BAD/IO
+    int request(const std::vector<uint8_t> &req, std::vector<uint8_t> &ans);
+    // function 04, returns 0, exception code or MODBUS_TIMEOUT/BAD/IO
+    int read_inputs(uint8_t slave, uint16_t addr, uint16_t count,
+                    std::vector<uint16_t> &value);
+    // bytes received outside of answers (after timeout, garbage)
+    uint64_t stray() const { return stray_; }
+
+private:
+    int fd_;
+    uint64_t stray_ = 0;
+
+    void drain(void);
+    size_t expected(const std::vector<uint8_t> &req, const std::vector<uint8_t> &ans) const;
+};
+
+#endif /* SIM_MODBUS_RTU_H */
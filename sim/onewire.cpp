@@ -0,0 +1,278 @@
+/**
+  @File Name
+    sim/onewire.cpp
+
+  @Summary
+    1-wire bus model with timing monitor for host simulator - see onewire.h
+*/
+
+#include <cstdio>
+
+#include "onewire.h"
+
+// violations printed in detail, further ones are only counted
+static const size_t LOG_MAX = 20;
+
+OneWireBus::OneWireBus(int port, int pin)
+    : port_(port), mask_((uint16_t)(1U << pin))
+{
+}
+
+double OneWireBus::us(uint64_t cycles) const
+{
+    return sim_cycles_to_us(cycles);
+}
+
+uint64_t OneWireBus::cycles(double us) const
+{
+    return (uint64_t)(us * sim_fcy / 1e6);
+}
+
+void OneWireBus::violation(uint64_t cycle, const char *what)
+{
+    violations_++;
+    if (log_.size() < LOG_MAX){
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%12.3f ms: %s", us(cycle) / 1000.0, what);
+        log_.push_back(buf);
+    }
+}
+
+void OneWireBus::check(Stat &st, double v, uint64_t cycle)
+{
+    if (st.count == 0 || v < st.min) st.min = v;
+    if (st.count == 0 || v > st.max) st.max = v;
+    st.count++;
+    if (v < st.min_limit || v > st.max_limit){
+        char buf[96];
+        snprintf(buf, sizeof(buf), "%s %.2f us out of %.0f..%.0f us",
+                 st.name, v, st.min_limit, st.max_limit);
+        violation(cycle, buf);
+    }
+}
+
+void OneWireBus::set_pull(bool low)
+{
+    if (dev_low_ != low){
+        dev_low_ = low;
+        if (!low && !mcu_low_){
+            start_rise(sim_cycles);
+        }
+        sim_pins_changed();
+    }
+}
+
+// bus released - pull-up charges cable
+void OneWireBus::start_rise(uint64_t cycle)
+{
+    if (rise_us > 0 && cycle >= rise_from){
+        rc_low_ = true;
+        rc_end_ = cycle + cycles(rise_us);
+    }
+}
+
+// falling edge driven by MCU - slaves transmit or start listening
+void OneWireBus::slot_begin(uint64_t cycle)
+{
+    bool tx0 = false;
+
+    tx_bit_ = -1;
+    listeners_.clear();
+    for (OneWireSlave *s : slaves_){
+        int b = s->ow_slot(cycle);
+        if (b < 0){
+            listeners_.push_back(s);
+        } else {
+            tx_bit_ = tx_bit_ == 0 || b == 0 ? 0 : 1;
+            tx0 = tx0 || b == 0;
+        }
+    }
+    if (tx0){
+        set_pull(true);
+        hold_end_ = cycle + cycles(SLAVE_HOLD);
+    }
+    if (!listeners_.empty()){
+        sample_at_ = cycle + cycles(SLAVE_SAMPLE);
+    }
+}
+
+void OneWireBus::slaves_sample(uint64_t cycle)
+{
+    int bit = bus_high() ? 1 : 0;
+
+    sample_at_ = UINT64_MAX;
+    for (OneWireSlave *s : listeners_){
+        s->ow_write(cycle, bit);
+    }
+    listeners_.clear();
+}
+
+void OneWireBus::on_pins(uint64_t cycle, uint16_t porta, uint16_t portb)
+{
+    (void)porta; (void)portb;
+    bool low = (sim_port_mcu_low(port_) & mask_) != 0;
+
+    if (low == mcu_low_){
+        return;
+    }
+    mcu_low_ = low;
+    if (low){
+        // falling edge driven by MCU
+        finish_read();
+        if (rc_low_){
+            violation(cycle, "slot started before bus rose (rise time)");
+        }
+        if (phase_ == RESET_HIGH){
+            check(reset_high_, us(cycle - rise_), cycle);
+        } else if (phase_ == SLOT && rise_valid_){
+            check(rec_, us(cycle - rise_), cycle);
+            check(slot_, us(cycle - fall_), cycle);
+        }
+        fall_ = cycle;
+        sampled_ = false;
+        rise_valid_ = false;
+        presence_at_ = presence_end_ = UINT64_MAX;
+        hold_end_ = UINT64_MAX;
+        set_pull(false);
+        rc_low_ = false;
+        rc_end_ = UINT64_MAX;
+        if (sample_at_ != UINT64_MAX){
+            // previous slot shorter than slave sampling time
+            slaves_sample(cycle);
+        }
+        slot_begin(cycle);
+        return;
+    }
+
+    // release by MCU
+    double w = us(cycle - fall_);
+    if (!dev_low_){
+        start_rise(cycle);
+    }
+    rise_ = cycle;
+    rise_valid_ = true;
+    sampled_ = false;
+    if (w > LOW0_MAX){
+        bool present = false;
+        check(reset_low_, w, cycle);
+        phase_ = RESET_HIGH;
+        // slot started by this falling edge is void
+        tx_bit_ = -1;
+        sample_at_ = hold_end_ = UINT64_MAX;
+        listeners_.clear();
+        set_pull(false);
+        for (OneWireSlave *s : slaves_){
+            present = s->ow_reset(cycle) || present;
+        }
+        if (present){
+            presence_at_ = cycle + cycles(PDHIGH);
+        }
+    } else {
+        // pulses between 15 and 60 us belong to nearer class (violation)
+        check(w <= (LOW1_MAX + LOW0_MIN) / 2 ? low1_ : low0_, w, cycle);
+        phase_ = SLOT;
+    }
+}
+
+uint16_t OneWireBus::pull_low(int port)
+{
+    return port == port_ && (dev_low_ || rc_low_) ? mask_ : 0;
+}
+
+void OneWireBus::on_port_read(uint64_t cycle, int port)
+{
+    if (port != port_ || mcu_low_ || sampled_ || !rise_valid_){
+        return;
+    }
+    if (phase_ == RESET_HIGH){
+        sampled_ = true;
+        check(presence_, us(cycle - rise_), cycle);
+    } else if (phase_ == SLOT && us(rise_ - fall_) <= LOW1_MAX &&
+               us(cycle - fall_) < SLOT_MIN){
+        // master polling the bus decides by last read within RDV,
+        // first read after RDV is late sample
+        if (us(cycle - fall_) > RDV && read_at_ != UINT64_MAX){
+            finish_read();
+            return;
+        }
+        read_at_ = cycle;
+        read_level_ = bus_high() ? 1 : 0;
+        if (us(cycle - fall_) > RDV){
+            finish_read();
+        }
+    }
+}
+
+void OneWireBus::finish_read()
+{
+    if (read_at_ == UINT64_MAX){
+        return;
+    }
+    sampled_ = true;
+    check(sample_, us(read_at_ - fall_), read_at_);
+    if (tx_bit_ >= 0 && read_level_ != tx_bit_){
+        violation(read_at_, tx_bit_ ? "read slot sampled 0, slave sent 1"
+                                    : "read slot sampled 1, slave sent 0");
+    }
+    read_at_ = UINT64_MAX;
+}
+
+uint64_t OneWireBus::next_event()
+{
+    uint64_t next = presence_at_;
+    if (presence_end_ < next) next = presence_end_;
+    if (hold_end_ < next) next = hold_end_;
+    if (sample_at_ < next) next = sample_at_;
+    if (rc_end_ < next) next = rc_end_;
+    return next;
+}
+
+void OneWireBus::on_event(uint64_t cycle)
+{
+    if (cycle >= presence_at_){
+        presence_at_ = UINT64_MAX;
+        presence_end_ = cycle + cycles(PDLOW);
+        set_pull(true);
+    } else if (cycle >= presence_end_){
+        presence_end_ = UINT64_MAX;
+        set_pull(false);
+    }
+    if (cycle >= sample_at_){
+        slaves_sample(cycle);
+    }
+    if (cycle >= hold_end_){
+        hold_end_ = UINT64_MAX;
+        set_pull(false);
+    }
+    if (cycle >= rc_end_){
+        rc_low_ = false;
+        rc_end_ = UINT64_MAX;
+        sim_pins_changed();
+    }
+}
+
+unsigned OneWireBus::report() const
+{
+    const Stat *stats[] = { &reset_low_, &reset_high_, &presence_, &low1_,
+                            &low0_, &sample_, &slot_, &rec_ };
+    const char *l = label.c_str();
+    fprintf(stderr, "%s: %-18s %8s %9s %9s  limits [us]\n",
+            l, "", "count", "min", "max");
+    for (const Stat *st : stats){
+        if (st->count == 0){
+            continue;
+        }
+        fprintf(stderr, "%s: %-18s %8llu %9.2f %9.2f  %.0f..",
+                l, st->name, (unsigned long long)st->count, st->min, st->max,
+                st->min_limit);
+        if (st->max_limit < 1e9){
+            fprintf(stderr, "%.0f", st->max_limit);
+        }
+        fputc('\n', stderr);
+    }
+    for (const std::string &s : log_){
+        fprintf(stderr, "%s: VIOLATION %s\n", label.c_str(), s.c_str());
+    }
+    fprintf(stderr, "%s: %u timing violations\n", label.c_str(), violations_);
+    return violations_;
+}
@@ -0,0 +1,157 @@
+/**
+  @File Name
+    sim/onewire.h
+
+  @Summary
+    1-wire bus model with timing monitor for host simulator.
+
+  @Description
+    Watches one open-drain pin, classifies every low pulse driven by
+    firmware (reset, write 0, write 1/read slot) and checks it against
+    DS18B20 datasheet timing. Sampling of the pin (PORTx read) is
+    checked too: presence pulse must be sampled 60..75 us after release
+    of reset, read slot within 15 us from its falling edge and the
+    sampled level must match the bit transmitted by slaves. When master
+    polls the bus in read slot, last read within 15 us is its sample.
+
+    Slaves (OneWireSlave, for example DS18B20 in ds18b20.h) see the bus
+    the way real devices do:
+    - reset pulse (low > 120 us) - ow_reset(), presence pulse 30 us
+      after release for 120 us when any slave answers
+    - falling edge of time slot - ow_slot(); transmitting slave with
+      bit 0 holds bus low for 30 us (wired-AND of all slaves)
+    - listening slaves sample bus 30 us after falling edge - ow_write()
+    So write slot with low time in 15..60 us is received as random bit
+    by real device - monitor flags it and model receives what it samples.
+
+    Cable capacitance is modelled by rise_us: after release (by MCU or
+    slave) bus reads low for rise_us more. Slot started before bus rose
+    is a violation (slaves may miss falling edge), read slot sampled
+    too early reads 0 instead of transmitted 1.
+
+    Bus without slaves reads as 1 and has no presence pulse (firmware
+    reports missing sensor).
+
+    All times are in microseconds, converted with current sim_fcy, so
+    checks hold for any simulated clock.
+*/
+
+#ifndef SIM_ONEWIRE_H
+#define SIM_ONEWIRE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+
+// device on 1-wire bus, driven by OneWireBus
+class OneWireSlave {
+public:
+    virtual ~OneWireSlave() {}
+    // end of reset pulse, returns true to answer with presence pulse
+    virtual bool ow_reset(uint64_t cycle) = 0;
+    // falling edge of time slot, returns transmitted bit (0 holds bus
+    // low), or -1 when slave listens
+    virtual int ow_slot(uint64_t cycle) = 0;
+    // bus level sampled by listening slave
+    virtual void ow_write(uint64_t cycle, int bit) = 0;
+};
+
+class OneWireBus : public SimDevice {
+public:
+    // DS18B20 timing limits [us]
+    static constexpr double RSTL_MIN = 480;   // reset low
+    static constexpr double RSTH_MIN = 480;   // after reset release
+    static constexpr double LOW1_MIN = 1;     // write 1 / read low
+    static constexpr double LOW1_MAX = 15;
+    static constexpr double LOW0_MIN = 60;    // write 0 low
+    static constexpr double LOW0_MAX = 120;
+    static constexpr double SLOT_MIN = 60;    // time slot
+    static constexpr double REC_MIN = 1;      // recovery between slots
+    static constexpr double RDV = 15;         // read data valid
+    static constexpr double PDHIGH = 30;      // presence wait (15..60)
+    static constexpr double PDLOW = 120;      // presence pulse (60..240)
+    static constexpr double PRESENCE_MIN = 60; // sample window (all devices)
+    static constexpr double PRESENCE_MAX = 75;
+    // behaviour of modelled slaves [us]
+    static constexpr double SLAVE_SAMPLE = 30; // write slot sample (15..60)
+    static constexpr double SLAVE_HOLD = 30;   // transmitted 0 held low
+
+    // statistics of one kind of pulse/interval
+    struct Stat {
+        const char *name;
+        double min_limit, max_limit;
+        uint64_t count = 0;
+        double min = 0, max = 0;
+        Stat(const char *n, double lo, double hi)
+            : name(n), min_limit(lo), max_limit(hi) {}
+    };
+
+    OneWireBus(int port, int pin);
+
+    // prefix of report lines
+    std::string label = "onewire";
+    // rise time after release [us], applies from cycle rise_from
+    double rise_us = 0;
+    uint64_t rise_from = 0;
+
+    void attach(OneWireSlave *slave) { slaves_.push_back(slave); }
+    // prints statistics and violations to stderr, returns number of violations
+    unsigned report() const;
+    unsigned violations() const { return violations_; }
+
+    void on_pins(uint64_t cycle, uint16_t porta, uint16_t portb) override;
+    uint16_t pull_low(int port) override;
+    void on_port_read(uint64_t cycle, int port) override;
+    uint64_t next_event() override;
+    void on_event(uint64_t cycle) override;
+
+private:
+    enum Phase { IDLE, SLOT, RESET_HIGH };
+
+    int port_;
+    uint16_t mask_;
+    std::vector<OneWireSlave *> slaves_;
+    std::vector<OneWireSlave *> listeners_; // in current slot
+    bool mcu_low_ = false;
+    bool dev_low_ = false;
+    Phase phase_ = IDLE;
+    uint64_t fall_ = 0;        // last falling edge driven by MCU
+    uint64_t rise_ = 0;        // last release by MCU
+    bool rise_valid_ = false;
+    bool sampled_ = false;     // slot/presence already sampled
+    uint64_t presence_at_ = UINT64_MAX;
+    uint64_t presence_end_ = UINT64_MAX;
+    int tx_bit_ = -1;          // bit transmitted by slaves in current slot
+    uint64_t hold_end_ = UINT64_MAX;   // end of transmitted 0
+    uint64_t sample_at_ = UINT64_MAX;  // listening slaves sample bus
+    bool rc_low_ = false;      // released, still rising
+    uint64_t read_at_ = UINT64_MAX; // last read of slot within RDV
+    int read_level_ = 0;
+    uint64_t rc_end_ = UINT64_MAX;
+    unsigned violations_ = 0;
+    std::vector<std::string> log_;
+
+    Stat reset_low_{"reset low", RSTL_MIN, 1e9};
+    Stat reset_high_{"reset high", RSTH_MIN, 1e9};
+    Stat presence_{"presence sample", PRESENCE_MIN, PRESENCE_MAX};
+    Stat low1_{"write 1/read low", LOW1_MIN, LOW1_MAX};
+    Stat low0_{"write 0 low", LOW0_MIN, LOW0_MAX};
+    Stat sample_{"read sample", 0, RDV};
+    Stat slot_{"slot", SLOT_MIN, 1e9};
+    Stat rec_{"recovery", REC_MIN, 1e9};
+
+    double us(uint64_t cycles) const;
+    uint64_t cycles(double us) const;
+    void check(Stat &st, double v, uint64_t cycle);
+    void violation(uint64_t cycle, const char *what);
+    void set_pull(bool low);
+    void start_rise(uint64_t cycle);
+    void finish_read();
+    void slot_begin(uint64_t cycle);
+    void slaves_sample(uint64_t cycle);
+    bool bus_high() const { return !mcu_low_ && !dev_low_ && !rc_low_; }
+};
+
+#endif /* SIM_ONEWIRE_H */
@@ -0,0 +1,48 @@
+/**
+  @File Name
+    sim/recorder.cpp
+
+  @Summary
+    Records pin transitions and SPI bytes as text trace - see recorder.h
+*/
+
+#include "recorder.h"
+
+TraceRecorder::TraceRecorder(FILE *f, double from_s, double to_s)
+    : f_(f), from_((uint64_t)(from_s * sim_fcy)), to_((uint64_t)(to_s * sim_fcy))
+{
+    fprintf(f_, "# sim trace fcy=%u from=%.6f to=%.6f\n", sim_fcy, from_s, to_s);
+}
+
+void TraceRecorder::on_pins(uint64_t cycle, uint16_t porta, uint16_t portb)
+{
+    uint16_t now[2] = { porta, portb };
+
+    if (!have_last_){
+        // levels after reset are initial state, not transitions
+        last_[0] = porta;
+        last_[1] = portb;
+        have_last_ = true;
+    }
+    for (int p = 0; p < 2; p++){
+        uint16_t changed = (uint16_t)(now[p] ^ last_[p]);
+        last_[p] = now[p];
+        if (!active(cycle)){
+            continue;
+        }
+        for (int pin = 0; pin < 16; pin++){
+            if (changed & (1U << pin)){
+                fprintf(f_, "%.2f %c%d %d\n", sim_cycles_to_us(cycle), 'A' + p,
+                        pin, (now[p] >> pin) & 1);
+            }
+        }
+    }
+}
+
+uint8_t TraceRecorder::on_spi(uint64_t cycle, uint8_t mosi)
+{
+    if (active(cycle)){
+        fprintf(f_, "%.2f SPI %02X\n", sim_cycles_to_us(cycle), mosi);
+    }
+    return 0;
+}
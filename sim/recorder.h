@@ -0,0 +1,44 @@
+/**
+  @File Name
+    sim/recorder.h
+
+  @Summary
+    Records timestamped pin transitions and SPI bytes as text trace.
+
+  @Description
+    One event per line, time in microseconds since reset:
+
+        # sim trace fcy=4000000 from=0.000000 to=0.120000
+        1234.50 B9 1        pin RB9 changed to 1
+        1240.25 SPI 80      byte shifted out of SPI1
+
+    Only events within [from, to) seconds are written. Traces of
+    scenarios are compared with golden ones by trace-diff (see
+    golden/scenarios and make host-test).
+*/
+
+#ifndef SIM_RECORDER_H
+#define SIM_RECORDER_H
+
+#include <stdint.h>
+#include <cstdio>
+
+#include "sim.h"
+
+class TraceRecorder : public SimDevice {
+public:
+    TraceRecorder(FILE *f, double from_s, double to_s);
+
+    void on_pins(uint64_t cycle, uint16_t porta, uint16_t portb) override;
+    uint8_t on_spi(uint64_t cycle, uint8_t mosi) override;
+
+private:
+    FILE *f_;
+    uint64_t from_, to_;
+    uint16_t last_[2] = { 0, 0 };
+    bool have_last_ = false;
+
+    bool active(uint64_t cycle) const { return cycle >= from_ && cycle < to_; }
+};
+
+#endif /* SIM_RECORDER_H */
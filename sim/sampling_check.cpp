@@ -0,0 +1,214 @@
+/**
+  @File Name
+    sim/sampling_check.cpp
+
+  @Summary
+    Host check of adaptive sampling policy (common/sampling.h).
+
+  @Description
+    Usage: sampling-check [-n readings] [-s seed]
+
+    Runs ../common/sampling.c with configuration of pic24fj-temp.X (4
+    levels, normal 1, 0.5 C fast change, 0.25 C stable, 5 stable
+    readings, thresholds 0 C and 30 C):
+    - table of readings with expected reason and level of each: first
+      reading, slowing down level by level to the slowest one, moderate
+      change back to normal, 0.5 C step up and down to level 0, ramp
+      across 30 C and 0 C both ways, reading equal to threshold
+    - random walk (small drift, moderate and fast steps, jumps over the
+      thresholds) against rules of sampling.h: reason follows from
+      change and thresholds, level from reason and previous level,
+      slowing down only after stable_count stable readings in row
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "check.h"
+#include "sampling.h"
+
+// sample_config of pic24fj-temp.X/main.c (1/16 C)
+static const sampling_config_t CONFIG = {
+    8, 4, 5, 4, 1, 2, { 0 * 16, 30 * 16 }
+};
+
+struct Step {
+    int16_t value;
+    sampling_reason_t reason;
+    uint8_t level;
+};
+
+#define C(t) ((int16_t)((t) * 16))
+
+static const Step TABLE[] = {
+    { C(21.5),    SAMPLING_FIRST,     1 },
+    // stable (|change| <= 0.25 C): 5 in row slow down one level
+    { C(21.5625), SAMPLING_HOLD,      1 },
+    { C(21.5),    SAMPLING_HOLD,      1 },
+    { C(21.75),   SAMPLING_HOLD,      1 },
+    { C(21.5),    SAMPLING_HOLD,      1 },
+    { C(21.5),    SAMPLING_STABLE,    2 },
+    { C(21.5),    SAMPLING_HOLD,      2 },
+    { C(21.5),    SAMPLING_HOLD,      2 },
+    { C(21.5),    SAMPLING_HOLD,      2 },
+    { C(21.5),    SAMPLING_HOLD,      2 },
+    { C(21.5),    SAMPLING_STABLE,    3 },
+    // slowest level stays
+    { C(21.5),    SAMPLING_HOLD,      3 },
+    { C(21.5),    SAMPLING_HOLD,      3 },
+    { C(21.5),    SAMPLING_HOLD,      3 },
+    { C(21.5),    SAMPLING_HOLD,      3 },
+    { C(21.5),    SAMPLING_HOLD,      3 },
+    // moderate change (0.3125 C) back to normal, then holds there and
+    // restarts stable count
+    { C(21.8125), SAMPLING_MOVING,    1 },
+    { C(22.125),  SAMPLING_HOLD,      1 },
+    { C(22.125),  SAMPLING_HOLD,      1 },
+    { C(22.125),  SAMPLING_HOLD,      1 },
+    { C(22.125),  SAMPLING_HOLD,      1 },
+    { C(22.125),  SAMPLING_HOLD,      1 },
+    { C(22.125),  SAMPLING_STABLE,    2 },
+    // 0.5 C step up and down - fastest level
+    { C(22.625),  SAMPLING_CHANGE,    0 },
+    { C(22.625),  SAMPLING_HOLD,      0 },
+    { C(22.125),  SAMPLING_CHANGE,    0 },
+    // moderate change at faster level than normal keeps it
+    { C(22.4375), SAMPLING_HOLD,      0 },
+    { C(22.4375), SAMPLING_HOLD,      0 },
+    { C(22.4375), SAMPLING_HOLD,      0 },
+    { C(22.4375), SAMPLING_HOLD,      0 },
+    { C(22.4375), SAMPLING_HOLD,      0 },
+    { C(22.4375), SAMPLING_STABLE,    1 },
+    // ramp across 30 C by 0.4375 C (moderate) - threshold wins
+    { C(29.5),    SAMPLING_CHANGE,    0 },
+    { C(29.5),    SAMPLING_HOLD,      0 },
+    { C(29.5),    SAMPLING_HOLD,      0 },
+    { C(29.5),    SAMPLING_HOLD,      0 },
+    { C(29.5),    SAMPLING_HOLD,      0 },
+    { C(29.5),    SAMPLING_STABLE,    1 },
+    { C(29.9375), SAMPLING_HOLD,      1 },
+    { C(30.375),  SAMPLING_THRESHOLD, 0 },
+    // reaching threshold from below crosses it, staying on it does not
+    { C(29.9375), SAMPLING_THRESHOLD, 0 },
+    { C(30),      SAMPLING_THRESHOLD, 0 },
+    { C(30),      SAMPLING_HOLD,      0 },
+    // fall from 30 C crosses it again, then small steps across 0 C
+    { C(0.125),   SAMPLING_THRESHOLD, 0 },
+    { C(-0.0625), SAMPLING_THRESHOLD, 0 },
+    { C(-0.0625), SAMPLING_HOLD,      0 },
+    { C(0),       SAMPLING_THRESHOLD, 0 },
+};
+
+// runs TABLE, every step must give its reason and level
+static void check_table(void)
+{
+    sampling_t s;
+    size_t i;
+
+    sampling_init(&s, &CONFIG);
+    if (s.level != CONFIG.normal){
+        fail("level %u after init", s.level);
+    }
+    for (i = 0; i < sizeof(TABLE) / sizeof(TABLE[0]); i++){
+        const Step &t = TABLE[i];
+        sampling_reason_t r = sampling_update(&s, t.value);
+        if (r != t.reason || s.level != t.level){
+            fail("table %zu (%.4f C): %s level %u, expected %s level %u", i,
+                 t.value / 16.0, sampling_reason_name(r), s.level,
+                 sampling_reason_name(t.reason), t.level);
+        }
+    }
+}
+
+static bool crossed(int16_t a, int16_t b)
+{
+    for (uint8_t i = 0; i < CONFIG.thresholds; i++){
+        int16_t th = CONFIG.threshold[i];
+        if ((a < th) != (b < th)){
+            return true;
+        }
+    }
+    return false;
+}
+
+// random walk against rules of sampling.h, returns level histogram
+static void check_walk(unsigned n, unsigned *levels)
+{
+    sampling_t s;
+    int16_t value = C(20);
+    unsigned stable = 0;
+    uint8_t prev;
+
+    sampling_init(&s, &CONFIG);
+    sampling_update(&s, value);
+    for (unsigned k = 0; k < n; k++){
+        int16_t last = value;
+        unsigned kind = rnd(100);
+        if (kind < 80){
+            value = (int16_t)(value + (int)rnd(9) - 4);           // stable
+        } else if (kind < 90){
+            value = (int16_t)(value + ((int)rnd(3) + 5) * (rnd(2) ? 1 : -1));
+        } else if (kind < 98){
+            value = (int16_t)(value + ((int)rnd(64) + 8) * (rnd(2) ? 1 : -1));
+        } else {
+            value = (int16_t)((int)rnd(60 * 16) - 15 * 16);       // -15..45 C
+        }
+        prev = s.level;
+        sampling_reason_t r = sampling_update(&s, value);
+        int d = abs(value - last);
+        sampling_reason_t want;
+        uint8_t level = prev;
+
+        if (crossed(last, value)){
+            want = SAMPLING_THRESHOLD;
+            level = 0;
+        } else if (d >= CONFIG.fast_delta){
+            want = SAMPLING_CHANGE;
+            level = 0;
+        } else if (d > CONFIG.stable_delta){
+            want = prev > CONFIG.normal ? SAMPLING_MOVING : SAMPLING_HOLD;
+            level = prev > CONFIG.normal ? CONFIG.normal : prev;
+        } else if (++stable >= CONFIG.stable_count && prev + 1 < CONFIG.levels){
+            want = SAMPLING_STABLE;
+            level = (uint8_t)(prev + 1);
+        } else {
+            want = SAMPLING_HOLD;
+        }
+        if (want != SAMPLING_HOLD || d > CONFIG.stable_delta){
+            stable = 0;
+        }
+        if (r != want || s.level != level || s.delta != value - last){
+            fail("reading %u (%.4f -> %.4f C, level %u): %s level %u, expected %s level %u",
+                 k, last / 16.0, value / 16.0, prev, sampling_reason_name(r), s.level,
+                 sampling_reason_name(want), level);
+        }
+        levels[s.level]++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned n = 100000, seed = 1;
+    unsigned levels[4] = { 0 };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1){
+        switch (opt){
+            case 'n': n = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n readings] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    check_init("sampling", seed);
+    check_table();
+    check_walk(n, levels);
+    fprintf(stderr, "sampling: %zu table steps, %u random readings, levels 0..3: %u %u %u %u\n",
+            sizeof(TABLE) / sizeof(TABLE[0]), n, levels[0], levels[1], levels[2], levels[3]);
+    fprintf(stderr, "sampling: %u failures\n", failures);
+    return failures ? 1 : 0;
+}
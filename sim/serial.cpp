@@ -0,0 +1,74 @@
+/**
+  @File Name
+    sim/serial.cpp
+
+  @Summary
+    Raw serial ports and pseudo-terminals. See serial.h for details.
+*/
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "serial.h"
+
+static speed_t baud_constant(unsigned baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        default: return B0;
+    }
+}
+
+static int set_raw(int fd, unsigned baud)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) < 0) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    speed_t speed = baud_constant(baud);
+    if (speed != B0) {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+int serial_open(const char *path, unsigned baud)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (set_raw(fd, baud) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int serial_open_pty(std::string &slave)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (grantpt(fd) < 0 || unlockpt(fd) < 0 || set_raw(fd, 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    slave = ptsname(fd);
+    return fd;
+}
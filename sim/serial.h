@@ -0,0 +1,29 @@
+/**
+  @File Name
+    sim/serial.h
+
+  @Summary
+    Raw serial ports and pseudo-terminals of host tools.
+
+  @Description
+    serial_open() opens tty (USB-serial adapter, pseudo-terminal) in
+    raw 8N1 mode - no echo, no line editing, every byte passes.
+    serial_open_pty() creates pseudo-terminal for two programs that
+    talk as over serial line (simulator with -o uart=pty and a master
+    tool, loopback tests): caller keeps master side, the other program
+    opens slave side by its path.
+*/
+
+#ifndef SIM_SERIAL_H
+#define SIM_SERIAL_H
+
+#include <string>
+
+// opens serial port or pseudo-terminal in raw 8N1 mode, returns file
+// descriptor or -1 (errno set)
+int serial_open(const char *path, unsigned baud);
+// creates pseudo-terminal in raw mode, returns its master side or -1
+// (errno set), 'slave' gets path of the other side
+int serial_open_pty(std::string &slave);
+
+#endif /* SIM_SERIAL_H */
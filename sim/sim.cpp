@@ -0,0 +1,1382 @@
+/**
+  @File Name
+    sim/sim.cpp
+
+  @Summary
+    Minimal PIC24FJ64GB002 simulator core. See sim.h for details.
+*/
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <dlfcn.h>
+
+#include <xc.h>
+#include "sim.h"
+
+// interrupt handlers provided by firmware (if any)
+extern "C" {
+void _T1Interrupt(void) __attribute__((weak));
+void _T2Interrupt(void) __attribute__((weak));
+void _T3Interrupt(void) __attribute__((weak));
+void _T4Interrupt(void) __attribute__((weak));
+void _SPI1Interrupt(void) __attribute__((weak));
+void _U1RXInterrupt(void) __attribute__((weak));
+void _U1TXInterrupt(void) __attribute__((weak));
+// task dispatcher of sched.c - its callees are roots of call depth
+void sched_run_once(void) __attribute__((weak));
+
+uint64_t sim_cycles = 0;
+uint32_t sim_fcy = 4000000UL;
+uint32_t sim_isr_entry_cycles = 20;
+uint32_t sim_isr_exit_cycles = 10;
+uint32_t sim_call_cycles = 0;
+uint32_t sim_wdt_period_us = 128000;
+uint64_t sim_hang_at = UINT64_MAX;
+}
+
+static const uint64_t NEVER = UINT64_MAX;
+
+// written by firmware through pointer returned from sim_sfr()
+static volatile uint16_t regs[SFR_COUNT];
+// value handed out by last sim_sfr() - to detect writes
+static uint16_t pending_snap;
+static int pending_id = -1;
+
+static uint64_t limit = NEVER;
+static jmp_buf stop_jmp;
+static bool running = false;
+static bool reset_req = false;  // sim_run() stopped by reset
+static int isr_depth = 0;
+static uint64_t wdt_deadline = UINT64_MAX;
+static bool gie = true;
+static uint64_t disi_until = 0;
+static std::vector<SimDevice *> devices;
+static uint16_t levels[2] = { 0xFFFF, 0xFFFF };
+// pins driven low by MCU itself (without devices)
+static uint16_t mcu_low[2] = { 0, 0 };
+static bool in_pins_update = false;
+
+// 16-bit timers TMR1, TMR4 (TMR4 not chained with TMR5)
+struct Timer16 {
+    sim_sfr_id_t tmr, pr, con;
+    sim_sfr_id_t ifs; int ifbit;
+    uint64_t zero;      // cycle when TMRx was last 0
+    uint64_t next;      // next PRx match (rollover)
+    uint16_t frozen;    // TMRx value when stopped
+};
+static Timer16 t1 = { SFR_TMR1, SFR_PR1, SFR_T1CON, SFR_IFS0, 3, 0, NEVER, 0 };
+static Timer16 t4 = { SFR_TMR4, SFR_PR4, SFR_T4CON, SFR_IFS1, 11, 0, NEVER, 0 };
+// TMR2/3
+static uint64_t t23_zero = 0;
+static uint64_t t23_next = NEVER;
+static uint32_t t23_frozen = 0;
+// SPI1
+static std::deque<uint16_t> spi_tx, spi_rx;
+static bool spi_shifting = false;
+static uint16_t spi_shift = 0;
+static uint64_t spi_done = NEVER;
+static bool spi_rov = false;
+// UART1
+static std::deque<uint16_t> u1_tx, u1_rx;
+static bool u1_shifting = false;
+static uint16_t u1_shift = 0;
+static uint64_t u1_done = NEVER;
+static bool u1_oerr = false;
+static std::deque<std::pair<uint64_t, uint8_t> > u1_inject;
+// U1TX output function of RPORx, U1TX/U1RX pins (RB2/RP2, RB3/RP3)
+static const unsigned PPS_U1TX = 3, PPS_U1TX_RP = 2, PPS_U1RX_RP = 3;
+// writes to PPS registers ignored because IOLOCK was set
+static unsigned pps_violations = 0;
+// flash (program memory, 24-bit words at even addresses) and RTSP
+static std::vector<uint32_t> flash(SIM_FLASH_END / 2, SIM_FLASH_ERASED);
+static std::vector<uint32_t> flash_erases(SIM_FLASH_END / SIM_FLASH_PAGE);
+static uint32_t flash_latch[SIM_FLASH_ROW / 2];
+static uint32_t flash_latch_addr = 0;
+static uint64_t flash_rows = 0, flash_words = 0, flash_stall = 0;
+// erase/write operations done, operations left until power cut (-1 none)
+static uint64_t flash_ops = 0;
+static int64_t flash_cut = -1;
+static unsigned flash_violations = 0;
+static std::vector<std::string> flash_log;
+static bool nvm_stall = false;  // CPU stalled by erase/write
+
+// read sentinels - value in register is replaced by firmware on write
+#define SPI_READ_SENTINEL 0xA500
+#define U1TX_SENTINEL     0xFFFF
+
+static void advance(uint64_t n);
+static void do_stop(void);
+
+/*
+ * Helpers
+ */
+static inline uint16_t reg(sim_sfr_id_t id) { return regs[id]; }
+static inline bool bit(sim_sfr_id_t id, int b) { return (regs[id] >> b) & 1; }
+static inline void set_bit(sim_sfr_id_t id, int b, bool v)
+{
+    if (v) regs[id] |= (uint16_t)(1U << b);
+    else regs[id] &= (uint16_t)~(1U << b);
+}
+
+static const unsigned TMR_PRESCALE[4] = { 1, 8, 64, 256 };
+
+static uint32_t t16_prescale(const Timer16 &t) { return TMR_PRESCALE[(reg(t.con) >> 4) & 3]; }
+static uint32_t t23_prescale(void) { return TMR_PRESCALE[(reg(SFR_T2CON) >> 4) & 3]; }
+static bool t23_is32(void) { return bit(SFR_T2CON, 3); }
+static uint64_t t23_period(void)
+{
+    if (t23_is32()){
+        return ((uint64_t)reg(SFR_PR3) << 16 | reg(SFR_PR2)) + 1;
+    }
+    return (uint64_t)reg(SFR_PR2) + 1;
+}
+
+static unsigned spi_depth(void) { return (reg(SFR_SPI1CON2) & 1) ? 8 : 1; }
+static uint64_t spi_byte_cycles(void)
+{
+    static const unsigned PPRE[4] = { 64, 16, 4, 1 };
+    uint16_t c1 = reg(SFR_SPI1CON1);
+    unsigned ppre = PPRE[c1 & 3];
+    unsigned spre = 8 - ((c1 >> 2) & 7);
+    unsigned bits = (c1 & (1U << 10)) ? 16 : 8;
+    return (uint64_t)bits * ppre * spre;
+}
+
+static uint64_t u1_frame_cycles(void)
+{
+    uint64_t bitc = (bit(SFR_U1MODE, 3) ? 4 : 16) * ((uint64_t)reg(SFR_U1BRG) + 1);
+    unsigned bits = 1 + 8 + (((reg(SFR_U1MODE) >> 1) & 3) ? 1 : 0) +
+                    (bit(SFR_U1MODE, 0) ? 2 : 1);
+    return bits * bitc;
+}
+
+/*
+ * GPIO
+ */
+static void update_pins(void)
+{
+    static const sim_sfr_id_t LAT[2] = { SFR_LATA, SFR_LATB };
+    static const sim_sfr_id_t TRIS[2] = { SFR_TRISA, SFR_TRISB };
+    static const sim_sfr_id_t ODC[2] = { SFR_ODCA, SFR_ODCB };
+    bool changed;
+
+    if (in_pins_update){
+        return;
+    }
+    in_pins_update = true;
+    do {
+        changed = false;
+        for (int p = 0; p < 2; p++){
+            uint16_t out = (uint16_t)~reg(TRIS[p]);
+            uint16_t lat = reg(LAT[p]);
+            uint16_t drive_low = out & (uint16_t)~lat;
+            if (drive_low != mcu_low[p]){
+                mcu_low[p] = drive_low;
+                changed = true;
+            }
+            uint16_t drive_high = out & lat & (uint16_t)~reg(ODC[p]);
+            uint16_t pulled = 0;
+            for (SimDevice *d : devices){
+                pulled |= d->pull_low(p);
+            }
+            // external pull-up on everything not driven
+            uint16_t lvl = drive_high | ((uint16_t)~drive_low & (uint16_t)~pulled);
+            if (lvl != levels[p]){
+                levels[p] = lvl;
+                changed = true;
+            }
+        }
+        if (changed){
+            for (SimDevice *d : devices){
+                d->on_pins(sim_cycles, levels[0], levels[1]);
+            }
+        }
+    } while (changed);
+    in_pins_update = false;
+}
+
+/*
+ * Timers
+ */
+static uint16_t t16_value(const Timer16 &t)
+{
+    if (!bit(t.con, 15)){
+        return t.frozen;
+    }
+    return (uint16_t)(((sim_cycles - t.zero) / t16_prescale(t)) %
+                      ((uint32_t)reg(t.pr) + 1));
+}
+
+static void t16_restart(Timer16 &t, uint16_t value)
+{
+    if (!bit(t.con, 15)){
+        t.frozen = value;
+        t.next = NEVER;
+        return;
+    }
+    uint64_t ps = t16_prescale(t);
+    uint32_t period = (uint32_t)reg(t.pr) + 1;
+    if (value >= period){
+        value = 0;
+    }
+    t.zero = sim_cycles - (uint64_t)value * ps;
+    t.next = t.zero + (uint64_t)period * ps;
+}
+
+// PRx match: TMRx resets, TxIF is set
+static bool t16_event(Timer16 &t)
+{
+    if (t.next > sim_cycles){
+        return false;
+    }
+    t.zero = t.next;
+    t.next += ((uint64_t)reg(t.pr) + 1) * t16_prescale(t);
+    set_bit(t.ifs, t.ifbit, true);
+    return true;
+}
+
+// TxCON written, 'old' is its previous value
+static void t16_control(Timer16 &t, uint16_t old)
+{
+    bool was_on = (old >> 15) & 1;
+    uint16_t now_v = was_on ? (uint16_t)(((sim_cycles - t.zero) /
+        TMR_PRESCALE[(old >> 4) & 3]) % ((uint32_t)reg(t.pr) + 1)) : t.frozen;
+    if (!bit(t.con, 15)){
+        t.frozen = now_v;
+        t.next = NEVER;
+    } else {
+        t16_restart(t, now_v);
+    }
+}
+
+static uint32_t t23_value(void)
+{
+    if (!bit(SFR_T2CON, 15)){
+        return t23_frozen;
+    }
+    return (uint32_t)(((sim_cycles - t23_zero) / t23_prescale()) % t23_period());
+}
+
+static void t23_restart(uint32_t value)
+{
+    if (!bit(SFR_T2CON, 15)){
+        t23_frozen = value;
+        t23_next = NEVER;
+        return;
+    }
+    uint64_t period = t23_period();
+    if (value >= period){
+        value = 0;
+    }
+    t23_zero = sim_cycles - (uint64_t)value * t23_prescale();
+    t23_next = t23_zero + period * t23_prescale();
+}
+
+/*
+ * SPI1
+ */
+static void spi_start_next(void)
+{
+    if (spi_shifting || spi_tx.empty()){
+        return;
+    }
+    spi_shift = spi_tx.front();
+    spi_tx.pop_front();
+    spi_shifting = true;
+    spi_done = sim_cycles + spi_byte_cycles();
+}
+
+static void spi_finish(void)
+{
+    uint8_t miso = 0;
+
+    for (SimDevice *d : devices){
+        miso |= d->on_spi(sim_cycles, (uint8_t)spi_shift);
+    }
+    if (spi_rx.size() < spi_depth()){
+        spi_rx.push_back(miso);
+    } else {
+        spi_rov = true;
+    }
+    spi_shifting = false;
+    spi_done = NEVER;
+    set_bit(SFR_IFS0, 10, true); // SPI1IF
+    spi_start_next();
+}
+
+/*
+ * UART1
+ */
+static void u1_tx_start_next(void)
+{
+    if (u1_shifting || u1_tx.empty()){
+        return;
+    }
+    u1_shift = u1_tx.front();
+    u1_tx.pop_front();
+    u1_shifting = true;
+    u1_done = sim_cycles + u1_frame_cycles();
+    // UTXISEL1:0 = 00 - char transferred to TSR
+    //              10 - transmit buffer becomes empty
+    bool isel1 = bit(SFR_U1STA, 15), isel0 = bit(SFR_U1STA, 13);
+    if ((!isel1 && !isel0) || (isel1 && !isel0 && u1_tx.empty())){
+        set_bit(SFR_IFS0, 12, true); // U1TXIF
+    }
+}
+
+// UART1 pins as mapped by Peripheral Pin Select
+static bool u1_tx_mapped(void)
+{
+    uint16_t rpor = reg((sim_sfr_id_t)(SFR_RPOR0 + PPS_U1TX_RP / 2));
+    return ((PPS_U1TX_RP & 1 ? rpor >> 8 : rpor) & 0x1F) == PPS_U1TX;
+}
+
+static bool u1_rx_mapped(void)
+{
+    return (reg(SFR_RPINR18) & 0x1F) == PPS_U1RX_RP;
+}
+
+static void u1_tx_finish(void)
+{
+    // unmapped U1TX drives no pin - nobody receives the byte
+    for (SimDevice *d : u1_tx_mapped() ? devices : std::vector<SimDevice *>()){
+        d->on_uart_tx(sim_cycles, (uint8_t)u1_shift);
+    }
+    u1_shifting = false;
+    u1_done = NEVER;
+    // UTXISEL1:0 = 01 - last transmission completed
+    if (!bit(SFR_U1STA, 15) && bit(SFR_U1STA, 13) && u1_tx.empty()){
+        set_bit(SFR_IFS0, 12, true);
+    }
+    u1_tx_start_next();
+}
+
+static void u1_rx_arrive(uint8_t byte)
+{
+    if (!bit(SFR_U1MODE, 15) || !u1_rx_mapped()){
+        return;
+    }
+    if (u1_rx.size() >= 4){
+        u1_oerr = true;
+        return;
+    }
+    u1_rx.push_back(byte);
+    // URXISEL: 0x - every char, 10 - 3 chars, 11 - 4 chars
+    unsigned isel = (reg(SFR_U1STA) >> 6) & 3;
+    if (isel < 2 || (isel == 2 && u1_rx.size() >= 3) || u1_rx.size() >= 4){
+        set_bit(SFR_IFS0, 11, true); // U1RXIF
+    }
+}
+
+/*
+ * Interrupt controller
+ */
+struct Irq {
+    sim_sfr_id_t ifs, iec; int bit;
+    sim_sfr_id_t ipc; int shift;
+    void (*handler)(void);
+    const char *name;
+};
+
+// ordered by natural priority (vector number)
+static const Irq IRQS[] = {
+    { SFR_IFS0, SFR_IEC0, 3,  SFR_IPC0, 12, _T1Interrupt,   "T1" },
+    { SFR_IFS0, SFR_IEC0, 7,  SFR_IPC1, 12, _T2Interrupt,   "T2" },
+    { SFR_IFS0, SFR_IEC0, 8,  SFR_IPC2, 0,  _T3Interrupt,   "T3" },
+    { SFR_IFS0, SFR_IEC0, 10, SFR_IPC2, 8,  _SPI1Interrupt, "SPI1" },
+    { SFR_IFS0, SFR_IEC0, 11, SFR_IPC2, 12, _U1RXInterrupt, "U1RX" },
+    { SFR_IFS0, SFR_IEC0, 12, SFR_IPC3, 0,  _U1TXInterrupt, "U1TX" },
+    { SFR_IFS1, SFR_IEC1, 11, SFR_IPC6, 12, _T4Interrupt,   "T4" },
+};
+
+struct IrqStats {
+    uint64_t count, total, min, max;
+};
+static IrqStats irq_stats[sizeof(IRQS) / sizeof(IRQS[0])];
+// inclusive cycles of ISRs nested in currently running one
+static uint64_t isr_inner_cycles = 0;
+
+// call depth (firmware built with -finstrument-functions), see
+// __cyg_profile_func_enter() below
+struct DepthRoot {
+    int base;       // call_top when root was entered
+    const void *fn; // task function, NULL for ISR
+    int irq;        // index to IRQS or -1
+};
+static int call_top = 0;
+#define SIM_CALL_STACK 256
+static const void *call_fn[SIM_CALL_STACK];
+static int call_max = 0;
+static std::vector<DepthRoot> depth_roots;
+static std::map<const void *, int> task_depth; // NULL key = main()
+static int irq_depth[sizeof(IRQS) / sizeof(IRQS[0])];
+
+static unsigned cpu_ipl(void)
+{
+    return ((reg(SFR_SR) >> 5) & 7) | (bit(SFR_CORCON, 3) ? 8 : 0);
+}
+
+static void commit_pending(void);
+
+static void dispatch_interrupts(void)
+{
+    for (;;){
+        const Irq *best = NULL;
+        unsigned best_prio = cpu_ipl();
+        bool disi = disi_until > sim_cycles;
+
+        if (!gie || nvm_stall){
+            return;
+        }
+        for (const Irq &q : IRQS){
+            unsigned prio = (reg(q.ipc) >> q.shift) & 7;
+            if (bit(q.ifs, q.bit) && bit(q.iec, q.bit) && prio > best_prio &&
+                !(disi && prio < 7)){
+                best = &q;
+                best_prio = prio;
+            }
+        }
+        if (!best){
+            return;
+        }
+        if (!best->handler){
+            // real CPU would jump to default interrupt (reset)
+            fprintf(stderr, "sim: no handler for %s interrupt - disabled\n",
+                    best->name);
+            set_bit(best->iec, best->bit, false);
+            continue;
+        }
+        uint16_t saved_sr = reg(SFR_SR);
+        uint64_t start = sim_cycles;
+        uint64_t saved_inner = isr_inner_cycles;
+        isr_inner_cycles = 0;
+        isr_depth++;
+        depth_roots.push_back(DepthRoot{ call_top, NULL, (int)(best - IRQS) });
+        regs[SFR_SR] = (uint16_t)((saved_sr & ~0xE0) | (best_prio << 5));
+        advance(sim_isr_entry_cycles);
+        best->handler();
+        commit_pending();
+        advance(sim_isr_exit_cycles);
+        regs[SFR_SR] = saved_sr; // RETFIE
+        isr_depth--;
+        depth_roots.pop_back();
+
+        // statistics without nested ISRs
+        uint64_t incl = sim_cycles - start;
+        uint64_t excl = incl - isr_inner_cycles;
+        IrqStats &st = irq_stats[best - IRQS];
+        if (st.count == 0 || excl < st.min) st.min = excl;
+        if (excl > st.max) st.max = excl;
+        st.count++;
+        st.total += excl;
+        isr_inner_cycles = saved_inner + incl;
+    }
+}
+
+/*
+ * Event loop
+ */
+static uint64_t next_event(void)
+{
+    uint64_t next = limit;
+    if (t1.next < next) next = t1.next;
+    if (t4.next < next) next = t4.next;
+    if (t23_next < next) next = t23_next;
+    if (spi_done < next) next = spi_done;
+    if (u1_done < next) next = u1_done;
+    if (!u1_inject.empty() && u1_inject.front().first < next){
+        next = u1_inject.front().first;
+    }
+    if (disi_until > sim_cycles && disi_until < next) next = disi_until;
+    if (wdt_deadline < next) next = wdt_deadline;
+    for (SimDevice *d : devices){
+        uint64_t n = d->next_event();
+        if (n < next) next = n;
+    }
+    return next;
+}
+
+static void process_events(void)
+{
+    bool again;
+    do {
+        again = false;
+        if (t16_event(t1)){
+            again = true;
+        }
+        if (t16_event(t4)){
+            again = true;
+        }
+        if (t23_next <= sim_cycles){
+            t23_zero = t23_next;
+            t23_next += t23_period() * t23_prescale();
+            set_bit(SFR_IFS0, t23_is32() ? 8 : 7, true); // T3IF / T2IF
+            again = true;
+        }
+        if (spi_done <= sim_cycles){
+            spi_finish();
+            again = true;
+        }
+        if (u1_done <= sim_cycles){
+            u1_tx_finish();
+            again = true;
+        }
+        if (!u1_inject.empty() && u1_inject.front().first <= sim_cycles){
+            u1_rx_arrive(u1_inject.front().second);
+            u1_inject.pop_front();
+            again = true;
+        }
+        for (SimDevice *d : devices){
+            if (d->next_event() <= sim_cycles){
+                d->on_event(sim_cycles);
+                again = true;
+            }
+        }
+        if (wdt_deadline <= sim_cycles){
+            wdt_deadline = NEVER;
+            set_bit(SFR_RCON, 4, true); // WDTO
+            fprintf(stderr, "sim: watchdog reset at %.3f ms\n",
+                    sim_cycles_to_us(sim_cycles) / 1000.0);
+            reset_req = true;
+            do_stop();
+        }
+    } while (again);
+}
+
+static void do_stop(void)
+{
+    limit = NEVER;
+    if (running){
+        running = false;
+        longjmp(stop_jmp, 1);
+    }
+}
+
+static uint64_t wdt_cycles(void)
+{
+    return (uint64_t)sim_wdt_period_us * sim_fcy / 1000000UL;
+}
+
+// fault injection - main context spins forever, interrupts still run
+static void hang_main(void)
+{
+    sim_hang_at = NEVER;
+    fprintf(stderr, "sim: main context hangs at %.3f ms\n",
+            sim_cycles_to_us(sim_cycles) / 1000.0);
+    for (;;){
+        advance(1000);
+    }
+}
+
+static void advance(uint64_t n)
+{
+    uint64_t remaining = n;
+    if (isr_depth == 0 && sim_cycles >= sim_hang_at){
+        hang_main();
+    }
+    do {
+        uint64_t next = next_event();
+        uint64_t step = 0;
+        if (next > sim_cycles){
+            step = next - sim_cycles;
+            if (step > remaining) step = remaining;
+        }
+        sim_cycles += step;
+        remaining -= step;
+        if (sim_cycles >= limit){
+            do_stop();
+        }
+        process_events();
+        dispatch_interrupts();
+    } while (remaining > 0);
+}
+
+/*
+ * SFR access
+ */
+
+// applies side effects of write done through last returned pointer
+static void commit_pending(void)
+{
+    int id = pending_id;
+    if (id < 0){
+        return;
+    }
+    pending_id = -1;
+    uint16_t v = regs[id];
+    bool written = v != pending_snap;
+
+    if (written && id >= SFR_RPOR0 && id <= SFR_RPINR20 && bit(SFR_OSCCON, 6)){
+        // IOLOCK set - PPS registers keep their value
+        regs[id] = pending_snap;
+        if (pps_violations++ < 10){
+            fprintf(stderr, "sim: VIOLATION PPS register %d written while "
+                    "IOLOCK is set\n", id - SFR_RPOR0);
+        }
+        return;
+    }
+    switch (id){
+        case SFR_LATA: case SFR_LATB: case SFR_TRISA: case SFR_TRISB:
+        case SFR_ODCA: case SFR_ODCB:
+            if (written) update_pins();
+            break;
+        case SFR_PORTA: case SFR_PORTB:
+            if (written){
+                // write to PORT goes to LAT
+                regs[id == SFR_PORTA ? SFR_LATA : SFR_LATB] = v;
+                regs[id] = pending_snap;
+                update_pins();
+            }
+            break;
+        case SFR_TMR1: case SFR_TMR4:
+            if (written) t16_restart(id == SFR_TMR1 ? t1 : t4, v);
+            break;
+        case SFR_PR1: case SFR_PR4: {
+            Timer16 &t = id == SFR_PR1 ? t1 : t4;
+            if (written) t16_restart(t, t16_value(t));
+            break;
+        }
+        case SFR_T1CON: case SFR_T4CON:
+            if (written) t16_control(id == SFR_T1CON ? t1 : t4, pending_snap);
+            break;
+        case SFR_TMR2:
+            if (written){
+                // writing TMR2 transfers TMR3HLD to TMR3 in 32-bit mode
+                uint32_t val = t23_is32() ?
+                    ((uint32_t)reg(SFR_TMR3HLD) << 16 | v) : v;
+                t23_restart(val);
+            }
+            break;
+        case SFR_PR2: case SFR_PR3:
+            if (written) t23_restart(t23_value());
+            break;
+        case SFR_T2CON:
+            if (written){
+                if (!bit(SFR_T2CON, 15)){
+                    t23_frozen = 0;
+                    t23_next = NEVER;
+                } else if (!((pending_snap >> 15) & 1)){
+                    t23_restart(t23_frozen);
+                }
+            }
+            break;
+        case SFR_SPI1BUF:
+            if (v != pending_snap || (v & 0xFF00) != SPI_READ_SENTINEL){
+                // write
+                if (bit(SFR_SPI1STAT, 15) && spi_tx.size() < spi_depth()){
+                    spi_tx.push_back(v);
+                    spi_start_next();
+                }
+            } else if (!spi_rx.empty()){
+                spi_rx.pop_front();
+            }
+            regs[id] = 0;
+            break;
+        case SFR_SPI1STAT:
+            if (written && !bit(SFR_SPI1STAT, 6)){
+                spi_rov = false;
+            }
+            break;
+        case SFR_U1TXREG:
+            if (v != U1TX_SENTINEL && bit(SFR_U1MODE, 15) && bit(SFR_U1STA, 10)){
+                if (u1_tx.size() < 4){
+                    u1_tx.push_back(v & 0x1FF);
+                    u1_tx_start_next();
+                }
+            }
+            regs[id] = 0;
+            break;
+        case SFR_U1RXREG:
+            if (!u1_rx.empty()){
+                u1_rx.pop_front();
+            }
+            break;
+        case SFR_U1STA:
+            if (written){
+                if (!((pending_snap >> 10) & 1) && bit(SFR_U1STA, 10)){
+                    // UTXEN set - TX buffer is empty
+                    set_bit(SFR_IFS0, 12, true);
+                }
+                if (((pending_snap >> 1) & 1) && !bit(SFR_U1STA, 1)){
+                    // OERR cleared - receive buffer is reset
+                    u1_oerr = false;
+                    u1_rx.clear();
+                }
+            }
+            break;
+        case SFR_U1MODE:
+            if (written && !bit(SFR_U1MODE, 15)){
+                u1_tx.clear();
+                u1_rx.clear();
+                u1_shifting = false;
+                u1_done = NEVER;
+            }
+            break;
+        case SFR_RCON:
+            if (written && bit(SFR_RCON, 5) != ((pending_snap >> 5) & 1)){
+                // SWDTEN - software enabled watchdog
+                wdt_deadline = bit(SFR_RCON, 5) ? sim_cycles + wdt_cycles() : NEVER;
+            }
+            break;
+        case SFR_DISICNT:
+            // writing DISICNT (typically 0) ends DISI early
+            if (written) disi_until = sim_cycles + v;
+            break;
+        default:
+            break;
+    }
+}
+
+// updates value of live registers before firmware reads them
+static void refresh(sim_sfr_id_t id)
+{
+    switch (id){
+        case SFR_PORTA:
+        case SFR_PORTB: {
+            int port = id == SFR_PORTA ? 0 : 1;
+            for (SimDevice *d : devices){
+                d->on_port_read(sim_cycles, port);
+            }
+            regs[id] = levels[port];
+            break;
+        }
+        case SFR_TMR1:
+            regs[id] = t16_value(t1);
+            break;
+        case SFR_TMR4:
+            regs[id] = t16_value(t4);
+            break;
+        case SFR_TMR2: {
+            uint32_t v = t23_value();
+            regs[id] = (uint16_t)v;
+            if (t23_is32()){
+                regs[SFR_TMR3HLD] = (uint16_t)(v >> 16);
+            }
+            break;
+        }
+        case SFR_TMR3:
+            regs[id] = (uint16_t)(t23_value() >> 16);
+            break;
+        case SFR_SPI1STAT: {
+            uint16_t s = reg(SFR_SPI1STAT) & 0xB01C; // SPIEN, SPISIDL, SISEL
+            if (spi_tx.size() >= spi_depth()) s |= 1U << 1;        // SPITBF
+            if (spi_depth() == 1 ? !spi_rx.empty()
+                                 : spi_rx.size() >= spi_depth()){
+                s |= 1U << 0;                                       // SPIRBF
+            }
+            if (spi_rx.empty()) s |= 1U << 5;                       // SRXMPT
+            if (spi_rov) s |= 1U << 6;                              // SPIROV
+            if (!spi_shifting && spi_tx.empty()) s |= 1U << 7;      // SRMPT
+            s |= (uint16_t)((spi_tx.size() & 7) << 8);              // SPIBEC
+            regs[id] = s;
+            break;
+        }
+        case SFR_SPI1BUF:
+            regs[id] = (uint16_t)(SPI_READ_SENTINEL |
+                                  (spi_rx.empty() ? 0 : (spi_rx.front() & 0xFF)));
+            break;
+        case SFR_U1STA: {
+            uint16_t s = reg(SFR_U1STA) & 0xECE8; // writable bits
+            if (!u1_rx.empty()) s |= 1U << 0;                       // URXDA
+            if (u1_oerr) s |= 1U << 1;                              // OERR
+            s |= 1U << 4;                                           // RIDLE
+            if (!u1_shifting && u1_tx.empty()) s |= 1U << 8;        // TRMT
+            if (u1_tx.size() >= 4) s |= 1U << 9;                    // UTXBF
+            regs[id] = s;
+            break;
+        }
+        case SFR_U1TXREG:
+            regs[id] = U1TX_SENTINEL;
+            break;
+        case SFR_U1RXREG:
+            regs[id] = u1_rx.empty() ? 0 : u1_rx.front();
+            break;
+        case SFR_DISICNT:
+            regs[id] = disi_until > sim_cycles ?
+                (uint16_t)(disi_until - sim_cycles) : 0;
+            break;
+        default:
+            break;
+    }
+}
+
+extern "C" volatile uint16_t *sim_sfr(sim_sfr_id_t id)
+{
+    commit_pending();
+    advance(1);
+    refresh(id);
+    pending_id = id;
+    pending_snap = regs[id];
+    return &regs[id];
+}
+
+/*
+ * Builtins
+ */
+extern "C" void sim_builtin_nop(void)
+{
+    commit_pending();
+    advance(1);
+}
+
+extern "C" void sim_builtin_disi(uint16_t cycles)
+{
+    commit_pending();
+    disi_until = sim_cycles + cycles + 1;
+    advance(1);
+}
+
+extern "C" void sim_builtin_interrupts(int enable)
+{
+    commit_pending();
+    gie = enable != 0;
+    advance(1);
+}
+
+extern "C" void sim_builtin_idle(void)
+{
+    commit_pending();
+    uint64_t next = next_event();
+    advance(next > sim_cycles && next != NEVER ? next - sim_cycles : 1);
+}
+
+extern "C" void sim_builtin_clrwdt(void)
+{
+    commit_pending();
+    if (wdt_deadline != NEVER){
+        wdt_deadline = sim_cycles + wdt_cycles();
+    }
+    advance(1);
+}
+
+extern "C" void sim_builtin_reset(void)
+{
+    commit_pending();
+    set_bit(SFR_RCON, 6, true); // SWR
+    fprintf(stderr, "sim: software reset at %.3f ms\n",
+            sim_cycles_to_us(sim_cycles) / 1000.0);
+    reset_req = true;
+    do_stop();
+}
+
+/*
+ * Flash self-programming (RTSP)
+ */
+// assumed self-timed erase/write cycle [us] (CPU stalls, see sim.h)
+static const double FLASH_CYCLE_US = 3000;
+// erase/write endurance of one page
+static const uint32_t FLASH_ENDURANCE = 10000;
+// first address of page with flash configuration words
+static const uint32_t FLASH_CONFIG_PAGE = SIM_FLASH_END - SIM_FLASH_PAGE;
+
+static uint32_t tbl_addr(uint16_t offset)
+{
+    return ((uint32_t)reg(SFR_TBLPAG) << 16 | offset) & ~1U;
+}
+
+static void flash_violation(const char *what, uint32_t addr)
+{
+    flash_violations++;
+    if (flash_log.size() < 10){
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%12.3f ms: %s 0x%06X",
+                 sim_cycles_to_us(sim_cycles) / 1000.0, what, addr);
+        flash_log.push_back(buf);
+    }
+}
+
+static void flash_latch_clear(void)
+{
+    for (uint32_t &w : flash_latch){
+        w = SIM_FLASH_ERASED;
+    }
+}
+
+// programs one word - only erased word may be programmed (all ones
+// leave any word unchanged), otherwise result is AND of both
+static void flash_program(uint32_t addr, uint32_t value)
+{
+    uint32_t &w = flash[addr / 2];
+    if (value == SIM_FLASH_ERASED){
+        return;
+    }
+    if (w != SIM_FLASH_ERASED){
+        flash_violation("program of not erased word", addr);
+    }
+    w &= value;
+}
+
+// CPU stalls (no interrupts) until erase/write finishes, timers run
+static void flash_busy(void)
+{
+    uint64_t cycles = (uint64_t)(FLASH_CYCLE_US * sim_fcy / 1e6);
+    nvm_stall = true;
+    advance(cycles);
+    nvm_stall = false;
+    flash_stall += cycles;
+}
+
+extern "C" uint16_t sim_builtin_tblrdl(uint16_t offset)
+{
+    uint32_t addr = tbl_addr(offset);
+    commit_pending();
+    advance(2);
+    return addr < SIM_FLASH_END ? (uint16_t)flash[addr / 2] : 0;
+}
+
+extern "C" uint16_t sim_builtin_tblrdh(uint16_t offset)
+{
+    uint32_t addr = tbl_addr(offset);
+    commit_pending();
+    advance(2);
+    return addr < SIM_FLASH_END ? (uint16_t)(flash[addr / 2] >> 16) : 0;
+}
+
+extern "C" void sim_builtin_tblwtl(uint16_t offset, uint16_t data)
+{
+    uint32_t &l = flash_latch[(offset % SIM_FLASH_ROW) / 2];
+    commit_pending();
+    flash_latch_addr = tbl_addr(offset);
+    l = (l & 0xFF0000) | data;
+    advance(2);
+}
+
+extern "C" void sim_builtin_tblwth(uint16_t offset, uint16_t data)
+{
+    uint32_t &l = flash_latch[(offset % SIM_FLASH_ROW) / 2];
+    commit_pending();
+    flash_latch_addr = tbl_addr(offset);
+    l = (l & 0xFFFF) | (uint32_t)(data & 0xFF) << 16;
+    advance(2);
+}
+
+extern "C" void sim_builtin_write_nvm(void)
+{
+    uint16_t nvmcon = reg(SFR_NVMCON);
+    uint32_t addr = flash_latch_addr;
+
+    commit_pending();
+    advance(4); // unlock sequence
+    if (!(nvmcon & 0x4000)){
+        return; // WREN clear - nothing happens
+    }
+    if (flash_cut == 0){
+        // power is gone: operation never starts, flash keeps its content
+        set_bit(SFR_NVMCON, 13, true); // WRERR
+        flash_latch_clear();
+        return;
+    }
+    if (flash_cut > 0){
+        flash_cut--;
+    }
+    flash_ops++;
+    if (addr >= FLASH_CONFIG_PAGE){
+        flash_violation("erase/write of configuration page or beyond", addr);
+        set_bit(SFR_NVMCON, 13, true); // WRERR
+        flash_latch_clear();
+        return;
+    }
+    switch (nvmcon & 0x7F){
+        case 0x42: { // page erase
+            uint32_t page = addr & ~(SIM_FLASH_PAGE - 1);
+            for (uint32_t a = page; a < page + SIM_FLASH_PAGE; a += 2){
+                flash[a / 2] = SIM_FLASH_ERASED;
+            }
+            if (++flash_erases[page / SIM_FLASH_PAGE] == FLASH_ENDURANCE + 1){
+                flash_violation("endurance exceeded on page", page);
+            }
+            break;
+        }
+        case 0x01: { // row program
+            uint32_t row = addr & ~(SIM_FLASH_ROW - 1);
+            for (uint32_t i = 0; i < SIM_FLASH_ROW / 2; i++){
+                flash_program(row + 2 * i, flash_latch[i]);
+            }
+            flash_rows++;
+            break;
+        }
+        case 0x03: // word program
+            flash_program(addr, flash_latch[(addr % SIM_FLASH_ROW) / 2]);
+            flash_words++;
+            break;
+        default:
+            flash_violation("unsupported NVMOP at", addr);
+            set_bit(SFR_NVMCON, 13, true); // WRERR
+            flash_latch_clear();
+            return;
+    }
+    flash_latch_clear();
+    flash_busy();
+    set_bit(SFR_NVMCON, 15, false); // WR
+    set_bit(SFR_NVMCON, 13, false); // WRERR
+}
+
+/*
+ * Function call cost - firmware compiled with -pg -mfentry (x86-64 only)
+ * calls __fentry__ at start of every function that was not inlined.
+ */
+extern "C" void sim_fentry(void)
+{
+    if (sim_call_cycles && running){
+        commit_pending();
+        advance(sim_call_cycles);
+    }
+}
+
+#if defined(__x86_64__)
+// saves argument registers of instrumented function around sim_fentry()
+__asm__(
+    ".text\n"
+    ".globl __fentry__\n"
+    ".type __fentry__, @function\n"
+    "__fentry__:\n"
+    "    push %rax\n    push %rdi\n    push %rsi\n"
+    "    push %rdx\n    push %rcx\n    push %r8\n"
+    "    push %r9\n    push %r10\n    push %r11\n"
+    "    sub $8, %rsp\n"
+    "    call sim_fentry@PLT\n"
+    "    add $8, %rsp\n"
+    "    pop %r11\n    pop %r10\n    pop %r9\n"
+    "    pop %r8\n    pop %rcx\n    pop %rdx\n"
+    "    pop %rsi\n    pop %rdi\n    pop %rax\n"
+    "    ret\n"
+    ".size __fentry__, .-__fentry__\n");
+#endif
+
+/*
+ * Call depth - firmware compiled with -finstrument-functions calls these
+ * on entry and exit of every function, inlined ones included (so depth
+ * is upper bound of real stack frames). Depth is counted per root:
+ * main(), each task (function called directly by sched_run_once()) and
+ * each ISR; maximum total includes nested ISRs.
+ */
+extern "C" void __cyg_profile_func_enter(void *fn, void *call_site)
+{
+    (void)call_site;
+    if (call_top > 0 && call_top <= SIM_CALL_STACK && sched_run_once &&
+        call_fn[call_top - 1] == (const void *)sched_run_once){
+        depth_roots.push_back(DepthRoot{ call_top, fn, -1 });
+    }
+    if (call_top < SIM_CALL_STACK){
+        call_fn[call_top] = fn;
+    }
+    call_top++;
+    if (call_top > call_max) call_max = call_top;
+
+    if (depth_roots.empty()){
+        int &d = task_depth[NULL];
+        if (call_top > d) d = call_top;
+        return;
+    }
+    const DepthRoot &r = depth_roots.back();
+    int depth = call_top - r.base;
+    int &d = r.irq >= 0 ? irq_depth[r.irq] : task_depth[r.fn];
+    if (depth > d) d = depth;
+}
+
+extern "C" void __cyg_profile_func_exit(void *fn, void *call_site)
+{
+    (void)fn; (void)call_site;
+    call_top--;
+    if (!depth_roots.empty() && depth_roots.back().irq < 0 &&
+        depth_roots.back().base == call_top){
+        depth_roots.pop_back();
+    }
+}
+
+static void print_depth(const char *kind, const char *name, int depth)
+{
+    fprintf(stderr, "sim: depth %-4s %-20s %3d calls\n", kind, name, depth);
+}
+
+extern "C" void __delay32(unsigned long cycles)
+{
+    commit_pending();
+    advance(cycles);
+}
+
+/*
+ * Public API
+ */
+extern "C" double sim_cycles_to_us(uint64_t cycles)
+{
+    return (double)cycles * 1e6 / sim_fcy;
+}
+
+extern "C" void sim_advance(uint64_t cycles)
+{
+    commit_pending();
+    advance(cycles);
+}
+
+// reset of CPU and peripherals (all SFRs except RCON)
+static void cpu_reset(void)
+{
+    uint16_t rcon = regs[SFR_RCON];
+    for (int i = 0; i < SFR_COUNT; i++){
+        regs[i] = 0;
+    }
+    regs[SFR_TRISA] = 0xFFFF;
+    regs[SFR_TRISB] = 0xFFFF;
+    regs[SFR_PR1] = 0xFFFF;
+    regs[SFR_PR2] = 0xFFFF;
+    regs[SFR_PR3] = 0xFFFF;
+    regs[SFR_PR4] = 0xFFFF;
+    regs[SFR_IPC0] = regs[SFR_IPC1] = regs[SFR_IPC2] = 0x4444;
+    regs[SFR_IPC3] = regs[SFR_IPC6] = regs[SFR_IPC7] = 0x4444;
+    regs[SFR_OSCCON] = 0x0000;
+    regs[SFR_RPINR18] = regs[SFR_RPINR19] = regs[SFR_RPINR20] = 0x1F1F;
+    regs[SFR_RCON] = rcon;
+    isr_depth = 0;
+    wdt_deadline = NEVER;
+    call_top = 0;
+    depth_roots.clear();
+    pending_id = -1;
+    gie = true;
+    disi_until = 0;
+    t1.next = t4.next = t23_next = NEVER;
+    t1.frozen = t4.frozen = 0;
+    t23_frozen = 0;
+    spi_tx.clear(); spi_rx.clear();
+    spi_shifting = false; spi_done = NEVER; spi_rov = false;
+    u1_tx.clear(); u1_rx.clear();
+    u1_shifting = false; u1_done = NEVER; u1_oerr = false;
+    levels[0] = levels[1] = 0xFFFF;
+    mcu_low[0] = mcu_low[1] = 0;
+    isr_inner_cycles = 0;
+    update_pins();
+}
+
+extern "C" void sim_reset(void)
+{
+    regs[SFR_RCON] = 0x0003; // POR, BOR
+    cpu_reset();
+    for (IrqStats &st : irq_stats){
+        st = IrqStats();
+    }
+    for (int &d : irq_depth){
+        d = 0;
+    }
+    task_depth.clear();
+    call_max = 0;
+}
+
+extern "C" void sim_reset_warm(void)
+{
+    set_bit(SFR_RCON, 5, false); // SWDTEN
+    cpu_reset();
+}
+
+extern "C" int sim_run(int (*entry)(void), uint64_t cycles)
+{
+    limit = sim_cycles + cycles;
+    running = true;
+    reset_req = false;
+    if (setjmp(stop_jmp) == 0){
+        entry();
+        // firmware returned from main() - real CPU would reset
+        running = false;
+        limit = NEVER;
+        return SIM_RETURNED;
+    }
+    return reset_req ? SIM_RESET : SIM_TIMEOUT;
+}
+
+extern "C" void sim_print_stats(void)
+{
+    for (size_t i = 0; i < sizeof(IRQS) / sizeof(IRQS[0]); i++){
+        const IrqStats &st = irq_stats[i];
+        if (st.count == 0){
+            continue;
+        }
+        fprintf(stderr, "sim: irq %-4s %8llu calls, cycles min %llu avg %.1f "
+                "max %llu, CPU %.2f%%\n", IRQS[i].name,
+                (unsigned long long)st.count, (unsigned long long)st.min,
+                (double)st.total / st.count, (unsigned long long)st.max,
+                sim_cycles ? 100.0 * st.total / sim_cycles : 0.0);
+    }
+    if (call_max == 0){
+        return; // not built with -finstrument-functions
+    }
+    for (const auto &t : task_depth){
+        if (t.first == NULL){
+            print_depth("main", "main", t.second);
+            continue;
+        }
+        Dl_info info;
+        char addr[24];
+        const char *name = addr;
+        if (dladdr(t.first, &info) && info.dli_sname){
+            name = info.dli_sname;
+        } else {
+            snprintf(addr, sizeof(addr), "%p", t.first);
+        }
+        print_depth("task", name, t.second);
+    }
+    for (size_t i = 0; i < sizeof(IRQS) / sizeof(IRQS[0]); i++){
+        if (irq_depth[i]){
+            print_depth("irq", IRQS[i].name, irq_depth[i]);
+        }
+    }
+    print_depth("max", "incl. nested ISRs", call_max);
+}
+
+extern "C" void sim_stop(void)
+{
+    do_stop();
+}
+
+// image file: magic, number of words, words, number of pages, erase
+// counters (all uint32_t, host byte order)
+static const char FLASH_MAGIC[8] = { 'S', 'I', 'M', 'F', 'L', 'A', 'S', 'H' };
+
+static bool flash_io(FILE *f, bool write, void *data, size_t len)
+{
+    return (write ? fwrite(data, 1, len, f) : fread(data, 1, len, f)) == len;
+}
+
+extern "C" int sim_flash_load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    char magic[8];
+    uint32_t n;
+    bool ok;
+
+    if (!f){
+        return 0; // erased chip
+    }
+    ok = flash_io(f, false, magic, sizeof(magic)) &&
+         memcmp(magic, FLASH_MAGIC, sizeof(magic)) == 0 &&
+         flash_io(f, false, &n, sizeof(n)) && n == flash.size() &&
+         flash_io(f, false, flash.data(), n * sizeof(uint32_t)) &&
+         flash_io(f, false, &n, sizeof(n)) && n == flash_erases.size() &&
+         flash_io(f, false, flash_erases.data(), n * sizeof(uint32_t));
+    fclose(f);
+    if (!ok){
+        fprintf(stderr, "sim: %s is not flash image\n", path);
+        return -1;
+    }
+    return 1;
+}
+
+extern "C" int sim_flash_save(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    uint32_t n;
+    bool ok;
+
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    n = (uint32_t)flash.size();
+    ok = flash_io(f, true, (void *)FLASH_MAGIC, sizeof(FLASH_MAGIC)) &&
+         flash_io(f, true, &n, sizeof(n)) &&
+         flash_io(f, true, flash.data(), n * sizeof(uint32_t));
+    n = (uint32_t)flash_erases.size();
+    ok = ok && flash_io(f, true, &n, sizeof(n)) &&
+         flash_io(f, true, flash_erases.data(), n * sizeof(uint32_t));
+    ok = fclose(f) == 0 && ok;
+    return ok ? 0 : -1;
+}
+
+extern "C" uint32_t sim_flash_read(uint32_t addr)
+{
+    return addr < SIM_FLASH_END ? flash[addr / 2] : 0;
+}
+
+extern "C" uint32_t sim_flash_erases(uint32_t addr)
+{
+    return addr < SIM_FLASH_END ? flash_erases[addr / SIM_FLASH_PAGE] : 0;
+}
+
+extern "C" uint64_t sim_flash_ops(void)
+{
+    return flash_ops;
+}
+
+extern "C" void sim_flash_cut(int64_t ops)
+{
+    flash_cut = ops;
+}
+
+extern "C" unsigned sim_flash_report(void)
+{
+    uint64_t erases = 0;
+    uint32_t max = 0, max_page = 0;
+
+    for (size_t i = 0; i < flash_erases.size(); i++){
+        erases += flash_erases[i];
+        if (flash_erases[i] > max){
+            max = flash_erases[i];
+            max_page = (uint32_t)i * SIM_FLASH_PAGE;
+        }
+    }
+    if (!erases && !flash_rows && !flash_words && !flash_violations){
+        return 0; // flash not used
+    }
+    fprintf(stderr, "flash: %llu row writes, %llu word writes, CPU stalled "
+            "%.3f ms; page erases %llu in total, max %u on page 0x%04X\n",
+            (unsigned long long)flash_rows, (unsigned long long)flash_words,
+            sim_cycles_to_us(flash_stall) / 1000.0,
+            (unsigned long long)erases, max, max_page);
+    for (const std::string &l : flash_log){
+        fprintf(stderr, "flash: VIOLATION %s\n", l.c_str());
+    }
+    fprintf(stderr, "flash: %u violations\n", flash_violations);
+    return flash_violations;
+}
+
+extern "C" void sim_builtin_write_oscconl(uint8_t v)
+{
+    commit_pending();
+    advance(4); // unlock sequence
+    // IOL1WAY = ON (configuration of all projects) - IOLOCK stays set
+    // until reset
+    regs[SFR_OSCCON] = (uint16_t)((regs[SFR_OSCCON] & 0xFF40) | v);
+}
+
+extern "C" unsigned sim_pps_report(void)
+{
+    if (pps_violations){
+        fprintf(stderr, "sim: %u PPS writes ignored (IOLOCK)\n", pps_violations);
+    }
+    return pps_violations;
+}
+
+extern "C" uint16_t sim_port_levels(int port)
+{
+    return levels[port & 1];
+}
+
+extern "C" uint16_t sim_port_mcu_low(int port)
+{
+    return mcu_low[port & 1];
+}
+
+extern "C" void sim_uart1_rx_inject(uint8_t byte, uint64_t at_cycle)
+{
+    u1_inject.push_back(std::make_pair(at_cycle, byte));
+}
+
+extern "C" uint64_t sim_uart1_frame_cycles(void)
+{
+    return u1_frame_cycles();
+}
+
+void sim_attach(SimDevice *dev)
+{
+    devices.push_back(dev);
+    update_pins();
+}
+
+void sim_pins_changed(void)
+{
+    update_pins();
+}
@@ -0,0 +1,150 @@
+/**
+  @File Name
+    sim/sim.h
+
+  @Summary
+    Minimal PIC24FJ64GB002 simulator core for running firmware on host.
+
+  @Description
+    Firmware C sources are compiled unchanged against include/xc.h and
+    include/libpic30.h. Virtual time is counted in instruction cycles:
+    - each SFR access costs 1 cycle
+    - __delay32()/__delay_us()/__delay_ms() cost requested cycles
+    - interrupt entry/exit costs sim_isr_entry_cycles/sim_isr_exit_cycles
+    - optionally each call of not inlined function costs sim_call_cycles
+    Other code between SFR accesses is free, so absolute cycle counts
+    are lower bound of real ones, but all timing based on delays and
+    peripherals (TMR1, TMR2/3, TMR4, SPI1, UART1) follows real hardware.
+
+    Modelled peripherals:
+    - GPIO ports A, B incl. open-drain (external pull-up assumed on all pins)
+    - TMR1, TMR4 (16-bit, prescaler), TMR2/3 (32-bit mode only)
+    - interrupt controller with priorities, nesting, DISI
+    - SPI1 master with enhanced buffer
+    - UART1 TX/RX with 4-level FIFOs
+    - software enabled WDT (RCON.SWDTEN, ClrWdt()), RESET instruction
+    - flash self-programming (TBLRD/TBLWT, NVMCON page erase, row and
+      word program): erased word reads 0xFFFFFF, only erased word may be
+      programmed (violation otherwise), CPU stalls for 3 ms per erase or
+      write with interrupts held off, erases are counted per page
+      (wear, 10000 cycles endurance); configuration page is read only
+
+    External hardware is attached as SimDevice (C++ only).
+*/
+
+#ifndef SIM_SIM_H
+#define SIM_SIM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// virtual instruction cycles since reset
+extern uint64_t sim_cycles;
+// real instruction clock of simulated CPU [Hz]
+extern uint32_t sim_fcy;
+// extra cycles charged on interrupt entry and exit
+extern uint32_t sim_isr_entry_cycles;
+extern uint32_t sim_isr_exit_cycles;
+// cycles charged for each call of not inlined function (call, return,
+// prologue), needs firmware compiled with -pg -mfentry (x86-64 only)
+extern uint32_t sim_call_cycles;
+// WDT period [us] (config bits FWPSA/WDTPS of firmware), WDT runs while
+// firmware keeps RCON.SWDTEN set
+extern uint32_t sim_wdt_period_us;
+// fault injection: main context spins forever from this cycle (stuck
+// busy loop), interrupts keep running; UINT64_MAX = never
+extern uint64_t sim_hang_at;
+
+// results of sim_run()
+#define SIM_TIMEOUT  0  // requested cycles elapsed
+#define SIM_RETURNED 1  // firmware returned from main()
+#define SIM_RESET    2  // RESET instruction or WDT timeout (see RCON)
+
+// converts cycles to microseconds using sim_fcy
+double sim_cycles_to_us(uint64_t cycles);
+// consumes cycles in current context (interrupts may fire meanwhile)
+void sim_advance(uint64_t cycles);
+// power-on reset of CPU state and peripherals (devices stay attached)
+void sim_reset(void);
+// reset by RESET instruction or WDT: keeps RCON flags, time and
+// statistics (firmware RAM is re-initialized by caller)
+void sim_reset_warm(void);
+// runs firmware entry point until 'cycles' elapse, returns SIM_*
+int sim_run(int (*entry)(void), uint64_t cycles);
+// stops simulation immediately (returns from sim_run)
+void sim_stop(void);
+// prints interrupt statistics (count, cycles excluding nested ISRs) and
+// maximum call depth of main, tasks and ISRs (only when firmware was
+// built with -finstrument-functions) to stderr
+void sim_print_stats(void);
+
+// current level of port pins (bit per pin), port 0=A, 1=B
+uint16_t sim_port_levels(int port);
+// pins actively driven low by MCU (not by devices), port 0=A, 1=B
+uint16_t sim_port_mcu_low(int port);
+// injects byte to UART1 receiver at given cycle (>= now)
+void sim_uart1_rx_inject(uint8_t byte, uint64_t at_cycle);
+// cycles of one UART1 character (start, data, parity, stop bits)
+uint64_t sim_uart1_frame_cycles(void);
+// board option given as -o name=value on command line (NULL if missing)
+const char *sim_option(const char *name);
+
+// program memory size [addresses], page and row [addresses]
+#define SIM_FLASH_END    0xAC00
+#define SIM_FLASH_PAGE   0x400
+#define SIM_FLASH_ROW    0x80
+#define SIM_FLASH_ERASED 0xFFFFFFU
+// flash image with erase counters, kept between runs; load returns 1
+// when loaded, 0 when file is missing (erased chip), -1 on error
+int sim_flash_load(const char *path);
+int sim_flash_save(const char *path);
+// 24-bit word at even address, erases of page containing address
+uint32_t sim_flash_read(uint32_t addr);
+uint32_t sim_flash_erases(uint32_t addr);
+// erase/write operations so far; power cut after 'ops' more of them
+// (later ones fail with WRERR and change nothing), -1 restores power
+uint64_t sim_flash_ops(void);
+void sim_flash_cut(int64_t ops);
+// prints writes to Peripheral Pin Select registers ignored because of
+// IOLOCK (IOL1WAY), returns their number
+unsigned sim_pps_report(void);
+// prints flash statistics and violations (when flash was used),
+// returns number of violations
+unsigned sim_flash_report(void);
+
+#ifdef __cplusplus
+}
+
+// External hardware attached to simulated pins/buses
+class SimDevice {
+public:
+    virtual ~SimDevice() {}
+    // called after any change of pin levels (port 0=A, 1=B)
+    virtual void on_pins(uint64_t cycle, uint16_t porta, uint16_t portb)
+    { (void)cycle; (void)porta; (void)portb; }
+    // pins actively pulled low by device (open-drain buses), port 0=A, 1=B
+    virtual uint16_t pull_low(int port) { (void)port; return 0; }
+    // firmware accesses PORTA/PORTB (samples pins), port 0=A, 1=B
+    virtual void on_port_read(uint64_t cycle, int port)
+    { (void)cycle; (void)port; }
+    // byte shifted out of SPI1 (MOSI), returns MISO byte
+    virtual uint8_t on_spi(uint64_t cycle, uint8_t mosi)
+    { (void)cycle; (void)mosi; return 0; }
+    // byte transmitted by UART1
+    virtual void on_uart_tx(uint64_t cycle, uint8_t byte)
+    { (void)cycle; (void)byte; }
+    // next cycle when device wants on_event() (UINT64_MAX = none)
+    virtual uint64_t next_event() { return UINT64_MAX; }
+    virtual void on_event(uint64_t cycle) { (void)cycle; }
+};
+
+void sim_attach(SimDevice *dev);
+// device must call this when its pull_low() result changed
+void sim_pins_changed(void);
+
+#endif
+
+#endif /* SIM_SIM_H */
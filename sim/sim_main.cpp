@@ -0,0 +1,218 @@
+/**
+  @File Name
+    sim/sim_main.cpp
+
+  @Summary
+    Command line runner - runs firmware of one project in simulator.
+
+  @Description
+    Usage: sim-<project> [-t seconds] [-f fcy_hz] [-i isr_entry_cycles]
+                         [-x isr_exit_cycles] [-c call_cycles]
+                         [-w wdt_ms] [-H hang_seconds] [-o name=value] [-q]
+
+    UART1 output of firmware is copied to stdout (raw bytes, so binary
+    trace frames can be piped to trace-decode). Project specific
+    hardware (sensors, displays) is attached by sim_board_setup()
+    from board_<project>.cpp when such file exists, -o passes options
+    to it (see sim_option()). Exit status is 1 when board checks (for
+    example 1-wire timing) failed.
+
+    Software (RESET instruction) and watchdog resets reboot firmware:
+    its initialized data and bss are restored (Makefile moves them to
+    fw_data/fw_bss sections), persistent variables are kept, devices
+    and time continue. -H makes main context hang at given time to
+    test watchdog supervision, -w sets WDT period (default 128 ms).
+
+    -o record=file writes trace of pin transitions and SPI bytes
+    (recorder.h), limited to -o record_from=s / record_to=s window.
+
+    -o flash=file keeps program memory written by firmware (RTSP)
+    between runs: loaded before start (missing file is erased chip),
+    saved at the end. Flash violations (programming of not erased word,
+    worn out page) make exit status 1 too.
+
+    Peripheral Pin Select follows IOL1WAY = ON: after IOLOCK is set
+    writes to RPORx/RPINRx are ignored and reported (exit status 1),
+    UART1 talks only through RP2/RP3 mapped as U1TX/U1RX.
+
+    -o uart=path connects UART1 to serial port or pseudo-terminal
+    instead of stdout (uart=pty creates one, its path is printed), so
+    host program can talk to firmware (uart_link.h); simulation then
+    runs at wall clock speed. Latency of replies out of -o reply_min=ms
+    .. reply_max=ms makes exit status 1.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <xc.h>
+#include "sim.h"
+#include "recorder.h"
+#include "uart_link.h"
+
+// firmware main() renamed by -Dmain=fw_main
+extern "C" int fw_main(void);
+
+// firmware RAM, sections created by Makefile (objcopy --rename-section)
+extern "C" char __start_fw_data[] __attribute__((weak));
+extern "C" char __stop_fw_data[] __attribute__((weak));
+extern "C" char __start_fw_bss[] __attribute__((weak));
+extern "C" char __stop_fw_bss[] __attribute__((weak));
+
+// optional project specific devices
+void sim_board_setup(int argc, char **argv) __attribute__((weak));
+// returns non-zero when board checks failed (exit status of simulator)
+int sim_board_report(void) __attribute__((weak));
+
+// -o name=value board options
+static std::vector<std::string> options;
+
+extern "C" const char *sim_option(const char *name)
+{
+    size_t len = strlen(name);
+    for (const std::string &o : options){
+        if (o.compare(0, len, name) == 0 && o.size() > len && o[len] == '='){
+            return o.c_str() + len + 1;
+        }
+    }
+    return NULL;
+}
+
+class UartConsole : public SimDevice {
+public:
+    bool quiet = false;
+    uint64_t bytes = 0;
+    void on_uart_tx(uint64_t cycle, uint8_t byte) override
+    {
+        (void)cycle;
+        bytes++;
+        if (!quiet){
+            putchar(byte);
+        }
+    }
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t seconds] [-f fcy_hz] [-i isr_entry_cycles]"
+            " [-x isr_exit_cycles] [-c call_cycles] [-w wdt_ms]"
+            " [-H hang_seconds] [-o name=value] [-q]\n", prog);
+    exit(2);
+}
+
+// C startup of firmware after reset: initialized data from snapshot
+// taken before first run, bss cleared
+static void fw_ram_init(const std::vector<char> &data)
+{
+    if (__start_fw_data && !data.empty()){
+        memcpy(__start_fw_data, data.data(), data.size());
+    }
+    if (__start_fw_bss){
+        memset(__start_fw_bss, 0, (size_t)(__stop_fw_bss - __start_fw_bss));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 12.0;
+    double hang = -1.0;
+    UartConsole console;
+    unsigned resets = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:f:i:x:c:w:H:o:qh")) != -1){
+        switch (opt){
+            case 't': seconds = atof(optarg); break;
+            case 'f': sim_fcy = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'i': sim_isr_entry_cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'x': sim_isr_exit_cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'c': sim_call_cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'w': sim_wdt_period_us = (uint32_t)(atof(optarg) * 1000); break;
+            case 'H': hang = atof(optarg); break;
+            case 'o': options.push_back(optarg); break;
+            case 'q': console.quiet = true; break;
+            default: usage(argv[0]);
+        }
+    }
+
+    sim_reset();
+    const char *flash = sim_option("flash");
+    if (flash && sim_flash_load(flash) < 0){
+        return 2;
+    }
+    sim_attach(&console);
+    UartLink link;
+    if (const char *path = sim_option("uart")){
+        if (!link.open(path)){
+            perror(path);
+            return 2;
+        }
+        const char *lo = sim_option("reply_min");
+        const char *hi = sim_option("reply_max");
+        link.min_us = lo ? atof(lo) * 1000 : link.min_us;
+        link.max_us = hi ? atof(hi) * 1000 : link.max_us;
+        console.quiet = true;
+        sim_attach(&link);
+    }
+    if (sim_board_setup){
+        sim_board_setup(argc, argv);
+    }
+    FILE *trace = NULL;
+    TraceRecorder *recorder = NULL;
+    if (const char *path = sim_option("record")){
+        trace = fopen(path, "w");
+        if (!trace){
+            perror(path);
+            return 2;
+        }
+        const char *from = sim_option("record_from");
+        const char *to = sim_option("record_to");
+        recorder = new TraceRecorder(trace, from ? atof(from) : 0.0,
+                                     to ? atof(to) : seconds);
+        sim_attach(recorder);
+    }
+    if (hang >= 0){
+        sim_hang_at = (uint64_t)(hang * sim_fcy);
+    }
+    std::vector<char> fw_data(__start_fw_data, __stop_fw_data);
+    uint64_t end = (uint64_t)(seconds * sim_fcy);
+    for (;;){
+        int r = sim_run(fw_main, end - sim_cycles);
+        if (r == SIM_RESET && sim_cycles < end){
+            sim_reset_warm();
+            fw_ram_init(fw_data);
+            resets++;
+            continue;
+        }
+        if (r == SIM_RETURNED){
+            fprintf(stderr, "sim: firmware returned from main()\n");
+        }
+        break;
+    }
+    fflush(stdout);
+    if (trace){
+        fclose(trace);
+        delete recorder;
+    }
+    fprintf(stderr, "sim: %.3f s simulated (%llu cycles at %u Hz), "
+            "%llu UART bytes, %u resets\n", sim_cycles_to_us(sim_cycles) / 1e6,
+            (unsigned long long)sim_cycles, sim_fcy,
+            (unsigned long long)console.bytes, resets);
+    sim_print_stats();
+    int status = sim_flash_report() || sim_pps_report() ? 1 : 0;
+    if (flash && sim_flash_save(flash) < 0){
+        fprintf(stderr, "sim: cannot save flash to %s\n", flash);
+        status = 2;
+    }
+    if (link.report()){
+        status = status ? status : 1;
+    }
+    if (sim_board_report && sim_board_report()){
+        status = status ? status : 1;
+    }
+    return status;
+}
@@ -0,0 +1,423 @@
+/**
+  @File Name
+    sim/telem_check.cpp
+
+  @Summary
+    Host check of telemetry (common/telem.h) and its receiver
+    (telem_rx.h) over pseudo-terminal loopback.
+
+  @Description
+    Usage: telem-check [-n seconds] [-s seed]
+
+    Runs ../common/telem.c against model of UART TX ring (uart_write()
+    of uart.h: 256 bytes, drained at 38400 Bd) in virtual time:
+    - sensor 0 sampled at 1 kHz with +-200 us jitter and rare missed
+      samples (breaks period - new batch), sensor 1 joins for 2 s of
+      every 10 s (2 kHz in total is over the line rate - frames must be
+      dropped, but only then), counters and diagnostics every second;
+      time starts 3 s before 32-bit microseconds wrap
+    - frames leaving the ring are written to master side of pty in
+      random pieces, mixed with text and event trace like chunks, 1 of
+      200 frames gets one byte corrupted
+    - TelemReceiver reads slave side (opened as serial port)
+
+    Checked:
+    - COBS and CRC-16 of known vectors, COBS round trip
+    - every received value was sampled (value and time within dt/2 of
+      t0 + i * dt, in order), values missing at receiver are exactly
+      those of dropped and corrupted frames
+    - counters and diagnostics arrive unchanged, lost frames (sequence
+      gaps) equal dropped plus corrupted ones
+    - no frame is dropped while only sensor 0 streams (1 kHz fits)
+
+    Exit status is 0 when all checks passed, 1 otherwise.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "telem.h"
+#include "cobs.h"
+#include "crc16.h"
+#include "serial.h"
+#include "telem_rx.h"
+
+// line and TX ring of uart.c
+static const double LINE_BPS = 38400 / 10.0;
+static const double TX_RING = 255;
+
+struct Sample {
+    uint64_t time;
+    int16_t value;
+};
+
+struct SentFrame {
+    uint8_t type;
+    unsigned sensor;
+    unsigned samples;
+    bool delivered;
+};
+
+
+static double now_s = 0;      // virtual time
+static double queued = 0;     // bytes in TX ring
+static bool burst = false;    // sensor 1 streams (or did in last 200 ms
+                              // - ring is emptied meanwhile)
+static bool clean = false;    // no corruption (last frame)
+static uint64_t refused = 0, refused_single = 0, corrupted = 0, noise = 0;
+static std::vector<uint8_t> line;   // bytes to be written to pty
+static uint64_t written = 0;        // written to pty
+static std::vector<SentFrame> sent;
+static std::deque<std::vector<uint32_t>> expect_counters;
+static std::deque<std::vector<uint16_t>> expect_diag;
+static std::vector<uint32_t> pending_counters;
+static std::vector<uint16_t> pending_diag;
+
+// other output of firmware between frames: text or trace frame
+static void add_noise(void)
+{
+    static const char *TEXT[] = { "load 4.6%\r\n", "sampling: level 1 (first), 12 bit\r\n",
+                                  "ow sensor 0: RB8 28-0000056A1B2C\r\n" };
+    if (rnd(2)) {
+        const char *t = TEXT[rnd(3)];
+        line.insert(line.end(), t, t + strlen(t));
+    } else {
+        line.push_back(0xA5);
+        line.push_back(0x5A);
+        for (unsigned i = rnd(40); i > 0; i--) {
+            line.push_back(rnd(3) ? (uint8_t)rng() : 0);
+        }
+    }
+    noise++;
+}
+
+// TX ring of uart.c, drained by line since last call
+extern "C" bool uart_write(const uint8_t *data, uint16_t len)
+{
+    uint8_t f[COBS_MAX(TELEM_FRAME_MAX)];
+    int16_t flen = cobs_decode(data + 1, (uint16_t)(len - 2), f);
+    SentFrame s = { f[0], 0, 0, false };
+
+    if (flen < TELEM_HDR_SIZE + TELEM_CRC_SIZE || data[0] || data[len - 1]) {
+        fail("frame not enclosed in delimiters or malformed");
+        return false;
+    }
+    if (s.type == TELEM_SAMPLES) {
+        s.sensor = f[TELEM_HDR_SIZE];
+        s.samples = f[TELEM_HDR_SIZE + 1];
+    }
+    if (TX_RING - queued < len) {
+        refused++;
+        refused_single += !burst;
+        sent.push_back(s);
+        return false;
+    }
+    queued += len;
+    size_t start = line.size();
+    line.insert(line.end(), data, data + len);
+    if (!clean && rnd(200) == 0) {
+        // any byte of frame except delimiters
+        line[start + 1 + rnd(len - 2)] ^= (uint8_t)(1 + rnd(255));
+        corrupted++;
+    } else {
+        s.delivered = true;
+        if (s.type == TELEM_COUNTERS) {
+            expect_counters.push_back(pending_counters);
+        } else if (s.type == TELEM_DIAG) {
+            expect_diag.push_back(pending_diag);
+        }
+    }
+    if (rnd(20) == 0) {
+        add_noise();
+    }
+    sent.push_back(s);
+    return true;
+}
+
+static void check_vectors(void)
+{
+    static const struct { std::vector<uint8_t> in, out; } COBS[] = {
+        { {}, { 0x01 } },
+        { { 0x00 }, { 0x01, 0x01 } },
+        { { 0x00, 0x00 }, { 0x01, 0x01, 0x01 } },
+        { { 0x11, 0x22, 0x00, 0x33 }, { 0x03, 0x11, 0x22, 0x02, 0x33 } },
+        { { 0x11, 0x00, 0x00, 0x00 }, { 0x02, 0x11, 0x01, 0x01, 0x01 } },
+    };
+    uint8_t out[COBS_MAX(600)], back[COBS_MAX(600)];
+
+    for (const auto &v : COBS) {
+        uint16_t n = cobs_encode(v.in.data(), (uint16_t)v.in.size(), out);
+        if (std::vector<uint8_t>(out, out + n) != v.out) {
+            fail("COBS of %zu byte vector", v.in.size());
+        }
+    }
+    // 254 and 255 non-zero bytes: 0xFF block, then nothing / one byte
+    for (unsigned len = 253; len <= 256; len++) {
+        std::vector<uint8_t> in(len, 0x42);
+        uint16_t n = cobs_encode(in.data(), (uint16_t)len, out);
+        unsigned expect = len + (len >= 254 ? 2 : 1) - (len == 254 ? 1 : 0);
+        if (n != expect || out[0] != (len >= 254 ? 0xFF : len + 1)) {
+            fail("COBS of %u non-zero bytes: %u bytes, first 0x%02X", len, n, out[0]);
+        }
+    }
+    for (unsigned i = 0; i < 20000; i++) {
+        unsigned len = rnd(600);
+        std::vector<uint8_t> in(len);
+        for (uint8_t &b : in) {
+            // runs of non-zero bytes over 254 and zeros
+            b = rnd(4) ? (uint8_t)(1 + rnd(255)) : (uint8_t)(rnd(8) ? 0x55 : 0);
+        }
+        uint16_t n = cobs_encode(in.data(), (uint16_t)len, out);
+        if (n > COBS_MAX(len) || memchr(out, 0, n)) {
+            fail("COBS of %u bytes: %u bytes or zero in output", len, n);
+            continue;
+        }
+        int16_t m = cobs_decode(out, n, back);
+        if (m != (int16_t)len || memcmp(in.data(), back, len)) {
+            fail("COBS round trip of %u bytes: %d bytes back", len, m);
+        }
+    }
+    if (crc16((const uint8_t *)"123456789", 9) != 0x29B1) {
+        fail("CRC-16 of \"123456789\" is 0x%04X", crc16((const uint8_t *)"123456789", 9));
+    }
+}
+
+// writes line bytes to pty master in random pieces (all of them or
+// while more than 300 are waiting), feeds receiver with what arrived
+// at slave; waits for slave only when pty buffer is filling up
+static void pump(int master, int slave, TelemReceiver &rx, bool all)
+{
+    size_t pos = 0;
+    uint8_t buf[512];
+
+    while (pos < line.size() && (all || line.size() - pos > 300)) {
+        size_t n = std::min(line.size() - pos, (size_t)(1 + rnd(300)));
+        ssize_t w = write(master, line.data() + pos, n);
+        if (w < 0) {
+            perror("pty write");
+            exit(1);
+        }
+        pos += (size_t)w;
+        written += (uint64_t)w;
+        struct pollfd p = { slave, POLLIN, 0 };
+        while (poll(&p, 1, written - rx.stats().bytes > 2048 ? 1000 : 0) > 0) {
+            ssize_t r = read(slave, buf, 1 + rnd(sizeof(buf)));
+            if (r <= 0) {
+                break;
+            }
+            rx.feed(buf, (size_t)r);
+        }
+    }
+    line.erase(line.begin(), line.begin() + pos);
+}
+
+// waits for all written bytes at slave
+static void drain(int slave, TelemReceiver &rx, uint64_t total)
+{
+    uint8_t buf[512];
+    struct pollfd p = { slave, POLLIN, 0 };
+
+    while (rx.stats().bytes < total && poll(&p, 1, 2000) > 0) {
+        ssize_t r = read(slave, buf, sizeof(buf));
+        if (r <= 0) {
+            break;
+        }
+        rx.feed(buf, (size_t)r);
+    }
+    if (rx.stats().bytes != total) {
+        fail("%llu of %llu bytes came through pty", (unsigned long long)rx.stats().bytes,
+             (unsigned long long)total);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 60;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n': seconds = atof(optarg); break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n seconds] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+    check_init("telem", seed);
+    check_vectors();
+
+    std::string path;
+    int master = serial_open_pty(path);
+    if (master < 0) {
+        perror("pty");
+        return 1;
+    }
+    int slave = serial_open(path.c_str(), 38400);
+    if (slave < 0) {
+        perror(path.c_str());
+        return 1;
+    }
+
+    // sampled values of each sensor and position of next expected one
+    std::vector<Sample> truth[2];
+    size_t next[2] = { 0, 0 };
+    uint64_t matched = 0, missed = 0;
+    TelemReceiver rx;
+    rx.on_samples = [&](const TelemSamples &s) {
+        if (s.sensor > 1) {
+            fail("sample frame of sensor %u", s.sensor);
+            return;
+        }
+        std::vector<Sample> &t = truth[s.sensor];
+        size_t &i = next[s.sensor];
+        for (size_t k = 0; k < s.values.size(); k++) {
+            uint64_t nominal = s.t0 + (uint64_t)k * s.dt;
+            // values in between belong to lost frames
+            while (i < t.size() && (t[i].time + s.dt / 2 < nominal ||
+                                    t[i].value != s.values[k])) {
+                i++;
+                missed++;
+            }
+            if (i == t.size() || t[i].time > nominal + s.dt / 2) {
+                fail("sensor %u: value %d at %.6f s was not sampled", s.sensor,
+                     s.values[k], nominal / 1e6);
+                return;
+            }
+            i++;
+            matched++;
+        }
+    };
+    rx.on_counters = [&](const std::vector<uint32_t> &v) {
+        if (expect_counters.empty() || v != expect_counters.front()) {
+            fail("counters frame differs");
+        }
+        if (!expect_counters.empty()) {
+            expect_counters.pop_front();
+        }
+    };
+    rx.on_diag = [&](const std::vector<uint16_t> &v) {
+        if (expect_diag.empty() || v != expect_diag.front()) {
+            fail("diagnostic frame differs");
+        }
+        if (!expect_diag.empty()) {
+            expect_diag.pop_front();
+        }
+    };
+
+    // 3 s before wrap of 32-bit microseconds
+    const uint64_t start = 0x100000000ULL - 3000000;
+    telem_batch_t batch[2];
+    telem_batch_init(&batch[0], 0, 1000);
+    telem_batch_init(&batch[1], 1, 1000);
+    int16_t value[2] = { 21 * 16, -5 * 16 };
+    double single_bytes = 0;
+    double single_s = 0;
+    unsigned steps = (unsigned)(seconds * 1000);
+    for (unsigned ms = 0; ms < steps; ms++) {
+        double prev = now_s;
+        now_s = ms / 1000.0;
+        // bytes sent by UART meanwhile
+        double sent_bytes = std::min(queued, (now_s - prev) * LINE_BPS);
+        queued -= sent_bytes;
+        if (!burst) {
+            single_bytes += sent_bytes;
+            single_s += now_s - prev;
+        }
+        bool both = ms % 10000 >= 6000 && ms % 10000 < 8000;
+        burst = ms % 10000 >= 6000 && ms % 10000 < 8200;
+        for (unsigned s = 0; s < (both ? 2u : 1u); s++) {
+            if (rnd(500) == 0) {
+                continue; // missed sample
+            }
+            uint64_t t = start + (uint64_t)ms * 1000 + (int64_t)rnd(401) - 200;
+            value[s] += (int16_t)rnd(7) - 3;
+            truth[s].push_back({ t, value[s] });
+            telem_batch_add(&batch[s], (uint32_t)t, value[s]);
+        }
+        if (ms % 1000 == 999) {
+            pending_counters.clear();
+            for (unsigned i = 0; i < TELEM_COUNTER_COUNT; i++) {
+                pending_counters.push_back(ms * 7 + i);
+            }
+            telem_counters(pending_counters.data(), TELEM_COUNTER_COUNT);
+            pending_diag.clear();
+            for (unsigned i = 0; i < TELEM_DIAG_COUNT; i++) {
+                pending_diag.push_back((uint16_t)(ms + i));
+            }
+            telem_diag(pending_diag.data(), TELEM_DIAG_COUNT);
+        }
+        pump(master, slave, rx, false);
+    }
+    telem_batch_flush(&batch[0]);
+    telem_batch_flush(&batch[1]);
+    // clean last frame - corruption of previous ones shows as gap
+    clean = true;
+    queued = 0;
+    pending_diag.assign(TELEM_DIAG_COUNT, 0);
+    telem_diag(pending_diag.data(), TELEM_DIAG_COUNT);
+    pump(master, slave, rx, true);
+    drain(slave, rx, written);
+
+    uint64_t lost = 0, lost_samples[2] = { 0, 0 }, values = 0;
+    for (const SentFrame &s : sent) {
+        lost += !s.delivered;
+        if (s.type == TELEM_SAMPLES) {
+            values += s.samples;
+            if (!s.delivered) {
+                lost_samples[s.sensor] += s.samples;
+            }
+        }
+    }
+    // values never matched at the end belong to lost frames too
+    missed += truth[0].size() - next[0] + truth[1].size() - next[1];
+    const TelemStats &st = rx.stats();
+    if (values != truth[0].size() + truth[1].size()) {
+        fail("%llu values sampled, %llu sent in frames", (unsigned long long)(truth[0].size() + truth[1].size()),
+             (unsigned long long)values);
+    }
+    if (missed != lost_samples[0] + lost_samples[1]) {
+        fail("%llu values missing at receiver, %llu in lost frames", (unsigned long long)missed,
+             (unsigned long long)(lost_samples[0] + lost_samples[1]));
+    }
+    if (st.frames != sent.size() - lost || st.lost != lost) {
+        fail("%llu frames received, %llu lost, expected %llu and %llu",
+             (unsigned long long)st.frames, (unsigned long long)st.lost,
+             (unsigned long long)(sent.size() - lost), (unsigned long long)lost);
+    }
+    if (st.rejected < corrupted) {
+        fail("%llu corrupted frames, only %llu rejected chunks", (unsigned long long)corrupted,
+             (unsigned long long)st.rejected);
+    }
+    if (telem_dropped != refused) {
+        fail("telem_dropped %u, %llu frames refused", telem_dropped, (unsigned long long)refused);
+    }
+    if (refused_single) {
+        fail("%llu frames dropped with only 1 kHz stream", (unsigned long long)refused_single);
+    }
+    if (!expect_counters.empty() || !expect_diag.empty()) {
+        fail("%zu counters and %zu diagnostic frames not received", expect_counters.size(),
+             expect_diag.size());
+    }
+
+    fprintf(stderr, "telem: %u frames, %llu values, %llu bytes through pty, 1 kHz stream "
+            "takes %.0f of %.0f bytes/s\n", (unsigned)sent.size(), (unsigned long long)values,
+            (unsigned long long)written, single_bytes / single_s, LINE_BPS);
+    fprintf(stderr, "telem: %llu dropped at 2 kHz, %llu corrupted, %llu noise chunks; "
+            "receiver: %llu frames, %llu rejected chunks, %llu lost frames, %llu values\n",
+            (unsigned long long)refused, (unsigned long long)corrupted,
+            (unsigned long long)noise, (unsigned long long)st.frames,
+            (unsigned long long)st.rejected, (unsigned long long)st.lost,
+            (unsigned long long)matched);
+    fprintf(stderr, "telem: %u failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+/**
+  @File Name
+    sim/telem_dump.cpp
+
+  @Summary
+    Prints telemetry frames (see common/telem_fmt.h) received from
+    serial port, capture file or stdin.
+
+  @Description
+    Usage: telem-dump [-b baud] [-k divisor] [-q] [source]
+
+    Source is tty (USB-serial adapter, opened raw at -b baud, default
+    38400) or file with raw UART capture, stdin when missing. Sample
+    values are divided by -k (default 16 - DS18B20 reads 1/16 C). With
+    -q only statistics are printed at the end (stderr):
+
+      telem: 5120 bytes, 21 frames (4 samples), 9 rejected chunks, 0 lost frames
+
+    Rejected chunks are text and event trace between frames.
+*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "serial.h"
+#include "telem_rx.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-b baud] [-k divisor] [-q] [source]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned baud = 38400;
+    double divisor = 16.0;
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:k:qh")) != -1) {
+        switch (opt) {
+            case 'b': baud = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'k': divisor = atof(optarg); break;
+            case 'q': quiet = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    int fd = 0;
+    if (optind < argc) {
+        fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+        if (fd >= 0 && isatty(fd)) {
+            close(fd);
+            fd = serial_open(argv[optind], baud);
+        }
+        if (fd < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    TelemReceiver rx;
+    if (!quiet) {
+        rx.on_samples = [divisor](const TelemSamples &s) {
+            for (size_t i = 0; i < s.values.size(); i++) {
+                printf("%12.6f s  sensor %u  %9.4f\n",
+                       (double)(s.t0 + (uint64_t)i * s.dt) / 1e6, s.sensor,
+                       s.values[i] / divisor);
+            }
+        };
+        rx.on_counters = [](const std::vector<uint32_t> &v) {
+            printf("counters");
+            for (size_t i = 0; i < v.size(); i++) {
+                const char *name = TelemReceiver::counter_name((unsigned)i);
+                if (name) {
+                    printf(" %s=%lu", name, (unsigned long)v[i]);
+                }
+            }
+            printf("\n");
+        };
+        rx.on_diag = [](const std::vector<uint16_t> &v) {
+            printf("diag    ");
+            for (size_t i = 0; i < v.size(); i++) {
+                const char *name = TelemReceiver::diag_name((unsigned)i);
+                if (name) {
+                    printf(" %s=%u", name, v[i]);
+                }
+            }
+            printf("\n");
+        };
+    }
+    uint8_t buf[256];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        rx.feed(buf, (size_t)n);
+        if (!quiet) {
+            fflush(stdout);
+        }
+    }
+    const TelemStats &st = rx.stats();
+    fprintf(stderr, "telem: %llu bytes, %llu frames (%llu samples), %llu rejected "
+            "chunks, %llu lost frames\n", (unsigned long long)st.bytes,
+            (unsigned long long)st.frames, (unsigned long long)st.samples,
+            (unsigned long long)st.rejected, (unsigned long long)st.lost);
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+  @File Name
+    sim/telem_rx.cpp
+
+  @Summary
+    Host receiver of telemetry frames. See telem_rx.h for details.
+*/
+
+#include "telem_rx.h"
+#include "cobs.h"
+#include "crc16.h"
+
+#define TELEM_NAME(id, name) name,
+static const char *COUNTER_NAMES[TELEM_COUNTER_COUNT] = {
+    TELEM_COUNTER_LIST(TELEM_NAME)
+};
+static const char *DIAG_NAMES[TELEM_DIAG_COUNT] = {
+    TELEM_DIAG_LIST(TELEM_NAME)
+};
+#undef TELEM_NAME
+
+// longest chunk that may be a frame
+static const size_t CHUNK_MAX = COBS_MAX(TELEM_FRAME_MAX);
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | (uint32_t)get16(p + 2) << 16; }
+
+const char *TelemReceiver::counter_name(unsigned i)
+{
+    return i < TELEM_COUNTER_COUNT ? COUNTER_NAMES[i] : NULL;
+}
+
+const char *TelemReceiver::diag_name(unsigned i)
+{
+    return i < TELEM_DIAG_COUNT ? DIAG_NAMES[i] : NULL;
+}
+
+void TelemReceiver::feed(const uint8_t *data, size_t len)
+{
+    st.bytes += len;
+    for (size_t i = 0; i < len; i++) {
+        if (!data[i]) {
+            end_chunk();
+        } else if (chunk.size() < CHUNK_MAX) {
+            chunk.push_back(data[i]);
+        } else {
+            overflow = true;
+        }
+    }
+}
+
+void TelemReceiver::end_chunk()
+{
+    uint8_t f[CHUNK_MAX];
+
+    if (chunk.empty()) {
+        // delimiters of adjacent frames
+        return;
+    }
+    int16_t len = overflow ? -1 : cobs_decode(chunk.data(), (uint16_t)chunk.size(), f);
+    if (len < TELEM_HDR_SIZE + TELEM_CRC_SIZE ||
+            crc16(f, (uint16_t)(len - TELEM_CRC_SIZE)) != get16(f + len - TELEM_CRC_SIZE) ||
+            !dispatch(f, (size_t)len - TELEM_CRC_SIZE)) {
+        st.rejected++;
+    }
+    chunk.clear();
+    overflow = false;
+}
+
+// frame without CRC, false when its body is malformed
+bool TelemReceiver::dispatch(const uint8_t *f, size_t len)
+{
+    const uint8_t *b = f + TELEM_HDR_SIZE;
+    size_t blen = len - TELEM_HDR_SIZE;
+    size_t n = blen ? b[0] : 0;
+
+    switch (f[0]) {
+        case TELEM_SAMPLES:
+            n = blen >= TELEM_SAMPLES_HDR ? b[1] : 0;
+            if (!n || n > TELEM_BATCH_MAX || blen != TELEM_SAMPLES_HDR + 2 * n) {
+                return false;
+            }
+            break;
+        case TELEM_COUNTERS:
+            if (!blen || blen != 1 + 4 * n) {
+                return false;
+            }
+            break;
+        case TELEM_DIAG:
+            if (!blen || blen != 1 + 2 * n) {
+                return false;
+            }
+            break;
+    }
+    if (have_seq) {
+        st.lost += (uint8_t)(f[1] - seq - 1);
+    }
+    have_seq = true;
+    seq = f[1];
+    st.frames++;
+    if (on_frame) {
+        on_frame(f[0], f[1], b, blen);
+    }
+
+    if (f[0] == TELEM_SAMPLES) {
+        TelemSamples s;
+        uint32_t t0 = get32(b + 2);
+        // closest 64-bit time with these low 32 bits
+        time = have_time ? time + (int32_t)(t0 - (uint32_t)time) : t0;
+        have_time = true;
+        s.sensor = b[0];
+        s.t0 = time;
+        s.dt = get16(b + 6);
+        for (size_t i = 0; i < n; i++) {
+            s.values.push_back((int16_t)get16(b + TELEM_SAMPLES_HDR + 2 * i));
+        }
+        st.samples += n;
+        if (on_samples) {
+            on_samples(s);
+        }
+    } else if (f[0] == TELEM_COUNTERS && on_counters) {
+        std::vector<uint32_t> v;
+        for (size_t i = 0; i < n; i++) {
+            v.push_back(get32(b + 1 + 4 * i));
+        }
+        on_counters(v);
+    } else if (f[0] == TELEM_DIAG && on_diag) {
+        std::vector<uint16_t> v;
+        for (size_t i = 0; i < n; i++) {
+            v.push_back(get16(b + 1 + 2 * i));
+        }
+        on_diag(v);
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+/**
+  @File Name
+    sim/telem_rx.h
+
+  @Summary
+    Host receiver of telemetry frames (see common/telem_fmt.h).
+
+  @Description
+    TelemReceiver is fed raw bytes as they come from serial port (any
+    split), collects them between 0x00 delimiters, decodes COBS, checks
+    CRC and length of body and calls handler of frame type. Anything
+    else on the line (text, event trace) ends as rejected chunk between
+    two frames, it never costs a valid frame.
+
+    Sequence numbers of valid frames give lost frames (dropped by
+    sender for lack of TX ring space or corrupted on the line). Time of
+    sample frames (32-bit microseconds, wraps in ~71 min) is extended
+    to 64 bits, so frames must come more often than every 35 min.
+    Serial port is opened by serial_open() (serial.h).
+*/
+
+#ifndef SIM_TELEM_RX_H
+#define SIM_TELEM_RX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "telem_fmt.h"
+
+struct TelemSamples {
+    unsigned sensor;
+    uint64_t t0;     // time of first value [us], extended
+    uint32_t dt;     // period [us]
+    std::vector<int16_t> values;
+};
+
+struct TelemStats {
+    uint64_t bytes = 0;     // fed
+    uint64_t frames = 0;    // valid frames
+    uint64_t rejected = 0;  // chunks that are not valid frames
+    uint64_t lost = 0;      // gaps in sequence numbers
+    uint64_t samples = 0;   // values in sample frames
+};
+
+class TelemReceiver {
+public:
+    // handlers of valid frames (unset ones are skipped)
+    std::function<void(const TelemSamples &)> on_samples;
+    std::function<void(const std::vector<uint32_t> &)> on_counters;
+    std::function<void(const std::vector<uint16_t> &)> on_diag;
+    // any valid frame incl. unknown types: type, seq, body
+    std::function<void(uint8_t, uint8_t, const uint8_t *, size_t)> on_frame;
+
+    void feed(const uint8_t *data, size_t len);
+    const TelemStats &stats() const { return st; }
+
+    // names of counters and diagnostic values (NULL when unknown)
+    static const char *counter_name(unsigned i);
+    static const char *diag_name(unsigned i);
+
+private:
+    std::vector<uint8_t> chunk;
+    bool overflow = false;
+    bool have_seq = false;
+    uint8_t seq = 0;
+    bool have_time = false;
+    uint64_t time = 0;
+    TelemStats st;
+
+    void end_chunk();
+    bool dispatch(const uint8_t *f, size_t len);
+};
+
+#endif /* SIM_TELEM_RX_H */
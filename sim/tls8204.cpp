@@ -0,0 +1,224 @@
+/**
+  @File Name
+    sim/tls8204.cpp
+
+  @Summary
+    TLS8204 LCD controller model - see tls8204.h
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "tls8204.h"
+#include "image.h"
+
+// errors printed in detail, further ones are only counted
+static const size_t LOG_MAX = 10;
+
+TLS8204::TLS8204(int port, int cs_pin, int dc_pin, int res_pin)
+    : port_(port), cs_mask_((uint16_t)(1U << cs_pin)),
+      dc_mask_((uint16_t)(1U << dc_pin)), res_mask_((uint16_t)(1U << res_pin))
+{
+    memset(ram_, 0, sizeof(ram_));
+    reset();
+}
+
+// state after /RES (RAM content is kept)
+void TLS8204::reset()
+{
+    x_ = y_ = 0;
+    h_ = 0;
+    pd_ = true;
+    d_ = e_ = false;
+    start_line_ = 0;
+    vop_ = 0;
+    bias_ = 0;
+}
+
+void TLS8204::error(uint64_t cycle, const char *what, uint8_t b)
+{
+    errors_++;
+    if (log_.size() < LOG_MAX){
+        char buf[96];
+        snprintf(buf, sizeof(buf), "%12.3f ms: %s 0x%02X",
+                 sim_cycles_to_us(cycle) / 1000.0, what, b);
+        log_.push_back(buf);
+    }
+}
+
+void TLS8204::on_pins(uint64_t cycle, uint16_t porta, uint16_t portb)
+{
+    (void)cycle;
+    bool res = ((port_ ? portb : porta) & res_mask_) == 0;
+
+    if (res && !in_reset_){
+        resets_++;
+        reset();
+    }
+    in_reset_ = res;
+}
+
+void TLS8204::command(uint64_t cycle, uint8_t b)
+{
+    if ((b & 0xE0) == 0x20){
+        // Function Set
+        pd_ = (b & 0x04) != 0;
+        h_ = b & 0x03;
+        return;
+    }
+    if (b == 0x00){
+        return; // NOP
+    }
+    if (h_ == 0){
+        if (b & 0x80){
+            x_ = b & 0x7F;
+            if (x_ >= RAM_COLS){
+                error(cycle, "X out of range", b);
+                x_ = 0;
+            }
+        } else if ((b & 0xF0) == 0x40){
+            y_ = b & 0x0F;
+            if (y_ >= RAM_BANKS){
+                error(cycle, "Y out of range", b);
+                y_ = 0;
+            }
+        } else if ((b & 0xFA) == 0x08){
+            d_ = (b & 0x04) != 0;
+            e_ = (b & 0x01) != 0;
+        } else {
+            error(cycle, "unknown command (H=00)", b);
+        }
+    } else if (h_ == 1){
+        if (b & 0x80){
+            vop_ = b & 0x7F;
+        } else if ((b & 0xC0) == 0x40){
+            start_line_ = (start_line_ & 0x40) | (b & 0x3F);
+        } else if ((b & 0xFE) == 0x04){
+            start_line_ = (start_line_ & 0x3F) | (unsigned)(b & 1) << 6;
+        } else if ((b & 0xF8) == 0x10){
+            bias_ = b & 0x07;
+        } else {
+            error(cycle, "unknown command (H=01)", b);
+        }
+    } else {
+        error(cycle, "instruction set H=1x not modelled", b);
+    }
+}
+
+void TLS8204::data(uint8_t b)
+{
+    ram_[y_][x_] = b;
+    // horizontal addressing
+    if (++x_ == RAM_COLS){
+        x_ = 0;
+        if (++y_ == RAM_BANKS){
+            y_ = 0;
+        }
+    }
+}
+
+uint8_t TLS8204::on_spi(uint64_t cycle, uint8_t mosi)
+{
+    uint16_t pins = sim_port_levels(port_);
+
+    if (pins & cs_mask_){
+        error(cycle, "byte with /CS high", mosi);
+        return 0;
+    }
+    if (in_reset_){
+        error(cycle, "byte during /RES", mosi);
+        return 0;
+    }
+    if (!frame_open_){
+        frame_open_ = true;
+        cur_ = Frame();
+        cur_.start = cycle;
+    }
+    cur_.end = cycle;
+    frame_end_at_ = cycle + (uint64_t)(FRAME_GAP * sim_fcy / 1e6);
+    if (pins & dc_mask_){
+        cur_.data++;
+        data(mosi);
+    } else {
+        cur_.cmd++;
+        command(cycle, mosi);
+    }
+    return 0; // no MISO on this module
+}
+
+std::vector<uint8_t> TLS8204::glass() const
+{
+    std::vector<uint8_t> px((size_t)GLASS_COLS * GLASS_ROWS);
+
+    for (int r = 0; r < GLASS_ROWS; r++){
+        int row = (int)((start_line_ + GLASS_COM_OFFSET + r) % RAM_ROWS);
+        for (int c = 0; c < GLASS_COLS; c++){
+            bool on = (ram_[row / 8][c] >> (row % 8)) & 1;
+            if (pd_ || (!d_ && !e_)){
+                on = false;          // power down or blank
+            } else if (!d_ && e_){
+                on = true;           // all segments on
+            } else if (d_ && e_){
+                on = !on;            // inverse
+            }
+            px[(size_t)r * GLASS_COLS + c] = on;
+        }
+    }
+    return px;
+}
+
+bool TLS8204::write_glass(const char *path) const
+{
+    return image_write(path, GLASS_COLS, GLASS_ROWS, glass());
+}
+
+void TLS8204::close_frame()
+{
+    frame_open_ = false;
+    frame_end_at_ = UINT64_MAX;
+    frames_.push_back(cur_);
+    if (log_frames){
+        fprintf(stderr, "lcd: frame %4zu at %10.3f ms: %3u cmd + %4u data bytes, "
+                "%.3f ms\n", frames_.size() - 1, sim_cycles_to_us(cur_.start) / 1000.0,
+                cur_.cmd, cur_.data, sim_cycles_to_us(cur_.end - cur_.start) / 1000.0);
+    }
+    if (!frame_prefix.empty()){
+        std::vector<uint8_t> px = glass();
+        if (px != written_){
+            char path[512];
+            snprintf(path, sizeof(path), "%s%04zu.%s", frame_prefix.c_str(),
+                     frames_.size() - 1, frame_ext.c_str());
+            image_write(path, GLASS_COLS, GLASS_ROWS, px);
+            written_ = px;
+            images_++;
+        }
+    }
+}
+
+uint64_t TLS8204::next_event()
+{
+    return frame_end_at_;
+}
+
+void TLS8204::on_event(uint64_t cycle)
+{
+    if (cycle >= frame_end_at_){
+        close_frame();
+    }
+}
+
+unsigned TLS8204::report() const
+{
+    unsigned cmd = 0, data = 0, max = 0;
+    for (const Frame &f : frames_){
+        cmd += f.cmd;
+        data += f.data;
+        if (f.cmd + f.data > max) max = f.cmd + f.data;
+    }
+    fprintf(stderr, "lcd: %zu frames, %u cmd + %u data bytes, max %u bytes/frame, "
+            "%u images, %u errors\n", frames_.size(), cmd, data, max, images_, errors_);
+    for (const std::string &l : log_){
+        fprintf(stderr, "lcd: ERROR %s\n", l.c_str());
+    }
+    return errors_;
+}
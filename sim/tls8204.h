@@ -0,0 +1,110 @@
+/**
+  @File Name
+    sim/tls8204.h
+
+  @Summary
+    TLS8204 LCD controller model (OLIMEX MOD-LCD3310) for host simulator.
+
+  @Description
+    Consumes bytes shifted out of SPI1 while /CS is low, D/C selects
+    command (0) or data (1) and is sampled at the end of byte like on
+    real controller. /RES low resets controller. Modelled instructions:
+
+      any H:  Function Set   0 0 1 MX MY PD H1 H0  (MX/MY not modelled)
+      H=00:   Display Control 0 0 0 0 1 D 0 E
+              Set Y           0 1 0 0 Y3..Y0   (bank 0..8)
+              Set X           1 X6..X0         (column 0..101)
+      H=01:   Start Line S6   0 0 0 0 0 1 0 S6
+              Start Line      0 1 S5..S0
+              Bias            0 0 0 1 0 BS2..BS0
+              EVR (Vop)       1 EV6..EV0
+
+    Display data RAM is 102x68 (9 banks of 8 rows, horizontal
+    addressing). Glass shows 84x48 pixels: column 0..83 and RAM rows
+    starting at start line + GLASS_COM_OFFSET (OLIMEX module wiring,
+    LCD_init() sets start line 64 so that bank 0 is top text line).
+
+    Burst of bytes ended by 2 ms pause on SPI is one frame - each frame
+    counts command and data bytes and may be written as image (see
+    image.h). Protocol errors (byte with /CS high or in reset, unknown
+    instruction, X/Y out of range) are counted.
+*/
+
+#ifndef SIM_TLS8204_H
+#define SIM_TLS8204_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+
+class TLS8204 : public SimDevice {
+public:
+    static const int RAM_COLS = 102;
+    static const int RAM_ROWS = 68;
+    static const int RAM_BANKS = 9;
+    static const int GLASS_COLS = 84;
+    static const int GLASS_ROWS = 48;
+    static const int GLASS_COM_OFFSET = 4;
+    // pause on SPI that ends frame [us]
+    static constexpr double FRAME_GAP = 2000;
+
+    struct Frame {
+        uint64_t start = 0, end = 0; // cycles of first and last byte
+        unsigned cmd = 0, data = 0;  // bytes
+    };
+
+    // pins on one port (0=A, 1=B)
+    TLS8204(int port, int cs_pin, int dc_pin, int res_pin);
+
+    // each frame that changed glass is written to <prefix>NNNN.<ext>
+    std::string frame_prefix;
+    std::string frame_ext = "pbm";
+    // prints one line per frame to stderr
+    bool log_frames = false;
+
+    // pixels of glass (GLASS_COLS x GLASS_ROWS, 1 = dark)
+    std::vector<uint8_t> glass() const;
+    bool write_glass(const char *path) const;
+    const std::vector<Frame> &frames() const { return frames_; }
+    // prints statistics and protocol errors to stderr, returns errors
+    unsigned report() const;
+
+    void on_pins(uint64_t cycle, uint16_t porta, uint16_t portb) override;
+    uint8_t on_spi(uint64_t cycle, uint8_t mosi) override;
+    uint64_t next_event() override;
+    void on_event(uint64_t cycle) override;
+
+private:
+    int port_;
+    uint16_t cs_mask_, dc_mask_, res_mask_;
+    bool in_reset_ = false;
+
+    uint8_t ram_[RAM_BANKS][RAM_COLS];
+    int x_ = 0, y_ = 0;
+    unsigned h_ = 0;         // instruction set H1H0
+    bool pd_ = true;         // power down
+    bool d_ = false, e_ = false; // display control
+    unsigned start_line_ = 0;
+    unsigned vop_ = 0;
+    unsigned bias_ = 0;
+
+    bool frame_open_ = false;
+    Frame cur_;
+    uint64_t frame_end_at_ = UINT64_MAX;
+    std::vector<Frame> frames_;
+    std::vector<uint8_t> written_;  // glass of last written frame
+    unsigned images_ = 0;
+    unsigned resets_ = 0;
+    unsigned errors_ = 0;
+    std::vector<std::string> log_;
+
+    void reset();
+    void error(uint64_t cycle, const char *what, uint8_t b);
+    void command(uint64_t cycle, uint8_t b);
+    void data(uint8_t b);
+    void close_frame();
+};
+
+#endif /* SIM_TLS8204_H */
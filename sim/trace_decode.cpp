@@ -0,0 +1,247 @@
+/**
+  @File Name
+    sim/trace_decode.cpp
+
+  @Summary
+    Decoder of binary event trace dump (see common/trace_fmt.h).
+
+  @Description
+    Usage: trace-decode [-f fcy_hz] [-k tick_cycles] [-v out.vcd] [-q] [dump]
+
+    Reads raw UART capture (file or stdin), which may contain also text
+    output of firmware, finds valid frames and prints events sorted
+    by time. With -v also writes VCD file (GTKWave, PulseView) with one
+    1-bit signal and one 16-bit 'arg' value per event type.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "trace_fmt.h"
+#include "crc8.h"
+
+struct EventInfo {
+    const char *name;
+    int kind;
+};
+
+#define TRACE_EVENT_INFO(id, name, kind) { name, kind },
+static const EventInfo EVENTS[TRACE_EVENT_COUNT] = {
+    TRACE_EVENTS(TRACE_EVENT_INFO)
+};
+#undef TRACE_EVENT_INFO
+
+static const char *RING_NAMES[TRACE_RINGS] = { "main", "isr" };
+
+struct Record {
+    uint64_t cycle;  // since boot
+    unsigned ring;
+    unsigned seq;    // order of arrival (for stable sort)
+    uint8_t event;
+    uint8_t aux;
+    uint16_t arg;
+};
+
+static uint32_t fcy = 4000000UL;
+static uint32_t tick_cycles = 10000;
+
+static uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+// CRC-8 over data followed by its CRC is 0
+static bool crc_ok(const uint8_t *p, size_t len)
+{
+    uint8_t crc = CRC8_INIT;
+
+    while (len--) {
+        crc = crc8_update(crc, *p++);
+    }
+    return crc == 0;
+}
+
+static std::string event_name(uint8_t ev)
+{
+    if (ev < TRACE_EVENT_COUNT) {
+        return EVENTS[ev].name;
+    }
+    return "event_" + std::to_string(ev);
+}
+
+static void write_vcd(const char *path, const std::vector<Record> &recs)
+{
+    struct Change { uint64_t ns; unsigned sig; uint32_t value; int bits; };
+    std::vector<Change> ch;
+    FILE *f = fopen(path, "w");
+
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(f, "$timescale 1 ns $end\n$scope module trace $end\n");
+    // signal 2*ev = 1-bit, 2*ev+1 = 16-bit arg; VCD ids are printable chars
+    for (unsigned ev = 0; ev < TRACE_EVENT_COUNT; ev++) {
+        fprintf(f, "$var wire 1 %c %s $end\n", (char)('!' + 2 * ev),
+                EVENTS[ev].name);
+        fprintf(f, "$var reg 16 %c %s_arg $end\n", (char)('!' + 2 * ev + 1),
+                EVENTS[ev].name);
+    }
+    fprintf(f, "$upscope $end\n$enddefinitions $end\n");
+
+    for (const Record &r : recs) {
+        if (r.event >= TRACE_EVENT_COUNT) {
+            continue;
+        }
+        uint64_t ns = r.cycle * 1000000000ULL / fcy;
+        unsigned sig = 2 * r.event;
+        ch.push_back({ ns, sig + 1, r.arg, 16 });
+        if (EVENTS[r.event].kind == TRACE_KIND_LEVEL) {
+            ch.push_back({ ns, sig, (uint32_t)(r.aux != 0), 1 });
+        } else {
+            // 1 us wide pulse
+            ch.push_back({ ns, sig, 1, 1 });
+            ch.push_back({ ns + 1000, sig, 0, 1 });
+        }
+    }
+    std::stable_sort(ch.begin(), ch.end(),
+                     [](const Change &a, const Change &b) { return a.ns < b.ns; });
+
+    fprintf(f, "#0\n$dumpvars\n");
+    for (unsigned ev = 0; ev < TRACE_EVENT_COUNT; ev++) {
+        fprintf(f, "0%c\nb0 %c\n", (char)('!' + 2 * ev), (char)('!' + 2 * ev + 1));
+    }
+    fprintf(f, "$end\n");
+    uint64_t last = 0;
+    for (const Change &c : ch) {
+        if (c.ns != last) {
+            fprintf(f, "#%llu\n", (unsigned long long)c.ns);
+            last = c.ns;
+        }
+        if (c.bits == 1) {
+            fprintf(f, "%u%c\n", c.value, (char)('!' + c.sig));
+        } else {
+            std::string b;
+            for (int i = c.bits - 1; i >= 0; i--) {
+                b += (c.value >> i) & 1 ? '1' : '0';
+            }
+            b.erase(0, std::min(b.find('1'), b.size() - 1));
+            fprintf(f, "b%s %c\n", b.c_str(), (char)('!' + c.sig));
+        }
+    }
+    fclose(f);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-f fcy_hz] [-k tick_cycles] [-v out.vcd] [-q] "
+            "[dump_file]\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    const char *vcd = NULL;
+    bool quiet = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:k:v:qh")) != -1) {
+        switch (opt) {
+            case 'f': fcy = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'k': tick_cycles = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'v': vcd = optarg; break;
+            case 'q': quiet = true; break;
+            default: usage(argv[0]);
+        }
+    }
+    FILE *in = stdin;
+    if (optind < argc) {
+        in = fopen(argv[optind], "rb");
+        if (!in) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    std::vector<uint8_t> data;
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        data.push_back((uint8_t)c);
+    }
+
+    std::vector<Record> recs;
+    uint64_t last[TRACE_RINGS] = { 0 };
+    bool have_dropped[TRACE_RINGS] = { false };
+    uint16_t dropped[TRACE_RINGS] = { 0 };
+    unsigned frames = 0, bad = 0, seq = 0;
+    size_t i = 0;
+
+    while (i + TRACE_HDR_SIZE + 1 <= data.size()) {
+        const uint8_t *p = &data[i];
+        if (p[0] != TRACE_SYNC0 || p[1] != TRACE_SYNC1 || p[2] >= TRACE_RINGS) {
+            i++;
+            continue;
+        }
+        size_t len = TRACE_HDR_SIZE + (size_t)p[3] * TRACE_REC_SIZE + 1;
+        if (i + len > data.size() || !crc_ok(p + 2, len - 2)) {
+            bad++;
+            i++;
+            continue;
+        }
+        unsigned ring = p[2];
+        unsigned n = p[3];
+        uint16_t drop = get16(p + 4);
+        uint32_t now = (uint32_t)get16(p + 6) | (uint32_t)get16(p + 8) << 16;
+
+        if (have_dropped[ring] && drop != dropped[ring]) {
+            Record r = { 0, ring, seq++, 0xFF, 0, (uint16_t)(drop - dropped[ring]) };
+            r.cycle = last[ring];
+            recs.push_back(r);
+        }
+        dropped[ring] = drop;
+        have_dropped[ring] = true;
+
+        for (unsigned k = 0; k < n; k++) {
+            const uint8_t *q = p + TRACE_HDR_SIZE + k * TRACE_REC_SIZE;
+            uint16_t tick16 = get16(q);
+            // extend 16-bit tick using frame time (record is older)
+            uint32_t tick = now - (uint16_t)((uint16_t)now - tick16);
+            uint64_t cyc = (uint64_t)tick * tick_cycles + get16(q + 2);
+            // stamp taken across TMR1 rollover is one tick early
+            if (cyc < last[ring] && last[ring] - cyc <= tick_cycles) {
+                cyc += tick_cycles;
+            }
+            last[ring] = cyc;
+            recs.push_back({ cyc, ring, seq++, q[4], q[5], get16(q + 6) });
+        }
+        frames++;
+        i += len;
+    }
+
+    std::stable_sort(recs.begin(), recs.end(),
+                     [](const Record &a, const Record &b) { return a.cycle < b.cycle; });
+
+    if (!quiet) {
+        for (const Record &r : recs) {
+            double t = (double)r.cycle / fcy;
+            if (r.event == 0xFF) {
+                printf("%12.6f %-4s --- %u records dropped\n", t,
+                       RING_NAMES[r.ring], r.arg);
+                continue;
+            }
+            printf("%12.6f %-4s %-12s aux=%-3u arg=%u (0x%04X)\n", t,
+                   RING_NAMES[r.ring], event_name(r.event).c_str(),
+                   r.aux, r.arg, r.arg);
+        }
+    }
+    if (vcd) {
+        std::vector<Record> ev;
+        for (const Record &r : recs) {
+            if (r.event != 0xFF) ev.push_back(r);
+        }
+        write_vcd(vcd, ev);
+    }
+    fprintf(stderr, "trace-decode: %u frames, %zu records, %u bad frames\n",
+            frames, recs.size(), bad);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+  @File Name
+    sim/trace_diff.cpp
+
+  @Summary
+    Compares pin/SPI trace of simulator with golden trace.
+
+  @Description
+    Usage: trace-diff [-t tolerance_us] [-n max_reports] golden trace
+
+    Both files are written by -o record= of simulator (see recorder.h).
+    Events are compared in order: each one must have the same pin and
+    level (or SPI byte) as in golden trace and its time may differ by at
+    most tolerance (default 1 us = 4 cycles at 4 MHz). Missing or extra
+    events (more bus traffic) fail regardless of time. Exit status is 0
+    when traces match, 1 otherwise, 2 on usage or file error.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct Event {
+    double us;
+    std::string what;   // "B9 1", "SPI 80"
+    unsigned line;
+};
+
+struct Trace {
+    std::string header;
+    std::vector<Event> events;
+};
+
+static bool load(const char *path, Trace &t)
+{
+    FILE *f = fopen(path, "r");
+    char buf[256];
+    unsigned line = 0;
+
+    if (!f){
+        perror(path);
+        return false;
+    }
+    while (fgets(buf, sizeof buf, f)){
+        std::string s(buf);
+        line++;
+        while (!s.empty() && (s.back() == '\n' || s.back() == '\r')){
+            s.pop_back();
+        }
+        if (s.empty()){
+            continue;
+        }
+        if (s[0] == '#'){
+            if (t.header.empty()){
+                t.header = s;
+            }
+            continue;
+        }
+        char *end;
+        double us = strtod(s.c_str(), &end);
+        if (end == s.c_str() || *end != ' '){
+            fprintf(stderr, "%s:%u: bad event '%s'\n", path, line, s.c_str());
+            fclose(f);
+            return false;
+        }
+        t.events.push_back({ us, std::string(end + 1), line });
+    }
+    fclose(f);
+    return true;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t tolerance_us] [-n max_reports] golden trace\n", prog);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    double tolerance = 1.0;
+    unsigned max_reports = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:n:h")) != -1){
+        switch (opt){
+            case 't': tolerance = atof(optarg); break;
+            case 'n': max_reports = (unsigned)strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (argc - optind != 2){
+        usage(argv[0]);
+    }
+    const char *golden_path = argv[optind];
+    const char *trace_path = argv[optind + 1];
+    Trace golden, trace;
+    if (!load(golden_path, golden) || !load(trace_path, trace)){
+        return 2;
+    }
+
+    unsigned reports = 0;
+    unsigned drifts = 0;
+    double max_drift = 0;
+    auto report = [&](const char *fmt, const Event &e, double us, const char *what) {
+        if (reports++ < max_reports){
+            printf(fmt, e.line, e.us, e.what.c_str(), us, what);
+        }
+    };
+
+    if (golden.header != trace.header){
+        printf("header differs: '%s' vs '%s'\n", golden.header.c_str(), trace.header.c_str());
+        reports++;
+    }
+    size_t n = std::min(golden.events.size(), trace.events.size());
+    size_t i;
+    for (i = 0; i < n; i++){
+        const Event &g = golden.events[i];
+        const Event &e = trace.events[i];
+        if (g.what != e.what){
+            // sequences differ from here on, further times are meaningless
+            report("golden line %u: expected %.2f %s, got %.2f %s\n",
+                   g, e.us, e.what.c_str());
+            break;
+        }
+        double d = e.us - g.us;
+        if (fabs(d) > fabs(max_drift)){
+            max_drift = d;
+        }
+        if (fabs(d) > tolerance){
+            drifts++;
+            report("golden line %u: %.2f %s moved to %.2f us (%s)\n",
+                   g, e.us, d > 0 ? "late" : "early");
+        }
+    }
+    if (i == n && golden.events.size() != trace.events.size()){
+        if (trace.events.size() > n){
+            const Event &e = trace.events[n];
+            printf("%zu extra events, first %.2f %s\n",
+                   trace.events.size() - n, e.us, e.what.c_str());
+        } else {
+            const Event &g = golden.events[n];
+            printf("%zu missing events, first %.2f %s (golden line %u)\n",
+                   golden.events.size() - n, g.us, g.what.c_str(), g.line);
+        }
+        reports++;
+    }
+    if (reports > max_reports){
+        printf("... %u more differences\n", reports - max_reports);
+    }
+    printf("%s: %zu/%zu events, %u drifted over %.2f us, max drift %+.2f us\n",
+           trace_path, trace.events.size(), golden.events.size(), drifts,
+           tolerance, max_drift);
+    return reports ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+/**
+  @File Name
+    sim/uart_link.cpp
+
+  @Summary
+    Simulated UART1 on serial port of host - see uart_link.h
+*/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "uart_link.h"
+#include "serial.h"
+
+// wall clock is checked every POLL_US of simulated time
+static const double POLL_US = 100.0;
+
+static double wall_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+bool UartLink::open(const char *path)
+{
+    if (strcmp(path, "pty") == 0){
+        fd_ = serial_open_pty(path_);
+        if (fd_ >= 0){
+            fprintf(stderr, "sim: UART1 on %s\n", path_.c_str());
+        }
+    } else {
+        path_ = path;
+        fd_ = serial_open(path, 0);
+    }
+    if (fd_ < 0){
+        return false;
+    }
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    wall_start_ = wall_us() - sim_cycles_to_us(sim_cycles);
+    next_ = sim_cycles;
+    return true;
+}
+
+// waits until wall clock catches up with simulated time, returns at
+// once when host sends something
+void UartLink::pace(uint64_t cycle)
+{
+    double ahead = sim_cycles_to_us(cycle) - (wall_us() - wall_start_);
+    if (ahead <= 0){
+        return;
+    }
+    struct pollfd p = { fd_, POLLIN, 0 };
+    struct timespec t = { (time_t)(ahead / 1e6), (long)(ahead * 1e3) % 1000000000L };
+    if (ppoll(&p, 1, &t, NULL) > 0 && !(p.revents & POLLIN)){
+        // other side closed - poll does not wait
+        nanosleep(&t, NULL);
+    }
+}
+
+void UartLink::on_event(uint64_t cycle)
+{
+    uint8_t buf[256];
+    ssize_t n;
+
+    pace(cycle);
+    while ((n = read(fd_, buf, sizeof(buf))) > 0){
+        for (ssize_t i = 0; i < n; i++){
+            rx_free_ = (rx_free_ > cycle ? rx_free_ : cycle) + sim_uart1_frame_cycles();
+            sim_uart1_rx_inject(buf[i], rx_free_);
+        }
+        bytes_in_ += (uint64_t)n;
+        waiting_ = true;
+    }
+    next_ = cycle + (uint64_t)(POLL_US * sim_fcy / 1e6);
+}
+
+void UartLink::on_uart_tx(uint64_t cycle, uint8_t byte)
+{
+    bytes_out_++;
+    if (write(fd_, &byte, 1) != 1){
+        dropped_++;
+    }
+    uint64_t start = cycle - sim_uart1_frame_cycles();
+    if (!waiting_ || start < rx_free_){
+        return;
+    }
+    waiting_ = false;
+    double lat = sim_cycles_to_us(start - rx_free_);
+    if (!replies_ || lat < lat_min_) lat_min_ = lat;
+    if (!replies_ || lat > lat_max_) lat_max_ = lat;
+    lat_sum_ += lat;
+    replies_++;
+    if (lat < min_us || lat > max_us){
+        violations_++;
+        fprintf(stderr, "uart: VIOLATION reply latency %.1f us at %.6f s (%.0f..%.0f us)\n",
+                lat, sim_cycles_to_us(start) / 1e6, min_us, max_us);
+    }
+}
+
+unsigned UartLink::report()
+{
+    if (fd_ < 0){
+        return 0;
+    }
+    fprintf(stderr, "uart: %s: %llu bytes in, %llu out (%llu dropped), %llu replies",
+            path_.c_str(), (unsigned long long)bytes_in_,
+            (unsigned long long)bytes_out_, (unsigned long long)dropped_,
+            (unsigned long long)replies_);
+    if (replies_){
+        fprintf(stderr, ", latency %.1f..%.1f us (mean %.1f)", lat_min_, lat_max_,
+                lat_sum_ / replies_);
+    }
+    fprintf(stderr, "\nuart: %llu latency violations\n", (unsigned long long)violations_);
+    return (unsigned)violations_;
+}
@@ -0,0 +1,65 @@
+/**
+  @File Name
+    sim/uart_link.h
+
+  @Summary
+    Connects simulated UART1 to serial port or pseudo-terminal of host.
+
+  @Description
+    Bytes transmitted by firmware are written to the port, bytes read
+    from it are received by UART1 back to back at current line speed
+    (U1BRG) - one write() of host program arrives as one burst without
+    gaps. Simulation is paced to wall clock (it never runs ahead of
+    it), so host program talking to firmware (Modbus master, terminal)
+    sees its real timing: answer that takes 2 ms of simulated time
+    comes ~2 ms after request.
+
+    Reply latency - from end of last received byte to start of first
+    byte transmitted after it - is measured in simulated time, so it
+    does not depend on host load. It is checked against [min, max]
+    (Modbus slave must keep line silent for t3.5 and answer before
+    master's response timeout), replies out of it are violations.
+
+    Port closed by the other side (no reader, pseudo-terminal hung up)
+    is not an error: transmitted bytes are dropped and simulation keeps
+    pace with wall clock until it is opened again.
+*/
+
+#ifndef SIM_UART_LINK_H
+#define SIM_UART_LINK_H
+
+#include <stdint.h>
+#include <string>
+
+#include "sim.h"
+
+class UartLink : public SimDevice {
+public:
+    // reply latency limits [us]
+    double min_us = 0, max_us = 1e12;
+
+    // opens tty or pseudo-terminal ("pty" creates new one and prints
+    // its path to stderr), false on error (errno set)
+    bool open(const char *path);
+    // prints statistics, returns number of violations
+    unsigned report();
+
+    void on_uart_tx(uint64_t cycle, uint8_t byte) override;
+    uint64_t next_event() override { return next_; }
+    void on_event(uint64_t cycle) override;
+
+private:
+    int fd_ = -1;
+    std::string path_;
+    uint64_t next_ = UINT64_MAX;
+    double wall_start_ = 0;
+    uint64_t rx_free_ = 0;        // receiver line idle from this cycle
+    bool waiting_ = false;        // request received, no reply yet
+    uint64_t bytes_in_ = 0, bytes_out_ = 0, dropped_ = 0;
+    uint64_t replies_ = 0, violations_ = 0;
+    double lat_min_ = 0, lat_max_ = 0, lat_sum_ = 0;
+
+    void pace(uint64_t cycle);
+};
+
+#endif /* SIM_UART_LINK_H */